@@ -11,122 +11,578 @@
 // --------------------------------------------------------------------------------------
 LR2BGAExternalRenderer::LR2BGAExternalRenderer(LR2BGASettings* pSettings)
     : m_pSettings(pSettings)
-    , m_bufWidth(0)
-    , m_bufHeight(0)
-    , m_bufStride(0)
+    , m_bMailboxPending(false)
+    , m_bRenderStop(false)
+    , m_hRenderWnd(NULL)
+    , m_qpcFreq(0)
+    , m_streamCfg()
+    , m_streamCfgVersion(0)
+    , m_renderCfg()
+    , m_renderCfgVersion(0)
+    , m_bVisible(false)
+    , m_duplicateCount(0)
+    , m_nextDueQpc(0)
+    , m_lastPostQpc(0)
+    , m_qualityLevel(QUALITY_FULL)
+    , m_costUs(0)
+    , m_costEmaMs(-1.0)
+    , m_intervalEmaMs(-1.0)
+    , m_overBudgetCount(0)
+    , m_levelChangedQpc(0)
+    , m_holdMs(kGovernorHoldMs)
+    , m_lastChangeWasUp(false)
+    , m_writeIndex(0)
+    , m_displayIndex(2)
+    , m_readyState(1)
 {
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    m_qpcFreq = freq.QuadPart > 0 ? freq.QuadPart : 1;
 }
 
 LR2BGAExternalRenderer::~LR2BGAExternalRenderer()
 {
+    StopRenderThread();
     ClearBuffer();
 }
 
 // --------------------------------------------------------------------------------------
-// UpdateFrame - ソースフレームをリサイズしてバッファに格納
+// StartRenderThread / StopRenderThread - 描画スレッド制御
 // --------------------------------------------------------------------------------------
+void LR2BGAExternalRenderer::StartRenderThread(HWND hExtWnd)
+{
+    StopRenderThread();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtxMailbox);
+        m_bMailboxPending = false;
+        m_bRenderStop = false;
+    }
+
+    // ガバナーは新しいウィンドウごとに設定どおりの画質から計測し直す
+    m_qualityLevel = QUALITY_FULL;
+    m_costUs = 0;
+    m_costEmaMs = -1.0;
+    m_intervalEmaMs = -1.0;
+    m_overBudgetCount = 0;
+    m_levelChangedQpc = 0;
+    m_holdMs = kGovernorHoldMs;
+    m_lastChangeWasUp = false;
+
+    // 新しいウィンドウは何も提示していないため、最初のフレームは必ず描画する
+    m_lastPresented = FrameKey();
+    m_duplicateCount = 0;
+
+    m_hRenderWnd = hExtWnd;
+    m_threadRender = std::thread(&LR2BGAExternalRenderer::RenderThread, this);
+}
+
+void LR2BGAExternalRenderer::StopRenderThread()
+{
+    // 以降の投函を止める (UpdateFrame は m_hRenderWnd が NULL ならコピーしない)
+    m_hRenderWnd = NULL;
+    m_bVisible = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtxMailbox);
+        m_bRenderStop = true;
+        m_bMailboxPending = false;
+    }
+    m_cvMailbox.notify_one();
+
+    if (m_threadRender.joinable()) {
+        m_threadRender.join();
+    }
+}
+
+// --------------------------------------------------------------------------------------
+// IsFrameDue - 外部ウィンドウ専用の上限FPSによる間引き判定
+// --------------------------------------------------------------------------------------
+// ストリーミングスレッドから、投函 (UpdateFrame / BeginPresizedFrame) の前に呼ばれます。
+// 投函予定時刻を 1/maxFPS 間隔のグリッドで進めるため、入力と上限が整数倍の関係でなくても
+// 平均の更新レートは上限に一致します。入力タイミングの揺らぎで1フレーム分ずれないよう、
+// 予定時刻の 1/4 間隔手前までは受け付けます。
+// ウィンドウが見えていない間は常に false を返し、外部ウィンドウ向けの処理を丸ごと省略します。
+bool LR2BGAExternalRenderer::IsFrameDue(HWND hExtWnd)
+{
+    if (!hExtWnd || m_hRenderWnd.load() != hExtWnd) return false;
+
+    if (!m_bVisible.load(std::memory_order_relaxed)) {
+        // 再開時は最初のフレームから投函する
+        m_nextDueQpc = 0;
+        return false;
+    }
+
+    RefreshConfig(LR2BGASettings::SNAPSHOT_READER_EXT_STREAM, m_streamCfg, m_streamCfgVersion);
+    const int maxFPS = m_streamCfg.maxFPS;
+
+    if (maxFPS <= 0) {
+        m_nextDueQpc = 0;
+        return true;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    const LONGLONG interval = m_qpcFreq / maxFPS;
+    if (m_nextDueQpc != 0 && now.QuadPart < m_nextDueQpc - interval / 4) return false;
+
+    // 一時停止などで1間隔以上遅れた場合はグリッドを現在時刻へ合わせ直す (まとめて投函しない)
+    if (m_nextDueQpc == 0 || now.QuadPart - m_nextDueQpc >= interval) {
+        m_nextDueQpc = now.QuadPart + interval;
+    } else {
+        m_nextDueQpc += interval;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------------------
+// UpdateFrame - ソースフレームをメールボックスへ投函
+// --------------------------------------------------------------------------------------
+// ストリーミングスレッドから呼ばれます。
+// クロップ範囲の行だけを m_staging へコピーし、メールボックスとスワップして戻ります。
+// 描画スレッドが前のフレームをまだ取り出していない場合、そのフレームは上書きされ破棄されます
+// (外部ウィンドウは常に最新フレームのみを表示すればよいため)。
 void LR2BGAExternalRenderer::UpdateFrame(const BYTE* pSrcData, int srcWidth, int srcHeight,
                                          int srcStride, int srcBitCount, const RECT* pSrcRect,
                                          HWND hExtWnd)
 {
-    if (!hExtWnd || !IsWindow(hExtWnd)) return;
+    if (!pSrcData || !hExtWnd || m_hRenderWnd.load() != hExtWnd) return;
+    if (srcBitCount != 24 && srcBitCount != 32) return;
 
-    // 設定のスナップショットを取得
-    LR2BGASettings::ExtWindowConfig cfg;
-    m_pSettings->GetExtWindowConfig(cfg);
+    RECT rc = {0, 0, srcWidth, srcHeight};
+    if (pSrcRect) rc = *pSrcRect;
+    if (rc.left < 0) rc.left = 0;
+    if (rc.top < 0) rc.top = 0;
+    if (rc.right > srcWidth) rc.right = srcWidth;
+    if (rc.bottom > srcHeight) rc.bottom = srcHeight;
 
-    int targetWidth = cfg.width;
-    int targetHeight = cfg.height;
+    const int cropW = rc.right - rc.left;
+    const int cropH = rc.bottom - rc.top;
+    if (cropW <= 0 || cropH <= 0) return;
 
-    if (cfg.passthrough) {
-        // パススルー時：クロップサイズまたはソースサイズを使用
-        if (pSrcRect) {
-            targetWidth = pSrcRect->right - pSrcRect->left;
-            targetHeight = pSrcRect->bottom - pSrcRect->top;
-        } else {
-            targetWidth = srcWidth;
-            targetHeight = srcHeight;
+    LARGE_INTEGER copyStart, copyEnd;
+    QueryPerformanceCounter(&copyStart);
+
+    // クロップ範囲の行コピー (メモリ上の行順をそのまま維持するため、ボトムアップDIBでも向きは変わらない)
+    const int bytesPerPixel = srcBitCount / 8;
+    const int rowBytes = cropW * bytesPerPixel;
+    const int stride = (rowBytes + 3) & ~3;
+    const size_t needed = (size_t)stride * cropH;
+    try {
+        if (m_staging.data.size() < needed) m_staging.data.resize(needed);
+    } catch (...) {
+        return;
+    }
+
+    const BYTE* pSrcRow = pSrcData + (size_t)rc.top * srcStride + (size_t)rc.left * bytesPerPixel;
+    BYTE* pDstRow = m_staging.data.data();
+    for (int y = 0; y < cropH; ++y) {
+        memcpy(pDstRow, pSrcRow, rowBytes);
+        pSrcRow += srcStride;
+        pDstRow += stride;
+    }
+    m_staging.width = cropW;
+    m_staging.height = cropH;
+    m_staging.stride = stride;
+    m_staging.bitCount = srcBitCount;
+    m_staging.presized = false;
+
+    QueryPerformanceCounter(&copyEnd);
+    m_staging.streamCostQpc = copyEnd.QuadPart - copyStart.QuadPart;
+
+    PostStagingFrame();
+}
+
+// --------------------------------------------------------------------------------------
+// BeginPresizedFrame / CommitPresizedFrame - リサイズ済みフレームの投函
+// --------------------------------------------------------------------------------------
+// LR2 向け出力のリサイズ (ResizeMulti) の出力先の1つとして m_staging を貸し出します。
+// ソースはLR2向けの処理で既にキャッシュに載っているため、クロップ範囲のコピーより安価で、
+// 描画スレッド側のリサイズも不要になります。
+bool LR2BGAExternalRenderer::BeginPresizedFrame(HWND hExtWnd, int cropWidth, int cropHeight,
+                                                LR2BGAImageProc::ResizeTarget& target)
+{
+    if (!hExtWnd || m_hRenderWnd.load() != hExtWnd) return false;
+    if (cropWidth <= 0 || cropHeight <= 0) return false;
+
+    // 設定のスナップショット (世代が変わったときだけ取り直す)
+    RefreshConfig(LR2BGASettings::SNAPSHOT_READER_EXT_STREAM, m_streamCfg, m_streamCfgVersion);
+    const LR2BGASettings::ExtWindowConfig& cfg = m_streamCfg;
+
+    // パススルーはクロップ範囲の等倍コピーなので従来の投函経路を使う
+    if (cfg.passthrough) return false;
+
+    // 画質ガバナーの現在のレベルで生成する (縮小解像度なら LR2 と同じ走査でより小さく出力する)
+    const int level = m_qualityLevel.load(std::memory_order_relaxed);
+    int targetWidth, targetHeight;
+    GetSizeAt(cfg, level, targetWidth, targetHeight);
+    if (targetWidth <= 0 || targetHeight <= 0) return false;
+
+    const int dstStride = ((targetWidth * 3 + 3) & ~3);
+    const size_t dstSize = (size_t)dstStride * targetHeight;
+    try {
+        if (m_staging.data.size() < dstSize) m_staging.data.resize(dstSize);
+    } catch (...) {
+        return false;
+    }
+
+    int outWidth, outHeight, offsetX, offsetY;
+    LR2BGAImageProc::CalculateResizeDimensions(
+        cropWidth, cropHeight, targetWidth, targetHeight,
+        cfg.keepAspect,
+        outWidth, outHeight, offsetX, offsetY);
+
+    // 背景クリア (レターボックス用)
+    if (outWidth < targetWidth || outHeight < targetHeight) {
+        memset(m_staging.data.data(), 0, dstSize);
+    }
+
+    m_staging.width = targetWidth;
+    m_staging.height = targetHeight;
+    m_staging.stride = dstStride;
+    m_staging.bitCount = 24;
+    m_staging.presized = true;
+    m_staging.qualityLevel = level;
+
+    target.pDst = m_staging.data.data();
+    target.dstWidth = targetWidth;
+    target.dstHeight = targetHeight;
+    target.dstStride = dstStride;
+    target.actualWidth = outWidth;
+    target.actualHeight = outHeight;
+    target.offsetX = offsetX;
+    target.offsetY = offsetY;
+    target.bilinear = IsBilinearAt(cfg, level);
+    target.pCache = &m_stagingCache;
+    return true;
+}
+
+void LR2BGAExternalRenderer::CommitPresizedFrame(LONGLONG resizeQpc, int sharedPixels)
+{
+    if (!m_staging.presized) return;
+
+    // ResizeMulti のコストは出力画素数にほぼ比例するため、外部ウィンドウ分を画素数の比で按分する
+    const double extPixels = (double)m_staging.width * m_staging.height;
+    const double totalPixels = extPixels + (sharedPixels > 0 ? sharedPixels : 0);
+    m_staging.streamCostQpc = (totalPixels > 0) ? (LONGLONG)(resizeQpc * (extPixels / totalPixels)) : 0;
+
+    PostStagingFrame();
+}
+
+// --------------------------------------------------------------------------------------
+// PostStagingFrame - m_staging をメールボックスへ差し替え
+// --------------------------------------------------------------------------------------
+void LR2BGAExternalRenderer::PostStagingFrame()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    m_staging.postIntervalQpc = (m_lastPostQpc != 0) ? (now.QuadPart - m_lastPostQpc) : 0;
+    m_lastPostQpc = now.QuadPart;
+
+    // 保持時間はスワップのみ
+    {
+        std::lock_guard<std::mutex> lock(m_mtxMailbox);
+        if (m_bRenderStop) return;
+        std::swap(m_staging, m_mailbox);
+        m_bMailboxPending = true;
+    }
+    m_cvMailbox.notify_one();
+}
+
+// --------------------------------------------------------------------------------------
+// RenderThread - 描画スレッド本体
+// --------------------------------------------------------------------------------------
+void LR2BGAExternalRenderer::RenderThread()
+{
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mtxMailbox);
+            m_cvMailbox.wait(lock, [this] { return m_bMailboxPending || m_bRenderStop; });
+            if (m_bRenderStop) break;
+            std::swap(m_mailbox, m_renderSrc);
+            m_bMailboxPending = false;
         }
+
+        HWND hExtWnd = m_hRenderWnd.load();
+        if (!hExtWnd) break;
+        RenderFrame(m_renderSrc, hExtWnd);
+    }
+}
+
+// --------------------------------------------------------------------------------------
+// RenderFrame - フレームをリサイズしてバッファに格納 (描画スレッド)
+// --------------------------------------------------------------------------------------
+void LR2BGAExternalRenderer::RenderFrame(FrameSlot& frame, HWND hExtWnd)
+{
+    if (!IsWindow(hExtWnd)) return;
+
+    // 設定のスナップショット (世代が変わったときだけ取り直す)
+    RefreshConfig(LR2BGASettings::SNAPSHOT_READER_EXT_RENDER, m_renderCfg, m_renderCfgVersion);
+    const LR2BGASettings::ExtWindowConfig& cfg = m_renderCfg;
+
+    LARGE_INTEGER renderStart, renderEnd;
+    QueryPerformanceCounter(&renderStart);
+
+    if (frame.presized) {
+        // 投函後に出力サイズ設定が変わった場合は破棄し、次のフレームを待つ
+        int expectedWidth, expectedHeight;
+        GetSizeAt(cfg, frame.qualityLevel, expectedWidth, expectedHeight);
+        if (cfg.passthrough || frame.width != expectedWidth || frame.height != expectedHeight) return;
+    }
+
+    // 画質ガバナーのレベルを適用 (リサイズ済みフレームは生成時のレベル、パススルーは等倍コピーのため対象外)
+    const int level = frame.presized ? frame.qualityLevel
+        : (cfg.passthrough ? QUALITY_FULL : m_qualityLevel.load(std::memory_order_relaxed));
+
+    // 重複フレーム判定
+    // 直前に提示したフレームと同じ内容なら、提示中の画像も同じなのでリサイズ・提示・再描画要求を省略する
+    FrameKey key;
+    key.hash = LR2BGAImageProc::HashRows(frame.data.data(), frame.width * (frame.bitCount / 8),
+                                         frame.height, frame.stride);
+    key.width = frame.width;
+    key.height = frame.height;
+    key.bitCount = frame.bitCount;
+    key.presized = frame.presized;
+    key.qualityLevel = level;
+    key.cfgVersion = m_renderCfgVersion;
+    key.valid = true;
+    if (IsSameFrame(key, m_lastPresented)) {
+        m_duplicateCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (frame.presized) {
+        // リサイズ済みなので、書き込み面とデータを交換するだけで提示できる
+        PresentBuffer& dst = m_present[m_writeIndex];
+        std::swap(dst.data, frame.data);
+        dst.width = frame.width;
+        dst.height = frame.height;
+        dst.stride = frame.stride;
+
+        const int prev = m_readyState.exchange(m_writeIndex | kPresentFreshBit, std::memory_order_acq_rel);
+        m_writeIndex = prev & kPresentIndexMask;
+        m_lastPresented = key;
+
+        InvalidateRect(hExtWnd, NULL, FALSE);
+
+        QueryPerformanceCounter(&renderEnd);
+        UpdateGovernor(frame, frame.qualityLevel, renderEnd.QuadPart - renderStart.QuadPart, cfg);
+        return;
     }
 
+    // フレームは投函時にクロップ済み
+    const int srcWidth = frame.width;
+    const int srcHeight = frame.height;
+
+    int targetWidth, targetHeight;
+    GetSizeAt(cfg, level, targetWidth, targetHeight);
+
+    if (cfg.passthrough) {
+        // パススルー時：クロップ後のソースサイズを使用
+        targetWidth = srcWidth;
+        targetHeight = srcHeight;
+    }
+    if (targetWidth <= 0 || targetHeight <= 0) return;
+
     // バッファサイズ計算
     int dstStride = ((targetWidth * 3 + 3) & ~3);
     int dstSize = dstStride * targetHeight;
 
-    // バッファサイズ変更 (排他制御)
-    {
-        std::lock_guard<std::mutex> lock(m_mtx);
-        if ((int)m_buffer.size() != dstSize ||
-            m_bufWidth != targetWidth ||
-            m_bufHeight != targetHeight) {
-            m_buffer.resize(dstSize);
-            m_bufWidth = targetWidth;
-            m_bufHeight = targetHeight;
-            m_bufStride = dstStride;
+    // 書き込み面のサイズ変更
+    // 書き込み面は描画スレッドだけが触るため排他制御は不要
+    PresentBuffer& dst = m_present[m_writeIndex];
+    if ((int)dst.data.size() != dstSize ||
+        dst.width != targetWidth ||
+        dst.height != targetHeight) {
+        try {
+            dst.data.resize(dstSize);
+        } catch (...) {
+            return;
         }
+        dst.width = targetWidth;
+        dst.height = targetHeight;
+        dst.stride = dstStride;
     }
 
     // パススルー時のウィンドウサイズ強制更新
-    // デッドロック回避のため、ロック外で実行
-    if (cfg.passthrough && hExtWnd) {
+    // ウィンドウはウィンドウスレッドが所有するため、SWP_ASYNCWINDOWPOS で投函のみ行い
+    // 描画スレッドがウィンドウスレッドの応答を待たないようにする
+    if (cfg.passthrough) {
         RECT rc;
         GetWindowRect(hExtWnd, &rc);
         int currentW = rc.right - rc.left;
         int currentH = rc.bottom - rc.top;
         if (currentW != targetWidth || currentH != targetHeight) {
             SetWindowPos(hExtWnd, NULL, 0, 0, targetWidth, targetHeight,
-                SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+                SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_ASYNCWINDOWPOS);
         }
     }
 
-    // リサイズ/コピー処理
+    // リサイズ/コピー処理 (書き込み面へ)
     {
-        std::lock_guard<std::mutex> lock(m_mtx);
-
-        // クロップ範囲の考慮
-        int effectiveSrcW = srcWidth;
-        int effectiveSrcH = srcHeight;
-        if (pSrcRect) {
-            effectiveSrcW = pSrcRect->right - pSrcRect->left;
-            effectiveSrcH = pSrcRect->bottom - pSrcRect->top;
-        }
-
         // 描画サイズとオフセット計算
         int outWidth, outHeight, offsetX, offsetY;
 
         if (cfg.passthrough) {
-            outWidth = effectiveSrcW;
-            outHeight = effectiveSrcH;
+            outWidth = srcWidth;
+            outHeight = srcHeight;
             offsetX = 0;
             offsetY = 0;
         } else {
             LR2BGAImageProc::CalculateResizeDimensions(
-                effectiveSrcW, effectiveSrcH, targetWidth, targetHeight,
+                srcWidth, srcHeight, targetWidth, targetHeight,
                 cfg.keepAspect,
                 outWidth, outHeight, offsetX, offsetY);
         }
 
         // 背景クリア (レターボックス用)
         if (outWidth < targetWidth || outHeight < targetHeight) {
-            memset(m_buffer.data(), 0, m_buffer.size());
+            memset(dst.data.data(), 0, dst.data.size());
         }
 
         // リサイズ実行
-        if (cfg.algo == RESIZE_NEAREST) {
+        if (!IsBilinearAt(cfg, level)) {
             LR2BGAImageProc::ResizeNearestNeighbor(
-                pSrcData, srcWidth, srcHeight, srcStride, srcBitCount,
-                m_buffer.data(), targetWidth, targetHeight, dstStride, 24,
-                outWidth, outHeight, offsetX, offsetY, pSrcRect, m_lutXIndices);
+                frame.data.data(), srcWidth, srcHeight, frame.stride, frame.bitCount,
+                dst.data.data(), targetWidth, targetHeight, dstStride, 24,
+                outWidth, outHeight, offsetX, offsetY, NULL, m_lutXIndices);
         } else {
             LR2BGAImageProc::ResizeBilinear(
-                pSrcData, srcWidth, srcHeight, srcStride, srcBitCount,
-                m_buffer.data(), targetWidth, targetHeight, dstStride, 24,
-                outWidth, outHeight, offsetX, offsetY, pSrcRect, m_lutXIndices, m_lutXWeights);
+                frame.data.data(), srcWidth, srcHeight, frame.stride, frame.bitCount,
+                dst.data.data(), targetWidth, targetHeight, dstStride, 24,
+                outWidth, outHeight, offsetX, offsetY, NULL, m_lutXIndices, m_lutXWeights);
         }
     }
 
-    // ウィンドウ再描画要求
+    // 書き込み面を提示待ちとして公開し、前の提示待ち面を次の書き込み面として受け取る
+    // Paint が前の提示待ち面をまだ取り出していなければ、そのフレームは提示されずに上書きされる
+    const int prev = m_readyState.exchange(m_writeIndex | kPresentFreshBit, std::memory_order_acq_rel);
+    m_writeIndex = prev & kPresentIndexMask;
+    m_lastPresented = key;
+
+    // ウィンドウ再描画要求 (InvalidateRect は他スレッドから呼んでもブロックしない)
     InvalidateRect(hExtWnd, NULL, FALSE);
+
+    QueryPerformanceCounter(&renderEnd);
+    UpdateGovernor(frame, level, renderEnd.QuadPart - renderStart.QuadPart, cfg);
+}
+
+// --------------------------------------------------------------------------------------
+// IsSameFrame / RefreshConfig
+// --------------------------------------------------------------------------------------
+bool LR2BGAExternalRenderer::IsSameFrame(const FrameKey& a, const FrameKey& b)
+{
+    return a.valid && b.valid &&
+           a.hash == b.hash &&
+           a.width == b.width && a.height == b.height && a.bitCount == b.bitCount &&
+           a.presized == b.presized &&
+           a.qualityLevel == b.qualityLevel &&
+           a.cfgVersion == b.cfgVersion;
+}
+
+void LR2BGAExternalRenderer::RefreshConfig(LR2BGASettings::SnapshotReader reader,
+                                           LR2BGASettings::ExtWindowConfig& cfg, unsigned& version)
+{
+    // 設定スナップショットは世代番号と値が対になっているため、ロックなしで比較・コピーできる
+    LR2BGASettings::SnapshotGuard snapshot(m_pSettings, reader);
+    if (snapshot->version == version) return;
+    cfg = snapshot->ext;
+    version = snapshot->version;
+}
+
+// --------------------------------------------------------------------------------------
+// IsBilinearAt / GetSizeAt - 画質レベルを反映した補間方式と内部解像度
+// --------------------------------------------------------------------------------------
+bool LR2BGAExternalRenderer::IsBilinearAt(const LR2BGASettings::ExtWindowConfig& cfg, int level)
+{
+    return cfg.algo != RESIZE_NEAREST && level == QUALITY_FULL;
+}
+
+void LR2BGAExternalRenderer::GetSizeAt(const LR2BGASettings::ExtWindowConfig& cfg, int level, int& width, int& height)
+{
+    width = cfg.width;
+    height = cfg.height;
+    if (level >= QUALITY_HALF) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+}
+
+// --------------------------------------------------------------------------------------
+// UpdateGovernor - 画質ガバナーの更新 (描画スレッド)
+// --------------------------------------------------------------------------------------
+// 1フレームあたりのコスト = ストリーミングスレッド側のコスト + 描画スレッドでのリサイズ・提示
+// 予算 = 投函間隔の平均 × kGovernorBudgetRatio
+// コストが予算を kGovernorDownFrames フレーム続けて超えたら1段階下げ、
+// 予算の kGovernorRecoverRatio 未満が m_holdMs 続いたら1段階戻します。
+// 戻した直後に再び下げた場合は m_holdMs を倍にし、段階の往復 (ちらつき) を抑えます。
+void LR2BGAExternalRenderer::UpdateGovernor(const FrameSlot& frame, int usedLevel, LONGLONG renderQpc,
+                                            const LR2BGASettings::ExtWindowConfig& cfg)
+{
+    const double costMs = (double)(frame.streamCostQpc + renderQpc) * 1000.0 / m_qpcFreq;
+    const double intervalMs = (double)frame.postIntervalQpc * 1000.0 / m_qpcFreq;
+
+    if (intervalMs > 0.0 && intervalMs <= kGovernorMaxIntervalMs) {
+        m_intervalEmaMs = (m_intervalEmaMs < 0.0) ? intervalMs
+            : m_intervalEmaMs + (intervalMs - m_intervalEmaMs) * kGovernorCostAlpha;
+    }
+
+    int level = m_qualityLevel.load(std::memory_order_relaxed);
+    if (!cfg.adaptiveQuality || cfg.passthrough) {
+        // 無効時は常に設定どおりの画質
+        if (level != QUALITY_FULL) {
+            m_qualityLevel.store(QUALITY_FULL, std::memory_order_relaxed);
+            m_costEmaMs = -1.0;
+        }
+        m_overBudgetCount = 0;
+        m_holdMs = kGovernorHoldMs;
+        m_costUs.store((int)(costMs * 1000.0), std::memory_order_relaxed);
+        return;
+    }
+
+    // 切り替え前のレベルで生成されたフレームは計測に含めない
+    if (usedLevel != level) return;
+
+    m_costEmaMs = (m_costEmaMs < 0.0) ? costMs : m_costEmaMs + (costMs - m_costEmaMs) * kGovernorCostAlpha;
+    m_costUs.store((int)(m_costEmaMs * 1000.0), std::memory_order_relaxed);
+    if (m_intervalEmaMs <= 0.0) return;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    const double sinceChangeMs = (double)(now.QuadPart - m_levelChangedQpc) * 1000.0 / m_qpcFreq;
+    const double budgetMs = m_intervalEmaMs * kGovernorBudgetRatio;
+
+    // 設定が最近傍の場合、QUALITY_NEAREST は QUALITY_FULL と同じ処理になるため飛ばす
+    const bool skipNearest = (cfg.algo == RESIZE_NEAREST);
+    int newLevel = level;
+
+    if (m_costEmaMs > budgetMs) {
+        if (++m_overBudgetCount >= kGovernorDownFrames && level < QUALITY_HALF) {
+            newLevel = (level == QUALITY_FULL && !skipNearest) ? QUALITY_NEAREST : QUALITY_HALF;
+            // 戻した直後に再び超過した場合は、次に戻すまでの待機を延ばす
+            if (m_lastChangeWasUp && sinceChangeMs < m_holdMs) {
+                m_holdMs = (m_holdMs * 2 < kGovernorMaxHoldMs) ? m_holdMs * 2 : kGovernorMaxHoldMs;
+            }
+            m_lastChangeWasUp = false;
+        }
+    } else {
+        m_overBudgetCount = 0;
+        if (level > QUALITY_FULL && sinceChangeMs >= m_holdMs &&
+            m_costEmaMs < budgetMs * kGovernorRecoverRatio) {
+            newLevel = (level == QUALITY_HALF && !skipNearest) ? QUALITY_NEAREST : QUALITY_FULL;
+            m_lastChangeWasUp = true;
+        } else if (m_lastChangeWasUp && sinceChangeMs >= kGovernorMaxHoldMs) {
+            // 戻した後に十分安定していれば待機時間を初期値へ戻す
+            m_holdMs = kGovernorHoldMs;
+        }
+    }
+
+    if (newLevel != level) {
+        m_qualityLevel.store(newLevel, std::memory_order_relaxed);
+        m_levelChangedQpc = now.QuadPart;
+        m_overBudgetCount = 0;
+        m_costEmaMs = -1.0;
+    }
 }
 
 // --------------------------------------------------------------------------------------
@@ -188,13 +644,20 @@ void LR2BGAExternalRenderer::UpdateWindowPos(HWND hExtWnd, HWND hOverlayWnd)
 // --------------------------------------------------------------------------------------
 void LR2BGAExternalRenderer::Paint(HDC hdc, HWND hwnd)
 {
-    std::lock_guard<std::mutex> lock(m_mtx);
+    // 新しいフレームが提示待ちなら、提示中の面と交換して取り出す
+    // 新しいフレームが無ければ現在の提示面をそのまま再描画する (ウィンドウ移動・露出時など)
+    if (m_readyState.load(std::memory_order_acquire) & kPresentFreshBit) {
+        const int ready = m_readyState.exchange(m_displayIndex, std::memory_order_acq_rel);
+        m_displayIndex = ready & kPresentIndexMask;
+    }
 
-    if (m_buffer.size() > 0 && m_bufWidth > 0 && m_bufHeight > 0) {
+    const PresentBuffer& buf = m_present[m_displayIndex];
+
+    if (buf.data.size() > 0 && buf.width > 0 && buf.height > 0) {
         BITMAPINFO bmi = {0};
         bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-        bmi.bmiHeader.biWidth = m_bufWidth;
-        bmi.bmiHeader.biHeight = m_bufHeight;
+        bmi.bmiHeader.biWidth = buf.width;
+        bmi.bmiHeader.biHeight = buf.height;
         bmi.bmiHeader.biPlanes = 1;
         bmi.bmiHeader.biBitCount = 24;
         bmi.bmiHeader.biCompression = BI_RGB;
@@ -203,8 +666,8 @@ void LR2BGAExternalRenderer::Paint(HDC hdc, HWND hwnd)
         GetClientRect(hwnd, &rect);
         SetStretchBltMode(hdc, COLORONCOLOR);
         StretchDIBits(hdc, 0, 0, rect.right, rect.bottom,
-            0, 0, m_bufWidth, m_bufHeight,
-            m_buffer.data(), &bmi, DIB_RGB_COLORS, SRCCOPY);
+            0, 0, buf.width, buf.height,
+            buf.data.data(), &bmi, DIB_RGB_COLORS, SRCCOPY);
     } else {
         // バッファがまだ無い場合は黒背景
         RECT rect;
@@ -218,11 +681,17 @@ void LR2BGAExternalRenderer::Paint(HDC hdc, HWND hwnd)
 // --------------------------------------------------------------------------------------
 void LR2BGAExternalRenderer::ClearBuffer()
 {
-    std::lock_guard<std::mutex> lock(m_mtx);
-    m_buffer.clear();
-    m_bufWidth = 0;
-    m_bufHeight = 0;
-    m_bufStride = 0;
+    // 描画スレッド停止後にのみ呼ばれるため、全面を直接初期化する
+    for (int i = 0; i < kPresentBufferCount; ++i) {
+        m_present[i].data.clear();
+        m_present[i].width = 0;
+        m_present[i].height = 0;
+        m_present[i].stride = 0;
+    }
+    m_writeIndex = 0;
+    m_readyState = 1;
+    m_displayIndex = 2;
+    m_lastPresented = FrameKey();
     m_lutXIndices.clear();
     m_lutXWeights.clear();
 }
@@ -12,16 +12,49 @@
 //   2. リサイズ処理: LR2BGAImageProc を使用した画像変換
 //   3. GDI描画: StretchDIBits を使用したウィンドウ描画
 //   4. オーバーレイ更新: 輝度調整用半透明レイヤーの制御
+//   5. 描画スレッド: 最新フレームのメールボックスを監視し、リサイズと再描画要求を行う
+//
+// スレッドモデル:
+//   - ストリーミングスレッド (Transform) は UpdateFrame でクロップ範囲の行をコピーし、
+//     1スロットのメールボックスへ差し替えるだけで即座に戻ります。
+//   - 描画スレッドがメールボックスから最新フレームを取り出してリサイズ・提示します。
+//     描画が追いつかない場合、未処理のフレームは新しいフレームで上書きされ破棄されます。
+//   - これにより外部ウィンドウの処理コストが LR2 向け出力のレイテンシに加算されません。
+//   - 描画スレッドと WM_PAINT (ウィンドウスレッド) の間はトリプルバッファで受け渡します。
+//     書き込み中/提示待ち/提示中の3面をアトミックな交換で回すため、
+//     リサイズ中に Paint が待つことも、StretchDIBits 中に描画スレッドが待つこともありません。
+//
+// 更新レートと画質の制御:
+//   - IsFrameDue は外部ウィンドウ専用の上限FPS (m_extWindowMaxFPS) で投函を間引きます。
+//     LR2 向けの FPS 制限 (WaitFPSLimit) とは独立しており、互いに影響しません。
+//   - 描画スレッドは1フレームあたりの外部ウィンドウ処理コストを計測し (ガバナー)、
+//     投函間隔に対する予算を超え続けると 設定の補間 -> 最近傍 -> 半分の内部解像度 と段階的に
+//     画質を下げます。縮小解像度の面は Paint の StretchDIBits でウィンドウサイズへ拡大されます。
+//     コストが十分下がった状態が続けば1段階ずつ戻します。
+//   - 画質の切り替えは外部ウィンドウ用フレームにのみ適用され、LR2 向け出力は変わりません。
+//
+// 不要な処理の省略:
+//   - ウィンドウスレッドが可視状態 (SetVisible) を通知します。最小化・非表示・画面外、
+//     および設定時は他のウィンドウに完全に覆われている間、IsFrameDue は false を返し、
+//     コピー・リサイズ・提示をすべて止めます。再び見えるようになると次の入力フレームから再開します。
+//   - 描画スレッドはフレームのハッシュを取り、直前に提示したフレームと画素・設定・画質レベルが
+//     同じなら、リサイズと提示を省略します (静止画BGAや入力より低いフレームレートの動画)。
+//   - 設定はフレームごとにロックせず、設定の世代番号が変わったときだけスナップショットを取り直します。
 //
 // 注意:
 //   このクラスは HWND を所有しません。ウィンドウ生成・破棄は LR2BGAWindow が担当します。
+//   ロックは m_mtxMailbox のみで、描画バッファの受け渡しはロックフリーです。
 // --------------------------------------------------------------------------------------
 #pragma once
 
 #include <windows.h>
 #include <vector>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
 #include "LR2BGASettings.h"
+#include "LR2BGAImageProc.h"
 
 // --------------------------------------------------------------------------------------
 // LR2BGAExternalRenderer クラス
@@ -34,11 +67,54 @@ public:
     // --------------------------------------------------------------------------
     // フレーム更新
     // --------------------------------------------------------------------------
-    // ソースフレームをリサイズしてバッファに格納
+    // ソースフレーム (クロップ範囲) をメールボックスへ投函 (ストリーミングスレッドから呼び出し)
+    // リサイズは描画スレッドで行われるため、行コピーのみで即座に戻ります
     void UpdateFrame(const BYTE* pSrcData, int srcWidth, int srcHeight,
                      int srcStride, int srcBitCount, const RECT* pSrcRect,
                      HWND hExtWnd);
 
+    // リサイズ済みフレームの投函 (ストリーミングスレッドから呼び出し)
+    // LR2 向けのリサイズと同じソース走査で外部ウィンドウ用フレームを生成するため、
+    // 投函スロットを出力先とする ResizeTarget を返す (黒帯部分は黒で初期化済み)
+    // パススルー設定時や描画スレッド停止中は false を返し、呼び出し側は UpdateFrame を使う
+    bool BeginPresizedFrame(HWND hExtWnd, int cropWidth, int cropHeight,
+                            LR2BGAImageProc::ResizeTarget& target);
+    // BeginPresizedFrame で確保したスロットへの書き込み完了後に呼び出し、メールボックスへ投函する
+    // resizeQpc: ResizeMulti を含む出力生成の所要時間 (QPCカウント)
+    // sharedPixels: 同じ走査で生成した他の出力 (LR2向け) の画素数。画素数の比でコストを按分する
+    void CommitPresizedFrame(LONGLONG resizeQpc, int sharedPixels);
+
+    // 外部ウィンドウ専用の上限FPSに対して、このフレームを投函すべきか判定する (ストリーミングスレッド)
+    // true を返した場合は投函枠を消費したものとして扱い、次の投函予定時刻を進める
+    bool IsFrameDue(HWND hExtWnd);
+
+    // 外部ウィンドウが実際に見えているかを通知 (ウィンドウスレッドから呼び出し)
+    // false の間は IsFrameDue が false を返し、外部ウィンドウ向けの処理を一切行わない
+    void SetVisible(bool visible) { m_bVisible.store(visible, std::memory_order_relaxed); }
+    bool IsVisible() const { return m_bVisible.load(std::memory_order_relaxed); }
+
+    // 直前と同一のため描画を省略したフレーム数 (デバッグ表示用)
+    long long GetDuplicateCount() const { return m_duplicateCount.load(std::memory_order_relaxed); }
+
+    // --------------------------------------------------------------------------
+    // 画質ガバナー
+    // --------------------------------------------------------------------------
+    enum QualityLevel {
+        QUALITY_FULL = 0,       // 設定どおりの補間・解像度
+        QUALITY_NEAREST = 1,    // 最近傍補間に切り替え
+        QUALITY_HALF = 2,       // 最近傍補間 + 縦横半分の内部解像度
+    };
+    // 現在の画質レベルと1フレームあたりの処理コスト (デバッグ表示用)
+    int GetQualityLevel() const { return m_qualityLevel.load(std::memory_order_relaxed); }
+    double GetFrameCostMs() const { return m_costUs.load(std::memory_order_relaxed) / 1000.0; }
+
+    // --------------------------------------------------------------------------
+    // 描画スレッド制御
+    // --------------------------------------------------------------------------
+    // 外部ウィンドウ作成後に開始し、メッセージループ終了後に停止する
+    void StartRenderThread(HWND hExtWnd);
+    void StopRenderThread();
+
     // --------------------------------------------------------------------------
     // オーバーレイ・位置更新
     // --------------------------------------------------------------------------
@@ -56,19 +132,130 @@ public:
     // --------------------------------------------------------------------------
     // バッファクリア
     // --------------------------------------------------------------------------
+    // 描画スレッド停止後、かつウィンドウ破棄後にのみ呼び出すこと
     void ClearBuffer();
 
 private:
+    // メールボックスで受け渡すフレーム (クロップ済み、ボトムアップDIBの行順を維持)
+    struct FrameSlot {
+        std::vector<BYTE> data;
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+        int bitCount = 0;
+        bool presized = false;  // true: 外部ウィンドウのサイズへリサイズ済み (RGB24)
+        int qualityLevel = QUALITY_FULL;    // リサイズ済みフレームの生成に使った画質レベル
+        LONGLONG streamCostQpc = 0;         // ストリーミングスレッド側で要したコスト (行コピー/按分したリサイズ)
+        LONGLONG postIntervalQpc = 0;       // 前回の投函からの間隔 (ガバナーの予算算出用)
+    };
+
+    // 提示したフレームの識別情報 (重複フレーム判定用)
+    // 画素が同じでも、設定や画質レベルが変われば提示内容が変わるため別フレームとして扱う
+    struct FrameKey {
+        UINT64 hash = 0;
+        int width = 0;
+        int height = 0;
+        int bitCount = 0;
+        bool presized = false;
+        int qualityLevel = QUALITY_FULL;
+        unsigned cfgVersion = 0;
+        bool valid = false;
+    };
+    static bool IsSameFrame(const FrameKey& a, const FrameKey& b);
+
+    // 設定の世代が変わっていればスナップショットを取り直す (呼び出し元スレッド専用のコピーを更新)
+    // reader: 呼び出し元スレッドの読み取り枠 (設定スナップショットの回収に使う)
+    void RefreshConfig(LR2BGASettings::SnapshotReader reader,
+                       LR2BGASettings::ExtWindowConfig& cfg, unsigned& version);
+
+    // 画質レベルを反映した外部ウィンドウ用の補間方式と内部解像度
+    static bool IsBilinearAt(const LR2BGASettings::ExtWindowConfig& cfg, int level);
+    static void GetSizeAt(const LR2BGASettings::ExtWindowConfig& cfg, int level, int& width, int& height);
+    // 描画1回分のコストからガバナーの状態を更新 (描画スレッド)
+    void UpdateGovernor(const FrameSlot& frame, int usedLevel, LONGLONG renderQpc,
+                        const LR2BGASettings::ExtWindowConfig& cfg);
+
+    // m_staging をメールボックスへ差し替えて描画スレッドへ通知
+    void PostStagingFrame();
+    // 描画スレッド本体
+    void RenderThread();
+    // フレームをリサイズして描画バッファに格納し、再描画を要求
+    // リサイズ済みフレームはバッファの交換のみで描画バッファへ移す
+    void RenderFrame(FrameSlot& frame, HWND hExtWnd);
+
     LR2BGASettings* m_pSettings;
 
-    // 描画バッファ
-    std::vector<BYTE> m_buffer;
-    int m_bufWidth;
-    int m_bufHeight;
-    int m_bufStride;
-    std::mutex m_mtx;
+    // 最新フレームのメールボックス (1スロット)
+    // m_staging: ストリーミングスレッド専用の書き込み先 (ロック不要)
+    // m_mailbox: 受け渡し用スロット (m_mtxMailbox で保護)
+    // m_renderSrc: 描画スレッド専用の読み出し元 (ロック不要)
+    // いずれもスワップで受け渡すため、定常状態ではメモリ確保が発生しません
+    FrameSlot m_staging;
+    FrameSlot m_mailbox;
+    FrameSlot m_renderSrc;
+    LR2BGAImageProc::ResizeCache m_stagingCache;    // リサイズ済み投函用 (ストリーミングスレッド専用)
+    bool m_bMailboxPending;             // 未処理フレームあり (m_mtxMailbox で保護)
+    bool m_bRenderStop;                 // 描画スレッド停止要求 (m_mtxMailbox で保護)
+    std::mutex m_mtxMailbox;
+    std::condition_variable m_cvMailbox;
+    std::thread m_threadRender;
+    std::atomic<HWND> m_hRenderWnd;     // 描画対象ウィンドウ (描画スレッド稼働中のみ非NULL)
+
+    LONGLONG m_qpcFreq;
+
+    // 設定のスナップショット (スレッドごとに保持し、設定の世代が変わったときだけ取り直す)
+    LR2BGASettings::ExtWindowConfig m_streamCfg;    // ストリーミングスレッド専用
+    unsigned m_streamCfgVersion;
+    LR2BGASettings::ExtWindowConfig m_renderCfg;    // 描画スレッド専用
+    unsigned m_renderCfgVersion;
+
+    // 可視状態 (ウィンドウスレッドが更新し、ストリーミングスレッドが参照する)
+    std::atomic<bool> m_bVisible;
+
+    // 重複フレーム判定 (描画スレッド専用)
+    FrameKey m_lastPresented;
+    std::atomic<long long> m_duplicateCount;
+
+    // 上限FPSによる間引き (ストリーミングスレッド専用)
+    LONGLONG m_nextDueQpc;              // 次に投函を受け付ける時刻 (0: 未設定)
+    LONGLONG m_lastPostQpc;             // 前回投函した時刻
+
+    // 画質ガバナー
+    // m_qualityLevel は描画スレッドのみが更新し、ストリーミングスレッド (BeginPresizedFrame) が参照する
+    static constexpr double kGovernorBudgetRatio = 0.5;    // 投函間隔のうち外部ウィンドウに割ける割合
+    static constexpr double kGovernorRecoverRatio = 0.25;  // 予算のこの割合を下回り続けたら1段階戻す
+    static constexpr double kGovernorCostAlpha = 0.1;      // コスト/間隔の指数移動平均の係数
+    static constexpr int kGovernorDownFrames = 8;          // 予算超過がこのフレーム数続いたら1段階下げる
+    static constexpr int kGovernorHoldMs = 3000;           // 段階を変えてから戻すまでの最短時間
+    static constexpr int kGovernorMaxHoldMs = 30000;       // 戻した直後に再び下げた場合の待機時間の上限
+    static constexpr double kGovernorMaxIntervalMs = 100.0; // これより長い投函間隔 (一時停止など) は平均に含めない
+    std::atomic<int> m_qualityLevel;
+    std::atomic<int> m_costUs;          // コストの移動平均 (マイクロ秒, デバッグ表示用)
+    double m_costEmaMs;                 // 以下は描画スレッド専用 (負値: 未計測)
+    double m_intervalEmaMs;
+    int m_overBudgetCount;
+    LONGLONG m_levelChangedQpc;
+    int m_holdMs;                       // 現在の復帰待機時間 (段階の往復が続くと延長する)
+    bool m_lastChangeWasUp;
+
+    // 描画バッファ (トリプルバッファ, RGB24 ボトムアップDIB)
+    // 各面は自身のサイズを保持するため、サイズ変更時も他の面に影響しません
+    struct PresentBuffer {
+        std::vector<BYTE> data;
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+    };
+    static constexpr int kPresentBufferCount = 3;
+    static constexpr int kPresentIndexMask = 0x3;
+    static constexpr int kPresentFreshBit = 0x4;    // 提示待ち面が未提示の新しいフレームであることを示す
+
+    PresentBuffer m_present[kPresentBufferCount];
+    int m_writeIndex;                   // 書き込み中の面 (描画スレッド専用)
+    int m_displayIndex;                 // 提示中の面 (ウィンドウスレッド専用)
+    std::atomic<int> m_readyState;      // 提示待ちの面のインデックス | kPresentFreshBit
 
-    // リサイズ用LUT (キャッシュ)
+    // リサイズ用LUT (キャッシュ, 描画スレッド専用)
     std::vector<int> m_lutXIndices;
     std::vector<short> m_lutXWeights;
 };
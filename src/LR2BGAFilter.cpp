@@ -18,6 +18,15 @@
 //------------------------------------------------------------------------------
 constexpr DWORD kLetterboxCheckIntervalMs = 200;  // 黒帯検出の頻度制限 (ms)
 constexpr DWORD kMaxSleepMs = 1000;               // FPS制限用Sleep上限 (ms)
+constexpr int kMinOutputBuffers = 1;              // LR2向け出力バッファ数の下限 (従来の同期動作)
+constexpr int kMaxOutputBuffers = 4;              // LR2向け出力バッファ数の上限
+constexpr LONG kInputBufferAlign = 64;            // 入力サンプル先頭の境界 (キャッシュライン / AVX-512幅)
+constexpr LONG kInputBufferTailPad = 64;          // 最終行を SIMD 幅で読み越しても範囲内に収めるための余白
+constexpr ULONGLONG kQualityNotifyIntervalMs = 1000; // 上流への品質メッセージの再送間隔 (同じ要求の維持)
+constexpr int kQualityProportionHysteresis = 50;  // Proportion がこれ以上変わったら間隔を待たずに送る
+constexpr REFERENCE_TIME kQualityFamineLate = 1000000; // 100ms以上の遅れで Famine (上流のデコードが追いつかない)
+constexpr REFERENCE_TIME kQualityFamineMaxLate = 10000000; // 1秒以上の遅れは一時停止などによるタイムラインのずれとみなす
+constexpr int kQualityMinProportion = 500;        // Famine で要求する下限 (baseclasses のレンダラと同じ)
 
 namespace {
 std::wstring GuidToString(const GUID& guid) {
@@ -295,12 +304,21 @@ CLR2BGAFilter::CLR2BGAFilter(LPUNKNOWN pUnk, HRESULT *phr)
       m_inputWidth(0), m_inputHeight(0), m_inputBitCount(0),
       // ラッチ設定初期化
       m_activePassthrough(false), m_activeDummy(false),
-      m_activeWidth(0), m_activeHeight(0),
+      m_activeWidth(0), m_activeHeight(0), m_activePipelined(false),
+      m_activeInPlace(false), m_receiveEnterQpc(0), m_inPlaceFrameCount(0),
+      m_upstreamRateReduced(false),
+      m_dummyStreamEnded(false),
+      m_pFrameSettings(NULL),
       // 統計情報初期化
       m_frameCount(0), m_processedFrameCount(0), m_inputFrameCount(0),
       m_totalProcessTime(0), m_avgProcessTime(0.0),
-      m_frameRate(0.0), m_outputFrameRate(0.0), m_qpcFrequency({0}),
-      m_pMemoryMonitor(std::make_unique<LR2MemoryMonitor>())
+      m_frameRate(0.0), m_qpcFrequency({0}),
+      m_lastDebugPublishQpc(0), m_lastSharedStatsPublishQpc(0),
+      m_pMemoryMonitor(std::make_unique<LR2MemoryMonitor>()),
+      m_avgTimePerFrame(0),
+      m_streamAutoRemoveLetterbox(false),
+      m_streamLbThreshold(0),
+      m_cacheStorePending(false)
 {
   QueryPerformanceFrequency(&m_qpcFrequency);
 
@@ -371,6 +389,9 @@ STDMETHODIMP CLR2BGAFilter::NonDelegatingQueryInterface(REFIID riid,
   if (riid == IID_ILR2BGAFilterSettings) {
     return GetInterface((ILR2BGAFilterSettings *)this, ppv);
   }
+  if (riid == IID_ILR2BGAFilterStats) {
+    return GetInterface((ILR2BGAFilterStats *)this, ppv);
+  }
 
   return CTransformFilter::NonDelegatingQueryInterface(riid, ppv);
 }
@@ -820,10 +841,8 @@ STDMETHODIMP CLR2BGAFilter::SetLetterboxThreshold(int threshold) {
   m_pSettings->Lock();
   m_pSettings->m_lbThreshold = threshold;
   m_pSettings->Unlock();
+  // 検出器へはストリーミングスレッドが次のフレームで設定スナップショットから反映する
   m_pSettings->Save();
-
-  // 検出器の設定を更新
-  m_pTransformLogic->GetDetector().SetParams(threshold, m_pSettings->m_lbStability);
   return S_OK;
 }
 
@@ -839,18 +858,55 @@ STDMETHODIMP CLR2BGAFilter::SetLetterboxStability(int stability) {
   m_pSettings->Lock();
   m_pSettings->m_lbStability = stability;
   m_pSettings->Unlock();
+  // 検出器へはストリーミングスレッドが次のフレームで設定スナップショットから反映する
   m_pSettings->Save();
-
-  // 検出器の設定を更新
-  m_pTransformLogic->GetDetector().SetParams(m_pSettings->m_lbThreshold, stability);
   return S_OK;
 }
 
 STDMETHODIMP CLR2BGAFilter::ResetPerformanceStatistics() {
   m_pTransformLogic->ResetStatistics();
+  if (m_pOutput) {
+    static_cast<CLR2BGAOutputPin *>(m_pOutput)->RequestStatisticsReset();
+  }
+  return S_OK;
+}
+
+//------------------------------------------------------------------------------
+// ILR2BGAFilterStats 実装 (LR2BGAStageStats へ委譲)
+//------------------------------------------------------------------------------
+STDMETHODIMP CLR2BGAFilter::GetStageLatency(int stage, LR2BGAStageLatency *pLatency) {
+  CheckPointer(pLatency, E_POINTER);
+  if (stage < 0 || stage >= STAGE_COUNT) {
+    return E_INVALIDARG;
+  }
+  m_pTransformLogic->GetStageStats().GetStageLatency((LR2BGAStage)stage, *pLatency);
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAFilter::GetOutputFrameRate(double *pFps) {
+  CheckPointer(pFps, E_POINTER);
+  *pFps = m_pTransformLogic->GetStageStats().GetOutputFrameRate();
   return S_OK;
 }
 
+STDMETHODIMP CLR2BGAFilter::ResetStatistics() {
+  return ResetPerformanceStatistics();
+}
+
+STDMETHODIMP CLR2BGAFilter::SaveTrace(LPCWSTR pszPath) {
+  wchar_t defaultPath[MAX_PATH];
+  if (!pszPath) {
+    LR2BGATrace::MakeDefaultPath(defaultPath, MAX_PATH);
+    pszPath = defaultPath;
+  }
+  HRESULT hr = LR2BGATrace::Instance().SaveToFile(pszPath);
+
+  wchar_t msg[MAX_PATH + 64];
+  swprintf_s(msg, L"[LR2BGAFilter] SaveTrace: %s hr=0x%08lX\n", pszPath, (unsigned long)hr);
+  OutputDebugStringW(msg);
+  return hr;
+}
+
 //------------------------------------------------------------------------------
 // GetPin - カスタムピン名を使用するためのオーバーライド ("In"/"Out")
 //------------------------------------------------------------------------------
@@ -914,6 +970,136 @@ HRESULT CLR2BGAInputPin::CheckConnect(IPin *pPin) {
   return S_OK;
 }
 
+//------------------------------------------------------------------------------
+// CLR2BGAInputAllocator::SetProperties
+// 上流の要求を満たしたまま、境界と余白だけを広げて CMemAllocator へ渡す。
+//   - cbAlign は 64 以上に引き上げる (より大きな2の冪の要求はそのまま)
+//   - CMemAllocator はプレフィックスを含めた位置を境界に揃えるため、
+//     プレフィックスを境界の倍数に切り上げてデータ先頭も境界に揃える
+//   - cbBuffer に読み越し用の余白を足す (上流は要求以上のサイズを受け入れる)
+//------------------------------------------------------------------------------
+STDMETHODIMP CLR2BGAInputAllocator::SetProperties(ALLOCATOR_PROPERTIES *pRequest,
+                                                  ALLOCATOR_PROPERTIES *pActual) {
+  CheckPointer(pRequest, E_POINTER);
+
+  ALLOCATOR_PROPERTIES request = *pRequest;
+  if (request.cbAlign < kInputBufferAlign || (request.cbAlign & (request.cbAlign - 1)) != 0) {
+    request.cbAlign = kInputBufferAlign;
+  }
+  if (request.cbPrefix < 0) request.cbPrefix = 0;
+  request.cbPrefix = (request.cbPrefix + request.cbAlign - 1) & ~(request.cbAlign - 1);
+  if (request.cbBuffer > 0) {
+    request.cbBuffer += kInputBufferTailPad;
+  }
+  return CMemAllocator::SetProperties(&request, pActual);
+}
+
+//------------------------------------------------------------------------------
+// CLR2BGAInputPin - 入力アロケータ (Input Allocator)
+//
+// 上流の出力ピンは DecideAllocator で、まず入力ピンの GetAllocator を試し、
+// 使えなければ自前のアロケータを使う。どちらを採用したかは NotifyAllocator で通知される。
+// 上流が自前のアロケータを使う場合でも、GetAllocatorRequirements で境界を要求しておく。
+//------------------------------------------------------------------------------
+CLR2BGAInputPin::CLR2BGAInputPin(TCHAR *pObjectName, CTransformFilter *pTransformFilter,
+                                 HRESULT *phr, LPCWSTR pName)
+    : CTransformInputPin(pObjectName, pTransformFilter, phr, pName),
+      m_pOwnAllocator(NULL), m_bOwnAllocatorInUse(false), m_allocProps(),
+      m_alignedSamples(0), m_totalSamples(0), m_bStrideAligned(false) {}
+
+CLR2BGAInputPin::~CLR2BGAInputPin() {
+  if (m_pOwnAllocator) {
+    m_pOwnAllocator->Release();
+    m_pOwnAllocator = NULL;
+  }
+}
+
+STDMETHODIMP CLR2BGAInputPin::GetAllocator(IMemAllocator **ppAllocator) {
+  CheckPointer(ppAllocator, E_POINTER);
+  CAutoLock lock(m_pLock);
+
+  if (m_pAllocator == NULL) {
+    if (m_pOwnAllocator == NULL) {
+      HRESULT hr = S_OK;
+      CLR2BGAInputAllocator *pAlloc = NULL;
+      try {
+        pAlloc = new CLR2BGAInputAllocator(&hr);
+      } catch (const std::bad_alloc &) {
+        pAlloc = NULL;
+        hr = E_OUTOFMEMORY;
+      }
+      if (FAILED(hr) || pAlloc == NULL) {
+        // 自前のアロケータを用意できない場合は既定の CMemAllocator を提案する
+        delete pAlloc;
+        return CTransformInputPin::GetAllocator(ppAllocator);
+      }
+      pAlloc->AddRef();
+      m_pOwnAllocator = pAlloc;
+    }
+    m_pAllocator = m_pOwnAllocator;
+    m_pAllocator->AddRef();
+  }
+
+  *ppAllocator = m_pAllocator;
+  m_pAllocator->AddRef();
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAInputPin::NotifyAllocator(IMemAllocator *pAllocator, BOOL bReadOnly) {
+  HRESULT hr = CTransformInputPin::NotifyAllocator(pAllocator, bReadOnly);
+  if (FAILED(hr)) return hr;
+
+  CAutoLock lock(m_pLock);
+  m_bOwnAllocatorInUse =
+      (m_pOwnAllocator != NULL && pAllocator == static_cast<IMemAllocator *>(m_pOwnAllocator));
+  ZeroMemory(&m_allocProps, sizeof(m_allocProps));
+  pAllocator->GetProperties(&m_allocProps);
+  m_alignedSamples = 0;
+  m_totalSamples = 0;
+
+  CLR2BGAFilter *pFilter = static_cast<CLR2BGAFilter *>(m_pTransformFilter);
+  if (pFilter->m_pSettings && pFilter->m_pSettings->m_debugMode) {
+    wchar_t msg[256];
+    swprintf_s(msg, L"[LR2BGAFilter] NotifyAllocator: %s cBuffers=%ld cbBuffer=%ld cbAlign=%ld cbPrefix=%ld readOnly=%d\n",
+               m_bOwnAllocatorInUse ? L"filter-provided" : L"upstream",
+               m_allocProps.cBuffers, m_allocProps.cbBuffer, m_allocProps.cbAlign,
+               m_allocProps.cbPrefix, bReadOnly ? 1 : 0);
+    OutputDebugStringW(msg);
+  }
+  return hr;
+}
+
+STDMETHODIMP CLR2BGAInputPin::GetAllocatorRequirements(ALLOCATOR_PROPERTIES *pProps) {
+  CheckPointer(pProps, E_POINTER);
+  // 枚数とサイズは上流に任せ、境界のみ要求する
+  ZeroMemory(pProps, sizeof(ALLOCATOR_PROPERTIES));
+  pProps->cbAlign = kInputBufferAlign;
+  return S_OK;
+}
+
+void CLR2BGAInputPin::RecordSampleAlignment(const BYTE *pData, int stride) {
+  m_totalSamples++;
+  if ((reinterpret_cast<UINT_PTR>(pData) & (kInputBufferAlign - 1)) == 0) {
+    m_alignedSamples++;
+  }
+  m_bStrideAligned = (stride % kInputBufferAlign) == 0;
+}
+
+void CLR2BGAInputPin::GetAllocatorInfo(InputAllocatorInfo &info) {
+  // m_pLock (フィルタロック) は取らない。ストリーミングスレッドは m_csReceive を保持しており、
+  // Stop は m_csFilter -> m_csReceive の順に取るため、ここで取るとデッドロックする。
+  // アロケータ情報は接続時 (ストリーミング停止中) にのみ更新される。
+  info.connected = (m_pAllocator != NULL);
+  info.ownAllocator = m_bOwnAllocatorInUse;
+  info.cBuffers = m_allocProps.cBuffers;
+  info.cbBuffer = m_allocProps.cbBuffer;
+  info.cbAlign = m_allocProps.cbAlign;
+  info.cbPrefix = m_allocProps.cbPrefix;
+  info.alignedSamples = m_alignedSamples;
+  info.totalSamples = m_totalSamples;
+  info.strideAligned = m_bStrideAligned;
+}
+
 //------------------------------------------------------------------------------
 // CLR2BGAOutputPin::CheckConnect
 // 接続先フィルタの検証 (プロセス名チェック、レンダラーチェック)
@@ -1040,6 +1226,146 @@ HRESULT CLR2BGAOutputPin::CheckConnect(IPin *pPin) {
   return S_OK;
 }
 
+//------------------------------------------------------------------------------
+// CLR2BGAOutputPin - パイプライン受け渡し (Pipelined Delivery)
+//
+// 同期モード (既定):
+//   Transform と同じストリーミングスレッドで LR2 の Receive を呼ぶ。
+//   出力バッファが1枚の場合、LR2 がサンプルを返すまで次フレームの変換を開始できない。
+// パイプラインモード:
+//   COutputQueue の専用スレッドが LR2 へ受け渡し、ストリーミングスレッドは
+//   すぐに次フレームの変換へ進む。同時に処理できるフレーム数は出力バッファ数で決まり、
+//   全バッファが下流に保持されている間は出力アロケータの GetBuffer で待機する (統計の Buffer Wait)。
+//
+// スレッド:
+//   m_pQueue の生成/破棄は Active/Inactive (ストリーミング停止中) に限定し、
+//   Deliver 系と統計の更新はストリーミングスレッドからのみ行う。
+//------------------------------------------------------------------------------
+CLR2BGAOutputPin::CLR2BGAOutputPin(TCHAR *pObjectName, CTransformFilter *pTransformFilter,
+                                   HRESULT *phr, LPCWSTR pName)
+    : CTransformOutputPin(pObjectName, pTransformFilter, phr, pName),
+      m_pQueue(NULL), m_actualBufferCount(0), m_stats(), m_bResetRequested(false) {}
+
+CLR2BGAOutputPin::~CLR2BGAOutputPin() {
+  delete m_pQueue;
+}
+
+HRESULT CLR2BGAOutputPin::Active() {
+  HRESULT hr = CTransformOutputPin::Active();
+  if (FAILED(hr)) return hr;
+
+  m_stats = DeliveryStats();
+  m_bResetRequested = false;
+
+  CLR2BGAFilter *pFilter = static_cast<CLR2BGAFilter *>(m_pTransformFilter);
+  if (pFilter->m_activePipelined && m_Connected && !m_pQueue) {
+    HRESULT hrQueue = S_OK;
+    try {
+      m_pQueue = new CLR2BGAOutputQueue(m_Connected, &hrQueue);
+    } catch (const std::bad_alloc &) {
+      m_pQueue = NULL;
+      hrQueue = E_OUTOFMEMORY;
+    }
+    if (FAILED(hrQueue)) {
+      // キューを用意できなくても再生は継続できるため、同期受け渡しに戻す
+      delete m_pQueue;
+      m_pQueue = NULL;
+      OutputDebugStringW(L"[LR2BGAFilter] Output queue unavailable. Falling back to synchronous delivery.\n");
+    }
+  }
+  return S_OK;
+}
+
+HRESULT CLR2BGAOutputPin::Inactive() {
+  // キューが保持しているサンプルをアロケータへ返してから Decommit する
+  delete m_pQueue;
+  m_pQueue = NULL;
+  return CTransformOutputPin::Inactive();
+}
+
+HRESULT CLR2BGAOutputPin::Deliver(IMediaSample *pSample) {
+  ApplyPendingReset();
+
+  LARGE_INTEGER start, end;
+  QueryPerformanceCounter(&start);
+
+  HRESULT hr;
+  int queueDepth = 0;
+  if (m_pQueue) {
+    // COutputQueue は受け取ったサンプルを Release する。
+    // CTransformFilter::Receive も Deliver 後に Release するため、キューの分を加算しておく
+    pSample->AddRef();
+    hr = m_pQueue->Receive(pSample);
+    queueDepth = m_pQueue->GetQueuedCount();
+  } else {
+    hr = CTransformOutputPin::Deliver(pSample);
+  }
+
+  QueryPerformanceCounter(&end);
+  const LONGLONG elapsed = end.QuadPart - start.QuadPart;
+  m_stats.samples++;
+  m_stats.deliverQpcSum += elapsed;
+  if (elapsed > m_stats.deliverQpcMax) m_stats.deliverQpcMax = elapsed;
+  m_stats.queueDepthSum += queueDepth;
+  if (queueDepth > m_stats.queueDepthMax) m_stats.queueDepthMax = queueDepth;
+  return hr;
+}
+
+HRESULT CLR2BGAOutputPin::DeliverEndOfStream() {
+  if (!m_pQueue) return CTransformOutputPin::DeliverEndOfStream();
+  // 送信済みサンプルの後に EndOfStream が届くようキューに積む
+  m_pQueue->EOS();
+  return S_OK;
+}
+
+HRESULT CLR2BGAOutputPin::DeliverBeginFlush() {
+  if (!m_pQueue) return CTransformOutputPin::DeliverBeginFlush();
+  // 未送信のサンプルを破棄し、下流へ BeginFlush を伝える
+  m_pQueue->BeginFlush();
+  return S_OK;
+}
+
+HRESULT CLR2BGAOutputPin::DeliverEndFlush() {
+  if (!m_pQueue) return CTransformOutputPin::DeliverEndFlush();
+  m_pQueue->EndFlush();
+  return S_OK;
+}
+
+HRESULT CLR2BGAOutputPin::DeliverNewSegment(REFERENCE_TIME tStart, REFERENCE_TIME tStop,
+                                            double dRate) {
+  if (!m_pQueue) return CTransformOutputPin::DeliverNewSegment(tStart, tStop, dRate);
+  m_pQueue->NewSegment(tStart, tStop, dRate);
+  return S_OK;
+}
+
+void CLR2BGAOutputPin::ApplyPendingReset() {
+  if (m_bResetRequested.exchange(false)) {
+    m_stats = DeliveryStats();
+  }
+}
+
+void CLR2BGAOutputPin::RecordBufferWait(LONGLONG waitQpc) {
+  ApplyPendingReset();
+  if (waitQpc < 0) waitQpc = 0;
+  m_stats.bufferWaits++;
+  m_stats.bufferWaitQpcSum += waitQpc;
+  if (waitQpc > m_stats.bufferWaitQpcMax) m_stats.bufferWaitQpcMax = waitQpc;
+}
+
+void CLR2BGAOutputPin::GetDeliveryInfo(OutputDeliveryInfo &info, LONGLONG qpcFrequency) {
+  const double toMs = (qpcFrequency > 0) ? (1000.0 / qpcFrequency) : 0.0;
+  const DeliveryStats &st = m_stats;
+  info.bufferCount = m_actualBufferCount;
+  info.pipelined = (m_pQueue != NULL);
+  info.samples = st.samples;
+  info.avgDeliverMs = st.samples > 0 ? (double)st.deliverQpcSum / st.samples * toMs : 0.0;
+  info.maxDeliverMs = st.deliverQpcMax * toMs;
+  info.avgBufferWaitMs = st.bufferWaits > 0 ? (double)st.bufferWaitQpcSum / st.bufferWaits * toMs : 0.0;
+  info.maxBufferWaitMs = st.bufferWaitQpcMax * toMs;
+  info.avgQueueDepth = st.samples > 0 ? (double)st.queueDepthSum / st.samples : 0.0;
+  info.maxQueueDepth = st.queueDepthMax;
+}
+
 //------------------------------------------------------------------------------
 // Settings Implementation (Connection Restrictions)
 //------------------------------------------------------------------------------
@@ -1075,7 +1401,153 @@ STDMETHODIMP CLR2BGAFilter::SetOnlyOutputToRenderer(BOOL enabled) {
   return S_OK;
 }
 
+//------------------------------------------------------------------------------
+// Settings Implementation (External Window Frame Rate / Adaptive Quality)
+// 外部ウィンドウの描画スレッドが GetExtWindowConfig で読むため、ロック下で更新する
+//------------------------------------------------------------------------------
+STDMETHODIMP CLR2BGAFilter::GetExternalWindowMaxFPS(int *pMaxFPS) {
+  CheckPointer(pMaxFPS, E_POINTER);
+  m_pSettings->Lock();
+  *pMaxFPS = m_pSettings->m_extWindowMaxFPS;
+  m_pSettings->Unlock();
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAFilter::SetExternalWindowMaxFPS(int maxFPS) {
+  if (maxFPS < 0 || maxFPS > 240) {
+    return E_INVALIDARG;
+  }
+  m_pSettings->Lock();
+  m_pSettings->m_extWindowMaxFPS = maxFPS;
+  m_pSettings->Unlock();
+  m_pSettings->Save();
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAFilter::GetExternalWindowAdaptiveQuality(BOOL *pEnabled) {
+  CheckPointer(pEnabled, E_POINTER);
+  m_pSettings->Lock();
+  *pEnabled = m_pSettings->m_extWindowAdaptiveQuality ? TRUE : FALSE;
+  m_pSettings->Unlock();
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAFilter::SetExternalWindowAdaptiveQuality(BOOL enabled) {
+  m_pSettings->Lock();
+  m_pSettings->m_extWindowAdaptiveQuality = (enabled != FALSE);
+  m_pSettings->Unlock();
+  m_pSettings->Save();
+  return S_OK;
+}
+
+//------------------------------------------------------------------------------
+// Settings Implementation (External Window Occlusion)
+// 外部ウィンドウのスレッドが遮蔽の定期判定で読むため、ロック下で更新する
+//------------------------------------------------------------------------------
+STDMETHODIMP CLR2BGAFilter::GetExternalWindowPauseWhenOccluded(BOOL *pEnabled) {
+  CheckPointer(pEnabled, E_POINTER);
+  m_pSettings->Lock();
+  *pEnabled = m_pSettings->m_extWindowPauseWhenOccluded ? TRUE : FALSE;
+  m_pSettings->Unlock();
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAFilter::SetExternalWindowPauseWhenOccluded(BOOL enabled) {
+  m_pSettings->Lock();
+  m_pSettings->m_extWindowPauseWhenOccluded = (enabled != FALSE);
+  m_pSettings->Unlock();
+  m_pSettings->Save();
+  return S_OK;
+}
+
+//------------------------------------------------------------------------------
+// Settings Implementation (Output Buffering)
+// バッファ数は次回接続時の DecideBufferSize、パイプラインは次回の StartStreaming で反映される
+//------------------------------------------------------------------------------
+STDMETHODIMP CLR2BGAFilter::GetOutputBufferCount(int *pCount) {
+  CheckPointer(pCount, E_POINTER);
+  m_pSettings->Lock();
+  *pCount = m_pSettings->m_outputBufferCount;
+  m_pSettings->Unlock();
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAFilter::SetOutputBufferCount(int count) {
+  if (count < kMinOutputBuffers || count > kMaxOutputBuffers) {
+    return E_INVALIDARG;
+  }
+  m_pSettings->Lock();
+  m_pSettings->m_outputBufferCount = count;
+  m_pSettings->Unlock();
+  m_pSettings->Save();
+  return S_OK;
+}
 
+STDMETHODIMP CLR2BGAFilter::GetOutputPipelined(BOOL *pEnabled) {
+  CheckPointer(pEnabled, E_POINTER);
+  m_pSettings->Lock();
+  *pEnabled = m_pSettings->m_outputPipelined ? TRUE : FALSE;
+  m_pSettings->Unlock();
+  return S_OK;
+}
+
+STDMETHODIMP CLR2BGAFilter::SetOutputPipelined(BOOL enabled) {
+  m_pSettings->Lock();
+  m_pSettings->m_outputPipelined = (enabled != FALSE);
+  m_pSettings->Unlock();
+  m_pSettings->Save();
+  return S_OK;
+}
+
+
+
+//------------------------------------------------------------------------------
+// 上流のソースフィルタから再生中のファイルパスを取得するヘルパー
+// IFileSourceFilter を実装するフィルタが見つかるまで入力ピンを遡る
+//------------------------------------------------------------------------------
+static bool FindUpstreamSourceFile(IPin *pPin, std::wstring &path, int depth) {
+  if (depth > 20)
+    return false;
+
+  bool found = false;
+  IPin *pPeer = NULL;
+  pPin->ConnectedTo(&pPeer);
+  if (pPeer) {
+    PIN_INFO pinInfo = {0};
+    if (SUCCEEDED(pPeer->QueryPinInfo(&pinInfo))) {
+      if (pinInfo.pFilter) {
+        IFileSourceFilter *pFileSource = NULL;
+        if (SUCCEEDED(pinInfo.pFilter->QueryInterface(IID_IFileSourceFilter, (void **)&pFileSource))) {
+          LPOLESTR pszFileName = NULL;
+          if (SUCCEEDED(pFileSource->GetCurFile(&pszFileName, NULL)) && pszFileName) {
+            path = pszFileName;
+            found = true;
+            CoTaskMemFree(pszFileName);
+          }
+          pFileSource->Release();
+        } else {
+          // さらに入力ピンを探して遡る
+          IEnumPins *pEnum = NULL;
+          if (SUCCEEDED(pinInfo.pFilter->EnumPins(&pEnum))) {
+            IPin *pNextPin = NULL;
+            while (!found && pEnum->Next(1, &pNextPin, NULL) == S_OK) {
+              PIN_DIRECTION dir;
+              pNextPin->QueryDirection(&dir);
+              if (dir == PINDIR_INPUT) {
+                found = FindUpstreamSourceFile(pNextPin, path, depth + 1);
+              }
+              pNextPin->Release();
+            }
+            pEnum->Release();
+          }
+        }
+        pinInfo.pFilter->Release();
+      }
+    }
+    pPeer->Release();
+  }
+  return found;
+}
 
 //------------------------------------------------------------------------------
 // StartStreaming - ストリーミング開始
@@ -1094,6 +1566,10 @@ HRESULT CLR2BGAFilter::StartStreaming() {
     return VFW_E_TYPE_NOT_ACCEPTED;
   }
 
+  // このストリームで使う設定は、すべてここで取得した1つのスナップショットからラッチする
+  // (COM のセッターが書き換える設定のフィールドは直接読まない)
+  LR2BGASettings::SnapshotGuard cfg(m_pSettings, LR2BGASettings::SNAPSHOT_READER_CONTROL);
+
   REFERENCE_TIME avgTimePerFrame = 0;
   if (mtIn.formattype == FORMAT_VideoInfo2) {
     VIDEOINFOHEADER2 *pvi2In = (VIDEOINFOHEADER2 *)mtIn.Format();
@@ -1108,54 +1584,116 @@ HRESULT CLR2BGAFilter::StartStreaming() {
     m_inputBitCount = pviIn->bmiHeader.biBitCount;
     avgTimePerFrame = pviIn->AvgTimePerFrame;
   }
+
+  // 動画キャッシュの検索 (上流のソースフィルタからファイルを特定できた場合のみ)
+  VideoCacheEntry cacheEntry;
+  bool cacheHit = false;
+  m_sourceIdentity = VideoFileIdentity();
+  if (FindUpstreamSourceFile(m_pInput, m_sourceIdentity.path, 1) &&
+      m_sourceIdentity.QueryFileAttributes()) {
+    cacheHit = m_videoCache.Lookup(m_sourceIdentity, cacheEntry) &&
+               cacheEntry.width == m_inputWidth && cacheEntry.height == m_inputHeight;
+  } else {
+    m_sourceIdentity = VideoFileIdentity();
+  }
+
+  // メディアタイプにフレーム間隔がない場合は前回の値を使用
+  if (avgTimePerFrame <= 0 && cacheHit) {
+    avgTimePerFrame = cacheEntry.avgTimePerFrame;
+  }
+  m_avgTimePerFrame = avgTimePerFrame;
   m_frameRate = (avgTimePerFrame > 0) ? (10000000.0 / avgTimePerFrame) : 0.0;
 
   // 設定画面の自動オープン
-  if (!m_bConfigMode && m_pSettings->m_autoOpenSettings && m_pWindow) {
+  if (!m_bConfigMode && cfg->autoOpenSettings && m_pWindow) {
     m_pWindow->ShowPropertyPage();
   }
 
   // 外部ウィンドウが有効な場合、表示する
-  if (!m_bConfigMode && m_pSettings->m_extWindowEnabled && m_pWindow) {
+  if (!m_bConfigMode && cfg->ext.enabled && m_pWindow) {
     m_pWindow->ShowExternalWindow();
   }
 
   // デバッグモードが有効な場合、デバッグウィンドウを表示する
-  if (m_pSettings->m_debugMode && m_pWindow) {
+  if (cfg->debugMode && m_pWindow) {
     m_pWindow->ShowDebugWindow();
+    // 接続後にグラフへ追加・接続されたフィルタも反映する
+    RefreshGraphTopology(true, true);
+  }
+  m_lastDebugPublishQpc = 0;
+
+  // 外部ツール向けの統計の公開 (失敗しても再生は続ける)
+  if (!m_bConfigMode) {
+    const HRESULT hrShared = m_sharedStats.Open();
+    if (hrShared != S_OK && cfg->debugMode) {
+      wchar_t msg[128];
+      swprintf_s(msg, L"[LR2BGAFilter] Shared stats not published (hr=0x%08X).\n", (unsigned)hrShared);
+      OutputDebugStringW(msg);
+    }
   }
+  m_lastSharedStatsPublishQpc = 0;
 
   // 出力サイズの決定 (SetMediaType と同じロジック)
   int outWidth, outHeight;
-  if (m_pSettings->m_dummyMode) {
+  if (cfg->dummyMode) {
     outWidth = 1;
     outHeight = 1;
-  } else if (m_pSettings->m_passthroughMode) {
+  } else if (cfg->passthroughMode) {
     // パススルーモードでは入力サイズをそのまま使用
     outWidth = m_inputWidth;
     outHeight = m_inputHeight;
   } else {
-    outWidth = m_pSettings->m_outputWidth;
-    outHeight = m_pSettings->m_outputHeight;
+    outWidth = cfg->outputWidth;
+    outHeight = cfg->outputHeight;
   }
 
   // Transform用にサイズをラッチ (毎フレームのMediaType取得を回避)
   m_activeWidth = outWidth;
   m_activeHeight = outHeight;
 
+  // 受け渡し方式をラッチ (この後 CBaseFilter::Pause から呼ばれる出力ピンの Active で参照)
+  m_activePipelined = cfg->outputPipelined;
+  m_receiveEnterQpc = 0;
+
   // TransformLogic開始
-  m_pTransformLogic->StartStreaming(m_inputWidth, m_inputHeight, m_inputBitCount,
-                                    outWidth, outHeight);
+  m_pTransformLogic->StartStreaming(*cfg, m_inputWidth, m_inputHeight, m_inputBitCount,
+                                    outWidth, outHeight, m_avgTimePerFrame);
+
+  // ゼロコピー判定: RGB24 のパススルーは出力が入力と1バイトも変わらないため、
+  // 出力サンプルへコピーせず入力サンプルをそのまま下流へ渡せる (フレームごとの条件は IsInPlaceFrame)
+  m_activeInPlace = m_pTransformLogic->IsPassthroughActive() && m_inputBitCount == 24 &&
+                    m_inputWidth == outWidth && m_inputHeight == outHeight;
+  m_inPlaceFrameCount = 0;
+  m_activeDummy = m_pTransformLogic->IsDummyActive();
+  m_dummyStreamEnded = false;
+
+  // 上流への品質制御は新しいストリームごとに通常レートから始める
+  m_upstreamQuality = {};
+  m_upstreamQuality.proportion = 1000;
+  m_upstreamQuality.type = Flood;
+  m_upstreamQuality.prevStart = -1;
+  m_upstreamQuality.lastResult = S_OK;
+  m_upstreamRateReduced = false;
+
+  // 動画キャッシュへ保存する条件 (このストリームで検出器に渡した値。StopStreaming で参照)
+  m_streamAutoRemoveLetterbox = cfg->autoRemoveLetterbox;
+  m_streamLbThreshold = cfg->lbThreshold;
+
+  // 前回の検出結果を適用 (解析時と同じ閾値の場合のみ)
+  if (cacheHit && m_streamAutoRemoveLetterbox && cacheEntry.lbThreshold == m_streamLbThreshold) {
+    m_pTransformLogic->SeedLetterboxResult((LetterboxMode)cacheEntry.lbMode, cacheEntry.cropRect,
+                                           m_inputWidth, m_inputHeight);
+  }
   // レターボックス検出スレッドを開始 (Logic側)
   m_pTransformLogic->StartLetterboxThread();
 
   // Memory Monitor Start
   // 設定が有効な場合のみスレッドを開始する
-  if (m_pMemoryMonitor && m_pSettings->m_closeOnResult) {
+  if (m_pMemoryMonitor && cfg->ext.closeOnResult) {
       m_pMemoryMonitor->Start();
   }
 
-  if (m_pSettings && m_pSettings->m_debugMode) {
+  if (cfg->debugMode) {
     // Debug: 接続確定後の最終出力MediaTypeを記録
     CMediaType mtOut;
     if (SUCCEEDED(m_pOutput->ConnectionMediaType(&mtOut))) {
@@ -1181,6 +1719,24 @@ HRESULT CLR2BGAFilter::StopStreaming() {
 
   // レターボックス検出スレッドを停止
   m_pTransformLogic->StopLetterboxThread();
+
+  // 確定した検出結果を動画キャッシュへ保存する (StartStreaming でラッチした、実際に検出に使った値で)
+  // レジストリへの書き込みは、フィルタのロックと m_csReceive を解放した後に Stop で行う
+  if (!m_sourceIdentity.path.empty() && m_streamAutoRemoveLetterbox) {
+    VideoCacheEntry entry;
+    LetterboxMode mode;
+    if (m_pTransformLogic->GetConfirmedLetterboxResult(mode, entry.cropRect)) {
+      entry.width = m_inputWidth;
+      entry.height = m_inputHeight;
+      entry.avgTimePerFrame = m_avgTimePerFrame;
+      entry.lbThreshold = m_streamLbThreshold;
+      entry.lbMode = mode;
+      std::lock_guard<std::mutex> cacheLock(m_mtxCacheStore);
+      m_cacheStoreIdentity = m_sourceIdentity;
+      m_cacheStoreEntry = entry;
+      m_cacheStorePending = true;
+    }
+  }
   
   // TransformLogic停止
   m_pTransformLogic->StopStreaming();
@@ -1189,10 +1745,81 @@ HRESULT CLR2BGAFilter::StopStreaming() {
   if (m_pWindow) {
     m_pWindow->CloseExternalWindow();
   }
+
+  // 外部ツールへ停止を通知する
+  LARGE_INTEGER stopQpc;
+  QueryPerformanceCounter(&stopQpc);
+  PublishSharedStats(stopQpc.QuadPart, NULL, false);
   return CTransformFilter::StopStreaming();
 }
 
-// EndOfStream implementation is removed as base class handles it
+//------------------------------------------------------------------------------
+// Stop - フィルタの停止
+// StopStreaming はフィルタのロックと m_csReceive の下で呼ばれるため、そこで確定した
+// 動画キャッシュのエントリはロックを解放した後にレジストリへ書き込む (グラフの停止を待たせない)。
+//------------------------------------------------------------------------------
+STDMETHODIMP CLR2BGAFilter::Stop() {
+  HRESULT hr = CTransformFilter::Stop();
+
+  VideoFileIdentity identity;
+  VideoCacheEntry entry;
+  {
+    std::lock_guard<std::mutex> cacheLock(m_mtxCacheStore);
+    if (!m_cacheStorePending) {
+      return hr;
+    }
+    identity = m_cacheStoreIdentity;
+    entry = m_cacheStoreEntry;
+    m_cacheStorePending = false;
+  }
+  m_videoCache.Store(identity, entry);
+  return hr;
+}
+
+//------------------------------------------------------------------------------
+// EndOfStream - 上流からのストリーム終了
+// ダミーモードで既に EndOfStream を送っている場合は下流へ重ねて送らない
+// (上流はサンプルを拒否されるとストリームを終えて EndOfStream を送ってくる)。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::EndOfStream() {
+  if (m_dummyStreamEnded) {
+    return S_OK;
+  }
+  return CTransformFilter::EndOfStream();
+}
+
+//------------------------------------------------------------------------------
+// EndFlush - フラッシュ終了
+// シーク等でフラッシュされた場合、下流は保持していた黒フレームを破棄しているため、
+// ダミーモードでも次のサンプルから黒フレームを1枚渡し直す。
+// フラッシュ中は上流のストリーミングスレッドが Receive に入らないため、ここで状態を戻してよい。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::EndFlush() {
+  m_dummyStreamEnded = false;
+  m_pTransformLogic->ResetDummySent();
+  return CTransformFilter::EndFlush();
+}
+
+//------------------------------------------------------------------------------
+// CompleteConnect - ピン接続の完了
+// 接続が確定した時点でフィルタグラフの構成を取得し直す。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::CompleteConnect(PIN_DIRECTION direction, IPin *pReceivePin) {
+  HRESULT hr = CTransformFilter::CompleteConnect(direction, pReceivePin);
+  if (SUCCEEDED(hr)) {
+    RefreshGraphTopology(true, true);
+  }
+  return hr;
+}
+
+//------------------------------------------------------------------------------
+// BreakConnect - ピン切断
+// 呼ばれた時点ではピンはまだ接続されているため、切断される側を除いて構成を取得し直す。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::BreakConnect(PIN_DIRECTION direction) {
+  RefreshGraphTopology(direction != PINDIR_INPUT, direction != PINDIR_OUTPUT);
+  return CTransformFilter::BreakConnect(direction);
+}
 
 //------------------------------------------------------------------------------
 // CheckInputType - 入力メディアタイプのチェック
@@ -1266,19 +1893,22 @@ HRESULT CLR2BGAFilter::GetMediaType(int iPosition, CMediaType *pMediaType) {
   // 設定に基づいて出力サイズを決定
   // 注意:
   // バッファサイズの問題を防ぐため、StartStreaming/Transformのラッチロジックと一致させる必要があります
-  // GetMediaType は StartStreaming の前、接続時に呼ばれるため、ここではm_pSettings を直接使用します。
+  // GetMediaType は StartStreaming の前、接続時に呼ばれるため、ここでも設定スナップショットから読みます。
   // なお、m_inputWidth/m_inputHeight/m_inputBitCount の確定は StartStreaming の責務です。
   // GetMediaType は出力メディアタイプ提案のみを行い、入力キャッシュ確定は行いません。
   int outWidth, outHeight;
-  if (m_pSettings->m_dummyMode) {
-    outWidth = 1;
-    outHeight = 1;
-  } else if (m_pSettings->m_passthroughMode) {
-    outWidth = inWidth;
-    outHeight = inHeight;
-  } else {
-    outWidth = m_pSettings->m_outputWidth;
-    outHeight = m_pSettings->m_outputHeight;
+  {
+    LR2BGASettings::SnapshotGuard cfg(m_pSettings, LR2BGASettings::SNAPSHOT_READER_CONTROL);
+    if (cfg->dummyMode) {
+      outWidth = 1;
+      outHeight = 1;
+    } else if (cfg->passthroughMode) {
+      outWidth = inWidth;
+      outHeight = inHeight;
+    } else {
+      outWidth = cfg->outputWidth;
+      outHeight = cfg->outputHeight;
+    }
   }
 
   pMediaType->SetType(&MEDIATYPE_Video);
@@ -1326,7 +1956,16 @@ HRESULT CLR2BGAFilter::DecideBufferSize(IMemAllocator *pAlloc,
 
   VIDEOINFOHEADER *pvi = (VIDEOINFOHEADER *)mtOut.Format();
 
-  pProp->cBuffers = 1;
+  // 出力バッファ数
+  // 1枚では LR2 がサンプルを返すまで次フレームの変換を開始できないため、
+  // パイプラインモードでは最低2枚を確保して変換と受け渡しを重ねる
+  LR2BGASettings::SnapshotGuard cfg(m_pSettings, LR2BGASettings::SNAPSHOT_READER_CONTROL);
+  int bufferCount = cfg->outputBufferCount;
+  if (bufferCount < kMinOutputBuffers) bufferCount = kMinOutputBuffers;
+  if (bufferCount > kMaxOutputBuffers) bufferCount = kMaxOutputBuffers;
+  if (cfg->outputPipelined && bufferCount < 2) bufferCount = 2;
+
+  pProp->cBuffers = bufferCount;
   pProp->cbBuffer = pvi->bmiHeader.biSizeImage;
 
   if (pProp->cbBuffer == 0) {
@@ -1342,9 +1981,249 @@ HRESULT CLR2BGAFilter::DecideBufferSize(IMemAllocator *pAlloc,
   if (actual.cbBuffer < pProp->cbBuffer)
     return E_FAIL;
 
+  // 下流のアロケータが要求より少ない枚数しか確保しない場合があるため、実際の値を記録する
+  static_cast<CLR2BGAOutputPin *>(m_pOutput)->SetActualBufferCount(actual.cBuffers);
+  if (cfg->debugMode) {
+    wchar_t msg[160];
+    swprintf_s(msg, L"[LR2BGAFilter] DecideBufferSize: requested=%ld actual=%ld cbBuffer=%ld\n",
+               pProp->cBuffers, actual.cBuffers, actual.cbBuffer);
+    OutputDebugStringW(msg);
+  }
+
   return S_OK;
 }
 
+//------------------------------------------------------------------------------
+// Receive - サンプル受信
+// CTransformFilter::Receive と同じ手順だが、出力サンプルを下流の Receive へ直接渡さず
+// m_pOutput->Deliver を経由させる (パイプラインモードのキューと受け渡し統計のため)。
+// InitializeOutputSample は出力アロケータの GetBuffer で空きバッファを待つため、
+// 受信から Transform 開始までを出力バッファ待ちとして計測する。
+// ゼロコピー対象のフレームは出力サンプルを確保せず、入力サンプル自体を下流へ渡す。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::Receive(IMediaSample *pSample) {
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  m_receiveEnterQpc = now.QuadPart;
+
+  // メディア以外のストリームはそのまま下流へ (キュー内のサンプルとの順序を保つため Deliver 経由)
+  AM_SAMPLE2_PROPERTIES *const pProps = m_pInput->SampleProps();
+  if (pProps->dwStreamId != AM_STREAM_MEDIA) {
+    return m_pOutput->Deliver(pSample);
+  }
+
+  // ダミーモードでストリームを終えた後は受け取らない (S_FALSE で上流に送出を止めさせる)
+  if (m_dummyStreamEnded) {
+    return S_FALSE;
+  }
+
+  // フレーム内で参照する設定は、ここで取得したスナップショットに固定する
+  LR2BGASettings::SnapshotGuard cfg(m_pSettings, LR2BGASettings::SNAPSHOT_READER_STREAMING);
+  m_pFrameSettings = cfg.get();
+
+  HRESULT hr;
+  if (IsInPlaceFrame(pSample, *cfg)) {
+    hr = ProcessFrame(pSample, NULL, *cfg);
+    if (hr == S_OK) {
+      // キューへ渡す場合は Deliver 内で AddRef される。入力サンプルの参照は上流が持つため Release しない
+      m_inPlaceFrameCount++;
+      hr = DeliverFrame(pSample);
+      m_bSampleSkipped = FALSE;
+    } else if (hr == S_FALSE) {
+      NotifySampleSkipped();
+      return S_OK;
+    }
+    return hr;
+  }
+
+  IMediaSample *pOutSample = NULL;
+  hr = InitializeOutputSample(pSample, &pOutSample);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  hr = Transform(pSample, pOutSample);
+  if (hr == S_OK) {
+    hr = DeliverFrame(pOutSample);
+    m_bSampleSkipped = FALSE;
+    if (hr == S_OK && ShouldEndDummyStream(*cfg)) {
+      // 黒フレームの後にストリームを終える。LR2 は最後のフレームを保持し、
+      // グラフは停止しないためクロックはそのまま進む。上流はデコードを止める
+      pOutSample->Release();
+      m_dummyStreamEnded = true;
+      m_pOutput->DeliverEndOfStream();
+      return S_FALSE;
+    }
+  } else if (hr == S_FALSE) {
+    pOutSample->Release();
+    NotifySampleSkipped();
+    return S_OK;
+  }
+
+  // 下流が保持する場合は下流 (またはキュー) が AddRef 済み
+  pOutSample->Release();
+  return hr;
+}
+
+//------------------------------------------------------------------------------
+// DeliverFrame - フレームを下流へ渡す
+// 受け渡しの所要時間 (STAGE_DELIVER) と、実測出力フレームレート用の出力時刻を記録する。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::DeliverFrame(IMediaSample *pSample) {
+  LARGE_INTEGER start, end;
+  QueryPerformanceCounter(&start);
+  HRESULT hr = m_pOutput->Deliver(pSample);
+  QueryPerformanceCounter(&end);
+
+  LR2BGAStageStats &stageStats = m_pTransformLogic->GetStageStats();
+  stageStats.Record(STAGE_DELIVER, start.QuadPart, end.QuadPart, 0, (int)hr);
+  if (hr == S_OK) {
+    stageStats.RecordOutput(end.QuadPart);
+  }
+  return hr;
+}
+
+//------------------------------------------------------------------------------
+// NotifySampleSkipped - 出力しなかったフレームの記録
+// S_FALSE は「このフレームは出力しない」というフィルタ内部の取り決め。
+// 上流へ S_FALSE を返すとストリーム終了の意味になるため、呼び出し側は S_OK を返す。
+//------------------------------------------------------------------------------
+void CLR2BGAFilter::NotifySampleSkipped() {
+  m_bSampleSkipped = TRUE;
+  if (!m_bQualityChanged) {
+    NotifyEvent(EC_QUALITY_CHANGE, 0, 0);
+    m_bQualityChanged = TRUE;
+  }
+}
+
+//------------------------------------------------------------------------------
+// ShouldEndDummyStream - ダミーモードでストリームを終えるか
+// 外部ウィンドウが有効な場合はダミーモードでも入力フレームを描画するため、
+// 従来どおりサンプルを受け取り続ける (FillOutputBuffer がフレーム長だけ待機してスキップ)。
+//------------------------------------------------------------------------------
+bool CLR2BGAFilter::ShouldEndDummyStream(const LR2BGASettings::Snapshot &cfg) const {
+  return m_activeDummy && !cfg.ext.enabled;
+}
+
+//------------------------------------------------------------------------------
+// IsInPlaceFrame - 入力サンプルをそのまま出力できるフレームか
+//
+// StartStreaming でラッチした m_activeInPlace に加え、フレームごとに以下を確認する:
+//   - 上流がメディアタイプを途中変更していない (変更後の形式は出力と一致する保証がない)
+//   - データ長が出力1フレーム分に足りている
+//   - 明るさ調整が必要な場合は、入力バッファへの書き込みが許されている (読み取り専用でない)
+// 明るさは ProcessFrame と同じ設定スナップショットから読むため、判定後に設定画面で
+// 変更されても読み取り専用バッファへ書き込むことはない。
+//------------------------------------------------------------------------------
+bool CLR2BGAFilter::IsInPlaceFrame(IMediaSample *pSample, const LR2BGASettings::Snapshot &cfg) {
+  if (!m_activeInPlace) {
+    return false;
+  }
+  if (m_pInput->SampleProps()->dwSampleFlags & AM_SAMPLE_TYPECHANGED) {
+    return false;
+  }
+  const long frameBytes = (long)((m_activeWidth * 3 + 3) & ~3) * m_activeHeight;
+  if (pSample->GetActualDataLength() < frameBytes) {
+    return false;
+  }
+  if (cfg.brightnessLR2 < 100 && m_pInput->IsReadOnly()) {
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// UpdateUpstreamQuality - 上流への品質制御
+//
+// WaitFPSLimit が捨てるフレームも上流ではデコードと色変換を終えているため、
+// IQualityControl::Notify で上流 (デコーダ) へ送出レートの削減を要求する。
+//   - Flood: FPS制限の目標レートが入力レートより低い。Proportion = 目標 / 入力 x 1000
+//   - Famine: タイムライン上の予定より kQualityFamineLate 以上遅れている。
+//             遅れに応じて Proportion を下げる (baseclasses のレンダラと同じ式、下限500)
+// 外部ウィンドウは FPS制限で捨てたフレームも描画するため、その上限FPSが目標を上回る
+// (または制限なしの) 場合は、外部ウィンドウに必要なレートまでしか下げない。
+// 要求が変わった場合と、削減中は kQualityNotifyIntervalMs ごとに送る。通常レートへ戻す際は
+// Proportion=1000 を1回送る。上流のスキップは、削減中の入力タイムスタンプの間隔から推定する。
+//------------------------------------------------------------------------------
+void CLR2BGAFilter::UpdateUpstreamQuality(IMediaSample *pIn, REFERENCE_TIME rtStart,
+                                          const LR2BGASettings::Snapshot &cfg) {
+  UpstreamQualityState &st = m_upstreamQuality;
+  const REFERENCE_TIME interval = m_avgTimePerFrame;
+
+  // 上流のスキップ検出 (シーク等の不連続点は除く)
+  if (st.proportion < 1000 && st.prevStart >= 0 && interval > 0 && rtStart > st.prevStart &&
+      pIn->IsDiscontinuity() != S_OK) {
+    const REFERENCE_TIME gap = rtStart - st.prevStart;
+    if (gap > interval + interval / 2) {
+      st.upstreamSkipped += (gap + interval / 2) / interval - 1;
+    }
+  }
+  st.prevStart = rtStart;
+
+  // 送るべき要求の決定 (FPS制限のタイムラインがない場合は通常レート)
+  int proportion = 1000;
+  QualityMessageType type = Flood;
+  REFERENCE_TIME late = 0;
+  if (m_pTransformLogic->GetTimelineLateness(late) && interval > 0) {
+    const double inputFps = 10000000.0 / interval;
+    double targetFps = cfg.maxFPS;
+    if (cfg.ext.enabled) {
+      const int extFps = cfg.ext.maxFPS;
+      targetFps = (extFps <= 0) ? inputFps : max(targetFps, (double)extFps);
+    }
+    if (targetFps < inputFps) {
+      proportion = (int)(1000.0 * targetFps / inputFps);
+    }
+    if (late >= kQualityFamineLate && late < kQualityFamineMaxLate) {
+      type = Famine;
+      const int famineProportion =
+          max(kQualityMinProportion, 1000 - (int)(late / (UNITS / 1000)));
+      proportion = min(proportion, famineProportion);
+    }
+    proportion = max(1, proportion);
+  }
+
+  const ULONGLONG now = GetTickCount64();
+  const bool changed = (type != st.type) ||
+                       (proportion == 1000) != (st.proportion == 1000) ||
+                       abs(proportion - st.proportion) >= kQualityProportionHysteresis;
+  const bool refresh = (proportion < 1000) && (now - st.lastSentTick >= kQualityNotifyIntervalMs);
+  if (!changed && !refresh) {
+    return;
+  }
+
+  Quality q;
+  q.Type = type;
+  q.Proportion = proportion;
+  q.Late = late;
+  q.TimeStamp = rtStart;
+  st.lastResult = m_pInput->PassNotify(q);
+  st.lastSentTick = now;
+  st.proportion = proportion;
+  st.type = type;
+  st.late = late;
+  st.messagesSent++;
+  m_upstreamRateReduced = (proportion < 1000);
+
+  if (cfg.debugMode && changed) {
+    wchar_t msg[160];
+    swprintf_s(msg, L"[LR2BGAFilter] Upstream quality: %s proportion=%d late=%.1fms hr=0x%08lX\n",
+               type == Famine ? L"Famine" : L"Flood", proportion, late / 10000.0,
+               (unsigned long)st.lastResult);
+    OutputDebugStringW(msg);
+  }
+}
+
+//------------------------------------------------------------------------------
+// AlterQuality - 下流からの品質メッセージ
+// 通常は上流へそのまま転送する (S_FALSE)。自前の要求で上流のレートを下げている間は、
+// 下流の要求で上書きされないよう転送しない (下流のスレッドから呼ばれるため atomic を参照)。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::AlterQuality(Quality q) {
+  UNREFERENCED_PARAMETER(q);
+  return m_upstreamRateReduced ? S_OK : S_FALSE;
+}
+
 //------------------------------------------------------------------------------
 // Transform - フレーム変換処理
 //
@@ -1372,12 +2251,27 @@ HRESULT CLR2BGAFilter::DecideBufferSize(IMemAllocator *pAlloc,
 //   7. 明るさ調整 (LR2用)
 //   8. 統計情報更新
 //
+// 実処理は ProcessFrame で行う (ゼロコピー時は出力サンプルなしで Receive から直接呼ばれる)。
+//
 // 同期に関する注意:
 //   - 設定値/フォーマット情報は、ストリーミング開始時にラッチされた値
 //     (m_activeWidth/m_activeHeight, m_inputWidth/m_inputHeight/m_inputBitCount) を使用します。
 //     これは、処理中に設定が変更されてバッファオーバーランが発生するのを防ぐためです。
 //------------------------------------------------------------------------------
 HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
+  // Transform は Receive からのみ呼ばれ、Receive が取得したスナップショットを使う
+  return ProcessFrame(pIn, pOut, *m_pFrameSettings);
+}
+
+//------------------------------------------------------------------------------
+// ProcessFrame - フレーム処理の本体
+// pOut が NULL の場合はゼロコピー: 出力バッファの生成を省略し、
+// LR2用の明るさ調整 (cfg.brightnessLR2 < 100 の場合のみ) を入力バッファ上で行う。
+// 外部ウィンドウへのコピーと黒帯検出のサムネイル生成はその前に済ませるため、
+// これらは調整前の入力を参照する (コピー経路と同じ結果)。
+//------------------------------------------------------------------------------
+HRESULT CLR2BGAFilter::ProcessFrame(IMediaSample *pIn, IMediaSample *pOut,
+                                    const LR2BGASettings::Snapshot &cfg) {
   m_inputFrameCount++;
 
   REFERENCE_TIME rtStart = 0, rtEnd = 0;
@@ -1390,13 +2284,21 @@ HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
   }
   QueryPerformanceCounter(&startTime);
 
+  // 出力バッファ待ち (Receive の開始から、出力アロケータの GetBuffer を経てここに至るまで)
+  if (pOut && m_receiveEnterQpc > 0) {
+    static_cast<CLR2BGAOutputPin *>(m_pOutput)->RecordBufferWait(startTime.QuadPart -
+                                                                  m_receiveEnterQpc);
+  }
+
   BYTE *pSrcData;
   HRESULT hr = pIn->GetPointer(&pSrcData);
   if (FAILED(hr)) return hr;
 
-  BYTE *pDstData;
-  hr = pOut->GetPointer(&pDstData);
-  if (FAILED(hr)) return hr;
+  BYTE *pDstData = NULL;
+  if (pOut) {
+    hr = pOut->GetPointer(&pDstData);
+    if (FAILED(hr)) return hr;
+  }
 
   // フォーマットは StartStreaming で確定したキャッシュ値を使用
   int srcWidth = m_inputWidth;
@@ -1406,6 +2308,7 @@ HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
     return E_UNEXPECTED;
   }
   int srcStride = ((srcWidth * (srcBitCount / 8) + 3) & ~3);
+  static_cast<CLR2BGAInputPin *>(m_pInput)->RecordSampleAlignment(pSrcData, srcStride);
 
   int dstWidth = m_activeWidth;
   int dstHeight = m_activeHeight;
@@ -1418,11 +2321,19 @@ HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
   // FPS制限 (Delegated to TransformLogic)
   // ここで時間同期とドロップ判定を行う。ドロップ時でも外部ウィンドウ更新は継続する。
   // -------------------------------------------------------------------------
-  hr = m_pTransformLogic->WaitFPSLimit(rtStart, rtEnd);
+  LARGE_INTEGER stageStart, stageEnd;
+  QueryPerformanceCounter(&stageStart);
+  hr = m_pTransformLogic->WaitFPSLimit(cfg, rtStart, rtEnd);
   if (FAILED(hr)) {
     return hr;
   }
   const bool dropByFPS = (hr == S_FALSE);
+  LR2BGAStageStats &stageStats = m_pTransformLogic->GetStageStats();
+  QueryPerformanceCounter(&stageEnd);
+  stageStats.Record(STAGE_FPS_WAIT, stageStart.QuadPart, stageEnd.QuadPart, rtStart, dropByFPS ? 1 : 0);
+
+  // 上流への品質制御 (WaitFPSLimit で測った遅れを使う)
+  UpdateUpstreamQuality(pIn, rtStart, cfg);
 
   // WaitFPSLimit 内部の待機時間を除外して計測するため、ここで計測開始点を更新
   QueryPerformanceCounter(&startTime);
@@ -1433,19 +2344,40 @@ HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
   RECT srcRect = {0, 0, srcWidth, srcHeight};
   RECT *pSrcRect = NULL;
   m_pTransformLogic->ProcessLetterboxDetection(
-      pSrcData, pIn->GetActualDataLength(), srcWidth, srcHeight, srcStride,
+      cfg, pSrcData, pIn->GetActualDataLength(), srcWidth, srcHeight, srcStride,
       srcBitCount, srcRect, pSrcRect);
+  QueryPerformanceCounter(&stageEnd);
+  stageStats.Record(STAGE_LETTERBOX, startTime.QuadPart, stageEnd.QuadPart, 0, pSrcRect ? 1 : 0);
 
   // -------------------------------------------------------------------------
   // 外部ウィンドウ更新
+  // 外部ウィンドウ専用の上限FPS (LR2向けのFPS制限とは独立) で間引いた上で、
+  // LR2向けにリサイズ出力するフレームでは、外部ウィンドウ用フレームも
+  // 同じソース走査で生成する (FillOutputBuffer 内の ResizeMulti)。
+  // それ以外 (FPS制限ドロップ、ダミー/パススルー) はクロップ範囲を描画スレッドへ投函する。
   // -------------------------------------------------------------------------
-  if (m_pSettings->m_extWindowEnabled) {
-    m_pWindow->UpdateExternalWindow(pSrcData, srcWidth, srcHeight, srcStride,
-                                    srcBitCount, pSrcRect);
+  LR2BGAImageProc::ResizeTarget extTarget = {};
+  bool extPresized = false;
+  if (cfg.ext.enabled && m_pWindow->IsExternalFrameDue()) {
+    stageStart = stageEnd;
+    if (!dropByFPS && m_pTransformLogic->IsResizeOutputActive()) {
+      const RECT &crop = pSrcRect ? *pSrcRect : srcRect;
+      extPresized = m_pWindow->BeginExternalPresizedFrame(
+          crop.right - crop.left, crop.bottom - crop.top, extTarget);
+    }
+    if (!extPresized) {
+      m_pWindow->UpdateExternalWindow(pSrcData, srcWidth, srcHeight, srcStride,
+                                      srcBitCount, pSrcRect);
+    }
+    QueryPerformanceCounter(&stageEnd);
+    stageStats.Record(STAGE_EXT_WINDOW, stageStart.QuadPart, stageEnd.QuadPart, 0, extPresized ? 1 : 0);
   }
 
-  // デバッグ情報の更新
-  UpdateDebugInfo();
+  // デバッグ統計の公開 (テキスト生成と描画はデバッグウィンドウのスレッドが一定周期で行う)
+  if (cfg.debugMode) {
+    PublishDebugStats(startTime.QuadPart);
+  }
+  PublishSharedStats(startTime.QuadPart, pSrcRect, true);
 
   if (dropByFPS) {
       // LR2向け出力のみドロップし、外部ウィンドウ更新と時間同期は維持する
@@ -1453,6 +2385,7 @@ HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
       m_processedFrameCount++;
       m_totalProcessTime +=
           (endTime.QuadPart - startTime.QuadPart) * 10000000 / freq.QuadPart;
+      stageStats.Record(STAGE_TOTAL, startTime.QuadPart, endTime.QuadPart, rtStart, TRACE_OUTCOME_FPS_DROP);
       return S_FALSE; // Skip output sample
   }
 
@@ -1462,19 +2395,38 @@ HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
   LARGE_INTEGER midTime2;
   QueryPerformanceCounter(&midTime2);
 
-  long outDataLen = 0;
-  hr = m_pTransformLogic->FillOutputBuffer(pSrcData, pDstData, srcWidth, srcHeight, srcStride, srcBitCount,
-                                           dstWidth, dstHeight, dstStride, pSrcRect, rtStart, rtEnd, outDataLen);
-  pOut->SetActualDataLength(outDataLen);
-  pOut->SetTime(&rtStart, &rtEnd);
-  pOut->SetSyncPoint(TRUE);
-  
-  if (hr == S_FALSE) {
-      // ダミーモード待機などでスキップされた場合
-      // WaitFPSLimit同様、待機時間を除外して計測する
-      m_processedFrameCount++;
-      m_totalProcessTime += (midTime2.QuadPart - startTime.QuadPart) * 10000000 / freq.QuadPart;
-      return S_FALSE; // Dummy skip
+  if (pOut == NULL) {
+    // ゼロコピー: 入力サンプル自体が出力になる (タイムスタンプ・データ長は上流の値のまま)
+    if (cfg.brightnessLR2 < 100) {
+      LR2BGAImageProc::ApplyBrightness(pSrcData, dstWidth, dstHeight, dstStride, cfg.brightnessLR2);
+      QueryPerformanceCounter(&stageEnd);
+      stageStats.Record(STAGE_BRIGHTNESS, midTime2.QuadPart, stageEnd.QuadPart, 0, cfg.brightnessLR2);
+    }
+    pIn->SetSyncPoint(TRUE);
+  } else {
+    long outDataLen = 0;
+    hr = m_pTransformLogic->FillOutputBuffer(cfg, pSrcData, pDstData, srcWidth, srcHeight, srcStride, srcBitCount,
+                                             dstWidth, dstHeight, dstStride, pSrcRect, rtStart, rtEnd, outDataLen,
+                                             extPresized ? &extTarget : NULL);
+    if (extPresized && hr == S_OK) {
+      // 画質ガバナーが外部ウィンドウ分のコストを按分できるよう、出力生成の所要時間を渡す
+      LARGE_INTEGER fillEnd;
+      QueryPerformanceCounter(&fillEnd);
+      m_pWindow->CommitExternalPresizedFrame(fillEnd.QuadPart - midTime2.QuadPart,
+                                             dstWidth * dstHeight);
+    }
+    pOut->SetActualDataLength(outDataLen);
+    pOut->SetTime(&rtStart, &rtEnd);
+    pOut->SetSyncPoint(TRUE);
+
+    if (hr == S_FALSE) {
+        // ダミーモード待機などでスキップされた場合
+        // WaitFPSLimit同様、待機時間を除外して計測する
+        m_processedFrameCount++;
+        m_totalProcessTime += (midTime2.QuadPart - startTime.QuadPart) * 10000000 / freq.QuadPart;
+        stageStats.Record(STAGE_TOTAL, startTime.QuadPart, midTime2.QuadPart, rtStart, TRACE_OUTCOME_SKIP);
+        return S_FALSE; // Dummy skip
+    }
   }
 
   // 統計情報更新 (正常出力)
@@ -1483,78 +2435,181 @@ HRESULT CLR2BGAFilter::Transform(IMediaSample *pIn, IMediaSample *pOut) {
   m_processedFrameCount++; // 計測対象フレーム数
   m_totalProcessTime +=
       (endTime.QuadPart - startTime.QuadPart) * 10000000 / freq.QuadPart;
+  stageStats.Record(STAGE_TOTAL, startTime.QuadPart, endTime.QuadPart, rtStart, TRACE_OUTCOME_OUTPUT);
 
   return S_OK;
 }
 
 // ------------------------------------------------------------------------------
-// Helper: UpdateDebugInfo - デバッグ情報の更新
+// 接続先ピンの所属フィルタ名を取得するヘルパー
+// ------------------------------------------------------------------------------
+static std::wstring GetPeerFilterName(CBasePin *pPin) {
+  std::wstring name = L"Disconnected";
+  if (!pPin || !pPin->IsConnected()) {
+    return name;
+  }
+
+  IPin *pPeer = NULL;
+  pPin->ConnectedTo(&pPeer);
+  if (pPeer) {
+    PIN_INFO pinInfo = {0};
+    if (SUCCEEDED(pPeer->QueryPinInfo(&pinInfo))) {
+      if (pinInfo.pFilter) {
+        FILTER_INFO filterInfo = {0};
+        pinInfo.pFilter->QueryFilterInfo(&filterInfo);
+        name = filterInfo.achName;
+        if (filterInfo.pGraph)
+          filterInfo.pGraph->Release();
+        pinInfo.pFilter->Release();
+      }
+    }
+    pPeer->Release();
+  }
+  return name;
+}
+
+// ------------------------------------------------------------------------------
+// Helper: RefreshGraphTopology - フィルタグラフ構成の更新
+//
+// 役割:
+//   上流・下流の接続先フィルタ名とフィルタグラフ全体の構成を取得し、
+//   デバッグウィンドウへ渡します。
+//
+// 注意:
+//   ピンやフィルタを COM で辿るため、フレームごとには呼ばず、
+//   接続・切断 (CompleteConnect / BreakConnect) とストリーミング開始時にだけ呼びます。
+//   BreakConnect では切断される側を includeUpstream / includeDownstream で除きます。
+// ------------------------------------------------------------------------------
+void CLR2BGAFilter::RefreshGraphTopology(bool includeUpstream, bool includeDownstream) {
+  if (!m_pWindow)
+    return;
+
+  try {
+    std::wstring inputName = includeUpstream ? GetPeerFilterName(m_pInput) : L"Disconnected";
+    std::wstring outputName = includeDownstream ? GetPeerFilterName(m_pOutput) : L"Disconnected";
+    std::wstring graphInfo = GetFilterGraphInfo(includeUpstream, includeDownstream);
+    m_pWindow->SetGraphTopology(inputName, outputName, graphInfo);
+  } catch (const std::bad_alloc&) {
+    // 表示用の情報のため、確保に失敗した場合は前回の構成のままにする
+  }
+}
+
+// ------------------------------------------------------------------------------
+// Helper: PublishDebugStats - デバッグ統計の公開
 //
 // 役割:
-//   現在のフィルタ状態（接続情報、画像サイズ、フレームレート、統計情報）を
-//   UIウィンドウに反映させます。
+//   現在のフィルタ状態（画像サイズ、フレームレート、統計情報）をまとめて
+//   デバッグウィンドウへ渡します。
 //
 // 処理内容:
-//   1. 設定フラグ (m_debugMode) をチェック。無効なら何もしない。
+//   1. デバッグウィンドウが開いていない、または前回から kDebugStatsPublishIntervalMs
+//      経っていなければ何もしない (表示の更新周期より細かく集めても捨てられるだけのため)。
 //   2. 平均処理時間を計算 (m_totalProcessTime / m_processedFrameCount)。
-//   3. 上流・下流の接続先フィルタ名を取得。
-//   4. UIウィンドウの更新メソッドを呼び出し、全情報を渡す。
+//   3. 各統計を FilterDebugStats へ集め、ロックフリーで公開する。
+//      テキストの生成と描画はデバッグウィンドウのスレッドが行う。
 // ------------------------------------------------------------------------------
-void CLR2BGAFilter::UpdateDebugInfo() {
-  if (!m_pSettings->m_debugMode)
+void CLR2BGAFilter::PublishDebugStats(LONGLONG nowQpc) {
+  constexpr LONGLONG kDebugStatsPublishIntervalMs = 100;
+
+  if (!m_pWindow || !m_pWindow->IsDebugWindowOpen())
+    return;
+  if (m_lastDebugPublishQpc != 0 &&
+      nowQpc - m_lastDebugPublishQpc < m_qpcFrequency.QuadPart * kDebugStatsPublishIntervalMs / 1000) {
     return;
+  }
+  m_lastDebugPublishQpc = nowQpc;
 
   if (m_totalProcessTime > 0 && m_processedFrameCount > 0) {
     m_avgProcessTime = (double)m_totalProcessTime / m_processedFrameCount / 10000.0;
   }
 
-  // 上流・下流の接続情報を取得 (Header表示用)
-  PIN_INFO pinInfo = {0};
-  std::wstring inputName = L"Disconnected";
-  std::wstring outputName = L"Disconnected";
-
-  if (m_pInput->IsConnected()) {
-    IPin *pPeer = NULL;
-    m_pInput->ConnectedTo(&pPeer);
-    if (pPeer) {
-      if (SUCCEEDED(pPeer->QueryPinInfo(&pinInfo))) {
-        if (pinInfo.pFilter) {
-          FILTER_INFO filterInfo = {0};
-          pinInfo.pFilter->QueryFilterInfo(&filterInfo);
-          inputName = filterInfo.achName;
-          filterInfo.pGraph->Release();
-          pinInfo.pFilter->Release();
-        }
-      }
-      pPeer->Release();
-    }
+  FilterDebugStats stats = {};
+  stats.inputWidth = m_inputWidth;
+  stats.inputHeight = m_inputHeight;
+  stats.inputBitCount = m_inputBitCount;
+  stats.outputWidth = m_activeWidth;
+  stats.outputHeight = m_activeHeight;
+  stats.frameRate = m_frameRate;
+  stats.outputFrameRate = m_pTransformLogic->GetStageStats().GetOutputFrameRate();
+  stats.frameCount = m_frameCount;
+  stats.droppedFrames = m_pTransformLogic->GetDroppedFrames();
+  stats.avgTime = m_avgProcessTime;
+  stats.lbInfo = m_pTransformLogic->GetDetector().GetDebugInfo();
+
+  // 入力アロケータの状態とLR2向け出力の受け渡し統計
+  static_cast<CLR2BGAInputPin *>(m_pInput)->GetAllocatorInfo(stats.allocInfo);
+  static_cast<CLR2BGAOutputPin *>(m_pOutput)->GetDeliveryInfo(stats.deliveryInfo,
+                                                              m_qpcFrequency.QuadPart);
+  stats.deliveryInfo.zeroCopy = m_activeInPlace;
+  stats.deliveryInfo.zeroCopySamples = m_inPlaceFrameCount;
+  stats.qualityInfo.proportion = m_upstreamQuality.proportion;
+  stats.qualityInfo.famine = (m_upstreamQuality.type == Famine);
+  stats.qualityInfo.lateMs = m_upstreamQuality.late / 10000.0;
+  stats.qualityInfo.messagesSent = m_upstreamQuality.messagesSent;
+  stats.qualityInfo.lastResult = m_upstreamQuality.lastResult;
+  stats.qualityInfo.upstreamSkipped = m_upstreamQuality.upstreamSkipped;
+  m_pTransformLogic->GetFrameIntervalHistogram(stats.intervalHist);
+  m_pTransformLogic->GetCadenceInfo(stats.cadenceInfo);
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    m_pTransformLogic->GetStageStats().GetStageLatency((LR2BGAStage)i, stats.stageLatency[i]);
   }
 
-  if (m_pOutput->IsConnected()) {
-    IPin *pPeer = NULL;
-    m_pOutput->ConnectedTo(&pPeer);
-    if (pPeer) {
-      if (SUCCEEDED(pPeer->QueryPinInfo(&pinInfo))) {
-        if (pinInfo.pFilter) {
-          FILTER_INFO filterInfo = {0};
-          pinInfo.pFilter->QueryFilterInfo(&filterInfo);
-          outputName = filterInfo.achName;
-          filterInfo.pGraph->Release();
-          pinInfo.pFilter->Release();
-        }
-      }
-      pPeer->Release();
-    }
-  }
+  m_pWindow->PublishDebugStats(stats);
+}
 
-  // フィルタグラフ全体の情報を取得
-  std::wstring graphInfo = GetFilterGraphInfo();
+//------------------------------------------------------------------------------
+// Helper: PublishSharedStats - 外部ツール向けの統計の公開
+//
+// 外部ツールは共有メモリを任意の周期で読むため、ここでは一定間隔に間引いて書くだけにする。
+// 書き込みはシーケンスロックのため、読み取り側が遅くてもストリーミングスレッドは待たない。
+//------------------------------------------------------------------------------
+void CLR2BGAFilter::PublishSharedStats(LONGLONG nowQpc, const RECT *pCropRect, bool streaming) {
+  constexpr LONGLONG kSharedStatsPublishIntervalMs = 50;
 
-  m_pWindow->UpdateDebugInfo(
-      inputName, outputName, graphInfo, m_inputWidth, m_inputHeight,
-      m_inputBitCount, m_pSettings->m_outputWidth, m_pSettings->m_outputHeight,
-      m_frameRate, m_outputFrameRate, m_frameCount, m_pTransformLogic->GetDroppedFrames(),
-      m_avgProcessTime, m_pTransformLogic->GetDetector().GetDebugInfo());
+  if (!m_sharedStats.IsOpen())
+    return;
+  if (streaming && m_lastSharedStatsPublishQpc != 0 &&
+      nowQpc - m_lastSharedStatsPublishQpc < m_qpcFrequency.QuadPart * kSharedStatsPublishIntervalMs / 1000) {
+    return;
+  }
+  m_lastSharedStatsPublishQpc = nowQpc;
+
+  const LR2BGAStageStats &stageStats = m_pTransformLogic->GetStageStats();
+  LR2BGAStageLatency total = {};
+  LR2BGAStageLatency deliver = {};
+  stageStats.GetStageLatency(STAGE_TOTAL, total);
+  stageStats.GetStageLatency(STAGE_DELIVER, deliver);
+
+  LR2BGASharedStatsData data = {};
+  data.updateQpc = nowQpc;
+  data.qpcFrequency = m_qpcFrequency.QuadPart;
+  data.streaming = streaming ? 1 : 0;
+  data.letterboxMode = m_pTransformLogic->GetCurrentLetterboxMode();
+  data.cropActive = pCropRect ? 1 : 0;
+  if (pCropRect) {
+    data.cropRect = *pCropRect;
+  } else {
+    SetRect(&data.cropRect, 0, 0, m_inputWidth, m_inputHeight);
+  }
+  data.inputWidth = m_inputWidth;
+  data.inputHeight = m_inputHeight;
+  data.inputBitCount = m_inputBitCount;
+  data.outputWidth = m_activeWidth;
+  data.outputHeight = m_activeHeight;
+  data.inputFrameRate = m_frameRate;
+  data.outputFrameRate = stageStats.GetOutputFrameRate();
+  data.inputFrames = m_inputFrameCount;
+  data.outputFrames = m_frameCount;
+  data.droppedFrames = m_pTransformLogic->GetDroppedFrames();
+  data.avgProcessMs = (m_processedFrameCount > 0)
+                          ? (double)m_totalProcessTime / m_processedFrameCount / 10000.0
+                          : 0.0;
+  data.processP95Ms = total.p95Ms;
+  data.processP99Ms = total.p99Ms;
+  data.processMaxMs = total.maxMs;
+  data.deliverP95Ms = deliver.p95Ms;
+
+  m_sharedStats.Publish(data);
 }
 
 // ------------------------------------------------------------------------------
@@ -1652,17 +2707,19 @@ void CollectDownstream(IPin *pPin, std::vector<std::wstring> &filters,
   }
 }
 
-std::wstring CLR2BGAFilter::GetFilterGraphInfo() {
+std::wstring CLR2BGAFilter::GetFilterGraphInfo(bool includeUpstream, bool includeDownstream) {
   std::vector<std::wstring> filters;
 
   // 1. 上流を収集
-  CollectUpstream(m_pInput, filters, 1);
+  if (includeUpstream)
+    CollectUpstream(m_pInput, filters, 1);
 
   // 2. 自分自身を追加
   filters.push_back(L"LR2 BGA Filter (Me)");
 
   // 3. 下流を収集
-  CollectDownstream(m_pOutput, filters, 1);
+  if (includeDownstream)
+    CollectDownstream(m_pOutput, filters, 1);
 
   // 番号付きリスト文字列を作成
   std::wstring info = L"";
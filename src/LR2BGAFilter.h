@@ -24,6 +24,8 @@
 #include "LR2BGATransformLogic.h"
 #include "LR2BGAWindow.h"
 #include "LR2MemoryMonitor.h"
+#include "LR2BGAVideoCache.h"
+#include "LR2BGASharedStats.h"
 
 //------------------------------------------------------------------------------
 // Filter GUID
@@ -46,6 +48,13 @@ DEFINE_GUID(CLSID_LR2BGAFilterPropertyPage, 0x2563d58e, 0xa087, 0x4d0f, 0xaf, 0x
 DEFINE_GUID(IID_ILR2BGAFilterSettings, 0xf42a4b4d, 0xc9fd, 0x4dcd, 0x9c, 0xd0, 0xae,
             0xbe, 0x95, 0xf8, 0x1f, 0x82);
 
+//------------------------------------------------------------------------------
+// Statistics Interface GUID
+// {C61CE82A-7589-450C-943A-5AF381E1DB71}
+//------------------------------------------------------------------------------
+DEFINE_GUID(IID_ILR2BGAFilterStats, 0xc61ce82a, 0x7589, 0x450c, 0x94, 0x3a, 0x5a,
+            0xf3, 0x81, 0xe1, 0xdb, 0x71);
+
 //------------------------------------------------------------------------------
 // Operation Modes
 //------------------------------------------------------------------------------
@@ -171,34 +180,163 @@ DECLARE_INTERFACE_(ILR2BGAFilterSettings, IUnknown) {
 
   STDMETHOD(GetOnlyOutputToRenderer)(THIS_ BOOL * pEnabled) PURE;
   STDMETHOD(SetOnlyOutputToRenderer)(THIS_ BOOL enabled) PURE;
+
+  // 外部ウィンドウ更新上限FPS (0: 制限なし, 1-240)
+  STDMETHOD(GetExternalWindowMaxFPS)(THIS_ int *pMaxFPS) PURE;
+  STDMETHOD(SetExternalWindowMaxFPS)(THIS_ int maxFPS) PURE;
+
+  // 外部ウィンドウ画質の自動調整 (描画コスト超過時に最近傍/縮小解像度へ段階的に切り替え)
+  STDMETHOD(GetExternalWindowAdaptiveQuality)(THIS_ BOOL * pEnabled) PURE;
+  STDMETHOD(SetExternalWindowAdaptiveQuality)(THIS_ BOOL enabled) PURE;
+
+  // 他のウィンドウに完全に覆われている間、外部ウィンドウの更新を止める
+  STDMETHOD(GetExternalWindowPauseWhenOccluded)(THIS_ BOOL * pEnabled) PURE;
+  STDMETHOD(SetExternalWindowPauseWhenOccluded)(THIS_ BOOL enabled) PURE;
+
+  // LR2向け出力バッファ数 (1-4, 次回接続時に反映)
+  STDMETHOD(GetOutputBufferCount)(THIS_ int *pCount) PURE;
+  STDMETHOD(SetOutputBufferCount)(THIS_ int count) PURE;
+
+  // LR2への受け渡しを専用スレッドで行うパイプラインモード (次回ストリーミング開始時に反映)
+  STDMETHOD(GetOutputPipelined)(THIS_ BOOL * pEnabled) PURE;
+  STDMETHOD(SetOutputPipelined)(THIS_ BOOL enabled) PURE;
+};
+
+//------------------------------------------------------------------------------
+// ILR2BGAFilterStats インターフェース
+// 性能統計の取得用 (読み取り専用)。任意のスレッドから呼べ、ストリーミングを止めない
+//------------------------------------------------------------------------------
+DECLARE_INTERFACE_(ILR2BGAFilterStats, IUnknown) {
+  // 処理段階ごとの所要時間 (stage: LR2BGAStage。範囲外は E_INVALIDARG)
+  STDMETHOD(GetStageLatency)(THIS_ int stage, LR2BGAStageLatency *pLatency) PURE;
+
+  // 直近1秒の実測出力フレームレート (出力が途絶えている場合は 0)
+  STDMETHOD(GetOutputFrameRate)(THIS_ double *pFps) PURE;
+
+  // 段階ごとの所要時間のリセット (ILR2BGAFilterSettings::ResetPerformanceStatistics と同じ)
+  STDMETHOD(ResetStatistics)(THIS) PURE;
+
+  // フレームごとのトレースを Chrome Trace 形式の JSON へ書き出す
+  // (pszPath が NULL の場合は %TEMP%\LR2BGAFilter_trace_YYYYMMDD_HHMMSS.json)
+  STDMETHOD(SaveTrace)(THIS_ LPCWSTR pszPath) PURE;
+};
+
+//------------------------------------------------------------------------------
+// CLR2BGAInputAllocator クラス
+// 入力ピンが上流へ提案するアロケータ。CMemAllocator のプール (解放は設定変更時と破棄時のみ)
+// をそのまま使い、サンプル先頭を 64 バイト境界に揃え、末尾に SIMD の読み越し用の余白を足す
+//------------------------------------------------------------------------------
+class CLR2BGAInputAllocator : public CMemAllocator {
+public:
+  CLR2BGAInputAllocator(HRESULT *phr)
+      : CMemAllocator(NAME("LR2 BGA Input Allocator"), NULL, phr) {}
+
+  STDMETHOD(SetProperties)(ALLOCATOR_PROPERTIES *pRequest,
+                           ALLOCATOR_PROPERTIES *pActual) override;
 };
 
 //------------------------------------------------------------------------------
 // CLR2BGAInputPin クラス
 // 再帰接続（自分自身への接続）を防ぐためのカスタム入力ピン
+// 上流には CLR2BGAInputAllocator を提案し、実際に採用されたアロケータを記録する
 //------------------------------------------------------------------------------
 class CLR2BGAInputPin : public CTransformInputPin {
 public:
   CLR2BGAInputPin(TCHAR *pObjectName, CTransformFilter *pTransformFilter,
-                  HRESULT *phr, LPCWSTR pName)
-      : CTransformInputPin(pObjectName, pTransformFilter, phr, pName) {}
+                  HRESULT *phr, LPCWSTR pName);
+  ~CLR2BGAInputPin();
 
   // CheckConnectをオーバーライドして上流フィルタを検証
   HRESULT CheckConnect(IPin *pPin) override;
+
+  // IMemInputPin: 自前のアロケータを提案し、上流の決定を受け取る
+  STDMETHOD(GetAllocator)(IMemAllocator **ppAllocator) override;
+  STDMETHOD(NotifyAllocator)(IMemAllocator *pAllocator, BOOL bReadOnly) override;
+  STDMETHOD(GetAllocatorRequirements)(ALLOCATOR_PROPERTIES *pProps) override;
+
+  // 入力サンプルの先頭アドレスと行ストライドの境界を記録 (ストリーミングスレッドから呼ぶこと)
+  void RecordSampleAlignment(const BYTE *pData, int stride);
+  void GetAllocatorInfo(InputAllocatorInfo &info);
+
+private:
+  CLR2BGAInputAllocator *m_pOwnAllocator; // 接続をまたいで保持する (バッファのプールを再利用)
+  bool m_bOwnAllocatorInUse;              // 上流が自前のアロケータを採用したか
+  ALLOCATOR_PROPERTIES m_allocProps;      // 採用されたアロケータの確定プロパティ
+  LONGLONG m_alignedSamples;              // 先頭が 64 バイト境界だったサンプル数
+  LONGLONG m_totalSamples;
+  bool m_bStrideAligned;                  // 行ストライドが 64 バイトの倍数か
+};
+
+//------------------------------------------------------------------------------
+// CLR2BGAOutputQueue クラス
+// LR2への受け渡しを専用スレッドで行う COutputQueue (キュー長の参照のみ追加)
+//------------------------------------------------------------------------------
+class CLR2BGAOutputQueue : public COutputQueue {
+public:
+  CLR2BGAOutputQueue(IPin *pInputPin, HRESULT *phr)
+      : COutputQueue(pInputPin, phr, FALSE /* bAuto */, TRUE /* bQueue */, 1, FALSE,
+                     DEFAULTCACHE, THREAD_PRIORITY_ABOVE_NORMAL) {}
+
+  // 下流へ未送信のサンプル数
+  int GetQueuedCount() {
+    CAutoLock lck(this);
+    return m_List ? m_List->GetCount() : 0;
+  }
 };
 
 //------------------------------------------------------------------------------
 // CLR2BGAOutputPin クラス
 // 接続先フィルタの制限を行うためのカスタム出力ピン
+// パイプラインモードでは CLR2BGAOutputQueue 経由で下流へ受け渡し、
+// Transform が次フレームを処理している間にLR2側の受け取りを並行させる
 //------------------------------------------------------------------------------
 class CLR2BGAOutputPin : public CTransformOutputPin {
 public:
   CLR2BGAOutputPin(TCHAR *pObjectName, CTransformFilter *pTransformFilter,
-                   HRESULT *phr, LPCWSTR pName)
-      : CTransformOutputPin(pObjectName, pTransformFilter, phr, pName) {}
+                   HRESULT *phr, LPCWSTR pName);
+  ~CLR2BGAOutputPin();
 
   // CheckConnectをオーバーライドして下流フィルタを検証
   HRESULT CheckConnect(IPin *pPin) override;
+
+  // ストリーミング開始/停止に合わせて受け渡しキューを生成/破棄
+  HRESULT Active() override;
+  HRESULT Inactive() override;
+
+  // 下流への受け渡し (パイプラインモード時はキューへ投函)
+  HRESULT Deliver(IMediaSample *pSample) override;
+  HRESULT DeliverEndOfStream() override;
+  HRESULT DeliverBeginFlush() override;
+  HRESULT DeliverEndFlush() override;
+  HRESULT DeliverNewSegment(REFERENCE_TIME tStart, REFERENCE_TIME tStop,
+                            double dRate) override;
+
+  // 統計 (ストリーミングスレッドから呼ぶこと)
+  void RecordBufferWait(LONGLONG waitQpc);
+  void GetDeliveryInfo(OutputDeliveryInfo &info, LONGLONG qpcFrequency);
+  // 任意のスレッドから呼べる。実際のクリアは次の受け渡し時にストリーミングスレッドで行う
+  void RequestStatisticsReset() { m_bResetRequested = true; }
+
+  // DecideBufferSize で確定したバッファ数
+  void SetActualBufferCount(int count) { m_actualBufferCount = count; }
+
+private:
+  struct DeliveryStats {
+    LONGLONG samples;
+    LONGLONG deliverQpcSum;
+    LONGLONG deliverQpcMax;
+    LONGLONG bufferWaits;
+    LONGLONG bufferWaitQpcSum;
+    LONGLONG bufferWaitQpcMax;
+    LONGLONG queueDepthSum;
+    int queueDepthMax;
+  };
+  void ApplyPendingReset();
+
+  CLR2BGAOutputQueue *m_pQueue; // パイプラインモード中のみ有効 (Active で生成、Inactive で破棄)
+  int m_actualBufferCount;
+  DeliveryStats m_stats;
+  std::atomic<bool> m_bResetRequested;
 };
 
 //------------------------------------------------------------------------------
@@ -208,7 +346,8 @@ public:
 
 class CLR2BGAFilter : public CTransformFilter,
                       public ISpecifyPropertyPages,
-                      public ILR2BGAFilterSettings {
+                      public ILR2BGAFilterSettings,
+                      public ILR2BGAFilterStats {
 public:
   // ファクトリメソッド
   static CUnknown *WINAPI CreateInstance(LPUNKNOWN pUnk, HRESULT *phr);
@@ -306,6 +445,25 @@ public:
   STDMETHOD(GetOnlyOutputToRenderer)(BOOL *pEnabled) override;
   STDMETHOD(SetOnlyOutputToRenderer)(BOOL enabled) override;
 
+  STDMETHOD(GetExternalWindowMaxFPS)(int *pMaxFPS) override;
+  STDMETHOD(SetExternalWindowMaxFPS)(int maxFPS) override;
+  STDMETHOD(GetExternalWindowAdaptiveQuality)(BOOL *pEnabled) override;
+  STDMETHOD(SetExternalWindowAdaptiveQuality)(BOOL enabled) override;
+  STDMETHOD(GetExternalWindowPauseWhenOccluded)(BOOL *pEnabled) override;
+  STDMETHOD(SetExternalWindowPauseWhenOccluded)(BOOL enabled) override;
+  STDMETHOD(GetOutputBufferCount)(int *pCount) override;
+  STDMETHOD(SetOutputBufferCount)(int count) override;
+  STDMETHOD(GetOutputPipelined)(BOOL *pEnabled) override;
+  STDMETHOD(SetOutputPipelined)(BOOL enabled) override;
+
+  //--------------------------------------------------------------------------
+  // ILR2BGAFilterStats
+  //--------------------------------------------------------------------------
+  STDMETHOD(GetStageLatency)(int stage, LR2BGAStageLatency *pLatency) override;
+  STDMETHOD(GetOutputFrameRate)(double *pFps) override;
+  STDMETHOD(ResetStatistics)() override;
+  STDMETHOD(SaveTrace)(LPCWSTR pszPath) override;
+
   //--------------------------------------------------------------------------
   // CTransformFilter Overrides
   //--------------------------------------------------------------------------
@@ -327,12 +485,28 @@ public:
   // 出力メディアタイプの取得
   HRESULT GetMediaType(int iPosition, CMediaType *pMediaType) override;
 
+  // サンプル受信 (出力を m_pOutput->Deliver 経由で渡し、出力バッファ待ちを計測する)
+  HRESULT Receive(IMediaSample *pSample) override;
+
   // フレーム変換処理 (Transform)
   HRESULT Transform(IMediaSample *pIn, IMediaSample *pOut) override;
 
+  // 下流からの品質メッセージ (自前の要求を上流へ送っている間は転送しない)
+  HRESULT AlterQuality(Quality q) override;
+
   // ストリーミング開始/終了
   HRESULT StartStreaming() override;
   HRESULT StopStreaming() override;
+  // 停止 (ロックの解放後に動画キャッシュを保存する)
+  STDMETHODIMP Stop() override;
+
+  // ストリーム終了/フラッシュ (ダミーモードで先行して送った EndOfStream の管理)
+  HRESULT EndOfStream() override;
+  HRESULT EndFlush() override;
+
+  // ピンの接続・切断 (デバッグ表示用のフィルタグラフ構成をここでだけ取得する)
+  HRESULT CompleteConnect(PIN_DIRECTION direction, IPin *pReceivePin) override;
+  HRESULT BreakConnect(PIN_DIRECTION direction) override;
 
   // 黒帯検出スレッド制御 (TransformLogicへ委譲)
   void StartLetterboxThread();
@@ -352,10 +526,32 @@ public:
 
 private:
   // 内部ヘルパー
-  std::wstring GetFilterGraphInfo();
-
-  // デバッグ情報の更新
-  void UpdateDebugInfo();
+  std::wstring GetFilterGraphInfo(bool includeUpstream, bool includeDownstream);
+
+  // フィルタグラフの構成 (接続先のフィルタ名など) を取得してデバッグウィンドウへ渡す
+  // COM でグラフを辿るため、フレームごとではなく接続・切断・ストリーミング開始時にだけ呼ぶ
+  void RefreshGraphTopology(bool includeUpstream, bool includeDownstream);
+
+  // デバッグ統計の公開 (ストリーミングスレッドから。kDebugStatsPublishIntervalMs ごとに間引く)
+  void PublishDebugStats(LONGLONG nowQpc);
+  // 外部ツール向けの共有メモリへの公開 (ストリーミングスレッドから。kSharedStatsPublishIntervalMs ごとに間引く)
+  // pCropRect: 今回のフレームの切り出し範囲 (NULL: 入力全体), streaming=false で停止を通知 (間引かない)
+  void PublishSharedStats(LONGLONG nowQpc, const RECT *pCropRect, bool streaming);
+
+  // フレーム処理の本体 (pOut == NULL でゼロコピー。Transform と Receive から呼ばれる)
+  // cfg: Receive の先頭で取得した設定スナップショット (フレーム内で値が変わらない)
+  HRESULT ProcessFrame(IMediaSample *pIn, IMediaSample *pOut, const LR2BGASettings::Snapshot &cfg);
+  // 入力サンプルをそのまま出力できるフレームか
+  bool IsInPlaceFrame(IMediaSample *pSample, const LR2BGASettings::Snapshot &cfg);
+  // フレームを下流へ渡し、受け渡しの所要時間と出力時刻を記録する
+  HRESULT DeliverFrame(IMediaSample *pSample);
+  // 出力しなかったフレームを記録し、初回のみ EC_QUALITY_CHANGE を通知する
+  void NotifySampleSkipped();
+  // ダミーモードで黒フレームを渡した後、ストリームを終えて上流のデコードを止めるか
+  bool ShouldEndDummyStream(const LR2BGASettings::Snapshot &cfg) const;
+  // 上流への品質制御 (FPS制限で捨てるフレームをデコード前に減らすよう要求する)
+  void UpdateUpstreamQuality(IMediaSample *pIn, REFERENCE_TIME rtStart,
+                             const LR2BGASettings::Snapshot &cfg);
 
   // Transform Helpers
   void ProcessLetterboxDetection(const BYTE* pSrcData, long actualDataLength, int srcWidth, int srcHeight, int srcStride, int srcBitCount, RECT& srcRect, RECT*& pSrcRect);
@@ -377,17 +573,15 @@ public:
   //--------------------------------------------------------------------------
   // 複数のミューテックスを必要とする場合、必ず以下の順序で取得すること:
   //   1. m_csReceive     (最外側: DirectShow BaseClass のクリティカルセクション)
-  //   2. m_mtxLBControl  (レターボックス検出スレッド制御)
-  //   3. m_mtxLBBuffer   (検出用バッファへのアクセス)
-  //   4. m_mtxLBMode     (最内側: 現在のレターボックスモード)
+  //   2. m_mtxLBControl  (レターボックス検出スレッド制御・輝度サムネイルの受け渡し)
+  //   3. m_mtxLBMode     (最内側: 現在のレターボックスモード)
   //
   // 注意:
   //   - ロックを保持したまま GUI 操作 (SendMessage 等) を行わないこと。
   //   - ロックのスコープはできるだけ短くすること。
   //--------------------------------------------------------------------------
   LR2BGALetterboxDetector m_lbDetector;
-  std::mutex m_mtxLBMode;     // 4. 最内側: m_currentLBMode へのアクセス保護
-  std::mutex m_mtxLBBuffer;   // 3. m_lbBuffer へのアクセス保護
+  std::mutex m_mtxLBMode;     // 3. 最内側: m_currentLBMode へのアクセス保護
   LetterboxMode m_currentLBMode;
 
   // 非同期検出スレッド (Async Detection Thread)
@@ -410,22 +604,45 @@ public:
   LONGLONG m_totalProcessTime; // 総処理時間 (100ns単位)
   double m_avgProcessTime;     // 平均処理時間 (ms)
   double m_frameRate;          // 入力フレームレート
-  double m_outputFrameRate;    // 実測出力フレームレート
   LARGE_INTEGER m_qpcFrequency; // QPC周波数キャッシュ
 
   // 設定モード
   BOOL m_bConfigMode;
 
-  // フィルタグラフ情報 (デバッグ表示用)
-  std::wstring m_inputFilterName;
-  std::wstring m_outputFilterName;
-  std::wstring m_filterGraphInfo;
+  // デバッグ統計を最後に公開した時刻 (QPC、ストリーミングスレッド専用)
+  LONGLONG m_lastDebugPublishQpc;
+
+  // 外部ツール向けの統計の共有メモリ (最初の StartStreaming で開き、フィルタの破棄まで保持)
+  LR2BGASharedStats m_sharedStats;
+  LONGLONG m_lastSharedStatsPublishQpc; // 最後に公開した時刻 (QPC、ストリーミングスレッド専用)
 
   // 設定値のラッチ (クラッシュ防止のためストリーミング開始時に固定)
   bool m_activePassthrough;
   bool m_activeDummy;
   int m_activeWidth;
   int m_activeHeight;
+  bool m_activePipelined;      // 出力ピンの Active で参照 (StartStreaming の後に呼ばれる)
+  bool m_activeInPlace;        // RGB24 パススルー: 入力サンプルをそのまま下流へ渡す (ゼロコピー)
+  LONGLONG m_receiveEnterQpc;  // Receive 開始時刻 (Transform 開始までの差分が出力バッファ待ち)
+  LONGLONG m_inPlaceFrameCount; // ゼロコピーで渡したフレーム数 (デバッグ表示用)
+  // ダミーモードで EndOfStream を送り、上流からのサンプルを拒否している
+  // (ストリーミングスレッドで設定、EndFlush/StartStreaming でリセット)
+  std::atomic<bool> m_dummyStreamEnded;
+  const LR2BGASettings::Snapshot *m_pFrameSettings; // Receive 中の設定スナップショット (Transform へ渡すため)
+
+  // 上流への品質制御 (ストリーミングスレッドのみが更新、StartStreaming でリセット)
+  struct UpstreamQualityState {
+    ULONGLONG lastSentTick;     // 最後に送信した時刻 (GetTickCount64)
+    int proportion;             // 最後に送った Proportion (1000: 通常レート)
+    QualityMessageType type;
+    REFERENCE_TIME late;
+    REFERENCE_TIME prevStart;   // 直前の入力開始時刻 (上流のスキップ検出用、-1: なし)
+    LONGLONG messagesSent;
+    LONGLONG upstreamSkipped;
+    HRESULT lastResult;
+  };
+  UpstreamQualityState m_upstreamQuality;
+  std::atomic<bool> m_upstreamRateReduced; // AlterQuality (下流のスレッド) から参照
 
   // リサイズ用LUTバッファ (メモリ再確保抑制)
   std::vector<int> m_lutXIndices;
@@ -433,6 +650,18 @@ public:
 
   // メモリ監視クラス（シーン検知用）
   std::unique_ptr<LR2MemoryMonitor> m_pMemoryMonitor;
+
+  // 動画キャッシュ (StartStreaming で参照、StopStreaming で保存)
+  LR2BGAVideoCache m_videoCache;
+  VideoFileIdentity m_sourceIdentity; // 再生中の動画ファイル (取得できない場合は path が空)
+  REFERENCE_TIME m_avgTimePerFrame;   // 入力フレーム間隔 (キャッシュ保存用)
+  bool m_streamAutoRemoveLetterbox;   // StartStreaming でラッチした黒帯除去の有効状態 (キャッシュ保存用)
+  int m_streamLbThreshold;            // StartStreaming でラッチした黒閾値 (キャッシュのキーと照合)
+  // StopStreaming で確定し、Stop がロックの解放後に保存するエントリ
+  std::mutex m_mtxCacheStore;
+  bool m_cacheStorePending;
+  VideoFileIdentity m_cacheStoreIdentity;
+  VideoCacheEntry m_cacheStoreEntry;
 };
 
 
@@ -47,6 +47,8 @@ CLR2BGAFilterPropertyPage::CLR2BGAFilterPropertyPage(LPUNKNOWN pUnk)
     , m_maxFPS(0)
     , m_dummyMode(FALSE)
     , m_passthroughMode(FALSE)
+    , m_outputBufferCount(1)
+    , m_outputPipelined(FALSE)
     , m_extEnabled(FALSE)
     , m_extX(0)
     , m_extY(0)
@@ -56,6 +58,9 @@ CLR2BGAFilterPropertyPage::CLR2BGAFilterPropertyPage(LPUNKNOWN pUnk)
     , m_extKeepAspect(TRUE)
     , m_extPassthrough(FALSE)
     , m_extTopmost(TRUE)
+    , m_extMaxFPS(0)
+    , m_extAdaptiveQuality(TRUE)
+    , m_extPauseWhenOccluded(FALSE)
     , m_brightnessLR2(100)
     , m_brightnessExt(100)
     , m_autoOpen(FALSE)
@@ -109,6 +114,9 @@ HRESULT CLR2BGAFilterPropertyPage::OnConnect(IUnknown* pUnk)
     
     m_pSettings->GetDummyMode(&m_dummyMode);
     m_pSettings->GetPassthroughMode(&m_passthroughMode);
+
+    m_pSettings->GetOutputBufferCount(&m_outputBufferCount);
+    m_pSettings->GetOutputPipelined(&m_outputPipelined);
     
     // External Window
     m_pSettings->GetExternalWindowEnabled(&m_extEnabled);
@@ -118,6 +126,9 @@ HRESULT CLR2BGAFilterPropertyPage::OnConnect(IUnknown* pUnk)
     m_pSettings->GetExternalWindowKeepAspect(&m_extKeepAspect);
     m_pSettings->GetExternalWindowPassthrough(&m_extPassthrough);
     m_pSettings->GetExternalWindowTopmost(&m_extTopmost);
+    m_pSettings->GetExternalWindowMaxFPS(&m_extMaxFPS);
+    m_pSettings->GetExternalWindowAdaptiveQuality(&m_extAdaptiveQuality);
+    m_pSettings->GetExternalWindowPauseWhenOccluded(&m_extPauseWhenOccluded);
 
     // Manual Close
     m_pSettings->GetCloseOnRightClick(&m_closeOnRightClick);
@@ -180,12 +191,14 @@ HRESULT CLR2BGAFilterPropertyPage::OnActivate()
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_WIDTH), UDM_SETRANGE32, 1, 4096);
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_HEIGHT), UDM_SETRANGE32, 1, 4096);
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_MAXFPS), UDM_SETRANGE32, 1, 60);
+    SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_OUTPUT_BUFFERS), UDM_SETRANGE32, 1, 4);
 
     // 外部ウィンドウ用スピン設定
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_EXT_X), UDM_SETRANGE32, -4096, 4096);
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_EXT_Y), UDM_SETRANGE32, -4096, 4096);
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_EXT_WIDTH), UDM_SETRANGE32, 1, 4096);
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_EXT_HEIGHT), UDM_SETRANGE32, 1, 4096);
+    SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_EXT_MAXFPS), UDM_SETRANGE32, 0, 240);
     
     // 黒帯除去用スピン設定
     SendMessage(GetDlgItem(m_Dlg, IDC_SPIN_LB_THRESHOLD), UDM_SETRANGE32, 0, 255);
@@ -241,6 +254,9 @@ HRESULT CLR2BGAFilterPropertyPage::OnApplyChanges()
     
     m_pSettings->SetDummyMode(m_dummyMode);
     m_pSettings->SetPassthroughMode(m_passthroughMode);
+
+    m_pSettings->SetOutputBufferCount(m_outputBufferCount);
+    m_pSettings->SetOutputPipelined(m_outputPipelined);
     
     m_pSettings->SetExternalWindowEnabled(m_extEnabled);
     m_pSettings->SetExternalWindowPosition(m_extX, m_extY);
@@ -249,6 +265,9 @@ HRESULT CLR2BGAFilterPropertyPage::OnApplyChanges()
     m_pSettings->SetExternalWindowKeepAspect(m_extKeepAspect);
     m_pSettings->SetExternalWindowPassthrough(m_extPassthrough);
     m_pSettings->SetExternalWindowTopmost(m_extTopmost);
+    m_pSettings->SetExternalWindowMaxFPS(m_extMaxFPS);
+    m_pSettings->SetExternalWindowAdaptiveQuality(m_extAdaptiveQuality);
+    m_pSettings->SetExternalWindowPauseWhenOccluded(m_extPauseWhenOccluded);
 
     // Manual Close
     m_pSettings->SetCloseOnRightClick(m_closeOnRightClick);
@@ -344,6 +363,11 @@ void CLR2BGAFilterPropertyPage::InitBindings()
     });
     m_bindings.push_back({ IDC_EDIT_MAXFPS, BindType::Int, &m_maxFPS, 1, 60 });
 
+    // 出力バッファ (Output Buffering)
+    // バッファ数は次回接続時、パイプラインは次回の再生開始時に反映される
+    m_bindings.push_back({ IDC_EDIT_OUTPUT_BUFFERS, BindType::Int, &m_outputBufferCount, 1, 4 });
+    m_bindings.push_back({ IDC_CHECK_OUTPUT_PIPELINED, BindType::Bool, &m_outputPipelined });
+
     // 動作モード (Operation Mode)
     m_bindings.push_back({ IDC_CHECK_DUMMY, BindType::Bool, &m_dummyMode });
     m_bindings.push_back({ IDC_CHECK_PASSTHROUGH, BindType::Bool, &m_passthroughMode, 0, 0, false, nullptr,
@@ -371,12 +395,15 @@ void CLR2BGAFilterPropertyPage::InitBindings()
             EnableWindow(GetDlgItem(m_Dlg, IDC_EDIT_EXT_Y), enabled);
             EnableWindow(GetDlgItem(m_Dlg, IDC_RADIO_EXT_TOPMOST), enabled);
             EnableWindow(GetDlgItem(m_Dlg, IDC_RADIO_EXT_BOTTOMMOST), enabled);
+            EnableWindow(GetDlgItem(m_Dlg, IDC_EDIT_EXT_MAXFPS), enabled);
+            EnableWindow(GetDlgItem(m_Dlg, IDC_CHECK_EXT_PAUSE_OCCLUDED), enabled);
             
             BOOL enableSize = enabled && !passthrough;
             EnableWindow(GetDlgItem(m_Dlg, IDC_EDIT_EXT_WIDTH), enableSize);
             EnableWindow(GetDlgItem(m_Dlg, IDC_EDIT_EXT_HEIGHT), enableSize);
             EnableWindow(GetDlgItem(m_Dlg, IDC_COMBO_EXT_ALGO), enableSize);
             EnableWindow(GetDlgItem(m_Dlg, IDC_CHECK_EXT_KEEPASPECT), enableSize);
+            EnableWindow(GetDlgItem(m_Dlg, IDC_CHECK_EXT_ADAPTIVE), enableSize);
         }
     });
 
@@ -388,6 +415,7 @@ void CLR2BGAFilterPropertyPage::InitBindings()
             EnableWindow(GetDlgItem(m_Dlg, IDC_EDIT_EXT_HEIGHT), enableSize);
             EnableWindow(GetDlgItem(m_Dlg, IDC_COMBO_EXT_ALGO), enableSize);
             EnableWindow(GetDlgItem(m_Dlg, IDC_CHECK_EXT_KEEPASPECT), enableSize);
+            EnableWindow(GetDlgItem(m_Dlg, IDC_CHECK_EXT_ADAPTIVE), enableSize);
         }
     });
 
@@ -397,6 +425,10 @@ void CLR2BGAFilterPropertyPage::InitBindings()
     m_bindings.push_back({ IDC_EDIT_EXT_HEIGHT, BindType::Int, &m_extHeight, 1, 4096 });
     m_bindings.push_back({ IDC_COMBO_EXT_ALGO, BindType::Combo, &m_extAlgo });
     m_bindings.push_back({ IDC_CHECK_EXT_KEEPASPECT, BindType::Bool, &m_extKeepAspect });
+    // 外部ウィンドウ専用の更新上限 (LR2向けの FPS制限 とは独立) と画質の自動調整
+    m_bindings.push_back({ IDC_EDIT_EXT_MAXFPS, BindType::Int, &m_extMaxFPS, 0, 240 });
+    m_bindings.push_back({ IDC_CHECK_EXT_ADAPTIVE, BindType::Bool, &m_extAdaptiveQuality });
+    m_bindings.push_back({ IDC_CHECK_EXT_PAUSE_OCCLUDED, BindType::Bool, &m_extPauseWhenOccluded });
     
     // 最前面表示ラジオボタン (バインディングは片方のみで管理し、ApplyToUIで連携)
     // BindType::Bool で特定IDの状態を監視すれば連動する
@@ -88,6 +88,10 @@ private:
   BOOL m_dummyMode;
   BOOL m_passthroughMode;
 
+  // Output buffering
+  int m_outputBufferCount;      // LR2向け出力バッファ数 (1-4, 次回接続時に反映)
+  BOOL m_outputPipelined;       // LR2への受け渡しを専用スレッドで行う
+
   // External window settings
   BOOL m_extEnabled;
   int m_extX;
@@ -98,6 +102,9 @@ private:
   BOOL m_extKeepAspect;
   BOOL m_extPassthrough;
   BOOL m_extTopmost;
+  int m_extMaxFPS;              // 外部ウィンドウ専用の更新上限 (0: 制限なし)
+  BOOL m_extAdaptiveQuality;
+  BOOL m_extPauseWhenOccluded;  // 完全に覆われている間は更新を止める
   
   // Brightness (Added)
   int m_brightnessLR2;
@@ -0,0 +1,129 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAFramePacer.cpp
+// LR2 BGA Filter - FPS制限用の高分解能タイマーとフレーム間隔の集計 実装
+//------------------------------------------------------------------------------
+
+#include "LR2BGAFramePacer.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+//------------------------------------------------------------------------------
+// 定数定義 (Constants)
+//------------------------------------------------------------------------------
+constexpr REFERENCE_TIME kPacerSpinWindow = 5000;  // 最後の 0.5ms はスピンで待つ (タイマーの起床誤差を吸収)
+
+LR2BGAFramePacer::LR2BGAFramePacer()
+    : m_hTimer(NULL),
+      m_highResolution(false),
+      m_qpcFreq(0),
+      m_pClock(NULL),
+      m_lastOutput(0),
+      m_hist(),
+      m_resetRequested(false)
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    m_qpcFreq = (freq.QuadPart > 0) ? freq.QuadPart : 1;
+
+    // 高分解能タイマーは Windows 10 1803 以降。未対応の環境では従来精度のタイマーで代用する
+    m_hTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                      TIMER_ALL_ACCESS);
+    if (m_hTimer) {
+        m_highResolution = true;
+    } else {
+        m_hTimer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+    ClearHistogram();
+}
+
+LR2BGAFramePacer::~LR2BGAFramePacer()
+{
+    if (m_hTimer) {
+        CloseHandle(m_hTimer);
+    }
+}
+
+REFERENCE_TIME LR2BGAFramePacer::Now() const
+{
+    if (m_pClock) return m_pClock->Now();
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    // 乗算のオーバーフローを避けるため秒と端数に分けて換算する
+    return (now.QuadPart / m_qpcFreq) * 10000000LL +
+           (now.QuadPart % m_qpcFreq) * 10000000LL / m_qpcFreq;
+}
+
+//------------------------------------------------------------------------------
+// WaitUntil - 指定時刻までの待機
+// 残り時間から kPacerSpinWindow を引いた分をタイマーで眠り、最後はスピンで合わせる。
+// 従来精度のタイマーでは起床が最大で1ティック (約15.6ms) 遅れるが、スピンは延ばさない
+// (CPUを浪費するより、旧実装の Sleep と同じ精度に留める)。
+//------------------------------------------------------------------------------
+void LR2BGAFramePacer::WaitUntil(REFERENCE_TIME deadline, REFERENCE_TIME maxWait)
+{
+    REFERENCE_TIME now = Now();
+    REFERENCE_TIME remain = deadline - now;
+    if (remain <= 0) return;
+    if (remain > maxWait) {
+        remain = maxWait;
+        deadline = now + remain;
+    }
+    if (m_pClock) {
+        m_pClock->WaitUntil(deadline);
+        return;
+    }
+
+    if (remain > kPacerSpinWindow) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(remain - kPacerSpinWindow);  // 相対時間 (100ns単位)
+        if (m_hTimer && SetWaitableTimer(m_hTimer, &due, 0, NULL, NULL, FALSE)) {
+            WaitForSingleObject(m_hTimer, INFINITE);
+        } else {
+            Sleep((DWORD)((remain - kPacerSpinWindow) / 10000));
+        }
+    }
+
+    while (Now() < deadline) {
+        YieldProcessor();
+    }
+}
+
+//------------------------------------------------------------------------------
+// RecordOutput - 出力間隔の記録
+//------------------------------------------------------------------------------
+void LR2BGAFramePacer::RecordOutput(REFERENCE_TIME now, REFERENCE_TIME targetInterval)
+{
+    if (m_resetRequested.exchange(false)) {
+        ClearHistogram();
+    }
+    m_hist.targetMs = targetInterval / 10000.0;
+
+    if (m_lastOutput > 0 && now > m_lastOutput) {
+        const double ms = (now - m_lastOutput) / 10000.0;
+        int bucket = (int)(ms / kFrameIntervalBucketMs);
+        if (bucket >= kFrameIntervalBucketCount) bucket = kFrameIntervalBucketCount - 1;
+        m_hist.counts[bucket]++;
+        if (m_hist.samples == 0 || ms < m_hist.minMs) m_hist.minMs = ms;
+        if (ms > m_hist.maxMs) m_hist.maxMs = ms;
+        m_hist.samples++;
+        m_hist.sumMs += ms;
+        m_hist.sumSqMs += ms * ms;
+    }
+    m_lastOutput = now;
+}
+
+void LR2BGAFramePacer::GetHistogram(FrameIntervalHistogram& out) const
+{
+    out = m_hist;
+    out.highResolution = m_highResolution;
+}
+
+void LR2BGAFramePacer::ClearHistogram()
+{
+    const double targetMs = m_hist.targetMs;
+    m_hist = FrameIntervalHistogram();
+    m_hist.targetMs = targetMs;
+}
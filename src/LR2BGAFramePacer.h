@@ -0,0 +1,76 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAFramePacer.h
+// LR2 BGA Filter - FPS制限用の高分解能タイマーとフレーム間隔の集計
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   FPS制限 (LR2BGATransformLogic::WaitFPSLimit) の時刻取得と待機を担当します。
+//   GetTickCount64 / Sleep (約15.6ms分解能) の代わりに QPC と高分解能の
+//   waitable timer を使い、最後の 0.5ms はスピンで合わせます。
+//   出力を許可したフレームの間隔をヒストグラムとして集計します。
+//   時刻源は LR2BGAClock で差し替えられます (オフライン再生で模擬時計を使うため)。
+//
+// スレッド:
+//   ストリーミングスレッドのみが操作します。RequestReset だけは他のスレッドから呼べます
+//   (次の RecordOutput で適用)。
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <windows.h>
+#include <atomic>
+
+#include "LR2BGATypes.h"
+
+//------------------------------------------------------------------------------
+// LR2BGAClock - 時刻源の差し替え口
+// 既定 (未設定) は QPC と高分解能タイマー。オフライン再生 (tools/LR2BGABench の LR2BGAReplay) は
+// 模擬時計を設定し、待機は時刻を進めるだけにする。ストリーミングスレッドからのみ呼ばれる。
+//------------------------------------------------------------------------------
+class LR2BGAClock {
+public:
+    virtual ~LR2BGAClock() {}
+    // 現在時刻 (100ns 単位、単調増加)
+    virtual REFERENCE_TIME Now() = 0;
+    // deadline まで待機する (LR2BGAFramePacer が上限で切り詰めた後の時刻)
+    virtual void WaitUntil(REFERENCE_TIME deadline) = 0;
+};
+
+class LR2BGAFramePacer {
+public:
+    LR2BGAFramePacer();
+    ~LR2BGAFramePacer();
+
+    LR2BGAFramePacer(const LR2BGAFramePacer&) = delete;
+    LR2BGAFramePacer& operator=(const LR2BGAFramePacer&) = delete;
+
+    // 時刻源の差し替え (NULL: QPC と高分解能タイマー。ストリーミング開始前に呼ぶ)
+    void SetClock(LR2BGAClock* pClock) { m_pClock = pClock; }
+
+    // 現在時刻 (QPC を 100ns 単位に換算した単調増加の時刻)
+    REFERENCE_TIME Now() const;
+
+    // Now と同じ時間軸の deadline まで待機する (maxWait を超える分は切り詰める)
+    void WaitUntil(REFERENCE_TIME deadline, REFERENCE_TIME maxWait);
+
+    // 出力を許可したフレームの時刻を記録する (直前の記録との間隔をヒストグラムへ)
+    void RecordOutput(REFERENCE_TIME now, REFERENCE_TIME targetInterval);
+    // 新しいストリームの開始 (間隔の起点のみ破棄し、集計は残す)
+    void Restart() { m_lastOutput = 0; }
+    // 集計のリセット要求 (UIスレッドから呼ばれる)
+    void RequestReset() { m_resetRequested = true; }
+
+    void GetHistogram(FrameIntervalHistogram& out) const;
+    bool IsHighResolution() const { return m_highResolution; }
+
+private:
+    void ClearHistogram();
+
+    HANDLE m_hTimer;                 // waitable timer (作成できない場合は NULL、Sleep で代用)
+    bool m_highResolution;           // CREATE_WAITABLE_TIMER_HIGH_RESOLUTION で作成できた
+    LONGLONG m_qpcFreq;
+    LR2BGAClock* m_pClock;           // 差し替えた時刻源 (NULL: QPC)
+
+    REFERENCE_TIME m_lastOutput;     // 直前に出力を許可した時刻 (0: なし)
+    FrameIntervalHistogram m_hist;
+    std::atomic<bool> m_resetRequested;
+};
@@ -2,6 +2,18 @@
 #include "LR2BGACPU.h"
 #include "LR2BGAThreadPool.h"
 
+// SIMD 版の関数だけに命令セットを許可する (GCC/Clang)。
+// 翻訳単位全体に -mavx2 を指定すると C++ 版や明るさ補正まで AVX2 で自動ベクトル化され、
+// AVX2 非対応の CPU で C++/SSE4.1 の段階を選んでも不正命令になるため。
+// MSVC は /arch なしで組み込み関数を使えるため何もしない (フィルタ本体のビルド)。
+#if defined(__GNUC__) || defined(__clang__)
+#define LR2BGA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define LR2BGA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LR2BGA_TARGET_SSE41
+#define LR2BGA_TARGET_AVX2
+#endif
+
 //------------------------------------------------------------------------------
 // 定数定義 (Constants)
 //------------------------------------------------------------------------------
@@ -11,28 +23,85 @@ constexpr int kMaxBrightnessPercent = 100;      // 最大輝度 (%)
 // Static Initializations
 LR2BGAImageProc::ResizeFuncNearest LR2BGAImageProc::pResizeNearest = LR2BGAImageProc::ResizeNearestNeighbor_Cpp;
 LR2BGAImageProc::ResizeFunc LR2BGAImageProc::pResizeBilinear = LR2BGAImageProc::ResizeBilinear_Cpp;
+LR2BGAImageProc::BilinearRowFunc LR2BGAImageProc::pBilinearRow = LR2BGAImageProc::BilinearRow_Cpp;
+LR2BGAImageProc::LumaRowFunc LR2BGAImageProc::pLumaRow = LR2BGAImageProc::ConvertRowToLuma_Cpp;
+LR2BGAImageProc::CountBelowFunc LR2BGAImageProc::pCountBelow = LR2BGAImageProc::CountBelowThreshold_Cpp;
+LR2BGAImageProc::LumaProfileFunc LR2BGAImageProc::pLumaProfile = LR2BGAImageProc::AccumulateLumaProfile_Cpp;
+LR2BGAImageProc::KernelTier LR2BGAImageProc::m_kernelTier = LR2BGAImageProc::KERNEL_TIER_CPP;
 bool LR2BGAImageProc::m_initialized = false;
 
 void LR2BGAImageProc::Initialize() {
     if (m_initialized) return;
 
-    // Default to Optimized C++ implementation (Fixed-point + LUT)
-    pResizeNearest = ResizeNearestNeighbor_CppOpt;
-    pResizeBilinear = ResizeBilinear_CppOpt;
+    ApplyKernelTier(GetMaxSupportedTier());
+    m_initialized = true;
+}
+
+LR2BGAImageProc::KernelTier LR2BGAImageProc::GetMaxSupportedTier() {
+    if (LR2BGACPU::IsAVX2Supported()) return KERNEL_TIER_AVX2;
+    if (LR2BGACPU::IsSSE41Supported()) return KERNEL_TIER_SSE41;
+    return KERNEL_TIER_CPPOPT;
+}
+
+bool LR2BGAImageProc::SetKernelTier(KernelTier tier) {
+    if (tier < KERNEL_TIER_CPP || tier >= KERNEL_TIER_COUNT || tier > GetMaxSupportedTier()) {
+        return false;
+    }
+    ApplyKernelTier(tier);
+    m_initialized = true;
+    return true;
+}
+
+LR2BGAImageProc::KernelTier LR2BGAImageProc::GetKernelTier() {
+    if (!m_initialized) Initialize();
+    return m_kernelTier;
+}
+
+const char* LR2BGAImageProc::GetKernelTierName(KernelTier tier) {
+    switch (tier) {
+    case KERNEL_TIER_CPP:    return "Cpp";
+    case KERNEL_TIER_CPPOPT: return "CppOpt";
+    case KERNEL_TIER_SSE41:  return "SSE4.1";
+    case KERNEL_TIER_AVX2:   return "AVX2";
+    default:                 return "?";
+    }
+}
+
+void LR2BGAImageProc::ApplyKernelTier(KernelTier tier) {
+    // 基準: 素朴なC++実装 (輝度系は C++ 版のみ)
+    pResizeNearest = ResizeNearestNeighbor_Cpp;
+    pResizeBilinear = ResizeBilinear_Cpp;
+    pBilinearRow = BilinearRow_Cpp;
+    pLumaRow = ConvertRowToLuma_Cpp;
+    pCountBelow = CountBelowThreshold_Cpp;
+    pLumaProfile = AccumulateLumaProfile_Cpp;
+
+    if (tier >= KERNEL_TIER_CPPOPT) {
+        // Optimized C++ implementation (Fixed-point + LUT)
+        pResizeNearest = ResizeNearestNeighbor_CppOpt;
+        pResizeBilinear = ResizeBilinear_CppOpt;
+    }
 
-    // Check CPU features and upgrade if possible
-    if (LR2BGACPU::IsSSE41Supported()) {
+    if (tier >= KERNEL_TIER_SSE41) {
         // SSE4.1 is supported
         // NearestNeighbor is already parallelized in CppOpt, no need for SIMD fallback
         pResizeBilinear = ResizeBilinear_SSE41;
+        pBilinearRow = BilinearRow_SSE41;
+        pLumaRow = ConvertRowToLuma_SSE41;
+        pCountBelow = CountBelowThreshold_SSE41;
+        pLumaProfile = AccumulateLumaProfile_SSE41;
     }
 
-    if (LR2BGACPU::IsAVX2Supported()) {
+    if (tier >= KERNEL_TIER_AVX2) {
         // AVX2 is also supported
         pResizeBilinear = ResizeBilinear_AVX2;
+        pBilinearRow = BilinearRow_AVX2;
+        pLumaRow = ConvertRowToLuma_AVX2;
+        pCountBelow = CountBelowThreshold_AVX2;
+        pLumaProfile = AccumulateLumaProfile_AVX2;
     }
 
-    m_initialized = true;
+    m_kernelTier = tier;
 }
 
 //------------------------------------------------------------------------------
@@ -46,11 +115,14 @@ void LR2BGAImageProc::Initialize() {
 //   - リサイズ: 最近傍法 (Nearest Neighbor) および バイリニア法 (Bilinear)。
 //   - アスペクト比計算: ソース矩形とターゲット矩形から最適な描画位置を算出。
 //   - 色変換/明るさ調整: ピクセル単位の操作。
+//   - 輝度変換: 黒帯検出用の8bit輝度行の生成と閾値未満画素の計数 (SSE4.1/AVX2対応)。
 //
 // 実装の詳細:
 //   - CppOpt: 固定小数点演算とLUT（Look-Up Table）を使用した最適化版標準実装（マルチスレッド対応）。
 //   - SSE4.1/AVX2: SIMD命令セットを使用した最適化実装（BilinearかつRGB32入力時に適用）。
 //   - MultiThread: スレッドプールを使用した並列処理（全実装で適用）。
+//   - 行カーネル: CppOpt/SSE4.1/AVX2 の各実装は1行分の処理を行カーネルとして切り出しており、
+//     単一ターゲット版と ResizeMulti (1パスで複数出力) で共用します。
 //
 // パフォーマンスノート:
 //   - Nearest Neighborは常に並列化されたCppOpt実装が使用されます。
@@ -254,6 +326,127 @@ void LR2BGAImageProc::ResizeBilinear_Cpp(
     }
 }
 
+//------------------------------------------------------------------------------
+// 行カーネル共通ヘルパー
+//
+// 各リサイズ実装は「LUT構築 → 出力行ごとのソース行決定 → 行カーネル」の3段に分かれています。
+// 単一ターゲット版 (ResizeXxx_*) は出力行で並列化し、マルチターゲット版 (ResizeMulti) は
+// ソース行バンドで並列化しますが、どちらも同じ行カーネルを呼ぶため出力は完全に一致します。
+//------------------------------------------------------------------------------
+constexpr int kBilinearPrecisionBits = 11;
+constexpr int kBilinearPrecisionScale = 1 << kBilinearPrecisionBits; // 2048
+
+// ResizeMulti のソース行バンド高さ
+// 4K RGB32 で約250KB となり、全ターゲットがバンドを読み終えるまで L2 に留まる大きさ
+constexpr int kResizeBandRows = 16;
+
+static RECT ResolveSourceRect(const RECT* pSrcRect, int srcW, int srcH)
+{
+    RECT rect = { 0, 0, srcW, srcH };
+    if (pSrcRect) rect = *pSrcRect;
+    return rect;
+}
+
+// 最近傍: X方向のソースオフセット (バイト) を事前計算
+static void BuildNearestLUT(const RECT& rect, int actualW, int srcBytes, std::vector<int>& lutIndices)
+{
+    if (lutIndices.size() < (size_t)actualW) lutIndices.resize(actualW);
+
+    float scaleX = (float)(rect.right - rect.left) / actualW;
+
+    for (int x = 0; x < actualW; x++) {
+        int srcX = rect.left + (int)(x * scaleX);
+        if (srcX >= rect.right) srcX = rect.right - 1;
+        lutIndices[x] = srcX * srcBytes;
+    }
+}
+
+static inline int NearestSourceRow(int y, const RECT& rect, float scaleY)
+{
+    int srcY = rect.top + (int)(y * scaleY);
+    if (srcY >= rect.bottom) srcY = rect.bottom - 1;
+    return srcY;
+}
+
+// バイリニア: X方向のソースオフセットと重み [inv_w, w] を事前計算
+// (全実装共通の形式。SIMD版は PMADDWD にそのまま渡せる並びになっている)
+static void BuildBilinearLUT(const RECT& rect, int actualW, int srcBytes,
+                             std::vector<int>& lutIndices, std::vector<short>& lutWeights)
+{
+    if (lutIndices.size() < (size_t)actualW) lutIndices.resize(actualW);
+    if (lutWeights.size() < (size_t)(actualW * 2)) lutWeights.resize(actualW * 2);
+
+    float scaleX = (float)(rect.right - rect.left - 1) / actualW;
+    if (actualW <= 1) scaleX = 0;
+
+    for (int x = 0; x < actualW; x++) {
+        float fx = x * scaleX;
+        int x1 = rect.left + (int)fx;
+        // Clamp
+        if (x1 >= rect.right - 1) x1 = rect.right - 2;
+        if (x1 < rect.left) x1 = rect.left;
+
+        lutIndices[x] = x1 * srcBytes;
+
+        float dx = fx - (int)fx;
+        int w = (int)(dx * kBilinearPrecisionScale);
+        lutWeights[x * 2 + 0] = (short)(kBilinearPrecisionScale - w);
+        lutWeights[x * 2 + 1] = (short)w;
+    }
+}
+
+static inline float BilinearScaleY(const RECT& rect, int actualH)
+{
+    float scaleY = (float)(rect.bottom - rect.top - 1) / actualH;
+    if (actualH <= 1) scaleY = 0;
+    return scaleY;
+}
+
+// バイリニア: 出力行 y に対応する上側ソース行 y1 と縦方向の重みを求める
+static inline int BilinearSourceRow(int y, const RECT& rect, float scaleY, int& w_y)
+{
+    float fy = y * scaleY;
+    int y1 = rect.top + (int)fy;
+    if (y1 >= rect.bottom - 1) y1 = rect.bottom - 2;
+    if (y1 < rect.top) y1 = rect.top;
+
+    float dy = fy - (int)fy;
+    w_y = (int)(dy * kBilinearPrecisionScale);
+    return y1;
+}
+
+// バイリニア 1画素 (スカラー)
+// SSE4.1/AVX2 版と同じく、横・縦の補間を終えてから1回だけ丸める (最大 255*2048*2048 で int に収まる)。
+// SIMD 版の端の画素もこの関数で処理するため、丸め方が違うと同じ行の中で結果が揃わなくなる。
+static inline void BilinearPixel_Scalar(const BYTE* s1, const BYTE* s2, int srcBytes,
+                                        int inv_w_x, int w_x, int inv_w_y, int w_y, BYTE* pDstPixel)
+{
+    for (int c = 0; c < 3; c++) {
+        int top = s1[c] * inv_w_x + s1[c + srcBytes] * w_x;
+        int bottom = s2[c] * inv_w_x + s2[c + srcBytes] * w_x;
+        pDstPixel[c] = (BYTE)((top * inv_w_y + bottom * w_y) >> (kBilinearPrecisionBits * 2));
+    }
+}
+
+//------------------------------------------------------------------------------
+// Row Kernel: NearestRow
+//------------------------------------------------------------------------------
+void LR2BGAImageProc::NearestRow(const BYTE* pSrcRow, BYTE* pDstRow, const int* pLutIndices,
+                                 int actualW, int offX, int dstW, int dstBytes)
+{
+    for (int x = 0; x < actualW; x++) {
+        int dstX = x + offX;
+        if (dstX < 0 || dstX >= dstW) continue;
+
+        int srcOffset = pLutIndices[x];
+
+        // Unroll loop for known 24-bit (3 bytes)
+        pDstRow[dstX * dstBytes + 0] = pSrcRow[srcOffset + 0];
+        pDstRow[dstX * dstBytes + 1] = pSrcRow[srcOffset + 1];
+        pDstRow[dstX * dstBytes + 2] = pSrcRow[srcOffset + 2];
+    }
+}
+
 //------------------------------------------------------------------------------
 // Implementation: ResizeNearestNeighbor_CppOpt (Pre-calculated Indices)
 //------------------------------------------------------------------------------
@@ -266,25 +459,17 @@ void LR2BGAImageProc::ResizeNearestNeighbor_CppOpt(
     int srcBytes = srcBpp / 8;
     int dstBytes = dstBpp / 8;
 
-    RECT rect = { 0, 0, srcW, srcH };
-    if (pSrcRect) rect = *pSrcRect;
+    RECT rect = ResolveSourceRect(pSrcRect, srcW, srcH);
     int srcRectW = rect.right - rect.left;
     int srcRectH = rect.bottom - rect.top;
 
     if (srcRectW <= 0 || srcRectH <= 0 || actualW <= 0 || actualH <= 0) return;
 
     // Pre-calculate X indices
-    if (lutIndices.size() < (size_t)actualW) lutIndices.resize(actualW);
-    
-    float scaleX = (float)srcRectW / actualW;
-    
-    for (int x = 0; x < actualW; x++) {
-        int srcX = rect.left + (int)(x * scaleX);
-        if (srcX >= rect.right) srcX = rect.right - 1;
-        lutIndices[x] = srcX * srcBytes;
-    }
+    BuildNearestLUT(rect, actualW, srcBytes, lutIndices);
 
     float scaleY = (float)srcRectH / actualH;
+    const int* pLut = lutIndices.data();
 
     // Parallel execution
     LR2BGAThreadPool::Instance().ParallelFor(0, actualH, [&](int startY, int endY) {
@@ -292,32 +477,61 @@ void LR2BGAImageProc::ResizeNearestNeighbor_CppOpt(
             int dstY = y + offY;
             if (dstY < 0 || dstY >= dstH) continue;
 
-            int srcY = rect.top + (int)(y * scaleY);
-            if (srcY >= rect.bottom) srcY = rect.bottom - 1;
-
-            BYTE* pDstRow = pDst + dstY * dstStride;
-            const BYTE* pSrcRow = pSrc + srcY * srcStride;
-
-            for (int x = 0; x < actualW; x++) {
-                int dstX = x + offX;
-                if (dstX < 0 || dstX >= dstW) continue;
-
-                int srcOffset = lutIndices[x];
-                
-                // Unroll loop for known 24-bit (3 bytes)
-                pDstRow[dstX * dstBytes + 0] = pSrcRow[srcOffset + 0];
-                pDstRow[dstX * dstBytes + 1] = pSrcRow[srcOffset + 1];
-                pDstRow[dstX * dstBytes + 2] = pSrcRow[srcOffset + 2];
-            }
+            int srcY = NearestSourceRow(y, rect, scaleY);
+            NearestRow(pSrc + srcY * srcStride, pDst + dstY * dstStride, pLut,
+                       actualW, offX, dstW, dstBytes);
         }
     });
 }
 
+//------------------------------------------------------------------------------
+// Helper: ResizeBilinearRows
+// バイリニア共通の駆動部 (LUT構築 + 出力行の並列ループ)。行の処理は rowFunc に委譲します。
+//------------------------------------------------------------------------------
+void LR2BGAImageProc::ResizeBilinearRows(
+    const BYTE* pSrc, int srcStride, int srcBpp, const RECT& rect,
+    BYTE* pDst, int dstW, int dstH, int dstStride, int dstBpp,
+    int actualW, int actualH, int offX, int offY,
+    std::vector<int>& lutIndices, std::vector<short>& lutWeights, BilinearRowFunc rowFunc)
+{
+    int srcBytes = srcBpp / 8;
+    int dstBytes = dstBpp / 8;
+
+    // Validation
+    if (rect.right - rect.left <= 0 || rect.bottom - rect.top <= 0 || actualW <= 0 || actualH <= 0) return;
+
+    // Pre-calculate X indices and weights
+    BuildBilinearLUT(rect, actualW, srcBytes, lutIndices, lutWeights);
+
+    // 幅1の切り出しでは右隣 (重み0) が切り出し範囲の外になるため、右隣を読まない行カーネルを使う
+    if (rect.right - rect.left < 2) rowFunc = BilinearRow_SingleColumn;
 
+    float scaleY = BilinearScaleY(rect, actualH);
+    const int* pLutI = lutIndices.data();
+    const short* pLutW = lutWeights.data();
+
+    // Parallel execution of Y lines
+    LR2BGAThreadPool::Instance().ParallelFor(0, actualH, [&](int startY, int endY) {
+        for (int y = startY; y < endY; y++) {
+            int dstY = y + offY;
+            if (dstY < 0 || dstY >= dstH) continue;
+
+            int w_y;
+            int y1 = BilinearSourceRow(y, rect, scaleY, w_y);
+
+            // 高さ1の切り出しでは下側の行 (重み0) が範囲外になるため、上側の行を使う
+            const BYTE* pSrcRow1 = pSrc + y1 * srcStride;
+            const BYTE* pSrcRow2 = (y1 + 1 < rect.bottom) ? pSrcRow1 + srcStride : pSrcRow1;
+            rowFunc(pSrcRow1, pSrcRow2, w_y, pDst + dstY * dstStride, pLutI, pLutW,
+                    actualW, offX, dstW, srcBytes, dstBytes);
+        }
+    }); // End ParallelFor
+}
 
 //------------------------------------------------------------------------------
 // Implementation: ResizeBilinear_SSE41 (128-bit SIMD + Multithreading)
 //------------------------------------------------------------------------------
+LR2BGA_TARGET_SSE41
 void LR2BGAImageProc::ResizeBilinear_SSE41(
     const BYTE* pSrc, int srcW, int srcH, int srcStride, int srcBpp,
     BYTE* pDst, int dstW, int dstH, int dstStride, int dstBpp,
@@ -336,180 +550,115 @@ void LR2BGAImageProc::ResizeBilinear_SSE41(
         return;
     }
 
-    RECT rect = { 0, 0, srcW, srcH };
-    if (pSrcRect) rect = *pSrcRect;
-    int srcRectW = rect.right - rect.left;
-    int srcRectH = rect.bottom - rect.top;
-
-    int srcBytes = srcBpp / 8;
-    int dstBytes = dstBpp / 8;
-
-    const int PRECISION_BITS = 11;
-    const int PRECISION_SCALE = 1 << PRECISION_BITS; // 2048
-
-    // Pre-calculate X indices and weights
-    if (lutIndices.size() < (size_t)actualW) lutIndices.resize(actualW);
-    if (lutWeights.size() < (size_t)(actualW * 2)) lutWeights.resize(actualW * 2);
-
-    float scaleX = (float)(srcRectW - 1) / actualW;
-    if (actualW <= 1) scaleX = 0;
-
-    for (int x = 0; x < actualW; x++) {
-        float fx = x * scaleX;
-        int x1 = rect.left + (int)fx;
-        if (x1 >= rect.right - 1) x1 = rect.right - 2;
-        if (x1 < rect.left) x1 = rect.left;
+    ResizeBilinearRows(pSrc, srcStride, srcBpp, ResolveSourceRect(pSrcRect, srcW, srcH),
+                       pDst, dstW, dstH, dstStride, dstBpp,
+                       actualW, actualH, offX, offY, lutIndices, lutWeights, BilinearRow_SSE41);
+}
 
-        lutIndices[x] = x1 * srcBytes;
+//------------------------------------------------------------------------------
+// Row Kernel: BilinearRow_SSE41 (RGB32入力専用)
+//------------------------------------------------------------------------------
+LR2BGA_TARGET_SSE41
+void LR2BGAImageProc::BilinearRow_SSE41(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                                        BYTE* pDstRow, const int* lutIndices, const short* lutWeights,
+                                        int actualW, int offX, int dstW, int srcBytes, int dstBytes)
+{
+    const int PRECISION_BITS = kBilinearPrecisionBits;
+    int inv_w_y = kBilinearPrecisionScale - w_y;
+
+    // Prepare Y weights in XMM register
+    __m128i v_inv_wy = _mm_set1_epi32(inv_w_y);
+    __m128i v_wy = _mm_set1_epi32(w_y);
+
+    int x = 0;
+
+    // SIMD Loop (Process 2 pixels at a time)
+    for (; x <= actualW - 2; x += 2) {
+        int dstX = x + offX;
+        if (dstX < 0 || dstX >= dstW - 1) {
+            // 出力範囲の端にかかる2画素はスカラーで1画素ずつ処理
+            for (int k = 0; k < 2; k++) {
+                int cx = x + k;
+                int dstX_scalar = cx + offX;
+                if (dstX_scalar < 0 || dstX_scalar >= dstW) continue;
+
+                int idx = lutIndices[cx];
+                BilinearPixel_Scalar(pSrcRow1 + idx, pSrcRow2 + idx, srcBytes,
+                                     lutWeights[cx * 2 + 0], lutWeights[cx * 2 + 1], inv_w_y, w_y,
+                                     pDstRow + dstX_scalar * dstBytes);
+            }
+            continue;
+        }
 
-        float dx = fx - (int)fx;
-        int w = (int)(dx * PRECISION_SCALE);
-        int inv_w = PRECISION_SCALE - w;
-        
-        lutWeights[x * 2 + 0] = (short)inv_w;
-        lutWeights[x * 2 + 1] = (short)w;
-    }
+        // Indexes for 2 pixels
+        int idx0 = lutIndices[x];
+        int idx1 = lutIndices[x+1];
 
-    float scaleY = (float)(srcRectH - 1) / actualH;
-    if (actualH <= 1) scaleY = 0;
+        // Weights for 2 pixels
+        short iwx0 = lutWeights[x*2];
+        short wx0  = lutWeights[x*2+1];
+        short iwx1 = lutWeights[(x+1)*2];
+        short wx1  = lutWeights[(x+1)*2+1];
 
-    // Parallel execution of Y lines
-    LR2BGAThreadPool::Instance().ParallelFor(0, actualH, [&](int startY, int endY) {
-        for (int y = startY; y < endY; y++) {
-            int dstY = y + offY;
-            if (dstY < 0 || dstY >= dstH) continue;
+        // Prepare X weight vectors (interleaved for PMADDWD)
+        __m128i v_wx0 = _mm_set_epi16(0, 0, wx0, iwx0, wx0, iwx0, wx0, iwx0);
+        __m128i v_wx1 = _mm_set_epi16(0, 0, wx1, iwx1, wx1, iwx1, wx1, iwx1);
 
-            float fy = y * scaleY;
-            int y1 = rect.top + (int)fy;
-            if (y1 >= rect.bottom - 1) y1 = rect.bottom - 2;
-            if (y1 < rect.top) y1 = rect.top;
+        // Load 4 pixels
+        int p0_TL = *(int*)(pSrcRow1 + idx0);
+        int p0_TR = *(int*)(pSrcRow1 + idx0 + srcBytes);
+        int p0_BL = *(int*)(pSrcRow2 + idx0);
+        int p0_BR = *(int*)(pSrcRow2 + idx0 + srcBytes);
 
-            float dy = fy - (int)fy;
-            int w_y = (int)(dy * PRECISION_SCALE);
-            int inv_w_y = PRECISION_SCALE - w_y;
+        int p1_TL = *(int*)(pSrcRow1 + idx1);
+        int p1_TR = *(int*)(pSrcRow1 + idx1 + srcBytes);
+        int p1_BL = *(int*)(pSrcRow2 + idx1);
+        int p1_BR = *(int*)(pSrcRow2 + idx1 + srcBytes);
 
-            const BYTE* pSrcRow1 = pSrc + y1 * srcStride;
-            const BYTE* pSrcRow2 = pSrc + (y1 + 1) * srcStride;
-            BYTE* pDstRow = pDst + dstY * dstStride;
+        // Pixel 0
+        __m128i v_p0_T = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_TL), _mm_cvtsi32_si128(p0_TR))); 
+        __m128i v_top0 = _mm_madd_epi16(v_p0_T, v_wx0); 
 
-            // Prepare Y weights in XMM register
-            __m128i v_inv_wy = _mm_set1_epi32(inv_w_y);
-            __m128i v_wy = _mm_set1_epi32(w_y);
+        __m128i v_p0_B = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_BL), _mm_cvtsi32_si128(p0_BR)));
+        __m128i v_btm0 = _mm_madd_epi16(v_p0_B, v_wx0);
 
-            int x = 0;
-            
-            // SIMD Loop (Process 2 pixels at a time)
-            for (; x <= actualW - 2; x += 2) {
-                int dstX = x + offX;
-                if (dstX < 0 || dstX >= dstW - 1) {
-                    goto ScalarFallback_Thread; 
-                }
+        __m128i v_res0 = _mm_add_epi32(_mm_mullo_epi32(v_top0, v_inv_wy), _mm_mullo_epi32(v_btm0, v_wy));
+        v_res0 = _mm_srai_epi32(v_res0, PRECISION_BITS * 2);
+        
+        __m128i v_out0 = _mm_packus_epi16(_mm_packus_epi32(v_res0, _mm_setzero_si128()), _mm_setzero_si128());
+        int val0 = _mm_cvtsi128_si32(v_out0);
+        
+        *(short*)(pDstRow + dstX * dstBytes) = (short)val0; 
+        *(pDstRow + dstX * dstBytes + 2) = (BYTE)(val0 >> 16); 
 
-                // Indexes for 2 pixels
-                int idx0 = lutIndices[x];
-                int idx1 = lutIndices[x+1];
-
-                // Weights for 2 pixels
-                short iwx0 = lutWeights[x*2];
-                short wx0  = lutWeights[x*2+1];
-                short iwx1 = lutWeights[(x+1)*2];
-                short wx1  = lutWeights[(x+1)*2+1];
-
-                // Prepare X weight vectors (interleaved for PMADDWD)
-                __m128i v_wx0 = _mm_set_epi16(0, 0, wx0, iwx0, wx0, iwx0, wx0, iwx0);
-                __m128i v_wx1 = _mm_set_epi16(0, 0, wx1, iwx1, wx1, iwx1, wx1, iwx1);
-
-                // Load 4 pixels
-                int p0_TL = *(int*)(pSrcRow1 + idx0);
-                int p0_TR = *(int*)(pSrcRow1 + idx0 + srcBytes);
-                int p0_BL = *(int*)(pSrcRow2 + idx0);
-                int p0_BR = *(int*)(pSrcRow2 + idx0 + srcBytes);
-
-                int p1_TL = *(int*)(pSrcRow1 + idx1);
-                int p1_TR = *(int*)(pSrcRow1 + idx1 + srcBytes);
-                int p1_BL = *(int*)(pSrcRow2 + idx1);
-                int p1_BR = *(int*)(pSrcRow2 + idx1 + srcBytes);
-
-                // Pixel 0
-                __m128i v_p0_T = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_TL), _mm_cvtsi32_si128(p0_TR))); 
-                __m128i v_top0 = _mm_madd_epi16(v_p0_T, v_wx0); 
-
-                __m128i v_p0_B = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_BL), _mm_cvtsi32_si128(p0_BR)));
-                __m128i v_btm0 = _mm_madd_epi16(v_p0_B, v_wx0);
-
-                __m128i v_res0 = _mm_add_epi32(_mm_mullo_epi32(v_top0, v_inv_wy), _mm_mullo_epi32(v_btm0, v_wy));
-                v_res0 = _mm_srai_epi32(v_res0, PRECISION_BITS * 2);
-                
-                __m128i v_out0 = _mm_packus_epi16(_mm_packus_epi32(v_res0, _mm_setzero_si128()), _mm_setzero_si128());
-                int val0 = _mm_cvtsi128_si32(v_out0);
-                
-                *(short*)(pDstRow + dstX * dstBytes) = (short)val0; 
-                *(pDstRow + dstX * dstBytes + 2) = (BYTE)(val0 >> 16); 
-
-                // Pixel 1
-                __m128i v_p1_T = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_TL), _mm_cvtsi32_si128(p1_TR)));
-                __m128i v_top1 = _mm_madd_epi16(v_p1_T, v_wx1);
-                
-                __m128i v_p1_B = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_BL), _mm_cvtsi32_si128(p1_BR)));
-                __m128i v_btm1 = _mm_madd_epi16(v_p1_B, v_wx1);
-
-                __m128i v_res1 = _mm_add_epi32(_mm_mullo_epi32(v_top1, v_inv_wy), _mm_mullo_epi32(v_btm1, v_wy));
-                v_res1 = _mm_srai_epi32(v_res1, PRECISION_BITS * 2);
-
-                __m128i v_out1 = _mm_packus_epi16(_mm_packus_epi32(v_res1, _mm_setzero_si128()), _mm_setzero_si128());
-                int val1 = _mm_cvtsi128_si32(v_out1);
-                
-                int dstX1 = dstX + 1;
-                *(short*)(pDstRow + dstX1 * dstBytes) = (short)val1;
-                *(pDstRow + dstX1 * dstBytes + 2) = (BYTE)(val1 >> 16);
-                
-                continue; 
-
-                ScalarFallback_Thread:
-                for (int k = 0; k < 2; k++) { 
-                    int cx = x + k;
-                    if (cx >= actualW) break;
-
-                    int dstX_scalar = cx + offX;
-                    if (dstX_scalar < 0 || dstX_scalar >= dstW) continue;
-
-                    int idx = lutIndices[cx];
-                    int w_x_s = lutWeights[cx * 2 + 1];
-                    int inv_w_x_s = lutWeights[cx * 2 + 0];
-
-                    const BYTE* s1 = pSrcRow1 + idx;
-                    const BYTE* s2 = pSrcRow2 + idx;
-                    
-                    for (int c = 0; c < 3; c++) {
-                        int top = (s1[c] * inv_w_x_s + s1[c + srcBytes] * w_x_s) >> PRECISION_BITS;
-                        int bottom = (s2[c] * inv_w_x_s + s2[c + srcBytes] * w_x_s) >> PRECISION_BITS;
-                        int final_val = (top * inv_w_y + bottom * w_y) >> PRECISION_BITS;
-                        pDstRow[dstX_scalar * dstBytes + c] = (BYTE)final_val;
-                    }
-                }
-            }
+        // Pixel 1
+        __m128i v_p1_T = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_TL), _mm_cvtsi32_si128(p1_TR)));
+        __m128i v_top1 = _mm_madd_epi16(v_p1_T, v_wx1);
+        
+        __m128i v_p1_B = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_BL), _mm_cvtsi32_si128(p1_BR)));
+        __m128i v_btm1 = _mm_madd_epi16(v_p1_B, v_wx1);
 
-            // Tail loop
-            for (; x < actualW; x++) {
-                int dstX = x + offX;
-                if (dstX < 0 || dstX >= dstW) continue;
+        __m128i v_res1 = _mm_add_epi32(_mm_mullo_epi32(v_top1, v_inv_wy), _mm_mullo_epi32(v_btm1, v_wy));
+        v_res1 = _mm_srai_epi32(v_res1, PRECISION_BITS * 2);
 
-                int idx = lutIndices[x];
-                int w_x = lutWeights[x * 2 + 1];
-                int inv_w_x = lutWeights[x * 2 + 0];
+        __m128i v_out1 = _mm_packus_epi16(_mm_packus_epi32(v_res1, _mm_setzero_si128()), _mm_setzero_si128());
+        int val1 = _mm_cvtsi128_si32(v_out1);
+        
+        int dstX1 = dstX + 1;
+        *(short*)(pDstRow + dstX1 * dstBytes) = (short)val1;
+        *(pDstRow + dstX1 * dstBytes + 2) = (BYTE)(val1 >> 16);
+    }
 
-                const BYTE* s1 = pSrcRow1 + idx;
-                const BYTE* s2 = pSrcRow2 + idx;
+    // Tail loop
+    for (; x < actualW; x++) {
+        int dstX = x + offX;
+        if (dstX < 0 || dstX >= dstW) continue;
 
-                for (int c = 0; c < 3; c++) {
-                    int top = (s1[c] * inv_w_x + s1[c + srcBytes] * w_x) >> PRECISION_BITS;
-                    int bottom = (s2[c] * inv_w_x + s2[c + srcBytes] * w_x) >> PRECISION_BITS;
-                    int final_val = (top * inv_w_y + bottom * w_y) >> PRECISION_BITS;
-                    pDstRow[dstX * dstBytes + c] = (BYTE)final_val;
-                }
-            }
-        }
-    }); // End ParallelFor
+        int idx = lutIndices[x];
+        BilinearPixel_Scalar(pSrcRow1 + idx, pSrcRow2 + idx, srcBytes,
+                             lutWeights[x * 2 + 0], lutWeights[x * 2 + 1], inv_w_y, w_y,
+                             pDstRow + dstX * dstBytes);
+    }
 }
 
 void LR2BGAImageProc::ResizeBilinear_CppOpt(
@@ -518,90 +667,55 @@ void LR2BGAImageProc::ResizeBilinear_CppOpt(
     int actualW, int actualH, int offX, int offY,
     const RECT* pSrcRect, std::vector<int>& lutIndices, std::vector<short>& lutWeights)
 {
-    int srcBytes = srcBpp / 8;
-    int dstBytes = dstBpp / 8;
-
-    RECT rect = { 0, 0, srcW, srcH };
-    if (pSrcRect) rect = *pSrcRect;
-    int srcRectW = rect.right - rect.left;
-    int srcRectH = rect.bottom - rect.top;
-
-    // Validation
-    if (srcRectW <= 0 || srcRectH <= 0 || actualW <= 0 || actualH <= 0) return;
-
-    // Fixed-point precision (11 bits = 2048)
-    const int PRECISION_BITS = 11;
-    const int PRECISION_SCALE = 1 << PRECISION_BITS;
-
-    // Pre-calculate X indices and weights
-    if (lutIndices.size() < (size_t)actualW) lutIndices.resize(actualW);
-    // CppOpt uses 1 weight per pixel, but vector might be reused by SSE41 (2 weights).
-    // We only need actualW size here.
-    if (lutWeights.size() < (size_t)actualW) lutWeights.resize(actualW);
+    ResizeBilinearRows(pSrc, srcStride, srcBpp, ResolveSourceRect(pSrcRect, srcW, srcH),
+                       pDst, dstW, dstH, dstStride, dstBpp,
+                       actualW, actualH, offX, offY, lutIndices, lutWeights, BilinearRow_Cpp);
+}
 
-    float scaleX = (float)(srcRectW - 1) / actualW;
-    if (actualW <= 1) scaleX = 0;
+//------------------------------------------------------------------------------
+// Row Kernel: BilinearRow_Cpp (Fixed-point, RGB32/24入力)
+//------------------------------------------------------------------------------
+void LR2BGAImageProc::BilinearRow_Cpp(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                                      BYTE* pDstRow, const int* lutIndices, const short* lutWeights,
+                                      int actualW, int offX, int dstW, int srcBytes, int dstBytes)
+{
+    int inv_w_y = kBilinearPrecisionScale - w_y;
 
     for (int x = 0; x < actualW; x++) {
-        float fx = x * scaleX;
-        int x1 = rect.left + (int)fx;
-        // Clamp
-        if (x1 >= rect.right - 1) x1 = rect.right - 2; 
-        if (x1 < rect.left) x1 = rect.left;
-        
-        lutIndices[x] = x1 * srcBytes;
-        
-        float dx = fx - (int)fx;
-        lutWeights[x] = (short)(dx * PRECISION_SCALE);
-    }
-
-    float scaleY = (float)(srcRectH - 1) / actualH;
-    if (actualH <= 1) scaleY = 0;
+        int dstX = x + offX;
+        if (dstX < 0 || dstX >= dstW) continue;
 
-    LR2BGAThreadPool::Instance().ParallelFor(0, actualH, [&](int startY, int endY) {
-        for (int y = startY; y < endY; y++) {
-            int dstY = y + offY;
-            if (dstY < 0 || dstY >= dstH) continue;
+        int idx = lutIndices[x];
+        BilinearPixel_Scalar(pSrcRow1 + idx, pSrcRow2 + idx, srcBytes,
+                             lutWeights[x * 2 + 0], lutWeights[x * 2 + 1], inv_w_y, w_y,
+                             pDstRow + dstX * dstBytes);
+    }
+}
 
-            float fy = y * scaleY;
-            int y1 = rect.top + (int)fy;
-            if (y1 >= rect.bottom - 1) y1 = rect.bottom - 2;
-            if (y1 < rect.top) y1 = rect.top;
-            
-            float dy = fy - (int)fy;
-            int w_y = (int)(dy * PRECISION_SCALE); 
-            int inv_w_y = PRECISION_SCALE - w_y;
+//------------------------------------------------------------------------------
+// Row Kernel: BilinearRow_SingleColumn (幅1の切り出し用)
+// LUT の重みは [全量, 0] になるため、右隣を読まずに縦方向だけ補間する。
+// 丸めは BilinearPixel_Scalar と同じ1回で、右隣を読んだ場合と同一の結果になる。
+//------------------------------------------------------------------------------
+void LR2BGAImageProc::BilinearRow_SingleColumn(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                                               BYTE* pDstRow, const int* lutIndices, const short* lutWeights,
+                                               int actualW, int offX, int dstW, int srcBytes, int dstBytes)
+{
+    int inv_w_y = kBilinearPrecisionScale - w_y;
 
-            const BYTE* pSrcRow1 = pSrc + y1 * srcStride;
-            const BYTE* pSrcRow2 = pSrc + (y1 + 1) * srcStride;
-            BYTE* pDstRow = pDst + dstY * dstStride;
-
-            for (int x = 0; x < actualW; x++) {
-                int dstX = x + offX;
-                if (dstX < 0 || dstX >= dstW) continue;
-
-                int idx = lutIndices[x];
-                int w_x = lutWeights[x];
-                int inv_w_x = PRECISION_SCALE - w_x;
-
-                const BYTE* s1 = pSrcRow1 + idx;
-                const BYTE* s2 = pSrcRow2 + idx;
-                
-                // RGB Loop
-                for (int c = 0; c < 3; c++) {
-                    // Top row interpolation
-                    // val = (val1 * inv_w_x + val2 * w_x)
-                    int top = (s1[c] * inv_w_x + s1[c + srcBytes] * w_x) >> PRECISION_BITS;
-                    int bottom = (s2[c] * inv_w_x + s2[c + srcBytes] * w_x) >> PRECISION_BITS;
-
-                    // Combine Y
-                    int final_val = (top * inv_w_y + bottom * w_y) >> PRECISION_BITS;
-
-                    pDstRow[dstX * dstBytes + c] = (BYTE)final_val;
-                }
-            }
+    for (int x = 0; x < actualW; x++) {
+        int dstX = x + offX;
+        if (dstX < 0 || dstX >= dstW) continue;
+
+        const BYTE* s1 = pSrcRow1 + lutIndices[x];
+        const BYTE* s2 = pSrcRow2 + lutIndices[x];
+        const int inv_w_x = lutWeights[x * 2 + 0];
+        for (int c = 0; c < 3; c++) {
+            int top = s1[c] * inv_w_x;
+            int bottom = s2[c] * inv_w_x;
+            pDstRow[dstX * dstBytes + c] = (BYTE)((top * inv_w_y + bottom * w_y) >> (kBilinearPrecisionBits * 2));
         }
-    });
+    }
 }
 
 // ------------------------------------------------------------------------------
@@ -639,6 +753,7 @@ void LR2BGAImageProc::ApplyBrightness(BYTE* pData, int width, int height, int st
         }
     }
 }
+LR2BGA_TARGET_AVX2
 void LR2BGAImageProc::ResizeBilinear_AVX2(
     const BYTE* pSrc, int srcW, int srcH, int srcStride, int srcBpp,
     BYTE* pDst, int dstW, int dstH, int dstStride, int dstBpp,
@@ -655,172 +770,535 @@ void LR2BGAImageProc::ResizeBilinear_AVX2(
         return;
     }
 
-    RECT rect = { 0, 0, srcW, srcH };
-    if (pSrcRect) rect = *pSrcRect;
-    int srcRectW = rect.right - rect.left;
-    int srcRectH = rect.bottom - rect.top;
+    ResizeBilinearRows(pSrc, srcStride, srcBpp, ResolveSourceRect(pSrcRect, srcW, srcH),
+                       pDst, dstW, dstH, dstStride, dstBpp,
+                       actualW, actualH, offX, offY, lutIndices, lutWeights, BilinearRow_AVX2);
+}
 
-    int srcBytes = srcBpp / 8;
-    int dstBytes = dstBpp / 8;
+//------------------------------------------------------------------------------
+// Row Kernel: BilinearRow_AVX2 (RGB32入力専用)
+//------------------------------------------------------------------------------
+LR2BGA_TARGET_AVX2
+void LR2BGAImageProc::BilinearRow_AVX2(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                                       BYTE* pDstRow, const int* lutIndices, const short* lutWeights,
+                                       int actualW, int offX, int dstW, int srcBytes, int dstBytes)
+{
+    const int PRECISION_BITS = kBilinearPrecisionBits;
+    int inv_w_y = kBilinearPrecisionScale - w_y;
 
-    const int PRECISION_BITS = 11;
-    const int PRECISION_SCALE = 1 << PRECISION_BITS; // 2048
+    __m256i v_inv_wy = _mm256_set1_epi32(inv_w_y);
+    __m256i v_wy = _mm256_set1_epi32(w_y);
 
-    if (lutIndices.size() < (size_t)actualW) lutIndices.resize(actualW);
-    if (lutWeights.size() < (size_t)(actualW * 2)) lutWeights.resize(actualW * 2);
+    int x = 0;
+    
+    // AVX2 Loop (Process 2 pixels at a time)
+    for (; x <= actualW - 2; x += 2) {
+        int dstX = x + offX;
+        if (dstX < 0 || dstX >= dstW - 1) {
+            // 出力範囲の端にかかった時点で、残りはスカラーのテールループで処理
+            break;
+        }
 
-    float scaleX = (float)(srcRectW - 1) / actualW;
-    if (actualW <= 1) scaleX = 0;
+        int idx0 = lutIndices[x];
+        int idx1 = lutIndices[x+1];
 
-    for (int x = 0; x < actualW; x++) {
-        float fx = x * scaleX;
-        int x1 = rect.left + (int)fx;
-        if (x1 >= rect.right - 1) x1 = rect.right - 2;
-        if (x1 < rect.left) x1 = rect.left;
+        // Load 2+2 pixels (Top and Bottom rows)
+        int p0_TL = *(int*)(pSrcRow1 + idx0); int p0_TR = *(int*)(pSrcRow1 + idx0 + 4);
+        int p0_BL = *(int*)(pSrcRow2 + idx0); int p0_BR = *(int*)(pSrcRow2 + idx0 + 4);
 
-        lutIndices[x] = x1 * srcBytes;
+        int p1_TL = *(int*)(pSrcRow1 + idx1); int p1_TR = *(int*)(pSrcRow1 + idx1 + 4);
+        int p1_BL = *(int*)(pSrcRow2 + idx1); int p1_BR = *(int*)(pSrcRow2 + idx1 + 4);
 
-        float dx = fx - (int)fx;
-        int w = (int)(dx * PRECISION_SCALE);
-        int inv_w = PRECISION_SCALE - w;
+        short i0 = lutWeights[x*2];   short w0 = lutWeights[x*2+1];
+        short i1 = lutWeights[x*2+2]; short w1 = lutWeights[x*2+3];
+
+        // Weights for horizontal interpolation [inv_w, w, inv_w, w...]
+        // Pixel 0 weights (8 shorts)
+        __m128i v_wx0_128 = _mm_set_epi16(w0,i0,w0,i0,w0,i0,w0,i0);
+        // Pixel 1 weights (8 shorts)
+        __m128i v_wx1_128 = _mm_set_epi16(w1,i1,w1,i1,w1,i1,w1,i1);
         
-        lutWeights[x * 2 + 0] = (short)inv_w;
-        lutWeights[x * 2 + 1] = (short)w;
+        // Combine to 256: [W1 | W0]
+        __m256i v_WX = _mm256_inserti128_si256(_mm256_castsi128_si256(v_wx0_128), v_wx1_128, 1);
+
+        // Top Line Interpolation
+        // Expand pixels to 16-bit
+        __m128i t0 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_TL), _mm_cvtsi32_si128(p0_TR));
+        __m128i t1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_TL), _mm_cvtsi32_si128(p1_TR));
+        
+        __m128i t0_16 = _mm_cvtepu8_epi16(t0); // 128 bit
+        __m128i t1_16 = _mm_cvtepu8_epi16(t1); // 128 bit
+        
+        // Combine to 256: [T1 | T0]
+        __m256i v_T_16 = _mm256_inserti128_si256(_mm256_castsi128_si256(t0_16), t1_16, 1);
+        
+        // Bottom Line Interpolation
+        __m128i b0 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_BL), _mm_cvtsi32_si128(p0_BR));
+        __m128i b1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_BL), _mm_cvtsi32_si128(p1_BR));
+        
+        __m128i b0_16 = _mm_cvtepu8_epi16(b0);
+        __m128i b1_16 = _mm_cvtepu8_epi16(b1);
+        
+        __m256i v_B_16 = _mm256_inserti128_si256(_mm256_castsi128_si256(b0_16), b1_16, 1);
+
+        // Horizontal Interpolation (madd_epi16)
+        // Result: 32-bit x 8 integers (4 per pixel)
+        __m256i v_top = _mm256_madd_epi16(v_T_16, v_WX); 
+        __m256i v_btm = _mm256_madd_epi16(v_B_16, v_WX);
+        
+        // Vertical Interpolation
+        __m256i v_res = _mm256_add_epi32(
+            _mm256_mullo_epi32(v_top, v_inv_wy), 
+            _mm256_mullo_epi32(v_btm, v_wy));
+            
+        v_res = _mm256_srai_epi32(v_res, PRECISION_BITS * 2);
+        
+        // Pack back to 8-bit
+        // 32-bit -> 16-bit
+        __m256i v_res_16 = _mm256_packus_epi32(v_res, _mm256_setzero_si256());
+        // v_res_16: [ Lane1(4 shorts) | 0 | Lane0(4 shorts) | 0 ] ?
+        // packus_epi32 packs 2 128-bit blocks independently.
+        // Block 0: Res0(4 ints) -> Res0(4 shorts) + Zero(4 shorts)
+        // Result Block 0: [ Res0_16 | 0 ] (64 bits | 64 bits)
+        // Block 1: Res1(4 ints) -> Res1(4 shorts) + Zero
+        // Result Block 1: [ Res1_16 | 0 ]
+        
+        // 16-bit -> 8-bit
+        __m256i v_res_8 = _mm256_packus_epi16(v_res_16, _mm256_setzero_si256());
+        // Block 0: Res0_16(4 shorts + 4 zeros) -> Res0_8(4 bytes + 4 zeros) + Zeros
+        // Result Block 0: [ Res0_8 | 0 | ... ]
+        // Res0_8 is 32 bits (BGRA).
+        
+        // Extract results
+        int val0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(v_res_8));
+        int val1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(v_res_8, 1));
+        
+        // Store results
+        *(short*)(pDstRow + dstX * dstBytes) = (short)val0; 
+        *(pDstRow + dstX * dstBytes + 2) = (BYTE)(val0 >> 16);
+        
+        *(short*)(pDstRow + (dstX+1) * dstBytes) = (short)val1;
+        *(pDstRow + (dstX+1) * dstBytes + 2) = (BYTE)(val1 >> 16);
     }
 
-    float scaleY = (float)(srcRectH - 1) / actualH;
-    if (actualH <= 1) scaleY = 0;
+    // Scalar fallback for tail/remainder
+    for (; x < actualW; x++) {
+        int dstX = x + offX;
+        if (dstX < 0 || dstX >= dstW) continue;
 
-    LR2BGAThreadPool::Instance().ParallelFor(0, actualH, [&](int startY, int endY) {
-        for (int y = startY; y < endY; y++) {
-            int dstY = y + offY;
-            if (dstY < 0 || dstY >= dstH) continue;
+        int idx = lutIndices[x];
+        BilinearPixel_Scalar(pSrcRow1 + idx, pSrcRow2 + idx, srcBytes,
+                             lutWeights[x * 2 + 0], lutWeights[x * 2 + 1], inv_w_y, w_y,
+                             pDstRow + dstX * dstBytes);
+    }
+}
 
-            float fy = y * scaleY;
-            int y1 = rect.top + (int)fy;
-            if (y1 >= rect.bottom - 1) y1 = rect.bottom - 2;
-            if (y1 < rect.top) y1 = rect.top;
+// ------------------------------------------------------------------------------
+// ResizeMulti (マルチターゲットリサイズ)
+//
+// 1つのソース (同一のクロップ矩形) から複数の出力先を1パスで生成します。
+// ソースのクロップ範囲を kResizeBandRows 行ずつのバンドに分け、バンド単位で並列化します。
+// 各バンドについて、そのバンドを上側ソース行とする全ターゲットの出力行をまとめて生成するため、
+// ソースの各行はキャッシュに載っている間に全ターゲットから読まれ、メモリからは1回だけ読まれます。
+//
+// 行カーネルとLUTは単一ターゲット版と共通のため、各ターゲットの出力は
+// ResizeNearestNeighbor / ResizeBilinear を個別に呼んだ場合と完全に一致します。
+// ------------------------------------------------------------------------------
+void LR2BGAImageProc::ResizeMulti(
+    const BYTE* pSrc, int srcWidth, int srcHeight, int srcStride, int srcBpp,
+    const RECT* pSrcRect, ResizeTarget* pTargets, int targetCount)
+{
+    if (!m_initialized) Initialize();
+    if (!pSrc || !pTargets || targetCount <= 0) return;
 
-            float dy = fy - (int)fy;
-            int w_y = (int)(dy * PRECISION_SCALE);
-            int inv_w_y = PRECISION_SCALE - w_y;
+    RECT rect = ResolveSourceRect(pSrcRect, srcWidth, srcHeight);
+    int srcRectW = rect.right - rect.left;
+    int srcRectH = rect.bottom - rect.top;
+    if (srcRectW <= 0 || srcRectH <= 0) return;
 
-            const BYTE* pSrcRow1 = pSrc + y1 * srcStride;
-            const BYTE* pSrcRow2 = pSrc + (y1 + 1) * srcStride;
-            BYTE* pDstRow = pDst + dstY * dstStride;
+    const int srcBytes = srcBpp / 8;
+    const int dstBytes = 3; // RGB24 出力
+    const int bandCount = (srcRectH + kResizeBandRows - 1) / kResizeBandRows;
+
+    // SIMD行カーネルは RGB32 専用 (単一ターゲット版のフォールバック規則と同じ)
+    BilinearRowFunc bilinearRow = (srcBpp == 32) ? pBilinearRow : BilinearRow_Cpp;
+    // 幅1の切り出しは右隣を読まない行カーネルで処理する (ResizeBilinearRows と同じ)
+    if (srcRectW < 2) bilinearRow = BilinearRow_SingleColumn;
+
+    // ターゲットごとに X LUT、出力行→ソース行の対応表、バンド境界を構築
+    for (int t = 0; t < targetCount; ++t) {
+        ResizeTarget& target = pTargets[t];
+        ResizeCache& cache = *target.pCache;
+        const int actualW = target.actualWidth;
+        const int actualH = target.actualHeight;
+        if (actualW <= 0 || actualH <= 0) {
+            cache.bandStart.assign(bandCount + 1, 0);
+            continue;
+        }
 
-            __m256i v_inv_wy = _mm256_set1_epi32(inv_w_y);
-            __m256i v_wy = _mm256_set1_epi32(w_y);
+        if (cache.rowSource.size() < (size_t)actualH) cache.rowSource.resize(actualH);
+        if (cache.rowWeight.size() < (size_t)actualH) cache.rowWeight.resize(actualH);
 
-            int x = 0;
-            
-            // AVX2 Loop (Process 2 pixels at a time)
-            for (; x <= actualW - 2; x += 2) {
-                int dstX = x + offX;
-                if (dstX < 0 || dstX >= dstW - 1) {
-                    goto ScalarFallback_AVX2; 
-                }
+        if (target.bilinear) {
+            BuildBilinearLUT(rect, actualW, srcBytes, cache.lutIndices, cache.lutWeights);
+            float scaleY = BilinearScaleY(rect, actualH);
+            for (int y = 0; y < actualH; ++y) {
+                int w_y;
+                cache.rowSource[y] = BilinearSourceRow(y, rect, scaleY, w_y);
+                cache.rowWeight[y] = w_y;
+            }
+        } else {
+            BuildNearestLUT(rect, actualW, srcBytes, cache.lutIndices);
+            float scaleY = (float)srcRectH / actualH;
+            for (int y = 0; y < actualH; ++y) {
+                cache.rowSource[y] = NearestSourceRow(y, rect, scaleY);
+                cache.rowWeight[y] = 0;
+            }
+        }
 
-                int idx0 = lutIndices[x];
-                int idx1 = lutIndices[x+1];
-
-                // Load 2+2 pixels (Top and Bottom rows)
-                int p0_TL = *(int*)(pSrcRow1 + idx0); int p0_TR = *(int*)(pSrcRow1 + idx0 + 4);
-                int p0_BL = *(int*)(pSrcRow2 + idx0); int p0_BR = *(int*)(pSrcRow2 + idx0 + 4);
-
-                int p1_TL = *(int*)(pSrcRow1 + idx1); int p1_TR = *(int*)(pSrcRow1 + idx1 + 4);
-                int p1_BL = *(int*)(pSrcRow2 + idx1); int p1_BR = *(int*)(pSrcRow2 + idx1 + 4);
-
-                short i0 = lutWeights[x*2];   short w0 = lutWeights[x*2+1];
-                short i1 = lutWeights[x*2+2]; short w1 = lutWeights[x*2+3];
-
-                // Weights for horizontal interpolation [inv_w, w, inv_w, w...]
-                // Pixel 0 weights (8 shorts)
-                __m128i v_wx0_128 = _mm_set_epi16(w0,i0,w0,i0,w0,i0,w0,i0);
-                // Pixel 1 weights (8 shorts)
-                __m128i v_wx1_128 = _mm_set_epi16(w1,i1,w1,i1,w1,i1,w1,i1);
-                
-                // Combine to 256: [W1 | W0]
-                __m256i v_WX = _mm256_inserti128_si256(_mm256_castsi128_si256(v_wx0_128), v_wx1_128, 1);
-
-                // Top Line Interpolation
-                // Expand pixels to 16-bit
-                __m128i t0 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_TL), _mm_cvtsi32_si128(p0_TR));
-                __m128i t1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_TL), _mm_cvtsi32_si128(p1_TR));
-                
-                __m128i t0_16 = _mm_cvtepu8_epi16(t0); // 128 bit
-                __m128i t1_16 = _mm_cvtepu8_epi16(t1); // 128 bit
-                
-                // Combine to 256: [T1 | T0]
-                __m256i v_T_16 = _mm256_inserti128_si256(_mm256_castsi128_si256(t0_16), t1_16, 1);
-                
-                // Bottom Line Interpolation
-                __m128i b0 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p0_BL), _mm_cvtsi32_si128(p0_BR));
-                __m128i b1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p1_BL), _mm_cvtsi32_si128(p1_BR));
-                
-                __m128i b0_16 = _mm_cvtepu8_epi16(b0);
-                __m128i b1_16 = _mm_cvtepu8_epi16(b1);
-                
-                __m256i v_B_16 = _mm256_inserti128_si256(_mm256_castsi128_si256(b0_16), b1_16, 1);
-
-                // Horizontal Interpolation (madd_epi16)
-                // Result: 32-bit x 8 integers (4 per pixel)
-                __m256i v_top = _mm256_madd_epi16(v_T_16, v_WX); 
-                __m256i v_btm = _mm256_madd_epi16(v_B_16, v_WX);
-                
-                // Vertical Interpolation
-                __m256i v_res = _mm256_add_epi32(
-                    _mm256_mullo_epi32(v_top, v_inv_wy), 
-                    _mm256_mullo_epi32(v_btm, v_wy));
-                    
-                v_res = _mm256_srai_epi32(v_res, PRECISION_BITS * 2);
-                
-                // Pack back to 8-bit
-                // 32-bit -> 16-bit
-                __m256i v_res_16 = _mm256_packus_epi32(v_res, _mm256_setzero_si256());
-                // v_res_16: [ Lane1(4 shorts) | 0 | Lane0(4 shorts) | 0 ] ?
-                // packus_epi32 packs 2 128-bit blocks independently.
-                // Block 0: Res0(4 ints) -> Res0(4 shorts) + Zero(4 shorts)
-                // Result Block 0: [ Res0_16 | 0 ] (64 bits | 64 bits)
-                // Block 1: Res1(4 ints) -> Res1(4 shorts) + Zero
-                // Result Block 1: [ Res1_16 | 0 ]
-                
-                // 16-bit -> 8-bit
-                __m256i v_res_8 = _mm256_packus_epi16(v_res_16, _mm256_setzero_si256());
-                // Block 0: Res0_16(4 shorts + 4 zeros) -> Res0_8(4 bytes + 4 zeros) + Zeros
-                // Result Block 0: [ Res0_8 | 0 | ... ]
-                // Res0_8 is 32 bits (BGRA).
-                
-                // Extract results
-                int val0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(v_res_8));
-                int val1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(v_res_8, 1));
-                
-                // Store results
-                *(short*)(pDstRow + dstX * dstBytes) = (short)val0; 
-                *(pDstRow + dstX * dstBytes + 2) = (BYTE)(val0 >> 16);
-                
-                *(short*)(pDstRow + (dstX+1) * dstBytes) = (short)val1;
-                *(pDstRow + (dstX+1) * dstBytes + 2) = (BYTE)(val1 >> 16);
+        // ソース行は出力行に対して単調非減少なので、バンド境界は1回の走査で求まる
+        // bandStart[b] = ソース行がバンド b 以降に属する最初の出力行
+        cache.bandStart.assign(bandCount + 1, actualH);
+        int band = 0;
+        for (int y = 0; y < actualH; ++y) {
+            int rowBand = (cache.rowSource[y] - rect.top) / kResizeBandRows;
+            while (band <= rowBand && band <= bandCount) {
+                cache.bandStart[band++] = y;
             }
+        }
+    }
 
-            // Scalar fallback for tail/remainder
-            ScalarFallback_AVX2:
-            for (; x < actualW; x++) {
-                int dstX = x + offX;
-                if (dstX < 0 || dstX >= dstW) continue;
-                int idx = lutIndices[x];
-                int w_x = lutWeights[x * 2 + 1];
-                int inv_w_x = lutWeights[x * 2 + 0];
-                const BYTE* s1 = pSrcRow1 + idx;
-                const BYTE* s2 = pSrcRow2 + idx;
-                for (int c = 0; c < 3; c++) {
-                    int top = (s1[c] * inv_w_x + s1[c + srcBytes] * w_x) >> PRECISION_BITS;
-                    int bottom = (s2[c] * inv_w_x + s2[c + srcBytes] * w_x) >> PRECISION_BITS;
-                    int final_val = (top * inv_w_y + bottom * w_y) >> PRECISION_BITS;
-                    pDstRow[dstX * dstBytes + c] = (BYTE)final_val;
+    LR2BGAThreadPool::Instance().ParallelFor(0, bandCount, [&](int startBand, int endBand) {
+        for (int b = startBand; b < endBand; ++b) {
+            for (int t = 0; t < targetCount; ++t) {
+                const ResizeTarget& target = pTargets[t];
+                const ResizeCache& cache = *target.pCache;
+                const int rowBegin = cache.bandStart[b];
+                const int rowEnd = cache.bandStart[b + 1];
+
+                for (int y = rowBegin; y < rowEnd; ++y) {
+                    int dstY = y + target.offsetY;
+                    if (dstY < 0 || dstY >= target.dstHeight) continue;
+
+                    const BYTE* pSrcRow = pSrc + cache.rowSource[y] * srcStride;
+                    BYTE* pDstRow = target.pDst + dstY * target.dstStride;
+
+                    if (target.bilinear) {
+                        const BYTE* pSrcRow2 =
+                            (cache.rowSource[y] + 1 < rect.bottom) ? pSrcRow + srcStride : pSrcRow;
+                        bilinearRow(pSrcRow, pSrcRow2, cache.rowWeight[y], pDstRow,
+                                    cache.lutIndices.data(), cache.lutWeights.data(),
+                                    target.actualWidth, target.offsetX, target.dstWidth, srcBytes, dstBytes);
+                    } else {
+                        NearestRow(pSrcRow, pDstRow, cache.lutIndices.data(),
+                                   target.actualWidth, target.offsetX, target.dstWidth, dstBytes);
+                    }
                 }
             }
         }
     });
 }
 
+// ------------------------------------------------------------------------------
+// 輝度変換 (ConvertRowToLuma)
+//
+// 黒帯検出用サムネイルの生成に使用する、1行分の8bit輝度変換です。
+// SIMD版で PMADDUBSW (符号付き8bit係数) を使うため、係数は7bit精度
+// (B=15, G=75, R=38, 合計128) としています。C++版も同じ式で計算するため、
+// 実装間で結果は完全に一致します。
+// ------------------------------------------------------------------------------
+constexpr int kLumaWeightB = 15;
+constexpr int kLumaWeightG = 75;
+constexpr int kLumaWeightR = 38;
+constexpr int kLumaShift = 7;
+
+void LR2BGAImageProc::ConvertRowToLuma(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma)
+{
+    if (!m_initialized) Initialize();
+    if (!pSrcRow || !pDstLuma || width <= 0) return;
+    pLumaRow(pSrcRow, width, srcBpp, pDstLuma);
+}
+
+void LR2BGAImageProc::ConvertRowToLuma_Cpp(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma)
+{
+    const int srcBytes = srcBpp / 8;
+    for (int x = 0; x < width; x++) {
+        const BYTE* p = pSrcRow + x * srcBytes;
+        pDstLuma[x] = (BYTE)((kLumaWeightR * p[2] + kLumaWeightG * p[1] + kLumaWeightB * p[0]) >> kLumaShift);
+    }
+}
+
+LR2BGA_TARGET_SSE41
+void LR2BGAImageProc::ConvertRowToLuma_SSE41(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma)
+{
+    if (srcBpp != 32) {
+        ConvertRowToLuma_Cpp(pSrcRow, width, srcBpp, pDstLuma);
+        return;
+    }
+
+    // メモリ上の並び (B, G, R, A) に対応する係数
+    const __m128i v_weights = _mm_set1_epi32((kLumaWeightR << 16) | (kLumaWeightG << 8) | kLumaWeightB);
+
+    int x = 0;
+    // 16画素 (64バイト) 単位で処理
+    for (; x <= width - 16; x += 16) {
+        const __m128i* p = (const __m128i*)(pSrcRow + x * 4);
+        // PMADDUBSW: 画素ごとに [B*15 + G*75, R*38 + A*0] の16bit値2つ
+        __m128i m0 = _mm_maddubs_epi16(_mm_loadu_si128(p + 0), v_weights);
+        __m128i m1 = _mm_maddubs_epi16(_mm_loadu_si128(p + 1), v_weights);
+        __m128i m2 = _mm_maddubs_epi16(_mm_loadu_si128(p + 2), v_weights);
+        __m128i m3 = _mm_maddubs_epi16(_mm_loadu_si128(p + 3), v_weights);
+        // PHADDW: 隣接ペアを加算して画素ごとの輝度 (最大 255*128 で16bitに収まる)
+        __m128i y01 = _mm_srli_epi16(_mm_hadd_epi16(m0, m1), kLumaShift);
+        __m128i y23 = _mm_srli_epi16(_mm_hadd_epi16(m2, m3), kLumaShift);
+        _mm_storeu_si128((__m128i*)(pDstLuma + x), _mm_packus_epi16(y01, y23));
+    }
+
+    // 端数
+    if (x < width) {
+        ConvertRowToLuma_Cpp(pSrcRow + x * 4, width - x, srcBpp, pDstLuma + x);
+    }
+}
+
+LR2BGA_TARGET_AVX2
+void LR2BGAImageProc::ConvertRowToLuma_AVX2(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma)
+{
+    if (srcBpp != 32) {
+        ConvertRowToLuma_Cpp(pSrcRow, width, srcBpp, pDstLuma);
+        return;
+    }
+
+    const __m256i v_weights = _mm256_set1_epi32((kLumaWeightR << 16) | (kLumaWeightG << 8) | kLumaWeightB);
+    // PHADDW / PACKUSWB はレーン単位で動作するため、最後に32bit単位で並べ替える
+    const __m256i v_order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int x = 0;
+    // 32画素 (128バイト) 単位で処理
+    for (; x <= width - 32; x += 32) {
+        const __m256i* p = (const __m256i*)(pSrcRow + x * 4);
+        __m256i m0 = _mm256_maddubs_epi16(_mm256_loadu_si256(p + 0), v_weights);
+        __m256i m1 = _mm256_maddubs_epi16(_mm256_loadu_si256(p + 1), v_weights);
+        __m256i m2 = _mm256_maddubs_epi16(_mm256_loadu_si256(p + 2), v_weights);
+        __m256i m3 = _mm256_maddubs_epi16(_mm256_loadu_si256(p + 3), v_weights);
+        __m256i y01 = _mm256_srli_epi16(_mm256_hadd_epi16(m0, m1), kLumaShift);
+        __m256i y23 = _mm256_srli_epi16(_mm256_hadd_epi16(m2, m3), kLumaShift);
+        __m256i packed = _mm256_packus_epi16(y01, y23);
+        _mm256_storeu_si256((__m256i*)(pDstLuma + x), _mm256_permutevar8x32_epi32(packed, v_order));
+    }
+
+    // 端数はSSE4.1版で処理 (さらに端数はC++版)
+    if (x < width) {
+        ConvertRowToLuma_SSE41(pSrcRow + x * 4, width - x, srcBpp, pDstLuma + x);
+    }
+}
+
+// ------------------------------------------------------------------------------
+// 閾値未満カウント (CountBelowThreshold)
+//
+// 黒帯検出で、輝度行のうち黒閾値未満の画素数を数えるためのカーネルです。
+// SIMD版は「x < t ⇔ max(x, t-1) == t-1」で比較マスクを作り、
+// バイト単位のカウンタへ加算します (最大255回ごとに PSADBW で横方向に集計)。
+// POPCNT 命令は SSE4.1 世代の一部CPUで使えないため使用しません。
+// ------------------------------------------------------------------------------
+constexpr int kCountFlushInterval = 255; // バイトカウンタが溢れる前に集計する間隔
+
+int LR2BGAImageProc::CountBelowThreshold(const BYTE* pData, int count, int threshold)
+{
+    if (!m_initialized) Initialize();
+    if (!pData || count <= 0 || threshold <= 0) return 0;
+    if (threshold > kMaxBrightness) return count;
+    return pCountBelow(pData, count, threshold);
+}
+
+int LR2BGAImageProc::CountBelowThreshold_Cpp(const BYTE* pData, int count, int threshold)
+{
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        if (pData[i] < threshold) result++;
+    }
+    return result;
+}
+
+LR2BGA_TARGET_SSE41
+int LR2BGAImageProc::CountBelowThreshold_SSE41(const BYTE* pData, int count, int threshold)
+{
+    const __m128i v_limit = _mm_set1_epi8((char)(threshold - 1));
+    const __m128i v_zero = _mm_setzero_si128();
+    __m128i v_total = _mm_setzero_si128();
+
+    int i = 0;
+    while (i <= count - 16) {
+        // バイトカウンタ (各バイト最大255)
+        __m128i v_acc = _mm_setzero_si128();
+        int blocks = (count - i) / 16;
+        if (blocks > kCountFlushInterval) blocks = kCountFlushInterval;
+        for (int b = 0; b < blocks; b++, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(pData + i));
+            __m128i v_mask = _mm_cmpeq_epi8(_mm_max_epu8(v, v_limit), v_limit); // 0xFF = 閾値未満
+            v_acc = _mm_sub_epi8(v_acc, v_mask);
+        }
+        v_total = _mm_add_epi64(v_total, _mm_sad_epu8(v_acc, v_zero));
+    }
+
+    int result = _mm_cvtsi128_si32(v_total) + _mm_extract_epi32(v_total, 2);
+    if (i < count) {
+        result += CountBelowThreshold_Cpp(pData + i, count - i, threshold);
+    }
+    return result;
+}
+
+LR2BGA_TARGET_AVX2
+int LR2BGAImageProc::CountBelowThreshold_AVX2(const BYTE* pData, int count, int threshold)
+{
+    const __m256i v_limit = _mm256_set1_epi8((char)(threshold - 1));
+    const __m256i v_zero = _mm256_setzero_si256();
+    __m256i v_total = _mm256_setzero_si256();
+
+    int i = 0;
+    while (i <= count - 32) {
+        __m256i v_acc = _mm256_setzero_si256();
+        int blocks = (count - i) / 32;
+        if (blocks > kCountFlushInterval) blocks = kCountFlushInterval;
+        for (int b = 0; b < blocks; b++, i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(pData + i));
+            __m256i v_mask = _mm256_cmpeq_epi8(_mm256_max_epu8(v, v_limit), v_limit);
+            v_acc = _mm256_sub_epi8(v_acc, v_mask);
+        }
+        v_total = _mm256_add_epi64(v_total, _mm256_sad_epu8(v_acc, v_zero));
+    }
+
+    __m128i v_sum = _mm_add_epi64(_mm256_castsi256_si128(v_total), _mm256_extracti128_si256(v_total, 1));
+    int result = _mm_cvtsi128_si32(v_sum) + _mm_extract_epi32(v_sum, 2);
+    if (i < count) {
+        result += CountBelowThreshold_SSE41(pData + i, count - i, threshold);
+    }
+    return result;
+}
+
+// ------------------------------------------------------------------------------
+// 輝度プロファイル集計 (AccumulateLumaProfile)
+//
+// 黒帯検出で、サムネイルの各行から「行の最大輝度」と「列ごとの最大輝度」を
+// 同時に求めるためのカーネルです。どちらも PMAXUB のみで計算できるため、
+// 1回の読み込みで両方のプロファイルを更新します。
+// ------------------------------------------------------------------------------
+BYTE LR2BGAImageProc::AccumulateLumaProfile(const BYTE* pLumaRow, int width, BYTE* pColMax)
+{
+    if (!m_initialized) Initialize();
+    if (!pLumaRow || !pColMax || width <= 0) return 0;
+    return pLumaProfile(pLumaRow, width, pColMax);
+}
+
+BYTE LR2BGAImageProc::AccumulateLumaProfile_Cpp(const BYTE* pLumaRow, int width, BYTE* pColMax)
+{
+    BYTE rowMax = 0;
+    for (int x = 0; x < width; x++) {
+        BYTE v = pLumaRow[x];
+        if (v > rowMax) rowMax = v;
+        if (v > pColMax[x]) pColMax[x] = v;
+    }
+    return rowMax;
+}
+
+LR2BGA_TARGET_SSE41
+BYTE LR2BGAImageProc::AccumulateLumaProfile_SSE41(const BYTE* pLumaRow, int width, BYTE* pColMax)
+{
+    __m128i v_rowMax = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x <= width - 16; x += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pLumaRow + x));
+        __m128i v_col = _mm_loadu_si128((const __m128i*)(pColMax + x));
+        _mm_storeu_si128((__m128i*)(pColMax + x), _mm_max_epu8(v_col, v));
+        v_rowMax = _mm_max_epu8(v_rowMax, v);
+    }
+
+    // 水平方向の最大値
+    v_rowMax = _mm_max_epu8(v_rowMax, _mm_srli_si128(v_rowMax, 8));
+    v_rowMax = _mm_max_epu8(v_rowMax, _mm_srli_si128(v_rowMax, 4));
+    v_rowMax = _mm_max_epu8(v_rowMax, _mm_srli_si128(v_rowMax, 2));
+    v_rowMax = _mm_max_epu8(v_rowMax, _mm_srli_si128(v_rowMax, 1));
+    BYTE rowMax = (BYTE)_mm_cvtsi128_si32(v_rowMax);
+
+    if (x < width) {
+        BYTE tailMax = AccumulateLumaProfile_Cpp(pLumaRow + x, width - x, pColMax + x);
+        if (tailMax > rowMax) rowMax = tailMax;
+    }
+    return rowMax;
+}
+
+LR2BGA_TARGET_AVX2
+BYTE LR2BGAImageProc::AccumulateLumaProfile_AVX2(const BYTE* pLumaRow, int width, BYTE* pColMax)
+{
+    __m256i v_rowMax = _mm256_setzero_si256();
+
+    int x = 0;
+    for (; x <= width - 32; x += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(pLumaRow + x));
+        __m256i v_col = _mm256_loadu_si256((const __m256i*)(pColMax + x));
+        _mm256_storeu_si256((__m256i*)(pColMax + x), _mm256_max_epu8(v_col, v));
+        v_rowMax = _mm256_max_epu8(v_rowMax, v);
+    }
+
+    __m128i v_max = _mm_max_epu8(_mm256_castsi256_si128(v_rowMax), _mm256_extracti128_si256(v_rowMax, 1));
+    v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 8));
+    v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 4));
+    v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 2));
+    v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 1));
+    BYTE rowMax = (BYTE)_mm_cvtsi128_si32(v_max);
+
+    if (x < width) {
+        BYTE tailMax = AccumulateLumaProfile_SSE41(pLumaRow + x, width - x, pColMax + x);
+        if (tailMax > rowMax) rowMax = tailMax;
+    }
+    return rowMax;
+}
+
+// ------------------------------------------------------------------------------
+// 画像ハッシュ (HashRows)
+//
+// 外部ウィンドウの重複フレーム判定用です。8バイト語ごとに h = (h ^ w) * K を
+// 4レーン独立に回し (乗算の依存チェーンを分けて並列に実行させる)、最後に畳み込みます。
+// 奇数 K による乗算は全単射なので、途中の状態が一度異なれば以降の語で一致に戻ることはなく、
+// 1語だけ異なる画像の衝突は起こりません。メモリ帯域に対して十分速いためSIMD版は持ちません。
+// ------------------------------------------------------------------------------
+UINT64 LR2BGAImageProc::HashRows(const BYTE* pData, int rowBytes, int rows, int stride)
+{
+    const UINT64 kMul = 0x9E3779B97F4A7C15ULL;
+    UINT64 h0 = 0x243F6A8885A308D3ULL;
+    UINT64 h1 = 0x13198A2E03707344ULL;
+    UINT64 h2 = 0xA4093822299F31D0ULL;
+    UINT64 h3 = 0x082EFA98EC4E6C89ULL;
+    if (!pData || rowBytes <= 0 || rows <= 0) return 0;
+
+    for (int y = 0; y < rows; ++y) {
+        const BYTE* p = pData + (size_t)y * stride;
+        int x = 0;
+        for (; x <= rowBytes - 32; x += 32) {
+            UINT64 w[4];
+            memcpy(w, p + x, sizeof(w));
+            h0 = (h0 ^ w[0]) * kMul;
+            h1 = (h1 ^ w[1]) * kMul;
+            h2 = (h2 ^ w[2]) * kMul;
+            h3 = (h3 ^ w[3]) * kMul;
+        }
+        for (; x <= rowBytes - 8; x += 8) {
+            UINT64 w;
+            memcpy(&w, p + x, sizeof(w));
+            h0 = (h0 ^ w) * kMul;
+        }
+        if (x < rowBytes) {
+            UINT64 w = 0;
+            memcpy(&w, p + x, rowBytes - x);
+            h1 = (h1 ^ w) * kMul;
+        }
+    }
+
+    // 乗算は上位ビットへしか伝播しないため、畳み込みの各段で右シフトを混ぜる
+    UINT64 h = h0;
+    h = (h ^ (h >> 29) ^ h1) * kMul;
+    h = (h ^ (h >> 29) ^ h2) * kMul;
+    h = (h ^ (h >> 29) ^ h3) * kMul;
+    h ^= h >> 32;
+    return h;
+}
@@ -30,13 +30,80 @@ public:
       int actualWidth, int actualHeight, int offsetX, int offsetY, 
       const RECT* pSrcRect, std::vector<int>& lutIndices, std::vector<short>& lutWeights);
 
+  // マルチターゲットリサイズ用のキャッシュ (ターゲットごとに呼び出し元が保持し、フレーム間で再利用する)
+  struct ResizeCache {
+      std::vector<int> lutIndices;    // X方向のソースオフセット
+      std::vector<short> lutWeights;  // X方向の重み [inv_w, w] (バイリニアのみ)
+      std::vector<int> rowSource;     // 出力行 -> ソース行 (バイリニアは上側の行)
+      std::vector<int> rowWeight;     // 出力行 -> 縦方向の重み (バイリニアのみ)
+      std::vector<int> bandStart;     // ソース行バンド -> 最初の出力行
+  };
+
+  // マルチターゲットリサイズの出力先記述子 (RGB24出力)
+  struct ResizeTarget {
+      BYTE* pDst;
+      int dstWidth;
+      int dstHeight;
+      int dstStride;
+      int actualWidth;                // CalculateResizeDimensions の結果
+      int actualHeight;
+      int offsetX;
+      int offsetY;
+      bool bilinear;                  // true: バイリニア, false: 最近傍
+      ResizeCache* pCache;
+  };
+
+  // マルチターゲットリサイズ
+  // 同一ソース・同一クロップ矩形から複数の出力先を、ソースを1回だけ走査して生成します
+  // 各出力は ResizeNearestNeighbor / ResizeBilinear を個別に呼んだ場合と同一の結果になります
+  // RGB32/24入力 -> RGB24出力 (レターボックス部分の黒塗りは呼び出し元で行うこと)
+  static void ResizeMulti(
+      const BYTE* pSrc, int srcWidth, int srcHeight, int srcStride, int srcBpp,
+      const RECT* pSrcRect, ResizeTarget* pTargets, int targetCount);
+
   // 明るさ調整 (In-place処理)
   // RGB24バッファの各画素値を指定されたパーセンテージ(0-100)で暗くします
   static void ApplyBrightness(BYTE* pData, int width, int height, int stride, int brightness);
 
+  // 8bit輝度変換 (1行分)
+  // RGB32/24の1行を Y = (38R + 75G + 15B) >> 7 の8bit輝度へ変換します
+  // 黒帯検出用の輝度サムネイル生成に使用します (SIMD版とC++版は同一結果)
+  static void ConvertRowToLuma(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma);
+
+  // 閾値未満カウント
+  // 8bit値の配列のうち threshold 未満の要素数を返します (黒画素の計数用)
+  static int CountBelowThreshold(const BYTE* pData, int count, int threshold);
+
+  // 輝度プロファイル集計 (1行分)
+  // pColMax[x] = max(pColMax[x], pLumaRow[x]) で列ごとの最大輝度を更新し、行の最大輝度を返します
+  // 黒帯検出で行/列プロファイルを1パスで構築するために使用します
+  static BYTE AccumulateLumaProfile(const BYTE* pLumaRow, int width, BYTE* pColMax);
+
+  // 画像ハッシュ (重複フレーム判定用)
+  // 各行の先頭 rowBytes バイトから64bitハッシュを計算します (行末のストライド余白は含めない)
+  // 1語だけ異なる画像は必ず異なる値になり、それ以外の衝突確率は約 2^-64 です
+  static UINT64 HashRows(const BYTE* pData, int rowBytes, int rows, int stride);
+
   // 初期化 (CPU機能判定と関数ポインタ設定)
   static void Initialize();
 
+  // カーネルの実装段階 (上位の段階は下位の段階の関数を置き換える)
+  enum KernelTier {
+      KERNEL_TIER_CPP = 0,    // 浮動小数点の素朴な実装 (単一スレッド。比較用の基準)
+      KERNEL_TIER_CPPOPT,     // 固定小数点 + LUT (並列化)
+      KERNEL_TIER_SSE41,
+      KERNEL_TIER_AVX2,
+      KERNEL_TIER_COUNT
+  };
+
+  // CPUが対応する最上位の段階 (Initialize はこれを選ぶ)
+  static KernelTier GetMaxSupportedTier();
+  // 使用する段階を明示的に切り替える (ベンチマーク・検証用。CPUが対応しない段階は false)
+  // 関数ポインタを差し替えるため、画像処理の実行中に呼ばないこと
+  static bool SetKernelTier(KernelTier tier);
+  static KernelTier GetKernelTier();
+  static const char* GetKernelTierName(KernelTier tier);
+
 private:
   // 関数ポインタ型定義 (Bilinear 用: LUTWeights あり)
   typedef void (*ResizeFunc)(const BYTE* pSrc, int srcW, int srcH, int srcStr, int srcBpp,
@@ -50,6 +117,20 @@ private:
                                     int actW, int actH, int offX, int offY, const RECT* pSrcRect,
                                     std::vector<int>& lutI);
 
+  // 関数ポインタ型定義 (バイリニア行カーネル用)
+  typedef void (*BilinearRowFunc)(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                                  BYTE* pDstRow, const int* pLutIndices, const short* pLutWeights,
+                                  int actualW, int offX, int dstW, int srcBytes, int dstBytes);
+
+  // 関数ポインタ型定義 (輝度変換用)
+  typedef void (*LumaRowFunc)(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma);
+
+  // 関数ポインタ型定義 (閾値未満カウント用)
+  typedef int (*CountBelowFunc)(const BYTE* pData, int count, int threshold);
+
+  // 関数ポインタ型定義 (輝度プロファイル集計用)
+  typedef BYTE (*LumaProfileFunc)(const BYTE* pLumaRow, int width, BYTE* pColMax);
+
   // 実装関数 (C++ Pure)
   static void ResizeNearestNeighbor_Cpp(const BYTE* pSrc, int srcW, int srcH, int srcStr, int srcBpp,
                                         BYTE* pDst, int dstW, int dstH, int dstStr, int dstBpp,
@@ -84,10 +165,56 @@ private:
                                   int actW, int actH, int offX, int offY, const RECT* pSrcRect,
                                   std::vector<int>& lutI, std::vector<short>& lutW);
 
+  // バイリニア共通駆動部 (LUT構築 + 出力行の並列ループ、行の処理は rowFunc)
+  static void ResizeBilinearRows(const BYTE* pSrc, int srcStride, int srcBpp, const RECT& rect,
+                                 BYTE* pDst, int dstW, int dstH, int dstStride, int dstBpp,
+                                 int actW, int actH, int offX, int offY,
+                                 std::vector<int>& lutI, std::vector<short>& lutW, BilinearRowFunc rowFunc);
+
+  // 行カーネル Implementations (単一ターゲット版と ResizeMulti で共用)
+  static void NearestRow(const BYTE* pSrcRow, BYTE* pDstRow, const int* pLutIndices,
+                         int actualW, int offX, int dstW, int dstBytes);
+  static void BilinearRow_Cpp(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                              BYTE* pDstRow, const int* pLutIndices, const short* pLutWeights,
+                              int actualW, int offX, int dstW, int srcBytes, int dstBytes);
+  static void BilinearRow_SSE41(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                                BYTE* pDstRow, const int* pLutIndices, const short* pLutWeights,
+                                int actualW, int offX, int dstW, int srcBytes, int dstBytes);
+  static void BilinearRow_AVX2(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                               BYTE* pDstRow, const int* pLutIndices, const short* pLutWeights,
+                               int actualW, int offX, int dstW, int srcBytes, int dstBytes);
+  // 幅1の切り出し用 (横方向の右隣を読まない。全段階で共用)
+  static void BilinearRow_SingleColumn(const BYTE* pSrcRow1, const BYTE* pSrcRow2, int w_y,
+                                       BYTE* pDstRow, const int* pLutIndices, const short* pLutWeights,
+                                       int actualW, int offX, int dstW, int srcBytes, int dstBytes);
+
+  // 輝度変換 Implementations (SIMD版はRGB32専用、それ以外はC++版へフォールバック)
+  static void ConvertRowToLuma_Cpp(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma);
+  static void ConvertRowToLuma_SSE41(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma);
+  static void ConvertRowToLuma_AVX2(const BYTE* pSrcRow, int width, int srcBpp, BYTE* pDstLuma);
+
+  // 閾値未満カウント Implementations
+  static int CountBelowThreshold_Cpp(const BYTE* pData, int count, int threshold);
+  static int CountBelowThreshold_SSE41(const BYTE* pData, int count, int threshold);
+  static int CountBelowThreshold_AVX2(const BYTE* pData, int count, int threshold);
+
+  // 輝度プロファイル集計 Implementations
+  static BYTE AccumulateLumaProfile_Cpp(const BYTE* pLumaRow, int width, BYTE* pColMax);
+  static BYTE AccumulateLumaProfile_SSE41(const BYTE* pLumaRow, int width, BYTE* pColMax);
+  static BYTE AccumulateLumaProfile_AVX2(const BYTE* pLumaRow, int width, BYTE* pColMax);
+
   // 関数ポインタ (Dispatch Target)
   static ResizeFuncNearest pResizeNearest; // 型変更
   static ResizeFunc pResizeBilinear;
+  static BilinearRowFunc pBilinearRow;     // ResizeMulti 用 (RGB32入力時)
+  static LumaRowFunc pLumaRow;
+  static CountBelowFunc pCountBelow;
+  static LumaProfileFunc pLumaProfile;
+  static KernelTier m_kernelTier;
   static bool m_initialized;
+
+  // 関数ポインタを段階に合わせて設定する
+  static void ApplyKernelTier(KernelTier tier);
 };
 
 
@@ -1,19 +1,25 @@
 ﻿#include "LR2BGALetterboxDetector.h"
+#include "LR2BGAImageProc.h"
+#include <cstdlib>
+#include <cmath>
 
 //------------------------------------------------------------------------------
 // 定数定義 (Constants)
 //------------------------------------------------------------------------------
 constexpr int kDefaultBlackThreshold = 16;      // デフォルト閾値: 明るさ16未満を黒とみなす
 constexpr int kDefaultStabilityThreshold = 5;   // デフォルト安定化: 5回連続検出で確定
+constexpr LONG kMaxSampleStep = 5;              // サンプリング間隔の上限 (px)
+constexpr LONG kMinBarSize = 8;                 // これ未満の黒帯は切り出さない (px)
+constexpr float kDarkContentRatio = 0.50f;      // コンテンツ範囲の黒率がこれを超えたら暗部とみなす
+constexpr float kKnownAspectTolerance = 0.02f;  // 16:9 / 4:3 とみなすアスペクト比の許容誤差 (相対)
 
 LR2BGALetterboxDetector::LR2BGALetterboxDetector()
-    : m_currentMode(LB_MODE_ORIGINAL), m_pendingMode(LB_MODE_ORIGINAL),
+    : m_currentMode(LB_MODE_ORIGINAL), m_currentRect(),
+      m_contentRect(), m_bContentLatched(false), m_bRejected(false),
+      m_pendingMode(LB_MODE_ORIGINAL), m_pendingRect(),
       m_stabilityCounter(0),
-      m_blackThreshold(kDefaultBlackThreshold) // デフォルト閾値: 明るさ16未満を黒とみなす
-      ,
-      m_stabilityThreshold(kDefaultStabilityThreshold) // デフォルト安定化: 5回連続検出で確定
-      ,
-      m_bRejected169(false), m_bRejected43(false) {
+      m_stabilityThreshold(kDefaultStabilityThreshold), // デフォルト安定化: 5回連続検出で確定
+      m_blackThreshold(kDefaultBlackThreshold) {        // デフォルト閾値: 明るさ16未満を黒とみなす
   // Init
 }
 
@@ -28,12 +34,15 @@ void LR2BGALetterboxDetector::SetParams(int threshold, int stabilityFrames) {
 
 void LR2BGALetterboxDetector::Reset() {
   m_currentMode = LB_MODE_ORIGINAL;
+  SetRectEmpty(&m_currentRect);
   m_pendingMode = LB_MODE_ORIGINAL;
+  SetRectEmpty(&m_pendingRect);
   m_stabilityCounter = 0;
 
-  // 除外フラグのクリア
-  m_bRejected169 = false;
-  m_bRejected43 = false;
+  // 除外ラッチのクリア
+  SetRectEmpty(&m_contentRect);
+  m_bContentLatched = false;
+  m_bRejected = false;
 
   {
       std::lock_guard<std::mutex> lock(m_mtxDebugInfo);
@@ -41,6 +50,33 @@ void LR2BGALetterboxDetector::Reset() {
   }
 }
 
+void LR2BGALetterboxDetector::Seed(LetterboxMode mode, const RECT &rect,
+                                   LONG width, LONG height) {
+  Reset();
+
+  const RECT fullRect = {0, 0, width, height};
+  m_currentMode = mode;
+  m_currentRect = (mode == LB_MODE_ORIGINAL) ? fullRect : rect;
+  m_pendingMode = m_currentMode;
+  m_pendingRect = m_currentRect;
+  m_stabilityCounter = m_stabilityThreshold;
+
+  m_contentRect = m_currentRect;
+  m_bContentLatched = true;
+  m_bRejected = (mode == LB_MODE_ORIGINAL);
+}
+
+void LR2BGALetterboxDetector::BeginNewScene() {
+  SetRectEmpty(&m_contentRect);
+  m_bContentLatched = false;
+  m_bRejected = false;
+
+  // 確定結果を維持したまま、再確認のためにカウンタのみ戻す
+  m_pendingMode = m_currentMode;
+  m_pendingRect = m_currentRect;
+  m_stabilityCounter = 0;
+}
+
 LetterboxDebugInfo LR2BGALetterboxDetector::GetDebugInfo() {
   std::lock_guard<std::mutex> lock(m_mtxDebugInfo);
   LetterboxDebugInfo info = m_lastDebugInfo;
@@ -48,160 +84,200 @@ LetterboxDebugInfo LR2BGALetterboxDetector::GetDebugInfo() {
 }
 
 // -----------------------------------------------------------------------------
-// フレーム解析のメインロジック
-// 上下の黒帯を検出し、最適なアスペクト比モードを推奨します。
+// サンプリング間隔
+// 解像度に応じてサンプリング間隔を動的に調整します。
+// 低解像度(240p等)では細かく、高解像度(720p等)では粗くサンプリングする
+// 目安: 短辺の1/150程度 (240px -> 1.6 -> 1px / 720px -> 4.8 -> 4px)
+// 最大値は従来の5pxに制限
 // -----------------------------------------------------------------------------
-LetterboxMode LR2BGALetterboxDetector::AnalyzeFrame(const BYTE *pBuffer,
+LONG LR2BGALetterboxDetector::GetSampleStep(LONG width, LONG height) {
+  LONG step = max(1, min(width, height) / 150);
+  if (step > kMaxSampleStep)
+    step = kMaxSampleStep;
+  return step;
+}
+
+// -----------------------------------------------------------------------------
+// 輝度サムネイル生成
+// 解析で参照する行 (GetSampleStep 行ごと) だけを8bit輝度へ変換します。
+// フルフレームをコピーする代わりにこちらを受け渡すことで、変換スレッドの
+// メモリ帯域消費とロック保持時間を抑えます。
+// -----------------------------------------------------------------------------
+bool LR2BGALetterboxDetector::BuildThumbnail(const BYTE *pBuffer,
+                                             size_t bufferSize, LONG width,
+                                             LONG height, LONG stride,
+                                             int bitsPerPixel,
+                                             LetterboxThumbnail &thumb) {
+  thumb.rows = 0;
+  if (!pBuffer || width <= 0 || height <= 0 || stride <= 0 || bufferSize == 0)
+    return false;
+  if (bitsPerPixel != 24 && bitsPerPixel != 32)
+    return false;
+
+  const LONG step = GetSampleStep(width, height);
+  const LONG maxRows = (height + step - 1) / step;
+  const size_t rowBytes = (size_t)width * (bitsPerPixel / 8);
+
+  try {
+    if (thumb.luma.size() < (size_t)maxRows * width)
+      thumb.luma.resize((size_t)maxRows * width);
+  } catch (...) {
+    return false;
+  }
+
+  thumb.width = width;
+  thumb.height = height;
+  thumb.rowStep = step;
+
+  LONG rows = 0;
+  for (LONG y = 0; y < height; y += step) {
+    const size_t rowOffset = (size_t)y * stride;
+    // バッファ終端を超える行は変換しない (actualDataLength が不足している場合)
+    if (rowOffset + rowBytes > bufferSize)
+      break;
+    LR2BGAImageProc::ConvertRowToLuma(pBuffer + rowOffset, width, bitsPerPixel,
+                                      thumb.luma.data() + (size_t)rows * width);
+    rows++;
+  }
+  thumb.rows = rows;
+  return rows > 0;
+}
+
+// -----------------------------------------------------------------------------
+// シーンシグネチャ
+// 8x8 格子上の画素の輝度を並べた 64 バイトの特徴量です。
+// 毎フレーム計算しても負荷にならない程度の軽量なシーンカット検出に使います。
+// -----------------------------------------------------------------------------
+void LR2BGALetterboxDetector::ComputeSceneSignature(const BYTE *pBuffer,
                                                     size_t bufferSize,
                                                     LONG width, LONG height,
                                                     LONG stride,
-                                                    int bitsPerPixel) {
+                                                    int bitsPerPixel,
+                                                    BYTE *pSignature) {
+  ZeroMemory(pSignature, kSceneSignatureSize);
+  if (!pBuffer || width <= 0 || height <= 0 || stride <= 0)
+    return;
+  if (bitsPerPixel != 24 && bitsPerPixel != 32)
+    return;
+
+  const int bytesPerPixel = bitsPerPixel / 8;
+  constexpr int kGrid = 8; // kGrid * kGrid = kSceneSignatureSize
+  for (int gy = 0; gy < kGrid; gy++) {
+    // 格子セルの中心をサンプリング
+    const LONG y = (LONG)(((2 * gy + 1) * (LONGLONG)height) / (2 * kGrid));
+    for (int gx = 0; gx < kGrid; gx++) {
+      const LONG x = (LONG)(((2 * gx + 1) * (LONGLONG)width) / (2 * kGrid));
+      const size_t offset = (size_t)y * stride + (size_t)x * bytesPerPixel;
+      if (offset + 3 > bufferSize)
+        continue;
+      const BYTE *p = pBuffer + offset;
+      pSignature[gy * kGrid + gx] = (BYTE)((38 * p[2] + 75 * p[1] + 15 * p[0]) >> 7);
+    }
+  }
+}
+
+int LR2BGALetterboxDetector::CompareSceneSignature(const BYTE *pSigA,
+                                                   const BYTE *pSigB) {
+  int total = 0;
+  for (int i = 0; i < kSceneSignatureSize; i++) {
+    total += std::abs((int)pSigA[i] - (int)pSigB[i]);
+  }
+  return total / kSceneSignatureSize;
+}
+
+// -----------------------------------------------------------------------------
+// フレーム解析のメインロジック
+// 行/列の最大輝度プロファイルからコンテンツ範囲を求め、最適な切り出し範囲を推奨します。
+//
+// 1. プロファイル: サムネイルの各行を1回ずつ読み、行ごと・列ごとの最大輝度を求める。
+// 2. コンテンツ範囲: 最大輝度が閾値以上の行/列を含む最小の矩形。
+// 3. 除外ラッチ: シーン内で観測した範囲の和集合を保持し、縮小させない。
+//    一度でもコンテンツが描画された領域は、そのシーンの間は切り出さない。
+//    ラッチは暗部ガード (範囲内の黒率 50% 以下) を通過したフレームでのみ開始する。
+// 4. ヒステリシス: 同じ結果が指定回数連続した場合のみ確定する。
+// -----------------------------------------------------------------------------
+LetterboxMode
+LR2BGALetterboxDetector::AnalyzeFrame(const LetterboxThumbnail &thumb) {
   LetterboxDebugInfo debugInfo;
   debugInfo.stabilityThreshold = m_stabilityThreshold;
-  debugInfo.is43TopBlack = false;
-  debugInfo.ratio43Top = -1.0f; // Skipped state
-  debugInfo.is43BottomBlack = false;
-  debugInfo.ratio43Bottom = -1.0f;
 
-  if (!pBuffer || width <= 0 || height <= 0 || bufferSize == 0)
+  const LONG width = thumb.width;
+  const LONG height = thumb.height;
+  if (width <= 0 || height <= 0 || thumb.rows <= 0)
     return LB_MODE_ORIGINAL;
 
-  // 現在のアスペクト比を計算
-  float currentAspect = (float)width / height;
-
-  // アスペクト比による事前除外
-  // (構造的にレターボックスになり得ない場合をリジェクト)
-  // 一度リジェクトされればフラグが立ち、以後のフレームでもチェックがスキップされる
-  if (currentAspect >= 1.76f) { // 16:9 (1.77) 以上
-    m_bRejected169 = true;
-    m_bRejected43 = true;
-  } else if (currentAspect >= 1.32f) { // 4:3 (1.33) 以上
-    m_bRejected43 = true;
+  const RECT fullRect = {0, 0, width, height};
+  if (IsRectEmpty(&m_currentRect)) {
+    m_currentRect = fullRect;
   }
 
-  // この後の "Rejection Latch Logic" ブロックで
-  // m_bRejectedの状態に応じた早期リターンが行われるため ここで return
-  // LB_MODE_ORIGINAL する必要はない (フローを共通化)
-
-  // -------------------------------------------------------------------------
-  // 新検出ロジック (Refined Detection Logic)
-  // -------------------------------------------------------------------------
-
-  LetterboxMode detectedMode = LB_MODE_ORIGINAL;
+  // 判定不能な場合は現在の結果を維持する
+  LetterboxMode detectedMode = m_currentMode;
+  RECT detectedRect = m_currentRect;
 
-  // 初期状態としてのデバッグ情報更新
-  debugInfo.bRejected169 = m_bRejected169;
-  debugInfo.bRejected43 = m_bRejected43;
-
-  // 既に両方とも除外されている場合は、解析せずオリジナルモード確定
-  if (m_bRejected169 && m_bRejected43) {
-    detectedMode = LB_MODE_ORIGINAL;
+  RECT frameRect;
+  debugInfo.hasContent = FindContentRect(thumb, frameRect);
+  if (!debugInfo.hasContent) {
+    // 全面が黒 (暗転中): 判定不能
+    debugInfo.isCenterBlack = true;
+    debugInfo.centerBlackRatio = 1.0f;
   } else {
-    bool is169Detected = false;
-
-    // ---------------------------------------------------------------------
-    // 1. Check 16:9
-    // ---------------------------------------------------------------------
-    if (!m_bRejected169) {
-      // 幅を基準に、16:9である場合の理想の高さを計算
-      LONG targetHeight169 = (LONG)(width / (16.0f / 9.0f));
-      LONG barHeight169 = (height - targetHeight169) / 2;
-      const LONG CHECK_MARGIN = 8;
-
-      if (barHeight169 > CHECK_MARGIN) {
-        LONG checkHeight = barHeight169 - CHECK_MARGIN;
-
-        debugInfo.is169TopBlack =
-            IsRegionBlack(pBuffer, bufferSize, width, height, stride,
-                          bitsPerPixel, 0, checkHeight, &debugInfo.ratio169Top);
-        debugInfo.is169BottomBlack = IsRegionBlack(
-            pBuffer, bufferSize, width, height, stride, bitsPerPixel,
-            height - checkHeight, height, &debugInfo.ratio169Bottom);
-
-        if (debugInfo.is169TopBlack && debugInfo.is169BottomBlack) {
-          // 16:9 黒帯検出成功
-          is169Detected = true;
-
-          // コンテンツ領域が暗いかどうかチェック (誤検出防止)
-          if (IsContentAreaDark(pBuffer, bufferSize, width, height, stride,
-                                bitsPerPixel, &debugInfo.centerBlackRatio)) {
-            debugInfo.isCenterBlack = true;
-            // 暗い場合は解析不能のため、現在のモードを維持する
-            detectedMode = m_currentMode;
-          } else {
-            debugInfo.isCenterBlack = false;
-            // 明るい場合は 16:9 モードと判定
-            detectedMode = LB_MODE_16_9;
-          }
-        } else {
-          // 黒帯領域にコンテンツがある -> 16:9ではない (恒常的に除外)
-          m_bRejected169 = true;
-          debugInfo.bRejected169 = true;
-        }
-      }
+    debugInfo.frameRect = frameRect;
+    debugInfo.centerBlackRatio = GetBlackRatio(thumb, frameRect);
+    debugInfo.isCenterBlack = (debugInfo.centerBlackRatio > kDarkContentRatio);
+
+    if (m_bContentLatched) {
+      // 観測したコンテンツは暗い場面でも確かなので、常に和集合へ加える
+      UnionRect(&m_contentRect, &m_contentRect, &frameRect);
+    } else if (!debugInfo.isCenterBlack) {
+      // 暗い場面 (フェード中など) の範囲は実際より狭く見えるため、ラッチを開始しない
+      m_contentRect = frameRect;
+      m_bContentLatched = true;
     }
+  }
 
-    // ---------------------------------------------------------------------
-    // 2. Check 4:3 (Only if 16:9 is not detected/rejected)
-    // ---------------------------------------------------------------------
-    // 16:9が検出された場合(is169Detected=true)は、より厳しいクロップを採用するため4:3チェックは行わない。
-    // 16:9が除外された(m_bRejected169)か、現在たまたま16:9黒帯が見つからなかった場合にのみ4:3をチェックする。
-    if (!is169Detected && !m_bRejected43) {
-      LONG targetHeight43 = (LONG)(width / (4.0f / 3.0f));
-      LONG barHeight43 = (height - targetHeight43) / 2;
-      const LONG CHECK_MARGIN = 8;
-
-      if (barHeight43 > CHECK_MARGIN) {
-        LONG checkHeight = barHeight43 - CHECK_MARGIN;
-
-        debugInfo.is43TopBlack =
-            IsRegionBlack(pBuffer, bufferSize, width, height, stride,
-                          bitsPerPixel, 0, checkHeight, &debugInfo.ratio43Top);
-        debugInfo.is43BottomBlack = IsRegionBlack(
-            pBuffer, bufferSize, width, height, stride, bitsPerPixel,
-            height - checkHeight, height, &debugInfo.ratio43Bottom);
-
-        if (debugInfo.is43TopBlack && debugInfo.is43BottomBlack) {
-          // 4:3 黒帯検出成功
-          if (IsContentAreaDark(pBuffer, bufferSize, width, height, stride,
-                                bitsPerPixel, &debugInfo.centerBlackRatio)) {
-            debugInfo.isCenterBlack = true;
-            detectedMode = m_currentMode;
-          } else {
-            debugInfo.isCenterBlack = false;
-            detectedMode = LB_MODE_4_3;
-          }
-        } else {
-          // 黒帯領域にコンテンツがある -> 4:3ではない
-          m_bRejected43 = true;
-          debugInfo.bRejected43 = true;
-          // 両方NGならオリジナル
-          detectedMode = LB_MODE_ORIGINAL;
-        }
-      }
+  if (m_bContentLatched) {
+    RECT candidate = SnapToFrame(m_contentRect, width, height);
+    const LONG candW = candidate.right - candidate.left;
+    const LONG candH = candidate.bottom - candidate.top;
+
+    if (EqualRect(&candidate, &fullRect)) {
+      // 黒帯なし (以後このシーンでは結果が変わらない)
+      m_bRejected = true;
+      detectedMode = LB_MODE_ORIGINAL;
+      detectedRect = fullRect;
+    } else if (candW * 2 >= width && candH * 2 >= height) {
+      detectedMode = ClassifyRect(candidate, width, height);
+      detectedRect = candidate;
     }
+    // 極端に小さい範囲 (黒背景のロゴのみ等) は信頼せず、現在の結果を維持する
   }
 
+  debugInfo.latchedRect = m_contentRect;
+  debugInfo.bRejected = m_bRejected;
   debugInfo.detectedMode = detectedMode;
 
   // -------------------------------------------------------------------------
   // ヒステリシス制御 (チャタリング防止)
   // 検出結果が「今回のフレーム」だけで変わっても即座には適用しません。
-  // 指定回数（m_stabilityThreshold）連続して同じモードが検出された場合のみ、モード変更を確定させます。
+  // 指定回数（m_stabilityThreshold）連続して同じ結果が検出された場合のみ、変更を確定させます。
   // これにより、数フレームの一瞬のノイズやフラッシュで画角がカクつくのを防ぎます。
   // -------------------------------------------------------------------------
-  if (detectedMode == m_pendingMode) {
+  if (detectedMode == m_pendingMode && EqualRect(&detectedRect, &m_pendingRect)) {
     m_stabilityCounter++;
     if (m_stabilityCounter >= m_stabilityThreshold) {
       m_currentMode = detectedMode;
+      m_currentRect = detectedRect;
     }
   } else {
-    // 検出モードが変わったため、カウンターをリセットして監視し直し
+    // 検出結果が変わったため、カウンターをリセットして監視し直し
     m_pendingMode = detectedMode;
+    m_pendingRect = detectedRect;
     m_stabilityCounter = 0;
   }
 
   debugInfo.stabilityCounter = m_stabilityCounter;
+  debugInfo.currentRect = m_currentRect;
 
   {
       std::lock_guard<std::mutex> lock(m_mtxDebugInfo);
@@ -212,129 +288,131 @@ LetterboxMode LR2BGALetterboxDetector::AnalyzeFrame(const BYTE *pBuffer,
 }
 
 // -----------------------------------------------------------------------------
-// 指定領域の黒判定
-// CPU負荷を抑えるため、全画素ではなく間引いてサンプリングを行います。
+// コンテンツ範囲の検出
+// 行/列ごとの最大輝度 (LR2BGAImageProc::AccumulateLumaProfile) を1パスで求め、
+// 閾値以上の画素を含む最小の矩形を返します。
+//
+// 行方向はサムネイルで間引かれているため、上下端は「コンテンツを切らない」側へ
+// 丸めます (最初の明るい行の直前のサンプル行の次から、最後の明るい行の次のサンプル行まで)。
+// 列方向は全画素を参照しているため正確です。
 // -----------------------------------------------------------------------------
-bool LR2BGALetterboxDetector::IsRegionBlack(const BYTE *pBuffer,
-                                            size_t bufferSize, LONG width,
-                                            LONG height, LONG stride, int bpp,
-                                            LONG startY, LONG endY,
-                                            float *outRatio) {
-  if (outRatio)
-    *outRatio = 0.0f;
-  if (startY < 0)
-    startY = 0;
-  if (endY > height)
-    endY = height;
-  if (startY >= endY)
+bool LR2BGALetterboxDetector::FindContentRect(const LetterboxThumbnail &thumb,
+                                              RECT &outRect) {
+  const LONG width = thumb.width;
+  const LONG rows = thumb.rows;
+  const LONG step = thumb.rowStep;
+
+  try {
+    m_rowMax.resize(rows);
+    m_colMax.assign(width, 0);
+  } catch (...) {
     return false;
+  }
+
+  for (LONG r = 0; r < rows; r++) {
+    m_rowMax[r] = LR2BGAImageProc::AccumulateLumaProfile(thumb.Row(r), width,
+                                                         m_colMax.data());
+  }
 
-  // サンプリング戦略:
-  // 解像度に応じてサンプリング間隔を動的に調整
-  // 低解像度(240p等)では細かく、高解像度(720p等)では粗くサンプリングする
-  // 目安: 短辺の1/150程度 (240px -> 1.6 -> 1px / 720px -> 4.8 -> 4px)
-  // 最大値は従来の5pxに制限
-  int step = max(1, min(width, height) / 150);
-  if (step > 5)
-    step = 5;
+  const int threshold = m_blackThreshold;
+  LONG firstRow = 0;
+  while (firstRow < rows && m_rowMax[firstRow] < threshold)
+    firstRow++;
+  if (firstRow >= rows)
+    return false;
+  LONG lastRow = rows - 1;
+  while (lastRow > firstRow && m_rowMax[lastRow] < threshold)
+    lastRow--;
+
+  LONG firstCol = 0;
+  while (firstCol < width && m_colMax[firstCol] < threshold)
+    firstCol++;
+  LONG lastCol = width - 1;
+  while (lastCol > firstCol && m_colMax[lastCol] < threshold)
+    lastCol--;
+
+  outRect.left = firstCol;
+  outRect.right = lastCol + 1;
+  outRect.top = (firstRow == 0) ? 0 : (firstRow - 1) * step + 1;
+  // 最後のサンプル行より下はサムネイルに含まれないため、フレーム端まで含める
+  outRect.bottom = (lastRow == rows - 1) ? thumb.height
+                                         : min(thumb.height, (lastRow + 1) * step);
+  return true;
+}
 
-  const int LINE_STEP = step;
-  const int PIXEL_STEP = step;
+// -----------------------------------------------------------------------------
+// 指定矩形の黒画素率
+// 行方向はサムネイル生成時に間引き済みです。各サンプル行は矩形内の全画素を
+// SIMDカーネル (LR2BGAImageProc::CountBelowThreshold) で一括計数します。
+// -----------------------------------------------------------------------------
+float LR2BGALetterboxDetector::GetBlackRatio(const LetterboxThumbnail &thumb,
+                                             const RECT &rect) {
+  const LONG left = max(0L, (LONG)rect.left);
+  const LONG right = min(thumb.width, (LONG)rect.right);
+  const LONG startY = max(0L, (LONG)rect.top);
+  const LONG endY = min(thumb.height, (LONG)rect.bottom);
+  if (left >= right || startY >= endY)
+    return 0.0f;
+
+  // 元画像の行範囲 [startY, endY) に含まれるサムネイル行
+  const LONG step = thumb.rowStep;
+  LONG firstRow = (startY + step - 1) / step;
+  LONG lastRow = (endY + step - 1) / step; // 排他的
+  if (lastRow > thumb.rows)
+    lastRow = thumb.rows;
 
-  int bytesPerPixel = bpp / 8;
   int totalSampled = 0;
   int blackSampled = 0;
 
-  // 安全のためバッファ終端アドレスを計算
-  // ストライドが負の場合でも、ポインタ演算の結果がこの範囲内かチェックする必要がある
-  const BYTE *pBufferEnd = pBuffer + bufferSize;
-
-  for (int y = startY; y < endY; y += LINE_STEP) {
-    // 該当行の先頭アドレス計算
-    // ストライド (stride) はパディングを含んだ1行のバイト数
-    LONG_PTR rowOffset = (LONG_PTR)y * stride;
-
-    const BYTE *pRow = pBuffer + rowOffset;
-
-    // 簡易的な行ポインタの範囲チェック
-    if (pRow < pBuffer || pRow >= pBufferEnd) {
-      // 範囲外の場合はこの行をスキップ
-      continue;
-    }
-
-    for (int x = 0; x < width; x += PIXEL_STEP) {
-      const BYTE *pPixel = pRow + (x * bytesPerPixel);
-
-      // 厳密な境界チェック
-      // RGB(A)成分を読み取るため、+3バイト先まで安全か確認
-      if (pPixel < pBuffer || pPixel + 3 > pBufferEnd) {
-        break; // この行の処理を中断
-      }
-
-      // 画素データ取得 (リトルエンディアン BGR)
-      BYTE b = pPixel[0];
-      BYTE g = pPixel[1];
-      BYTE r = pPixel[2];
-
-      // 輝度(Y)を計算して判定
-      // Y = 0.299R + 0.587G + 0.114B
-      // 高速化のため整数演算を使用: Y = (77*R + 150*G + 29*B) >> 8 (合計256)
-      int yVal = (77 * r + 150 * g + 29 * b) >> 8;
-
-      if (yVal < m_blackThreshold) {
-        blackSampled++;
-      }
-      totalSampled++;
-    }
+  for (LONG r = firstRow; r < lastRow; r++) {
+    // 輝度(Y)はサムネイル生成時に計算済み
+    // Y = (38*R + 75*G + 15*B) >> 7 (BT.601 近似, 7bit係数)
+    blackSampled += LR2BGAImageProc::CountBelowThreshold(thumb.Row(r) + left, right - left,
+                                                         m_blackThreshold);
+    totalSampled += right - left;
   }
 
   if (totalSampled == 0)
-    return false;
-
-  float ratio = (float)blackSampled / totalSampled;
-  if (outRatio)
-    *outRatio = ratio;
-
-  // 95%以上の画素が「黒」であれば、その領域は黒帯とみなす
-  // (多少のノイズや字幕の端などが含まれていても許容するため100%にはしない)
-  // 圧縮ノイズ対策として 99% -> 95% に緩和
-  return ratio > 0.95f;
+    return 0.0f;
+  return (float)blackSampled / totalSampled;
 }
 
 // -----------------------------------------------------------------------------
-// コンテンツ領域の暗部判定
-// 16:9のアスペクト比に相当する領域（上下の黒帯を除いた部分）を検査し、
-// 一定割合以上（90%）が黒ければ「暗い場面」と判定します。
+// 最小黒帯幅の適用
+// 圧縮ノイズやエッジのにじみで生じる数pxの黒帯は切り出さず、フレーム端へ丸めます。
 // -----------------------------------------------------------------------------
-bool LR2BGALetterboxDetector::IsContentAreaDark(const BYTE *pBuffer,
-                                                size_t bufferSize, LONG width,
-                                                LONG height, LONG stride,
-                                                int bpp, float *outRatio) {
-  // 16:9 の場合のコンテンツ高さを計算
-  LONG targetHeight169 = (LONG)(width / (16.0f / 9.0f));
-  LONG barHeight = (height - targetHeight169) / 2;
-
-  // マージン (AnalyzeFrame内の定数と同じく8px程度推奨だが、ここでは独自に定義)
-  const LONG CHECK_MARGIN = 8;
-
-  LONG startY = barHeight + CHECK_MARGIN;
-  LONG endY = height - barHeight - CHECK_MARGIN;
-
-  // コンテンツ領域が極端に狭い場合は全体をチェック（安全策）
-  if (startY >= endY) {
-    startY = 0;
-    endY = height;
-  }
-
-  // 指定領域の黒画素率を取得
-  float ratio = 0.0f;
-  IsRegionBlack(pBuffer, bufferSize, width, height, stride, bpp, startY, endY,
-                &ratio);
-
-  if (outRatio)
-    *outRatio = ratio;
-
-  // 50%超が黒ければ「暗い」とみなす
-  return ratio > 0.50f;
+RECT LR2BGALetterboxDetector::SnapToFrame(const RECT &rect, LONG width,
+                                          LONG height) {
+  RECT result = rect;
+  if (result.left < kMinBarSize)
+    result.left = 0;
+  if (result.top < kMinBarSize)
+    result.top = 0;
+  if (width - result.right < kMinBarSize)
+    result.right = width;
+  if (height - result.bottom < kMinBarSize)
+    result.bottom = height;
+  return result;
 }
 
+// -----------------------------------------------------------------------------
+// 切り出し範囲の分類
+// 上下のみの黒帯で 16:9 / 4:3 に近いものはそのモード、それ以外は LB_MODE_CUSTOM です。
+// (分類は表示用で、切り出しには常に矩形そのものを使用します)
+// -----------------------------------------------------------------------------
+LetterboxMode LR2BGALetterboxDetector::ClassifyRect(const RECT &rect,
+                                                    LONG width, LONG height) {
+  const LONG rectW = rect.right - rect.left;
+  const LONG rectH = rect.bottom - rect.top;
+  if (rectW == width && rectH == height)
+    return LB_MODE_ORIGINAL;
+  if (rectW != width || rectH <= 0)
+    return LB_MODE_CUSTOM;
+
+  const float aspect = (float)rectW / rectH;
+  if (std::fabs(aspect / (16.0f / 9.0f) - 1.0f) <= kKnownAspectTolerance)
+    return LB_MODE_16_9;
+  if (std::fabs(aspect / (4.0f / 3.0f) - 1.0f) <= kKnownAspectTolerance)
+    return LB_MODE_4_3;
+  return LB_MODE_CUSTOM;
+}
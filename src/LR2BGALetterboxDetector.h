@@ -1,12 +1,15 @@
 ﻿#pragma once
 #include <windows.h>
 #include <mutex>
+#include <vector>
 
 // 検出モード (Letterbox Detection Modes)
+// 切り出し範囲は常に GetCurrentRect() の矩形で表され、モードはその分類です。
 enum LetterboxMode {
     LB_MODE_ORIGINAL = 0, // 加工なし (黒帯なし、または検出されず)
     LB_MODE_16_9,         // 16:9 のレターボックスを検出 (上下黒帯をカット)
-    LB_MODE_4_3           // 4:3 のレターボックスを検出 (上下黒帯をカット)
+    LB_MODE_4_3,          // 4:3 のレターボックスを検出 (上下黒帯をカット)
+    LB_MODE_CUSTOM        // 上記以外の矩形 (シネスコ、ピラーボックス、額縁など)
 };
 
 // デバッグ用情報構造体
@@ -14,32 +17,50 @@ struct LetterboxDebugInfo {
     int stabilityCounter = 0;
     int stabilityThreshold = 0;
     
+    // コンテンツ領域の暗部判定 (暗転・フェード中はラッチを開始しない)
     bool isCenterBlack = false;
     float centerBlackRatio = 0.0f;
-    
-    bool is169TopBlack = false;
-    float ratio169Top = 0.0f;
-    bool is169BottomBlack = false;
-    float ratio169Bottom = 0.0f;
-    
-    bool is43TopBlack = false;
-    float ratio43Top = 0.0f;
-    bool is43BottomBlack = false;
-    float ratio43Bottom = 0.0f;
+
+    // 矩形はすべてメモリ上の行座標 (ボトムアップDIBでは上下が反転)
+    bool hasContent = false;       // 今回のフレームに閾値以上の画素があった
+    RECT frameRect = {};           // 今回のフレームで観測したコンテンツ範囲
+    RECT latchedRect = {};         // シーン内で観測したコンテンツ範囲の和集合
+    RECT currentRect = {};         // 確定している切り出し範囲
     
     // 除外ステータス (Rejection Status)
-    // 一度でも黒帯領域にコンテンツが描画された場合、そのモードは恒久的に除外される
-    bool bRejected169 = false;
-    bool bRejected43 = false;
+    // コンテンツが描画された領域は、そのシーンの間は恒久的に切り出し対象から除外される。
+    // 和集合がフレーム全体に達すると黒帯なしで確定する。
+    bool bRejected = false;
     
     LetterboxMode detectedMode = LB_MODE_ORIGINAL;
 };
 
+// シーンシグネチャ (Scene Signature)
+// 8x8 格子上の輝度サンプルです。シーンカット検出に使用します。
+constexpr int kSceneSignatureSize = 64;
+
+// -----------------------------------------------------------------------------
+// 解析用輝度サムネイル (Luma Thumbnail)
+//
+// 変換スレッドが入力フレームから生成し、検出スレッドへ受け渡す解析専用データです。
+// フルフレームのコピーの代わりに、検出器がサンプリングする行 (rowStep 行ごと) だけを
+// 全幅の8bit輝度として保持します。(例: 1920x1080 RGB32 の 8MB -> 約0.4MB)
+// -----------------------------------------------------------------------------
+struct LetterboxThumbnail {
+    std::vector<BYTE> luma; // rows x width の8bit輝度 (行 r は元画像の r * rowStep 行目)
+    LONG width = 0;         // 元画像の幅 (= サムネイルの幅)
+    LONG height = 0;        // 元画像の高さ
+    LONG rows = 0;          // 保持している行数
+    LONG rowStep = 1;       // 元画像での行間隔
+
+    const BYTE* Row(LONG r) const { return luma.data() + (size_t)r * width; }
+};
+
 // -----------------------------------------------------------------------------
 // LR2BGALetterboxDetector
 // 
-// 映像フレーム内の「黒帯（レターボックス）」を自動検出するためのクラスです。
-// フレームバッファを解析し、上下に黒い領域が存在するかどうかを判定します。
+// 映像フレーム内の「黒帯（レターボックス/ピラーボックス）」を自動検出するためのクラスです。
+// 行/列ごとの最大輝度プロファイルから、コンテンツを含む最小の矩形を求めます。
 // ちらつき防止のためのヒステリシス制御（安定化機能）も備えています。
 // -----------------------------------------------------------------------------
 class LR2BGALetterboxDetector
@@ -48,19 +69,53 @@ public:
     LR2BGALetterboxDetector();
     ~LR2BGALetterboxDetector();
 
-    // メイン解析関数 (スレッドセーフ設計)
-    // ワーカースレッドから呼び出され、推奨されるレターボックスモードを返します。
+    // 輝度サムネイル生成 (変換スレッドから呼び出し)
+    // 検出器がサンプリングする行のみを8bit輝度へ変換して thumb へ書き込みます。
+    // 検出器の状態には触れないため、AnalyzeFrame と並行して呼び出せます。
     // 引数:
     //   pBuffer: 画像データへのポインタ
     //   bufferSize: バッファサイズ
     //   width, height: 画像解像度
     //   stride: 1行あたりのバイト数
     //   bitsPerPixel: ビット深度 (24 or 32)
-    LetterboxMode AnalyzeFrame(const BYTE* pBuffer, size_t bufferSize, LONG width, LONG height, LONG stride, int bitsPerPixel);
+    // 戻り値: 生成に成功した場合 true
+    static bool BuildThumbnail(const BYTE* pBuffer, size_t bufferSize, LONG width, LONG height,
+                               LONG stride, int bitsPerPixel, LetterboxThumbnail& thumb);
+
+    // メイン解析関数 (スレッドセーフ設計)
+    // ワーカースレッドから呼び出され、推奨されるレターボックスモードを返します。
+    LetterboxMode AnalyzeFrame(const LetterboxThumbnail& thumb);
 
     // 現在確定している（安定した）モードを取得します
     LetterboxMode GetCurrentMode() const { return m_currentMode; }
 
+    // 現在確定している切り出し範囲を取得します (LB_MODE_ORIGINAL の場合はフレーム全体)
+    RECT GetCurrentRect() const { return m_currentRect; }
+
+    // 判定が安定しているか (確定結果が閾値回数以上連続して再確認された)
+    bool IsStable() const {
+        return m_pendingMode == m_currentMode && EqualRect(&m_pendingRect, &m_currentRect) &&
+               m_stabilityCounter >= m_stabilityThreshold;
+    }
+
+    // 黒帯なしで確定済みか (和集合がフレーム全体に達し、シーン内では結果が変わらない)
+    bool IsFullyRejected() const { return m_bRejected; }
+
+    // 前回の確定結果を初期状態として設定します (動画キャッシュ適用時)
+    // 確定済み・安定済みとして扱い、観測範囲のラッチも引き継ぎます (以後の観測で拡大のみ)。
+    void Seed(LetterboxMode mode, const RECT& rect, LONG width, LONG height);
+
+    // 新しいシーンの開始を通知します (シーンカット検出時)
+    // コンテンツ範囲のラッチはシーン単位の観測結果としてクリアしますが、
+    // 確定結果は維持します (シーンカットのたびに画角が戻らないようにするため)。
+    void BeginNewScene();
+
+    // シーンシグネチャを計算します (変換スレッドから呼び出し、状態に触れない)
+    static void ComputeSceneSignature(const BYTE* pBuffer, size_t bufferSize, LONG width, LONG height,
+                                      LONG stride, int bitsPerPixel, BYTE* pSignature);
+    // シグネチャ間の平均輝度差 (0-255) を返します
+    static int CompareSceneSignature(const BYTE* pSigA, const BYTE* pSigB);
+
     // デバッグ情報を取得（スレッドセーフ）
     LetterboxDebugInfo GetDebugInfo();
 
@@ -73,32 +128,47 @@ public:
     void SetParams(int threshold, int stabilityFrames);
 
 private:
-    // ヘルパー: 指定されたY範囲（行範囲）がすべて「黒」かどうかを判定します
-    // outRatio: 黒画素の割合 (0.0 - 1.0) を書き戻すポインタ (nullptr可)
-    bool IsRegionBlack(const BYTE* pBuffer, size_t bufferSize, LONG width, LONG height, LONG stride, int bpp, LONG startY, LONG endY, float* outRatio = nullptr);
-    
-    // ヘルパー: コンテンツ領域（16:9相当）が「暗い」かどうかを判定します
-    // 暗転時やフェードアウト時に誤ってレターボックスと判定するのを防ぐために使用します
-    // outRatio: 黒画素の割合 (0.0 - 1.0) を書き戻すポインタ (nullptr可)
-    bool IsContentAreaDark(const BYTE* pBuffer, size_t bufferSize, LONG width, LONG height, LONG stride, int bpp, float* outRatio = nullptr);
+    // ヘルパー: 解像度に応じた行方向のサンプリング間隔を返します
+    static LONG GetSampleStep(LONG width, LONG height);
+
+    // ヘルパー: 行/列プロファイルから、今回のフレームのコンテンツ範囲を求めます
+    // 閾値以上の画素が1つもない場合は false を返します
+    bool FindContentRect(const LetterboxThumbnail& thumb, RECT& outRect);
+
+    // ヘルパー: 指定矩形内の黒画素の割合 (0.0 - 1.0) を返します
+    float GetBlackRatio(const LetterboxThumbnail& thumb, const RECT& rect);
 
-    // 現在確定しているモード
+    // ヘルパー: 最小黒帯幅未満の黒帯をフレーム端へ丸めます
+    static RECT SnapToFrame(const RECT& rect, LONG width, LONG height);
+
+    // ヘルパー: 切り出し範囲をモードに分類します
+    static LetterboxMode ClassifyRect(const RECT& rect, LONG width, LONG height);
+
+    // 現在確定しているモードと切り出し範囲
     LetterboxMode m_currentMode;
+    RECT m_currentRect;
     
-    // 除外フラグ (Rejection Flags)
-    bool m_bRejected169;
-    bool m_bRejected43;
+    // 除外ラッチ (Rejection Latch)
+    // m_contentRect: シーン内で観測したコンテンツ範囲の和集合 (縮小しない)
+    RECT m_contentRect;
+    bool m_bContentLatched;
+    bool m_bRejected; // 和集合がフレーム全体に達した
 
     // ヒステリシス制御用変数
-    // m_pendingMode: 現在検出されているが、まだ確定していない（安定待ちの）モード
+    // m_pendingMode/Rect: 現在検出されているが、まだ確定していない（安定待ちの）結果
     LetterboxMode m_pendingMode;
-    // m_stabilityCounter: 同じモードが連続して検出された回数
+    RECT m_pendingRect;
+    // m_stabilityCounter: 同じ結果が連続して検出された回数
     int m_stabilityCounter;
     
     // 設定パラメータ
     int m_stabilityThreshold; // 確定に必要なフレーム数
     int m_blackThreshold;     // 黒判定の閾値
 
+    // プロファイル作業領域 (検出スレッドのみが使用)
+    std::vector<BYTE> m_rowMax; // サムネイル行ごとの最大輝度
+    std::vector<BYTE> m_colMax; // 列ごとの最大輝度
+
     // デバッグ情報
     LetterboxDebugInfo m_lastDebugInfo;
     std::mutex m_mtxDebugInfo; // デバッグ情報アクセス保護用
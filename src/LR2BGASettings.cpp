@@ -1,5 +1,6 @@
 ﻿#include "LR2BGASettings.h"
 #include <stdio.h>
+#include <new>
 
 // レジストリ保存先キー
 const wchar_t* LR2BGASettings::REGISTRY_KEY = L"Software\\LR2BGAFilter";
@@ -14,6 +15,8 @@ LR2BGASettings::LR2BGASettings()
     , m_dummyMode(false)
     , m_maxFPS(60)
     , m_limitFPSEnabled(false)
+    , m_outputBufferCount(1)   // 1: 従来どおりLR2の受け取りと同期して動作する
+    , m_outputPipelined(false)
     , m_debugMode(false)
     , m_extWindowEnabled(true)
     , m_extWindowX(0)
@@ -25,13 +28,23 @@ LR2BGASettings::LR2BGASettings()
     , m_extWindowPassthrough(false)
 
     , m_extWindowTopmost(true) // デフォルトで最前面
-    , m_brightnessLR2(100)
-    , m_brightnessExt(100)
-    , m_autoOpenSettings(false)
+    , m_extWindowMaxFPS(0)     // デフォルトは入力フレームごとに更新
+    , m_extWindowAdaptiveQuality(true)
+    , m_extWindowPauseWhenOccluded(false) // OBS等で覆われたウィンドウをキャプチャする場合があるため既定は無効
+
+    // デバッグウィンドウ初期値 (CW_USEDEFAULT)
+    , m_debugWindowX(CW_USEDEFAULT)
+    , m_debugWindowY(CW_USEDEFAULT)
+    , m_debugWindowWidth(450)
+    , m_debugWindowHeight(1000)
+
     // 黒帯自動除去 (デフォルト有効)
     , m_autoRemoveLetterbox(true)
     , m_lbThreshold(22)
     , m_lbStability(3)
+    , m_brightnessLR2(100)
+    , m_brightnessExt(100)
+    , m_autoOpenSettings(false)
     
     // 手動クローズトリガー設定
     , m_closeOnRightClick(true)
@@ -45,19 +58,112 @@ LR2BGASettings::LR2BGASettings()
     // 接続制限 (デフォルト有効)
     , m_onlyOutputToLR2(true)
     , m_onlyOutputToRenderer(true)
-    
-    // デバッグウィンドウ初期値 (CW_USEDEFAULT)
-    , m_debugWindowX(CW_USEDEFAULT)
-    , m_debugWindowY(CW_USEDEFAULT)
-    , m_debugWindowWidth(450)
-    , m_debugWindowHeight(1000)
+    , m_version(1)
+    , m_snapshot(nullptr)
+    , m_epoch(1)
 {
     // InitializeCriticalSection(&m_cs); // No longer needed
+    for (int i = 0; i < SNAPSHOT_READER_COUNT; i++) {
+        m_readerEpochs[i] = 0;
+    }
+    // 読み取り側が NULL を扱わずに済むよう、最初のスナップショットは必ず作る
+    // (確保できない場合は new LR2BGASettings と同じく bad_alloc を生成元へ伝える)
+    PublishSnapshot();
+    if (!m_snapshot.load()) {
+        throw std::bad_alloc();
+    }
 }
 
 LR2BGASettings::~LR2BGASettings()
 {
     // DeleteCriticalSection(&m_cs); // No longer needed
+    // 破棄時点では読み取り側 (ストリーミング・描画スレッド) は停止済み
+    for (size_t i = 0; i < m_retiredSnapshots.size(); i++) {
+        delete m_retiredSnapshots[i].pSnapshot;
+    }
+    m_retiredSnapshots.clear();
+    delete m_snapshot.load();
+}
+
+// ------------------------------------------------------------------------------
+// 設定スナップショット
+// ------------------------------------------------------------------------------
+const LR2BGASettings::Snapshot* LR2BGASettings::AcquireSnapshot(SnapshotReader reader)
+{
+    // エポックを枠に書いてからポインタを読む (どちらも seq_cst。PublishSnapshot の順序と対になる)
+    m_readerEpochs[reader].store(m_epoch.load());
+    return m_snapshot.load();
+}
+
+void LR2BGASettings::ReleaseSnapshot(SnapshotReader reader)
+{
+    m_readerEpochs[reader].store(0, std::memory_order_release);
+}
+
+void LR2BGASettings::BuildSnapshot(Snapshot& out)
+{
+    Lock();
+    out.version = m_version.load(std::memory_order_relaxed);
+    out.outputWidth = m_outputWidth;
+    out.outputHeight = m_outputHeight;
+    out.passthroughMode = m_passthroughMode;
+    out.dummyMode = m_dummyMode;
+    out.outputBufferCount = m_outputBufferCount;
+    out.outputPipelined = m_outputPipelined;
+    out.autoOpenSettings = m_autoOpenSettings;
+    out.resizeAlgo = m_resizeAlgo;
+    out.keepAspectRatio = m_keepAspectRatio;
+    out.limitFPSEnabled = m_limitFPSEnabled;
+    out.maxFPS = m_maxFPS;
+    out.brightnessLR2 = m_brightnessLR2;
+    out.debugMode = m_debugMode;
+    out.autoRemoveLetterbox = m_autoRemoveLetterbox;
+    out.lbThreshold = m_lbThreshold;
+    out.lbStability = m_lbStability;
+    FillExtWindowConfig(out.ext);
+    Unlock();
+}
+
+void LR2BGASettings::PublishSnapshot()
+{
+    Snapshot* pNew = NULL;
+    try {
+        pNew = new Snapshot();
+    } catch (const std::bad_alloc&) {
+        // 確保できない場合は前回のスナップショットを使い続ける (変更の反映が遅れるだけ)
+        return;
+    }
+    BuildSnapshot(*pNew);
+
+    // 差し替えてからエポックを進める。差し替え前に読んだ読み取り側の枠は retireEpoch 以下になる
+    const Snapshot* pOld = m_snapshot.exchange(pNew);
+    const unsigned long long retireEpoch = m_epoch.fetch_add(1);
+    if (pOld) {
+        try {
+            m_retiredSnapshots.push_back({pOld, retireEpoch});
+        } catch (const std::bad_alloc&) {
+            // 回収待ちに積めない場合は解放を諦める (数十バイトのリーク。参照中の可能性があるため解放しない)
+        }
+    }
+    ReclaimSnapshots();
+}
+
+void LR2BGASettings::ReclaimSnapshots()
+{
+    unsigned long long oldestActive = ~0ULL;
+    for (int i = 0; i < SNAPSHOT_READER_COUNT; i++) {
+        const unsigned long long e = m_readerEpochs[i].load();
+        if (e != 0 && e < oldestActive) oldestActive = e;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < m_retiredSnapshots.size(); i++) {
+        if (m_retiredSnapshots[i].epoch < oldestActive) {
+            delete m_retiredSnapshots[i].pSnapshot;
+        } else {
+            m_retiredSnapshots[kept++] = m_retiredSnapshots[i];
+        }
+    }
+    m_retiredSnapshots.resize(kept);
 }
 
 // 設定をレジストリから読み込む
@@ -77,6 +183,11 @@ void LR2BGASettings::Load()
         if (RegQueryValueExW(hKey, L"LimitFPSEnabled", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_limitFPSEnabled = (data != 0);
         if (RegQueryValueExW(hKey, L"DummyMode", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_dummyMode = (data != 0);
         if (RegQueryValueExW(hKey, L"PassthroughMode", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_passthroughMode = (data != 0);
+        if (RegQueryValueExW(hKey, L"OutputBufferCount", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) {
+            // 範囲外の値はアロケータへ渡さない
+            if (data >= 1 && data <= 4) m_outputBufferCount = (int)data;
+        }
+        if (RegQueryValueExW(hKey, L"OutputPipelined", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_outputPipelined = (data != 0);
         
         // 外部ウィンドウ設定
         if (RegQueryValueExW(hKey, L"ExtWindowEnabled", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_extWindowEnabled = (data != 0);
@@ -88,6 +199,9 @@ void LR2BGASettings::Load()
         if (RegQueryValueExW(hKey, L"ExtWindowKeepAspect", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_extWindowKeepAspect = (data != 0);
         if (RegQueryValueExW(hKey, L"ExtWindowPassthrough", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_extWindowPassthrough = (data != 0);
         if (RegQueryValueExW(hKey, L"ExtWindowTopmost", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_extWindowTopmost = (data != 0);
+        if (RegQueryValueExW(hKey, L"ExtWindowMaxFPS", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_extWindowMaxFPS = (int)data;
+        if (RegQueryValueExW(hKey, L"ExtWindowAdaptiveQuality", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_extWindowAdaptiveQuality = (data != 0);
+        if (RegQueryValueExW(hKey, L"ExtWindowPauseWhenOccluded", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_extWindowPauseWhenOccluded = (data != 0);
         
         // 明るさ設定
         if (RegQueryValueExW(hKey, L"BrightnessLR2", NULL, NULL, (LPBYTE)&data, &size) == ERROR_SUCCESS) m_brightnessLR2 = data;
@@ -131,6 +245,9 @@ void LR2BGASettings::Load()
 
         RegCloseKey(hKey);
     }
+    // 値の変更を参照側へ知らせる (レジストリ操作の成否に関わらず進める)
+    m_version.fetch_add(1, std::memory_order_acq_rel);
+    PublishSnapshot();
     Unlock();
 }
 
@@ -151,6 +268,8 @@ void LR2BGASettings::Save()
         data = m_limitFPSEnabled ? 1 : 0; RegSetValueExW(hKey, L"LimitFPSEnabled", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
         data = m_dummyMode ? 1 : 0; RegSetValueExW(hKey, L"DummyMode", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
         data = m_passthroughMode ? 1 : 0; RegSetValueExW(hKey, L"PassthroughMode", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
+        data = (DWORD)m_outputBufferCount; RegSetValueExW(hKey, L"OutputBufferCount", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
+        data = m_outputPipelined ? 1 : 0; RegSetValueExW(hKey, L"OutputPipelined", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
 
         // 外部ウィンドウ設定
         data = m_extWindowEnabled ? 1 : 0; RegSetValueExW(hKey, L"ExtWindowEnabled", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
@@ -162,6 +281,9 @@ void LR2BGASettings::Save()
         data = m_extWindowKeepAspect ? 1 : 0; RegSetValueExW(hKey, L"ExtWindowKeepAspect", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
         data = m_extWindowPassthrough ? 1 : 0; RegSetValueExW(hKey, L"ExtWindowPassthrough", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
         data = m_extWindowTopmost ? 1 : 0; RegSetValueExW(hKey, L"ExtWindowTopmost", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
+        data = (DWORD)m_extWindowMaxFPS; RegSetValueExW(hKey, L"ExtWindowMaxFPS", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
+        data = m_extWindowAdaptiveQuality ? 1 : 0; RegSetValueExW(hKey, L"ExtWindowAdaptiveQuality", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
+        data = m_extWindowPauseWhenOccluded ? 1 : 0; RegSetValueExW(hKey, L"ExtWindowPauseWhenOccluded", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
         
         // 明るさ設定
         data = m_brightnessLR2; RegSetValueExW(hKey, L"BrightnessLR2", 0, REG_DWORD, (LPBYTE)&data, sizeof(DWORD));
@@ -196,6 +318,9 @@ void LR2BGASettings::Save()
 
         RegCloseKey(hKey);
     }
+    // 値の変更を参照側へ知らせる (レジストリ操作の成否に関わらず進める)
+    m_version.fetch_add(1, std::memory_order_acq_rel);
+    PublishSnapshot();
     Unlock();
 }
 
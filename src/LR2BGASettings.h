@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <windows.h>
 #include <mutex>
+#include <atomic>
+#include <vector>
 #include "LR2BGATypes.h"
 
 // デフォルト値定数
@@ -26,6 +28,8 @@ public:
     bool m_dummyMode;               // ダミー出力モード (1x1ピクセル等の軽量出力をLR2へ渡す)
     int m_maxFPS;                   // FPS制限値 (ターゲットFPS)
     bool m_limitFPSEnabled;         // FPS制限を有効にするかどうか (チェックボックスの状態)
+    int m_outputBufferCount;        // LR2向け出力バッファ数 (1-4。次回接続時の DecideBufferSize で反映)
+    bool m_outputPipelined;         // LR2への受け渡しを専用スレッドで行う (ストリーミング開始時にラッチ)
 
     // デバッグ設定 (Debug Settings)
     bool m_debugMode;               // デバッグモード有効化 (ログ出力など)
@@ -40,6 +44,9 @@ public:
     bool m_extWindowKeepAspect;     // アスペクト比維持 (外部ウィンドウ)
     bool m_extWindowPassthrough;    // ソース同期モード (リサイズせず入力解像度で表示)
     bool m_extWindowTopmost;        // 最前面表示 (Topmost)
+    int m_extWindowMaxFPS;          // 外部ウィンドウの更新上限FPS (0: 制限なし。LR2向けのFPS制限とは独立)
+    bool m_extWindowAdaptiveQuality;// 描画コストが予算を超えたら外部ウィンドウの画質を自動で下げる
+    bool m_extWindowPauseWhenOccluded;// 他のウィンドウに完全に覆われている間は外部ウィンドウの更新を止める
     
     // デバッグウィンドウ位置設定
     int m_debugWindowX;
@@ -58,6 +65,9 @@ public:
         bool keepAspect;
         bool passthrough;
         bool topmost;
+        int maxFPS;
+        bool adaptiveQuality;
+        bool pauseWhenOccluded;
         int brightness;
         bool autoRemoveLetterbox; // 追加: 自動黒帯除去設定
         
@@ -73,6 +83,78 @@ public:
 
     void GetExtWindowConfig(ExtWindowConfig& cfg) {
         Lock();
+        FillExtWindowConfig(cfg);
+        Unlock();
+    }
+
+    //--------------------------------------------------------------------------
+    // 設定スナップショット (ストリーミングのホットパス用)
+    //--------------------------------------------------------------------------
+    // Load/Save のたびにロック下で作り直し、アトミックなポインタで公開する不変のコピーです。
+    // 毎フレーム設定を参照するスレッドは、フレームの先頭でポインタを1回読むだけで、
+    // フレーム内で一貫した値を得られます (ロックも、変更途中の値を読む競合もありません)。
+    // アルゴリズム・明るさ・FPS制限などの変更は次のフレームから反映されます。
+    // 出力サイズ・パススルー・ダミーなどは、ストリーミング開始時に同じスナップショットからラッチします。
+    struct Snapshot {
+        unsigned version;           // 作成時の世代番号 (GetVersion と同じ値)
+        // ストリーミング開始時・接続時にラッチする項目
+        int outputWidth;
+        int outputHeight;
+        bool passthroughMode;
+        bool dummyMode;
+        int outputBufferCount;
+        bool outputPipelined;
+        bool autoOpenSettings;
+        // フレームごとに参照する項目
+        ResizeAlgorithm resizeAlgo;
+        bool keepAspectRatio;
+        bool limitFPSEnabled;
+        int maxFPS;
+        int brightnessLR2;
+        bool debugMode;
+        bool autoRemoveLetterbox;
+        int lbThreshold;
+        int lbStability;
+        ExtWindowConfig ext;
+    };
+
+    // 読み取り側の枠 (スレッドの役割ごとに1つ。同じ枠を入れ子や複数スレッドで使わないこと)
+    enum SnapshotReader {
+        SNAPSHOT_READER_STREAMING = 0,  // フィルタのストリーミングスレッド (Receive 1回分)
+        SNAPSHOT_READER_EXT_STREAM,     // 外部ウィンドウへの投函 (ストリーミングスレッド内)
+        SNAPSHOT_READER_EXT_RENDER,     // 外部ウィンドウの描画スレッド
+        SNAPSHOT_READER_CONTROL,        // ストリーミングの開始/停止と接続時のネゴシエーション (フィルタのロック下)
+        SNAPSHOT_READER_COUNT
+    };
+
+    // 現在の設定値からスナップショットの内容を作る (公開はしない)
+    // PublishSnapshot と、設定を直接書き換えて使うオフライン再生ツール (LR2BGAReplay) が使う
+    void BuildSnapshot(Snapshot& out);
+
+    // スナップショットの取得/解放 (ロックフリー。戻り値は NULL にならない)
+    // 取得から解放までの間、返したスナップショットは解放されません (エポックによる回収)
+    const Snapshot* AcquireSnapshot(SnapshotReader reader);
+    void ReleaseSnapshot(SnapshotReader reader);
+
+    // スコープ内でスナップショットを保持するヘルパー
+    class SnapshotGuard {
+    public:
+        SnapshotGuard(LR2BGASettings* pSettings, SnapshotReader reader)
+            : m_pSettings(pSettings), m_reader(reader), m_pSnapshot(pSettings->AcquireSnapshot(reader)) {}
+        ~SnapshotGuard() { m_pSettings->ReleaseSnapshot(m_reader); }
+        const Snapshot& operator*() const { return *m_pSnapshot; }
+        const Snapshot* operator->() const { return m_pSnapshot; }
+        const Snapshot* get() const { return m_pSnapshot; }
+    private:
+        SnapshotGuard(const SnapshotGuard&) = delete;
+        SnapshotGuard& operator=(const SnapshotGuard&) = delete;
+        LR2BGASettings* m_pSettings;
+        SnapshotReader m_reader;
+        const Snapshot* m_pSnapshot;
+    };
+
+private:
+    void FillExtWindowConfig(ExtWindowConfig& cfg) const {
         cfg.enabled = m_extWindowEnabled;
         cfg.x = m_extWindowX;
         cfg.y = m_extWindowY;
@@ -82,6 +164,9 @@ public:
         cfg.keepAspect = m_extWindowKeepAspect;
         cfg.passthrough = m_extWindowPassthrough;
         cfg.topmost = m_extWindowTopmost;
+        cfg.maxFPS = m_extWindowMaxFPS;
+        cfg.adaptiveQuality = m_extWindowAdaptiveQuality;
+        cfg.pauseWhenOccluded = m_extWindowPauseWhenOccluded;
         cfg.brightness = m_brightnessExt;
         cfg.autoRemoveLetterbox = m_autoRemoveLetterbox;
         
@@ -92,9 +177,9 @@ public:
         cfg.gamepadBtn = m_gamepadButtonID;
         cfg.keyboardClose = m_keyboardCloseEnabled;
         cfg.keyboardKey = m_keyboardKeyCode;
-        Unlock();
     }
-    
+
+public:
     // 黒帯自動除去設定 (Auto Remove Letterbox)
     bool m_autoRemoveLetterbox; // 機能有効化
     int m_lbThreshold;          // 黒色判定の輝度閾値 (0-255)
@@ -127,9 +212,34 @@ public:
     void Lock() { m_mtx.lock(); }
     void Unlock() { m_mtx.unlock(); }
 
+    // 設定の世代番号 (Load/Save のたびに進む)
+    // 毎フレーム設定を参照するスレッドは、世代が変わったときだけロックを取って
+    // スナップショットを取り直すことで、フレームごとのロックを避けられます
+    // 設定の変更は必ず Save() を伴うため、世代の比較だけで変更を検出できます
+    unsigned GetVersion() const { return m_version.load(std::memory_order_acquire); }
+
 private:
+    // 現在の値からスナップショットを作って公開し、古いものを回収待ちにする (ロック下で呼ぶ)
+    void PublishSnapshot();
+    // どの読み取り側からも参照されなくなったスナップショットを解放する (ロック下で呼ぶ)
+    void ReclaimSnapshots();
+
     std::recursive_mutex m_mtx;
+    std::atomic<unsigned> m_version;
     static const wchar_t* REGISTRY_KEY;
+
+    // スナップショットの公開とエポックによる回収
+    // 読み取り側は現在のエポックを自分の枠に書いてからポインタを読む。
+    // 差し替えたスナップショットには差し替え時のエポックを記録し、それ以下のエポックで
+    // 読み取り中の枠がなくなった時点で解放する (差し替え後に枠へ書かれたエポックは必ずより大きい)。
+    std::atomic<const Snapshot*> m_snapshot;
+    std::atomic<unsigned long long> m_epoch;
+    std::atomic<unsigned long long> m_readerEpochs[SNAPSHOT_READER_COUNT]; // 0: 読み取り中でない
+    struct RetiredSnapshot {
+        const Snapshot* pSnapshot;
+        unsigned long long epoch;   // 差し替え時のエポック
+    };
+    std::vector<RetiredSnapshot> m_retiredSnapshots; // m_mtx で保護
 };
 
 
@@ -0,0 +1,95 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGASharedStats.cpp
+// LR2 BGA Filter - 外部ツール向けに統計を公開する共有メモリ 実装
+//------------------------------------------------------------------------------
+
+#include "LR2BGASharedStats.h"
+
+namespace {
+
+// 書き込みを所有していたプロセスがまだ動いているか
+bool IsProcessAlive(DWORD processId) {
+    HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, processId);
+    if (!hProcess) {
+        // 権限不足で開けない場合は生存しているとみなす (所有権を奪わない)
+        return GetLastError() == ERROR_ACCESS_DENIED;
+    }
+    const bool alive = (WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT);
+    CloseHandle(hProcess);
+    return alive;
+}
+
+} // namespace
+
+LR2BGASharedStats::LR2BGASharedStats()
+    : m_hMapping(NULL),
+      m_pBlock(NULL)
+{
+}
+
+LR2BGASharedStats::~LR2BGASharedStats() {
+    Close();
+}
+
+HRESULT LR2BGASharedStats::Open() {
+    if (m_pBlock) return S_OK;
+
+    HANDLE hMapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                         sizeof(LR2BGASharedStatsBlock), LR2BGA_SHARED_STATS_NAME);
+    if (!hMapping) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    LR2BGASharedStatsBlock *pBlock = static_cast<LR2BGASharedStatsBlock *>(
+        MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, sizeof(LR2BGASharedStatsBlock)));
+    if (!pBlock) {
+        const HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        CloseHandle(hMapping);
+        return hr;
+    }
+
+    // 所有権の取得 (新規作成したセクションはゼロ初期化されている)
+    // 同じプロセスの別インスタンスが所有している場合も取らない
+    const LONG self = (LONG)GetCurrentProcessId();
+    LONG owner = InterlockedCompareExchange(&pBlock->writerProcessId, self, 0);
+    if (owner != 0 && owner != self && !IsProcessAlive((DWORD)owner) &&
+        InterlockedCompareExchange(&pBlock->writerProcessId, self, owner) == owner) {
+        owner = 0;  // 終了したプロセスから引き継いだ
+    }
+    if (owner != 0) {
+        UnmapViewOfFile(pBlock);
+        CloseHandle(hMapping);
+        return S_FALSE;
+    }
+
+    // 前の所有者が書き込み途中で終了していた場合に備え、sequence を偶数に揃えてからヘッダを書く
+    if (pBlock->sequence & 1) {
+        InterlockedIncrement(&pBlock->sequence);
+    }
+    pBlock->magic = kLR2BGASharedStatsMagic;
+    pBlock->version = kLR2BGASharedStatsVersion;
+    pBlock->size = sizeof(LR2BGASharedStatsBlock);
+
+    m_hMapping = hMapping;
+    m_pBlock = pBlock;
+    return S_OK;
+}
+
+void LR2BGASharedStats::Close() {
+    if (!m_pBlock) return;
+
+    InterlockedCompareExchange(&m_pBlock->writerProcessId, 0, (LONG)GetCurrentProcessId());
+    UnmapViewOfFile(m_pBlock);
+    CloseHandle(m_hMapping);
+    m_pBlock = NULL;
+    m_hMapping = NULL;
+}
+
+void LR2BGASharedStats::Publish(const LR2BGASharedStatsData &data) {
+    if (!m_pBlock) return;
+
+    // Interlocked はフルバリアのため、data の書き込みが sequence の更新を越えて並び替わらない
+    const LONG sequence = m_pBlock->sequence;
+    InterlockedExchange(&m_pBlock->sequence, sequence + 1);
+    CopyMemory((void *)&m_pBlock->data, &data, sizeof(data));
+    InterlockedExchange(&m_pBlock->sequence, sequence + 2);
+}
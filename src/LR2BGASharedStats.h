@@ -0,0 +1,133 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGASharedStats.h
+// LR2 BGA Filter - 外部ツール向けに統計を公開する共有メモリ
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   配信用オーバーレイなどの外部ツールが、COM やデバッグウィンドウ (GDI) を使わずに
+//   フィルタの状態 (フレームレート、ドロップ数、処理時間、黒帯判定) を取得できるよう、
+//   名前付きの共有メモリ (kLR2BGASharedStatsName) に固定レイアウトの構造体を公開します。
+//
+// 整合性 (シーケンスロック):
+//   書き込み側は sequence を奇数にしてから data を書き、書き終えたら偶数に戻します。
+//   読み取り側は前後で sequence を読み、奇数または前後で値が違えば読み直します
+//   (LR2BGAReadSharedStats)。読み取り側は書き込み側を一切待たせません。
+//
+// 互換性:
+//   magic / version / size で判定します。フィールドは末尾にのみ追加し (size が増える)、
+//   既存フィールドの意味や位置を変える場合は version を上げます。
+//   32bit と 64bit のプロセス間で同じレイアウトになるよう、固定長の型だけを使います。
+//
+// 書き込み側:
+//   1つのセクションに書き込むのは1つのフィルタインスタンスだけです (writerProcessId で所有し、
+//   同じプロセスの別インスタンスは所有しない)。所有者のプロセスが終了していれば引き継ぎます。
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <windows.h>
+#include <stddef.h>
+
+// 共有メモリの名前 (同じセッション内のプロセスから OpenFileMappingW で開く)
+#define LR2BGA_SHARED_STATS_NAME L"Local\\LR2BGAFilter_Stats"
+
+constexpr DWORD kLR2BGASharedStatsMagic = 0x5342524C;   // 'LRBS'
+constexpr DWORD kLR2BGASharedStatsVersion = 1;
+
+#pragma pack(push, 8)
+
+//------------------------------------------------------------------------------
+// 公開する統計 (書き込み中でなければ、すべて同じ時点の値)
+//------------------------------------------------------------------------------
+struct LR2BGASharedStatsData {
+    LONGLONG updateQpc;         // 公開した時刻 (QPC。同じPCのプロセス間で比較できる)
+    LONGLONG qpcFrequency;      // QPC周波数
+
+    LONG streaming;             // 1: ストリーミング中, 0: 停止
+    LONG letterboxMode;         // LetterboxMode (黒帯除去が無効なら LB_MODE_ORIGINAL)
+    LONG cropActive;            // 1: 黒帯を除いた範囲を切り出して出力している
+    LONG inputBitCount;
+    RECT cropRect;              // 切り出し範囲 (メモリ上の行座標。cropActive=0 では入力全体)
+    LONG inputWidth;
+    LONG inputHeight;
+    LONG outputWidth;
+    LONG outputHeight;
+
+    double inputFrameRate;      // 入力の公称フレームレート
+    double outputFrameRate;     // 直近1秒の実測出力フレームレート
+    LONGLONG inputFrames;       // 受信フレーム数
+    LONGLONG outputFrames;      // LR2向けに出力したフレーム数
+    LONGLONG droppedFrames;     // FPS制限でドロップしたフレーム数
+
+    double avgProcessMs;        // 平均処理時間 (FPS制限の待機と受け渡しを除く)
+    double processP95Ms;        // 処理時間 (STAGE_TOTAL) の p95
+    double processP99Ms;
+    double processMaxMs;
+    double deliverP95Ms;        // 下流への受け渡し (STAGE_DELIVER) の p95
+};
+
+struct LR2BGASharedStatsBlock {
+    DWORD magic;                // kLR2BGASharedStatsMagic
+    DWORD version;              // kLR2BGASharedStatsVersion
+    DWORD size;                 // sizeof(LR2BGASharedStatsBlock)
+    volatile LONG writerProcessId; // 書き込み中のフィルタのプロセスID (0: なし)
+    volatile LONG sequence;     // シーケンスロック (奇数: 書き込み中。公開ごとに2増える)
+    DWORD reserved;
+    LR2BGASharedStatsData data;
+};
+
+#pragma pack(pop)
+
+static_assert(offsetof(LR2BGASharedStatsBlock, data) == 24, "shared stats layout changed");
+static_assert(sizeof(LR2BGASharedStatsData) == 144, "shared stats layout changed");
+
+//------------------------------------------------------------------------------
+// LR2BGAReadSharedStats - シーケンスロックで整合した data を読み取る (読み取り側用)
+// 読み取り専用でマップしたブロックを渡せます。書き込みが続いて整合した値を
+// 得られなかった場合は false を返します (次の周期で読み直す)。
+//------------------------------------------------------------------------------
+inline bool LR2BGAReadSharedStats(const LR2BGASharedStatsBlock *pBlock, LR2BGASharedStatsData &out) {
+    constexpr int kMaxAttempts = 64;
+    if (!pBlock || pBlock->magic != kLR2BGASharedStatsMagic ||
+        pBlock->version != kLR2BGASharedStatsVersion ||
+        pBlock->size < sizeof(LR2BGASharedStatsBlock)) {
+        return false;
+    }
+    for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
+        const LONG begin = pBlock->sequence;
+        if (begin & 1) {
+            YieldProcessor();
+            continue;
+        }
+        MemoryBarrier();
+        CopyMemory(&out, (const void *)&pBlock->data, sizeof(out));
+        MemoryBarrier();
+        if (pBlock->sequence == begin) return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// LR2BGASharedStats - 共有メモリへの公開 (書き込み側)
+//------------------------------------------------------------------------------
+class LR2BGASharedStats {
+public:
+    LR2BGASharedStats();
+    ~LR2BGASharedStats();
+
+    LR2BGASharedStats(const LR2BGASharedStats&) = delete;
+    LR2BGASharedStats& operator=(const LR2BGASharedStats&) = delete;
+
+    // 共有メモリを作成 (または開いて) 書き込みの所有権を取る
+    // S_OK: 公開できる, S_FALSE: 他のフィルタが公開中 (何もしない), 失敗: 作成・マップの失敗
+    HRESULT Open();
+    // 所有権を手放してマップを解除する
+    void Close();
+    bool IsOpen() const { return m_pBlock != NULL; }
+
+    // 統計を書き込む (単一ライター。Open していなければ何もしない)
+    void Publish(const LR2BGASharedStatsData &data);
+
+private:
+    HANDLE m_hMapping;
+    LR2BGASharedStatsBlock *m_pBlock;
+};
@@ -0,0 +1,182 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAStageStats.cpp
+// LR2 BGA Filter - 処理段階ごとの所要時間と実測出力フレームレートの集計 実装
+//------------------------------------------------------------------------------
+
+#include "LR2BGAStageStats.h"
+
+#include <intrin.h>
+
+//------------------------------------------------------------------------------
+// LR2BGALatencyHistogram
+//------------------------------------------------------------------------------
+LR2BGALatencyHistogram::LR2BGALatencyHistogram()
+    : m_sumUs(0),
+      m_maxUs(0)
+{
+    for (int i = 0; i < kBucketCount; i++) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int LR2BGALatencyHistogram::BucketIndex(LONGLONG us)
+{
+    if (us < kSubBucketCount) return (us > 0) ? (int)us : 0;
+    if (us >= (1LL << kMaxExponent)) return kBucketCount - 1;
+
+    unsigned long exponent;
+    _BitScanReverse(&exponent, (unsigned long)us);  // kSubBucketBits 以上 kMaxExponent 未満
+    const int shift = (int)exponent - kSubBucketBits;
+    const int sub = (int)(us >> shift) - kSubBucketCount;
+    return kSubBucketCount + shift * kSubBucketCount + sub;
+}
+
+LONGLONG LR2BGALatencyHistogram::BucketUpperBound(int index)
+{
+    if (index < kSubBucketCount) return index;
+    const int shift = (index - kSubBucketCount) / kSubBucketCount;
+    const int sub = (index - kSubBucketCount) % kSubBucketCount;
+    return ((LONGLONG)(kSubBucketCount + sub + 1) << shift) - 1;
+}
+
+//------------------------------------------------------------------------------
+// Record - 所要時間の記録
+// 書き込みはストリーミングスレッドのみのため、read-modify-write は不要 (ロック命令を使わない)。
+//------------------------------------------------------------------------------
+void LR2BGALatencyHistogram::Record(LONGLONG us)
+{
+    if (us < 0) us = 0;
+    std::atomic<unsigned long>& bucket = m_counts[BucketIndex(us)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_sumUs.store(m_sumUs.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+    if (us > m_maxUs.load(std::memory_order_relaxed)) {
+        m_maxUs.store(us, std::memory_order_relaxed);
+    }
+}
+
+void LR2BGALatencyHistogram::Clear()
+{
+    for (int i = 0; i < kBucketCount; i++) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+    m_sumUs.store(0, std::memory_order_relaxed);
+    m_maxUs.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// Get - 統計の算出
+// パーセンタイルは累積数が全体の p 以上になった最初のバケットの上端 (最大値で頭打ち)。
+//------------------------------------------------------------------------------
+void LR2BGALatencyHistogram::Get(LR2BGAStageLatency& out) const
+{
+    out = LR2BGAStageLatency();
+
+    unsigned long counts[kBucketCount];
+    LONGLONG total = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) return;
+
+    const LONGLONG maxUs = m_maxUs.load(std::memory_order_relaxed);
+    const LONGLONG ranks[3] = { (total * 50 + 99) / 100, (total * 95 + 99) / 100, (total * 99 + 99) / 100 };
+    double* const results[3] = { &out.p50Ms, &out.p95Ms, &out.p99Ms };
+
+    LONGLONG cumulative = 0;
+    int next = 0;
+    for (int i = 0; i < kBucketCount && next < 3; i++) {
+        cumulative += counts[i];
+        while (next < 3 && cumulative >= ranks[next]) {
+            LONGLONG value = BucketUpperBound(i);
+            if (value > maxUs) value = maxUs;
+            *results[next] = value / 1000.0;
+            next++;
+        }
+    }
+
+    out.samples = total;
+    out.meanMs = (double)m_sumUs.load(std::memory_order_relaxed) / total / 1000.0;
+    out.maxMs = maxUs / 1000.0;
+}
+
+//------------------------------------------------------------------------------
+// LR2BGAStageStats
+//------------------------------------------------------------------------------
+LR2BGAStageStats::LR2BGAStageStats()
+    : m_qpcFreq(0),
+      m_resetRequested(false),
+      m_outputTimes(),
+      m_outputHead(0),
+      m_outputCount(0),
+      m_outputFps(0.0),
+      m_lastOutputQpc(0)
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    m_qpcFreq = (freq.QuadPart > 0) ? freq.QuadPart : 1;
+}
+
+void LR2BGAStageStats::Record(LR2BGAStage stage, LONGLONG startQpc, LONGLONG endQpc,
+                              LONGLONG arg0, int arg1, int arg2)
+{
+    if (m_resetRequested.load(std::memory_order_relaxed) && m_resetRequested.exchange(false)) {
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            m_stages[i].Clear();
+        }
+    }
+    if (stage < 0 || stage >= STAGE_COUNT) return;
+    LR2BGATrace::Instance().Record(stage, startQpc, endQpc, arg0, arg1, arg2);
+
+    const LONGLONG qpcTicks = endQpc - startQpc;
+    // 乗算のオーバーフローを避けるため秒と端数に分けて換算する
+    const LONGLONG us = (qpcTicks / m_qpcFreq) * 1000000LL + (qpcTicks % m_qpcFreq) * 1000000LL / m_qpcFreq;
+    m_stages[stage].Record(us);
+}
+
+//------------------------------------------------------------------------------
+// RecordOutput - 出力時刻の記録
+// 直近 kRateWindowMs に収まる出力時刻だけをリングバッファに残し、
+// 最古と最新の間隔からレートを求める (Filter Graph の AvgTimePerFrame ではなく実測値)。
+//------------------------------------------------------------------------------
+void LR2BGAStageStats::RecordOutput(LONGLONG qpc)
+{
+    m_outputTimes[m_outputHead] = qpc;
+    m_outputHead = (m_outputHead + 1) % kRateHistorySize;
+    if (m_outputCount < kRateHistorySize) m_outputCount++;
+
+    const LONGLONG window = m_qpcFreq * kRateWindowMs / 1000;
+    int oldest = (m_outputHead - m_outputCount + kRateHistorySize) % kRateHistorySize;
+    while (m_outputCount > 1 && qpc - m_outputTimes[oldest] > window) {
+        oldest = (oldest + 1) % kRateHistorySize;
+        m_outputCount--;
+    }
+
+    double fps = 0.0;
+    const LONGLONG span = qpc - m_outputTimes[oldest];
+    if (m_outputCount > 1 && span > 0) {
+        fps = (double)(m_outputCount - 1) * m_qpcFreq / span;
+    }
+    m_outputFps.store(fps, std::memory_order_relaxed);
+    m_lastOutputQpc.store(qpc, std::memory_order_release);
+}
+
+void LR2BGAStageStats::GetStageLatency(LR2BGAStage stage, LR2BGAStageLatency& out) const
+{
+    if (stage < 0 || stage >= STAGE_COUNT) {
+        out = LR2BGAStageLatency();
+        return;
+    }
+    m_stages[stage].Get(out);
+}
+
+double LR2BGAStageStats::GetOutputFrameRate() const
+{
+    const LONGLONG last = m_lastOutputQpc.load(std::memory_order_acquire);
+    if (last == 0) return 0.0;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (now.QuadPart - last > m_qpcFreq * kRateWindowMs / 1000) return 0.0;
+    return m_outputFps.load(std::memory_order_relaxed);
+}
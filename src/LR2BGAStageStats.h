@@ -0,0 +1,94 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAStageStats.h
+// LR2 BGA Filter - 処理段階ごとの所要時間と実測出力フレームレートの集計
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   フレーム処理の段階 (LR2BGAStage) ごとに QPC で測った所要時間を、
+//   対数バケットのヒストグラム (HDR Histogram と同じ方式) に集計します。
+//   平均だけでは見えない p95/p99/最大を、値の桁に関係なく 1/8 以内の誤差で求められます。
+//   出力したフレームの時刻から直近1秒の出力フレームレートも求めます。
+//   記録した段階はトレース用リングバッファ (LR2BGATrace) にもイベントとして残します。
+//
+// スレッド:
+//   記録 (Record / RecordOutput) はストリーミングスレッドのみが行います。
+//   取得 (GetStageLatency / GetOutputFrameRate) と RequestReset は任意のスレッドから呼べます。
+//   バケットは単一ライターのアトミック変数のため、取得中に記録されたフレームが
+//   一部のバケットにだけ反映されることはありますが、ロックは取りません。
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <windows.h>
+#include <atomic>
+
+#include "LR2BGATypes.h"
+#include "LR2BGATrace.h"
+
+//------------------------------------------------------------------------------
+// LR2BGALatencyHistogram - 対数バケットのヒストグラム (単位: マイクロ秒)
+// 8未満は1刻み、以降は2の冪ごとに8等分する (相対誤差 1/8 以内)。
+// 2^26 us (約67秒) 以上は最後のバケットにまとめる。
+//------------------------------------------------------------------------------
+class LR2BGALatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr int kMaxExponent = 26;
+    static constexpr int kBucketCount = kSubBucketCount + (kMaxExponent - kSubBucketBits) * kSubBucketCount;
+
+    LR2BGALatencyHistogram();
+
+    LR2BGALatencyHistogram(const LR2BGALatencyHistogram&) = delete;
+    LR2BGALatencyHistogram& operator=(const LR2BGALatencyHistogram&) = delete;
+
+    void Record(LONGLONG us);       // ストリーミングスレッド専用
+    void Clear();                   // ストリーミングスレッド専用
+    void Get(LR2BGAStageLatency& out) const;
+
+private:
+    static int BucketIndex(LONGLONG us);
+    static LONGLONG BucketUpperBound(int index);
+
+    std::atomic<unsigned long> m_counts[kBucketCount];
+    std::atomic<long long> m_sumUs;
+    std::atomic<long long> m_maxUs;
+};
+
+//------------------------------------------------------------------------------
+// LR2BGAStageStats - 処理段階ごとの所要時間と実測出力フレームレート
+//------------------------------------------------------------------------------
+class LR2BGAStageStats {
+public:
+    LR2BGAStageStats();
+
+    LR2BGAStageStats(const LR2BGAStageStats&) = delete;
+    LR2BGAStageStats& operator=(const LR2BGAStageStats&) = delete;
+
+    // 段階の所要時間を記録する (startQpc/endQpc: QueryPerformanceCounter の値)
+    // arg0-arg2 はトレースのイベント引数 (意味は段階ごと。LR2BGATrace.h を参照)
+    void Record(LR2BGAStage stage, LONGLONG startQpc, LONGLONG endQpc,
+                LONGLONG arg0 = 0, int arg1 = 0, int arg2 = 0);
+    // 下流へ出力したフレームの時刻を記録する (QueryPerformanceCounter の値)
+    void RecordOutput(LONGLONG qpc);
+    // 集計のリセット要求 (UIスレッドから呼ばれる。次の Record で適用)
+    void RequestReset() { m_resetRequested = true; }
+
+    void GetStageLatency(LR2BGAStage stage, LR2BGAStageLatency& out) const;
+    // 直近 kRateWindowMs の出力フレームレート (出力が kRateWindowMs 以上途絶えている場合は 0)
+    double GetOutputFrameRate() const;
+
+private:
+    static constexpr int kRateHistorySize = 128;    // 出力時刻の保持数 (これを超えるレートでは窓が短くなる)
+    static constexpr LONGLONG kRateWindowMs = 1000;
+
+    LONGLONG m_qpcFreq;
+    LR2BGALatencyHistogram m_stages[STAGE_COUNT];
+    std::atomic<bool> m_resetRequested;
+
+    // 出力時刻のリングバッファ (ストリーミングスレッド専用)
+    LONGLONG m_outputTimes[kRateHistorySize];
+    int m_outputHead;                   // 次に書き込む位置
+    int m_outputCount;                  // 窓内の時刻の数
+    std::atomic<double> m_outputFps;    // 最後の RecordOutput 時点のレート
+    std::atomic<long long> m_lastOutputQpc;
+};
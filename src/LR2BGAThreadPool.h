@@ -27,6 +27,8 @@
 #include <atomic>
 #include <future>
 
+#include "LR2BGATrace.h"
+
 class LR2BGAThreadPool {
 public:
     static LR2BGAThreadPool& Instance() {
@@ -42,7 +44,9 @@ public:
         if (range <= 0) return;
 
         int threadCount = (int)workers.size();
-        if (threadCount == 0 || range < threadCount) {
+        const int limit = maxParallelism.load(std::memory_order_relaxed);
+        if (limit > 0 && limit < threadCount) threadCount = limit;
+        if (threadCount <= 1 || range < threadCount) {
              func(start, end);
              return;
         }
@@ -60,9 +64,20 @@ public:
             
             // タスクをスレッドプールにエンキューし、futureで完了を待機
             // カスタムスレッドプールにより、スレッド生成コストを抑制
+            // チャンクごとの実行時間はトレースに記録する (ワーカー間の偏りや起床遅れの調査用)
+            // 記録できない場合は計測の QPC も読まない
             if (currentChunk > 0) {
                 futures.emplace_back(Enqueue([=] {
+                    if (!LR2BGATrace::Instance().IsEnabled()) {
+                        func(currentStart, currentEnd);
+                        return;
+                    }
+                    LARGE_INTEGER chunkStart, chunkEnd;
+                    QueryPerformanceCounter(&chunkStart);
                     func(currentStart, currentEnd);
+                    QueryPerformanceCounter(&chunkEnd);
+                    LR2BGATrace::Instance().Record(TRACE_POOL_CHUNK, chunkStart.QuadPart, chunkEnd.QuadPart,
+                                                   0, currentStart, currentEnd);
                 }));
             }
             currentStart = currentEnd;
@@ -74,6 +89,13 @@ public:
         }
     }
 
+    // 並列度の上限 (0: ワーカー数すべて)
+    // ベンチマークでスレッド数ごとのスケーリングを測るためのもので、フィルタは変更しない
+    void SetMaxParallelism(int maxThreads) {
+        maxParallelism.store(maxThreads > 0 ? maxThreads : 0, std::memory_order_relaxed);
+    }
+    int GetWorkerCount() const { return (int)workers.size(); }
+
     // 汎用タスクのエンキュー
     template<class F, class... Args>
     auto Enqueue(F&& f, Args&&... args) 
@@ -108,7 +130,7 @@ public:
     }
 
 private:
-    LR2BGAThreadPool() : stop(false) {
+    LR2BGAThreadPool() : stop(false), maxParallelism(0) {
         // ハードウェアスレッド数を取得 (0の場合はフォールバック)
         unsigned int threads = std::thread::hardware_concurrency();
         if (threads == 0) threads = 4;
@@ -142,6 +164,7 @@ private:
     std::mutex queue_mutex;
     std::condition_variable condition;
     bool stop;
+    std::atomic<int> maxParallelism;
     
     // コピー禁止
     LR2BGAThreadPool(const LR2BGAThreadPool&) = delete;
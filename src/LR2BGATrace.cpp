@@ -0,0 +1,181 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGATrace.cpp
+// LR2 BGA Filter - トレース用リングバッファ 実装 (Chrome Trace 形式での書き出し)
+//------------------------------------------------------------------------------
+
+#include "LR2BGATrace.h"
+
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// 定数定義 (Constants)
+//------------------------------------------------------------------------------
+constexpr size_t kTraceMaxThreads = 64;         // スレッド名を付けるスレッド数の上限
+constexpr size_t kTraceFileBufferSize = 1 << 16;
+
+namespace {
+
+const char* const kTraceEventNames[TRACE_EVENT_COUNT] = {
+    "FPS Wait", "Letterbox", "Ext Window", "Resize", "Brightness", "Deliver", "Frame", "Pool Chunk", "Letterbox Submit"
+};
+
+const char* const kTraceKernelNames[] = { "copy", "nearest", "bilinear", "multi" };
+
+const char* TraceCategory(int type) {
+    if (type == STAGE_TOTAL) return "frame";
+    if (type == TRACE_POOL_CHUNK) return "pool";
+    if (type == TRACE_LETTERBOX_SUBMIT) return "letterbox";
+    return "stage";
+}
+
+// QPC の値をマイクロ秒へ (乗算のオーバーフローを避けるため秒と端数に分けて換算する)
+double QpcToUs(LONGLONG qpc, LONGLONG freq) {
+    return (double)(qpc / freq) * 1000000.0 + (double)(qpc % freq) * 1000000.0 / freq;
+}
+
+void WriteEventArgs(FILE* fp, int type, LONGLONG arg0, int arg1, int arg2) {
+    switch (type) {
+    case STAGE_FPS_WAIT:
+        fprintf(fp, "{\"input_ms\":%.3f,\"decision\":\"%s\"}", arg0 / 10000.0, arg1 ? "drop" : "output");
+        break;
+    case STAGE_LETTERBOX:
+        fprintf(fp, "{\"crop\":%s}", arg1 ? "true" : "false");
+        break;
+    case STAGE_EXT_WINDOW:
+        fprintf(fp, "{\"presized\":%s}", arg1 ? "true" : "false");
+        break;
+    case STAGE_RESIZE: {
+        const int kernelCount = (int)(sizeof(kTraceKernelNames) / sizeof(kTraceKernelNames[0]));
+        fprintf(fp, "{\"kernel\":\"%s\",\"rows\":%d}",
+                (arg1 >= 0 && arg1 < kernelCount) ? kTraceKernelNames[arg1] : "unknown", arg2);
+        break;
+    }
+    case STAGE_BRIGHTNESS:
+        fprintf(fp, "{\"brightness\":%d}", arg1);
+        break;
+    case STAGE_DELIVER:
+        fprintf(fp, "{\"hr\":\"0x%08X\"}", (unsigned int)arg1);
+        break;
+    case STAGE_TOTAL:
+        fprintf(fp, "{\"input_ms\":%.3f,\"outcome\":\"%s\"}", arg0 / 10000.0,
+                arg1 == TRACE_OUTCOME_OUTPUT ? "output" :
+                arg1 == TRACE_OUTCOME_FPS_DROP ? "fps_drop" : "skip");
+        break;
+    case TRACE_POOL_CHUNK:
+        fprintf(fp, "{\"begin\":%d,\"end\":%d}", arg1, arg2);
+        break;
+    case TRACE_LETTERBOX_SUBMIT:
+        fprintf(fp, "{\"interval_ms\":%d,\"sync\":%s}", arg1, arg2 ? "true" : "false");
+        break;
+    default:
+        fprintf(fp, "{}");
+        break;
+    }
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// SaveToFile - Chrome Trace 形式 (Trace Event Format) での書き出し
+//
+// 処理内容:
+//   1. リングバッファの有効なスロットをシーケンス番号で確認しながら読み出す
+//      (書き出し中も記録は続くため、読み出し中に上書きされたスロットは捨てる)。
+//   2. 開始時刻順に並べ、完了イベント ("ph":"X") として書き出す。
+//      時刻は QPC をマイクロ秒に換算した値 (複数回の書き出しで時間軸が揃う)。
+//   3. フレーム処理を記録したスレッドとスレッドプールのワーカーにスレッド名を付ける。
+//------------------------------------------------------------------------------
+HRESULT LR2BGATrace::SaveToFile(LPCWSTR pszPath) const
+{
+    if (!pszPath) return E_POINTER;
+    if (!m_slots) return E_OUTOFMEMORY;
+
+    std::vector<Event> events;
+    try {
+        events.reserve(kCapacity);
+    } catch (const std::bad_alloc&) {
+        return E_OUTOFMEMORY;
+    }
+
+    const unsigned long end = m_writeIndex.load(std::memory_order_acquire);
+    const unsigned long count = (end < kCapacity) ? end : kCapacity;
+    for (unsigned long i = end - count; i != end; i++) {
+        const Slot& slot = m_slots[i & (kCapacity - 1)];
+        const unsigned long seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != i + 1) continue;    // 記録中、または既に上書きされた
+
+        Event ev;
+        ev.type = slot.type;
+        ev.threadId = slot.threadId;
+        ev.arg1 = slot.arg1;
+        ev.arg2 = slot.arg2;
+        ev.startQpc = slot.startQpc;
+        ev.endQpc = slot.endQpc;
+        ev.arg0 = slot.arg0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) continue;  // 読み出し中に上書きされた
+
+        if (ev.type < 0 || ev.type >= TRACE_EVENT_COUNT || ev.endQpc < ev.startQpc) continue;
+        events.push_back(ev);
+    }
+    std::sort(events.begin(), events.end(),
+              [](const Event& a, const Event& b) { return a.startQpc < b.startQpc; });
+
+    FILE* fp = NULL;
+    if (_wfopen_s(&fp, pszPath, L"wb") != 0 || !fp) {
+        return HRESULT_FROM_WIN32(ERROR_OPEN_FAILED);
+    }
+    setvbuf(fp, NULL, _IOFBF, kTraceFileBufferSize);
+
+    const DWORD pid = GetCurrentProcessId();
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"generator\":\"LR2 BGA Filter\","
+                "\"recorded\":%lu,\"exported\":%u},\"traceEvents\":[\n",
+            end, (unsigned int)events.size());
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,\"args\":{\"name\":\"LR2 BGA Filter\"}}",
+            pid);
+
+    // スレッド名 (フレーム処理 = ストリーミングスレッド、チャンク = スレッドプールのワーカー)
+    DWORD namedThreads[kTraceMaxThreads];
+    size_t namedCount = 0;
+    for (const Event& ev : events) {
+        if (ev.type != STAGE_TOTAL && ev.type != TRACE_POOL_CHUNK) continue;
+        if (namedCount >= kTraceMaxThreads) break;
+        if (std::find(namedThreads, namedThreads + namedCount, ev.threadId) != namedThreads + namedCount) continue;
+        namedThreads[namedCount++] = ev.threadId;
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                pid, ev.threadId, ev.type == STAGE_TOTAL ? "Streaming" : "Pool Worker");
+    }
+
+    for (const Event& ev : events) {
+        fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"pid\":%lu,\"tid\":%lu,\"args\":",
+                kTraceEventNames[ev.type], TraceCategory(ev.type),
+                QpcToUs(ev.startQpc, m_qpcFreq),
+                (double)(ev.endQpc - ev.startQpc) * 1000000.0 / m_qpcFreq,
+                pid, ev.threadId);
+        WriteEventArgs(fp, ev.type, ev.arg0, ev.arg1, ev.arg2);
+        fputc('}', fp);
+    }
+    fprintf(fp, "\n]}\n");
+
+    const bool failed = ferror(fp) != 0;
+    if (fclose(fp) != 0 || failed) {
+        return HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+    }
+    return S_OK;
+}
+
+void LR2BGATrace::MakeDefaultPath(wchar_t* buffer, size_t size)
+{
+    wchar_t dir[MAX_PATH];
+    DWORD len = GetTempPathW(MAX_PATH, dir);
+    if (len == 0 || len >= MAX_PATH) {
+        wcscpy_s(dir, L".\\");
+    }
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    swprintf_s(buffer, size, L"%sLR2BGAFilter_trace_%04u%02u%02u_%02u%02u%02u.json", dir,
+               st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+}
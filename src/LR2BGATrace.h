@@ -0,0 +1,150 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGATrace.h
+// LR2 BGA Filter - フレームごとのイベントを記録するトレース用リングバッファ
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   平均値では分からない単発のカクつきを調べるため、フレーム処理の各段階と
+//   スレッドプールのチャンク、黒帯検出のサムネイル投入の開始・終了時刻 (QPC) を
+//   固定長のリングバッファに記録し続けます。
+//   SaveToFile で Chrome Trace / Perfetto で開ける JSON (Trace Event Format) に書き出します。
+//
+// 記録:
+//   常時有効です。1イベントあたりの負荷はインデックスのアトミック加算1回と数十バイトの書き込みで、
+//   処理段階の時刻は段階の計測で取得済みの値を渡します (記録のために QPC を追加で呼ばない)。
+//   段階の計測がない区間 (プールのチャンク、サムネイル投入) だけは記録のために前後で QPC を読みます。
+//   チャンクはフレームあたりワーカー数程度、投入は解析間隔ごとのため、追加の呼び出しはわずかです。
+//   リングバッファを確保できなかった場合 (IsEnabled が false) はこの QPC も読みません。
+//   容量を超えると古いイベントから上書きされます。
+//
+// スレッド:
+//   Record は任意のスレッドから同時に呼べます (ロックなし)。
+//   各スロットは記録中にシーケンス番号を 0 にし、書き終えてから番号を書くため、
+//   書き出し側は読み取り前後の番号を比べて、記録途中や上書き中のスロットを読み飛ばします。
+//
+// 使用法:
+//   LR2BGATrace::Instance().Record(STAGE_RESIZE, startQpc, endQpc, 0, TRACE_KERNEL_BILINEAR);
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <windows.h>
+#include <atomic>
+#include <memory>
+#include <new>
+
+#include "LR2BGATypes.h"
+
+//------------------------------------------------------------------------------
+// トレースイベントの種類
+// 処理段階 (LR2BGAStage) はその値のまま記録し、段階以外のイベントはその後に続ける。
+// 引数の意味 (arg0 / arg1 / arg2):
+//   STAGE_FPS_WAIT   : 入力タイムスタンプ (100ns) / 1: FPS制限でドロップ / -
+//   STAGE_LETTERBOX  : - / 1: 黒帯を除いて切り出し / -
+//   STAGE_EXT_WINDOW : - / 1: LR2向け出力と同時にリサイズ / -
+//   STAGE_RESIZE     : - / LR2BGATraceKernel / 出力の有効行数
+//   STAGE_BRIGHTNESS : - / 明るさ (0-100) / -
+//   STAGE_DELIVER    : - / HRESULT / -
+//   STAGE_TOTAL      : 入力タイムスタンプ (100ns) / LR2BGATraceOutcome / -
+//   TRACE_POOL_CHUNK : - / 開始位置 / 終了位置 (ParallelFor の範囲)
+//   TRACE_LETTERBOX_SUBMIT : - / 解析間隔 (ms) / 1: 同期モード (このスレッドで解析)
+//------------------------------------------------------------------------------
+enum LR2BGATraceEvent {
+    TRACE_POOL_CHUNK = STAGE_COUNT, // スレッドプールのチャンク1つの実行
+    TRACE_LETTERBOX_SUBMIT,         // 黒帯検出へのサムネイル投入 (検出の頻度を見るため)
+    TRACE_EVENT_COUNT
+};
+
+// STAGE_RESIZE の arg1
+enum LR2BGATraceKernel {
+    TRACE_KERNEL_COPY = 0,      // パススルーのコピー
+    TRACE_KERNEL_NEAREST,
+    TRACE_KERNEL_BILINEAR,
+    TRACE_KERNEL_MULTI          // 外部ウィンドウ用フレームとの同時リサイズ (ResizeMulti)
+};
+
+// STAGE_TOTAL の arg1
+enum LR2BGATraceOutcome {
+    TRACE_OUTCOME_OUTPUT = 0,   // LR2向けに出力
+    TRACE_OUTCOME_FPS_DROP,     // FPS制限でドロップ
+    TRACE_OUTCOME_SKIP          // ダミーモード等で出力なし
+};
+
+class LR2BGATrace {
+public:
+    static constexpr unsigned long kCapacity = 32768;     // 2の冪 (60fpsで十数秒分)
+
+    static LR2BGATrace& Instance() {
+        static LR2BGATrace instance;
+        return instance;
+    }
+
+    // 記録できるか (リングバッファの確保に失敗した場合は false)
+    // 記録のためだけに時刻を取得する呼び出し側は、これが false なら取得を省く
+    bool IsEnabled() const { return m_slots != nullptr; }
+
+    // イベントの記録 (任意のスレッドから呼べる。startQpc/endQpc は QueryPerformanceCounter の値)
+    void Record(int type, LONGLONG startQpc, LONGLONG endQpc,
+                LONGLONG arg0 = 0, int arg1 = 0, int arg2 = 0) {
+        if (!m_slots) return;
+        const unsigned long index = m_writeIndex.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = m_slots[index & (kCapacity - 1)];
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.type = (short)type;
+        slot.threadId = GetCurrentThreadId();
+        slot.startQpc = startQpc;
+        slot.endQpc = endQpc;
+        slot.arg0 = arg0;
+        slot.arg1 = arg1;
+        slot.arg2 = arg2;
+        slot.seq.store(index + 1, std::memory_order_release);
+    }
+
+    // Chrome Trace 形式の JSON へ書き出す (記録は止めない)
+    HRESULT SaveToFile(LPCWSTR pszPath) const;
+    // 既定の書き出し先 (%TEMP%\LR2BGAFilter_trace_YYYYMMDD_HHMMSS.json)
+    static void MakeDefaultPath(wchar_t* buffer, size_t size);
+
+private:
+    struct Slot {
+        std::atomic<unsigned long> seq;     // 0: 記録中/未使用、それ以外: 書き込みインデックス + 1
+        short type;
+        DWORD threadId;
+        int arg1;
+        int arg2;
+        LONGLONG startQpc;
+        LONGLONG endQpc;
+        LONGLONG arg0;
+    };
+
+    // 書き出し用に読み出したイベント
+    struct Event {
+        int type;
+        DWORD threadId;
+        int arg1;
+        int arg2;
+        LONGLONG startQpc;
+        LONGLONG endQpc;
+        LONGLONG arg0;
+    };
+
+    LR2BGATrace() : m_writeIndex(0), m_qpcFreq(0) {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        m_qpcFreq = (freq.QuadPart > 0) ? freq.QuadPart : 1;
+        // 確保できない場合は記録しない (フィルタの動作には影響させない)
+        m_slots.reset(new (std::nothrow) Slot[kCapacity]);
+        if (m_slots) {
+            for (unsigned long i = 0; i < kCapacity; i++) {
+                m_slots[i].seq.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    LR2BGATrace(const LR2BGATrace&) = delete;
+    LR2BGATrace& operator=(const LR2BGATrace&) = delete;
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<unsigned long> m_writeIndex;
+    LONGLONG m_qpcFreq;
+};
@@ -5,7 +5,8 @@
 
 #include "LR2BGATransformLogic.h"
 #include "LR2BGAImageProc.h"
-#include "LR2BGAWindow.h" // m_pWindow のために必要 (将来的な利用含む)
+#include <math.h>
+#include <stdlib.h>
 
 //------------------------------------------------------------------------------
 // コンストラクタ / デストラクタ
@@ -14,20 +15,52 @@ LR2BGATransformLogic::LR2BGATransformLogic(LR2BGASettings* pSettings, LR2BGAWind
     : m_pSettings(pSettings),
       m_pWindow(pWindow),
       m_currentLBMode(LB_MODE_ORIGINAL),
+      m_currentLBRect(),
       m_bLBExit(false),
       m_bLBRequest(false),
-      m_lbWidth(0),
-      m_lbHeight(0),
-      m_lbStride(0),
-      m_lbBpp(0),
+      m_lbSynchronous(false),
+      m_lbFrontIndex(1),
+      m_lbAnalyzingIndex(-1),
+      m_lbCommand(LB_CMD_NONE),
+      m_lbCommandEpoch(0),
+      m_lbPendingParams(),
+      m_lbParamsPending(false),
+      m_lbResultStable(false),
+      m_lbResultRejected(false),
+      m_lbResultEpoch(0),
       m_lastLBRequestTime(0),
+      m_lbPhaseStartTime(0),
+      m_lbIntervalMs(kTransformLetterboxDenseIntervalMs),
+      m_lbScheduleStarted(false),
+      m_lbSeeded(false),
+      m_lbShutdown(false),
+      m_lbEpoch(0),
+      m_lbLastWidth(0),
+      m_lbLastHeight(0),
+      m_lbSceneSignatureValid(false),
+      m_lbResetPending(false),
+      m_lbParams(),
+      m_lbParamsVersion(0),
       m_lastOutputTime(0),
-      m_lastOutputWallclockTime(0),
+      m_nextDueTime(0),
+      m_nextDueWallclock(0),
+      m_srcFrameInterval(0),
+      m_cadenceTarget(0),
+      m_cadenceBase(0),
+      m_cadenceNextSlot(0),
+      m_cadenceLastIndex(-1),
+      m_cadenceOutputs(0),
+      m_cadenceMissedSlots(0),
+      m_cadenceErrSumSq(0.0),
+      m_cadenceErrMax(0.0),
+      m_cadenceResetRequested(false),
       m_timelineBaseInputTime(0),
       m_timelineBaseWallclockTime(0),
       m_droppedFrames(0),
       m_timelineBaseInitialized(false),
       m_loggedTimestampFallback(false),
+      m_lastLateness(0),
+      m_latenessValid(false),
       m_dummySent(false),
       m_lastDummyTime(0),
       m_activePassthrough(false),
@@ -45,11 +78,13 @@ LR2BGATransformLogic::~LR2BGATransformLogic() {
 //------------------------------------------------------------------------------
 // 初期化・終了
 //------------------------------------------------------------------------------
-void LR2BGATransformLogic::StartStreaming(int inputWidth, int inputHeight, int inputBitCount,
-                                          int outputWidth, int outputHeight) {
+void LR2BGATransformLogic::StartStreaming(const LR2BGASettings::Snapshot& cfg,
+                                          int inputWidth, int inputHeight, int inputBitCount,
+                                          int outputWidth, int outputHeight,
+                                          REFERENCE_TIME srcFrameInterval) {
     // 設定のラッチ
     // ストリーミング中に設定が変更されても、バッファオーバーランなどを防ぐために
-    // この時点での値を維持する
+    // この時点での値を維持する (すべて呼び出し側が開始時に取得した同じスナップショットから読む)
     m_activeWidth = outputWidth;
     m_activeHeight = outputHeight;
 
@@ -61,26 +96,46 @@ void LR2BGATransformLogic::StartStreaming(int inputWidth, int inputHeight, int i
     // パススルー条件:
     //   1. 入出力サイズが完全一致
     //   2. アスペクト比維持がOFF（ONだと黒帯除去時に余白計算が発生するため）
-    m_activePassthrough = isSizeSame && !m_pSettings->m_keepAspectRatio;
+    m_activePassthrough = isSizeSame && !cfg.keepAspectRatio;
 
     // ダミーモード
     // 設定で有効化された場合を正とし、入力不正(0x0)時もフェイルセーフで有効化する
-    m_activeDummy = (m_pSettings && m_pSettings->m_dummyMode) ||
-                    (inputWidth == 0 || inputHeight == 0);
+    m_activeDummy = cfg.dummyMode || (inputWidth == 0 || inputHeight == 0);
 
     // 状態リセット
     m_lastOutputTime = 0;
-    m_lastOutputWallclockTime = 0;
+    m_nextDueTime = 0;
+    m_nextDueWallclock = 0;
+    m_pacer.Restart();
+    m_srcFrameInterval = (srcFrameInterval > 0) ? srcFrameInterval : 0;
+    m_cadenceTarget = 0;
+    m_cadenceOutputs = 0;
+    m_cadenceMissedSlots = 0;
+    m_cadenceErrSumSq = 0.0;
+    m_cadenceErrMax = 0.0;
     m_timelineBaseInputTime = 0;
     m_timelineBaseWallclockTime = 0;
     m_droppedFrames = 0;
     m_timelineBaseInitialized = false;
     m_loggedTimestampFallback = false;
+    m_lastLateness = 0;
+    m_latenessValid = false;
     m_dummySent = false;
     m_lastDummyTime = 0;
 
     // レターボックス関連
+    // スケジュールは最初のフレーム到着時に密な解析フェーズから開始する
     m_lastLBRequestTime = 0;
+    m_lbScheduleStarted = false;
+    m_lbSeeded = false;
+    m_lbShutdown = false;
+    m_lbSceneSignatureValid = false;
+    // 設定値を検出器へ反映 (検出スレッドの開始前。以後の変更は ProcessLetterboxDetection から送る)
+    m_lbParams.threshold = cfg.lbThreshold;
+    m_lbParams.stability = cfg.lbStability;
+    m_lbParamsVersion = cfg.version;
+    m_lbParamsPending = false;
+    m_lbDetector.SetParams(m_lbParams.threshold, m_lbParams.stability);
     {
         std::lock_guard<std::mutex> lock(m_mtxLBMode);
         m_currentLBMode = LB_MODE_ORIGINAL;
@@ -107,6 +162,9 @@ void LR2BGATransformLogic::StopStreaming() {
 // アーキテクチャ:
 //   - イベント駆動型 (Event-Driven): m_bLBRequest フラグと Condition Variable
 //   がシグナルされるまで待機します。
+//   - 入力はフルフレームではなく輝度サムネイル (ダブルバッファ) です。
+//   解析中のサムネイルは変換スレッドから書き換えられないため、
+//   解析自体はロックを保持せずに行います。
 // ------------------------------------------------------------------------------
 void LR2BGATransformLogic::StartLetterboxThread() {
     std::lock_guard<std::mutex> lock(m_mtxLBControl);
@@ -115,6 +173,7 @@ void LR2BGATransformLogic::StartLetterboxThread() {
     }
     m_bLBExit = false;
     m_bLBRequest = false;
+    m_lbAnalyzingIndex = -1;
     m_threadLB = std::thread(&LR2BGATransformLogic::LetterboxThreadProc, this);
 }
 
@@ -129,7 +188,9 @@ void LR2BGATransformLogic::StopLetterboxThread() {
 }
 
 void LR2BGATransformLogic::ResetLetterboxState() {
-    m_lbDetector.Reset();
+    // 検出器は検出スレッドが使用しているため、リセットは変換スレッド経由で
+    // 次回の解析前に適用する (LB_CMD_RESET)
+    m_lbResetPending = true;
     {
         std::lock_guard<std::mutex> lock(m_mtxLBMode);
         m_currentLBMode = LB_MODE_ORIGINAL;
@@ -140,75 +201,280 @@ void LR2BGATransformLogic::ResetLetterboxState() {
 // LetterboxThread - 非同期解析スレッド
 // ------------------------------------------------------------------------------
 void LR2BGATransformLogic::LetterboxThreadProc() {
-    std::vector<BYTE> workBuffer;
-
     while (true) {
-        // 待機
+        // 待機して解析対象とコマンドを確保
+        int index = -1;
+        LetterboxCommand command = LB_CMD_NONE;
+        unsigned int epoch = 0;
+        LetterboxParams params = {};
+        bool applyParams = false;
         {
             std::unique_lock<std::mutex> lock(m_mtxLBControl);
             m_cvLB.wait(lock, [this] { return m_bLBRequest || m_bLBExit; });
 
             if (m_bLBExit) break;
             m_bLBRequest = false;
+            index = m_lbFrontIndex;
+            m_lbAnalyzingIndex = index;
+            command = m_lbCommand;
+            m_lbCommand = LB_CMD_NONE;
+            epoch = m_lbCommandEpoch;
+            applyParams = m_lbParamsPending;
+            params = m_lbPendingParams;
+            m_lbParamsPending = false;
         }
 
-        // パラメータ取得
-        int w = 0, h = 0, s = 0, bpp = 0;
-        size_t srcSize = 0;
-        {
-            std::lock_guard<std::mutex> lock(m_mtxLBBuffer);
-            w = m_lbWidth;
-            h = m_lbHeight;
-            s = m_lbStride;
-            bpp = m_lbBpp;
-            srcSize = m_lbBuffer.size();
-        }
+        AnalyzeLetterboxThumbnail(index, command, epoch, applyParams ? &params : NULL);
+    }
+}
 
-        if (w <= 0 || h <= 0 || s <= 0 || srcSize == 0) continue;
+void LR2BGATransformLogic::AnalyzeLetterboxThumbnail(int index, LetterboxCommand command, unsigned int epoch,
+                                                     const LetterboxParams* pParams) {
+    if (pParams) {
+        m_lbDetector.SetParams(pParams->threshold, pParams->stability);
+    }
+    if (command == LB_CMD_RESET) {
+        m_lbDetector.Reset();
+    } else if (command == LB_CMD_NEW_SCENE) {
+        m_lbDetector.BeginNewScene();
+    }
 
-        // 作業用バッファ準備
-        try {
-            if (workBuffer.size() < srcSize) {
-                workBuffer.resize(srcSize);
-            }
-        } catch (...) {
-            continue;
+    // 解析実行 (ロック不要: m_lbAnalyzingIndex が示す側は書き換えられない)
+    LetterboxMode mode = m_lbDetector.AnalyzeFrame(m_lbThumbs[index]);
+
+    // 解析中にリセットが要求された場合、この結果は破棄する
+    bool stale = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mtxLBControl);
+        m_lbAnalyzingIndex = -1;
+        stale = (m_lbCommand == LB_CMD_RESET);
+    }
+    if (!stale) {
+        std::lock_guard<std::mutex> lock(m_mtxLBMode);
+        m_currentLBMode = mode;
+        m_currentLBRect = m_lbDetector.GetCurrentRect();
+        m_lbResultStable = m_lbDetector.IsStable();
+        m_lbResultRejected = m_lbDetector.IsFullyRejected();
+        m_lbResultEpoch = epoch;
+    }
+}
+
+// ------------------------------------------------------------------------------
+// Helper: SubmitLetterboxThumbnail - 解析用サムネイルの受け渡し
+//
+// 役割:
+//   入力フレームから輝度サムネイルを生成し、検出スレッドへ公開します。
+//
+// 受け渡しの手順:
+//   1. m_mtxLBControl 下で書き込み先を決定する (解析中でない側)。
+//      公開済みだが未解析の側へ上書きする場合は、一旦公開を取り下げる。
+//   2. ロックを保持せずにサムネイルを生成する。
+//   3. m_mtxLBControl 下でインデックスを公開し、検出スレッドへ通知する。
+//   同期モード (SetSynchronousLetterbox) では 3. の代わりにこのスレッドで解析する。
+// ------------------------------------------------------------------------------
+void LR2BGATransformLogic::SubmitLetterboxThumbnail(const BYTE* pSrcData, long actualDataLength,
+                                                    int srcWidth, int srcHeight, int srcStride, int srcBitCount) {
+    LONG absSrcStride = std::abs(srcStride);
+    size_t calcSize = (size_t)absSrcStride * srcHeight;
+    size_t safeSize = (actualDataLength > 0 && (size_t)actualDataLength < calcSize) ? (size_t)actualDataLength : calcSize;
+
+    int writeIndex;
+    {
+        std::lock_guard<std::mutex> lock(m_mtxLBControl);
+        if (m_lbAnalyzingIndex >= 0) {
+            writeIndex = 1 - m_lbAnalyzingIndex;
+        } else {
+            writeIndex = 1 - m_lbFrontIndex;
+        }
+        if (writeIndex == m_lbFrontIndex) {
+            m_bLBRequest = false;
         }
+    }
 
-        // コピーサイズ計算
-        int calcSize = s * h;
-        int copySize = (calcSize > (int)srcSize) ? (int)srcSize : calcSize;
+    if (!LR2BGALetterboxDetector::BuildThumbnail(pSrcData, safeSize, srcWidth, srcHeight,
+                                                 absSrcStride, srcBitCount, m_lbThumbs[writeIndex])) {
+        return;
+    }
 
-        if (copySize > 0) {
-            std::lock_guard<std::mutex> lock(m_mtxLBBuffer);
-            if (m_lbBuffer.size() >= (size_t)copySize) {
-                CopyMemory(workBuffer.data(), m_lbBuffer.data(), copySize);
-            }
+    if (m_lbSynchronous) {
+        LetterboxCommand command;
+        unsigned int epoch;
+        LetterboxParams params;
+        bool applyParams;
+        {
+            std::lock_guard<std::mutex> lock(m_mtxLBControl);
+            m_lbFrontIndex = writeIndex;
+            m_lbAnalyzingIndex = writeIndex;
+            command = m_lbCommand;
+            m_lbCommand = LB_CMD_NONE;
+            epoch = m_lbCommandEpoch;
+            applyParams = m_lbParamsPending;
+            params = m_lbPendingParams;
+            m_lbParamsPending = false;
         }
+        AnalyzeLetterboxThumbnail(writeIndex, command, epoch, applyParams ? &params : NULL);
+        return;
+    }
 
-        if (copySize <= 0) continue;
-        
-        // 解析実行 (SEHなし、直接呼び出し)
-        LetterboxMode mode = m_lbDetector.AnalyzeFrame(workBuffer.data(), (size_t)calcSize, w, h, s, bpp);
+    {
+        std::lock_guard<std::mutex> lock(m_mtxLBControl);
+        m_lbFrontIndex = writeIndex;
+        m_bLBRequest = true;
+        m_cvLB.notify_one();
+    }
+}
 
+// ------------------------------------------------------------------------------
+// 適応スケジューラ (Adaptive Letterbox Scheduling)
+//
+// 役割:
+//   黒帯解析を要求するタイミングを決定します。
+//
+// 方針:
+//   1. ストリーム開始 (最初のフレーム) から1秒間は 50ms 間隔で密に解析し、早期に確定させる。
+//   2. 以後は 200ms 間隔を基本とし、判定が安定している間は間隔を倍々に延ばす (最大 3.2秒)。
+//      判定が不安定になったら基本間隔へ戻す。
+//   3. 黒帯なしで確定すると結果は変わらないため、スナップショット自体を停止する。
+//   4. 解像度変更 (検出器をリセット) とシーンカット (除外ラッチのみクリア) で
+//      密な解析フェーズから再開する。シーンカットは停止中・バックオフ中のみ監視する。
+//
+// 世代 (epoch):
+//   コマンド送信ごとに世代を進め、送信後の解析結果のみを停止・バックオフの判断に使う。
+// ------------------------------------------------------------------------------
+bool LR2BGATransformLogic::ScheduleLetterboxAnalysis(const BYTE* pSrcData, long actualDataLength,
+                                                     int srcWidth, int srcHeight, int srcStride, int srcBitCount,
+                                                     DWORD now) {
+    // 1. 設定変更・解像度変更によるリセット
+    bool reset = m_lbResetPending.exchange(false);
+    if (srcWidth != m_lbLastWidth || srcHeight != m_lbLastHeight) {
+        if (m_lbLastWidth != 0 || m_lbLastHeight != 0) reset = true;
+        m_lbLastWidth = srcWidth;
+        m_lbLastHeight = srcHeight;
+    }
+    if (reset) {
         {
             std::lock_guard<std::mutex> lock(m_mtxLBMode);
-            m_currentLBMode = mode;
+            m_currentLBMode = LB_MODE_ORIGINAL;
+        }
+        PostLetterboxCommand(LB_CMD_RESET);
+        RestartLetterboxSchedule(now);
+    } else if (!m_lbScheduleStarted) {
+        RestartLetterboxSchedule(now);
+        if (m_lbSeeded) {
+            // キャッシュ済みの結果から開始: 密な解析を省略し、最大間隔での再確認から始める
+            m_lbPhaseStartTime = now - kTransformLetterboxDensePhaseMs;
+            m_lbIntervalMs = kTransformLetterboxMaxIntervalMs;
+            m_lastLBRequestTime = now;
+        }
+    }
+
+    // 2. 現在の世代の検出結果を取得
+    bool stable = false;
+    bool rejected = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mtxLBMode);
+        if (m_lbResultEpoch == m_lbEpoch) {
+            stable = m_lbResultStable;
+            rejected = m_lbResultRejected;
         }
     }
+
+    // 3. 黒帯なしで確定済みならスナップショットを停止
+    //    (ヒステリシスが ORIGINAL へ戻り切るまでは解析を続ける)
+    if (!m_lbShutdown && rejected && stable) {
+        m_lbShutdown = true;
+        m_lbSceneSignatureValid = false;
+    }
+
+    // 4. シーンカット監視 (停止中・バックオフ中のみ)
+    const bool watchSceneCut = m_lbShutdown || (m_lbIntervalMs > kTransformLetterboxCheckIntervalMs);
+    if (!watchSceneCut || !pSrcData) {
+        m_lbSceneSignatureValid = false;
+    } else if (DetectSceneCut(pSrcData, actualDataLength, srcWidth, srcHeight, srcStride, srcBitCount)) {
+        PostLetterboxCommand(LB_CMD_NEW_SCENE);
+        RestartLetterboxSchedule(now);
+    }
+
+    if (m_lbShutdown) {
+        return false;
+    }
+
+    // 5. 実行間隔の判定
+    if (now - m_lastLBRequestTime < m_lbIntervalMs) {
+        return false;
+    }
+    m_lastLBRequestTime = now;
+
+    // 次回の間隔
+    if (now - m_lbPhaseStartTime < kTransformLetterboxDensePhaseMs) {
+        m_lbIntervalMs = kTransformLetterboxDenseIntervalMs;
+    } else if (stable) {
+        m_lbIntervalMs = max(m_lbIntervalMs * 2, kTransformLetterboxCheckIntervalMs);
+        if (m_lbIntervalMs > kTransformLetterboxMaxIntervalMs) m_lbIntervalMs = kTransformLetterboxMaxIntervalMs;
+    } else {
+        m_lbIntervalMs = kTransformLetterboxCheckIntervalMs;
+    }
+    return true;
+}
+
+void LR2BGATransformLogic::RestartLetterboxSchedule(DWORD now) {
+    m_lbScheduleStarted = true;
+    m_lbShutdown = false;
+    m_lbSceneSignatureValid = false;
+    m_lbPhaseStartTime = now;
+    m_lbIntervalMs = kTransformLetterboxDenseIntervalMs;
+    m_lastLBRequestTime = now - kTransformLetterboxDenseIntervalMs; // 即時に要求する
+}
+
+void LR2BGATransformLogic::PostLetterboxCommand(LetterboxCommand command) {
+    m_lbEpoch++;
+    std::lock_guard<std::mutex> lock(m_mtxLBControl);
+    // 未適用のリセットはシーン切替で上書きしない
+    if (m_lbCommand != LB_CMD_RESET) {
+        m_lbCommand = command;
+    }
+    m_lbCommandEpoch = m_lbEpoch;
+}
+
+void LR2BGATransformLogic::PostLetterboxParams(const LetterboxParams& params) {
+    {
+        std::lock_guard<std::mutex> lock(m_mtxLBControl);
+        m_lbPendingParams = params;
+        m_lbParamsPending = true;
+    }
+    // 閾値が変わると除外ラッチや安定化の途中経過は意味を失うため、リセットして密な解析から始め直す
+    ResetLetterboxState();
+}
+
+bool LR2BGATransformLogic::DetectSceneCut(const BYTE* pSrcData, long actualDataLength,
+                                          int srcWidth, int srcHeight, int srcStride, int srcBitCount) {
+    LONG absSrcStride = std::abs(srcStride);
+    size_t calcSize = (size_t)absSrcStride * srcHeight;
+    size_t safeSize = (actualDataLength > 0 && (size_t)actualDataLength < calcSize) ? (size_t)actualDataLength : calcSize;
+
+    BYTE signature[kSceneSignatureSize];
+    LR2BGALetterboxDetector::ComputeSceneSignature(pSrcData, safeSize, srcWidth, srcHeight,
+                                                   absSrcStride, srcBitCount, signature);
+
+    bool isCut = m_lbSceneSignatureValid &&
+                 LR2BGALetterboxDetector::CompareSceneSignature(signature, m_lbSceneSignature) >= kTransformSceneCutThreshold;
+
+    CopyMemory(m_lbSceneSignature, signature, kSceneSignatureSize);
+    m_lbSceneSignatureValid = true;
+    return isCut;
 }
 
 // ------------------------------------------------------------------------------
 // Helper: ProcessLetterboxDetection - 黒帯検出ロジックの実装
 //
 // 役割:
-//   入力フレームの一部（または全体）を解析用バッファにコピーし、別スレッドでの解析を依頼します。
+//   入力フレームから解析用の輝度サムネイルを生成し、別スレッドでの解析を依頼します。
 //   また、現在の検出状態（m_currentLBMode）に基づいて、切り出し範囲（Source Rect）を調整します。
 //
 // 処理の詳細:
-//   1. 頻度制御: 負荷軽減のため、約200msごとに1回のみ解析をリクエストします。
-//   2. バッファコピー: ワーカースレッドが安全に参照できるようにデータをコピーします。
-//   3. モード反映: 検出されたレターボックスモード（16:9, 4:3等）に従い、srcRectの上下を削ります。
+//   1. 頻度制御: 適応スケジューラ (ScheduleLetterboxAnalysis) が要求タイミングを決定します。
+//   2. サムネイル生成: サンプリング対象行のみを輝度化して受け渡します (フルフレームのコピーは行わない)。
+//   3. 範囲反映: 検出された切り出し範囲（上下/左右の黒帯を除いた矩形）を srcRect に設定します。
 //
 // 引数:
 //   pSrcData         : 入力画像のデータポインタ
@@ -219,62 +485,94 @@ void LR2BGATransformLogic::LetterboxThreadProc() {
 //   srcRect          : 修正される矩形構造体 (参照)
 //   pSrcRect         : 修正された場合にセットされるポインタ (参照)
 // ------------------------------------------------------------------------------
-void LR2BGATransformLogic::ProcessLetterboxDetection(const BYTE* pSrcData, long actualDataLength,
+void LR2BGATransformLogic::ProcessLetterboxDetection(const LR2BGASettings::Snapshot& cfg,
+                                                     const BYTE* pSrcData, long actualDataLength,
                                                      int srcWidth, int srcHeight, int srcStride, int srcBitCount,
                                                      RECT& srcRect, RECT*& pSrcRect) {
-    if (!m_pSettings->m_autoRemoveLetterbox) {
+    if (!cfg.autoRemoveLetterbox) {
         return;
     }
 
-    // 頻度制限
-    DWORD now = GetTickCount();
-    if (now - m_lastLBRequestTime < kTransformLetterboxCheckIntervalMs) {
-        // Skip
-    } else {
-        m_lastLBRequestTime = now;
-        LONG absSrcStride = std::abs(srcStride);
-        int calcSize = absSrcStride * srcHeight;
-        int safeSize = (actualDataLength > 0 && actualDataLength < calcSize) ? (int)actualDataLength : calcSize;
-
-        if (pSrcData && safeSize > 0) {
-            {
-                std::lock_guard<std::mutex> lock(m_mtxLBBuffer);
-                if (m_lbBuffer.size() < (size_t)safeSize) {
-                    m_lbBuffer.resize(safeSize);
-                }
-                CopyMemory(m_lbBuffer.data(), pSrcData, safeSize);
-                m_lbWidth = srcWidth;
-                m_lbHeight = srcHeight;
-                m_lbStride = absSrcStride;
-                m_lbBpp = srcBitCount;
-            }
-            {
-                std::lock_guard<std::mutex> lock(m_mtxLBControl);
-                m_bLBRequest = true;
-                m_cvLB.notify_one();
-            }
+    // 検出パラメータの変更 (設定の世代が変わったフレームでのみ比較する)
+    // 検出器は検出スレッドが使用しているため、UIスレッドからは直接変更しない
+    if (cfg.version != m_lbParamsVersion) {
+        m_lbParamsVersion = cfg.version;
+        if (cfg.lbThreshold != m_lbParams.threshold || cfg.lbStability != m_lbParams.stability) {
+            m_lbParams.threshold = cfg.lbThreshold;
+            m_lbParams.stability = cfg.lbStability;
+            PostLetterboxParams(m_lbParams);
+        }
+    }
+
+    // 頻度制御 (適応スケジューラ)
+    // 時刻は FPS制限と同じ時刻源のミリ秒 (DWORD の周回は差分で扱う)
+    DWORD now = (DWORD)(m_pacer.Now() / 10000);
+    if (ScheduleLetterboxAnalysis(pSrcData, actualDataLength, srcWidth, srcHeight, srcStride, srcBitCount, now) &&
+        pSrcData) {
+        // 投入はトレースに残す (STAGE_LETTERBOX はフレームごとのため、検出の頻度はこちらで見る)
+        LR2BGATrace& trace = LR2BGATrace::Instance();
+        LARGE_INTEGER submitStart = {}, submitEnd = {};
+        if (trace.IsEnabled()) QueryPerformanceCounter(&submitStart);
+        SubmitLetterboxThumbnail(pSrcData, actualDataLength, srcWidth, srcHeight, srcStride, srcBitCount);
+        if (trace.IsEnabled()) {
+            QueryPerformanceCounter(&submitEnd);
+            trace.Record(TRACE_LETTERBOX_SUBMIT, submitStart.QuadPart, submitEnd.QuadPart,
+                         0, (int)m_lbIntervalMs, m_lbSynchronous ? 1 : 0);
         }
     }
 
     // 結果適用
     LetterboxMode mode;
+    RECT rect;
     {
         std::lock_guard<std::mutex> lock(m_mtxLBMode);
         mode = m_currentLBMode;
+        rect = m_currentLBRect;
     }
 
-    if (mode != LB_MODE_ORIGINAL) {
-        float targetAspect = (mode == LB_MODE_16_9) ? (16.0f / 9.0f) : (4.0f / 3.0f);
-        LONG targetH = (LONG)(srcWidth / targetAspect);
-        LONG barH = (srcHeight - targetH) / 2;
-        if (barH > 0) {
-            srcRect.top = barH;
-            srcRect.bottom = srcHeight - barH;
-            pSrcRect = &srcRect;
-        }
+    // 解像度変更直後の古い結果 (範囲外) は適用しない
+    if (mode != LB_MODE_ORIGINAL &&
+        rect.left >= 0 && rect.top >= 0 && rect.right <= srcWidth && rect.bottom <= srcHeight &&
+        rect.right > rect.left && rect.bottom > rect.top) {
+        srcRect = rect;
+        pSrcRect = &srcRect;
     }
 }
 
+// ------------------------------------------------------------------------------
+// 動画キャッシュ連携
+//
+// Seed: 前回再生時の確定結果を、現在の世代の「安定した結果」として公開します。
+//   最初のフレームから切り出しが適用され、黒帯なしで確定済みなら解析自体を行いません。
+//   以後の解析で範囲外にコンテンツが見つかれば、通常どおり範囲が拡大されます。
+// ------------------------------------------------------------------------------
+void LR2BGATransformLogic::SeedLetterboxResult(LetterboxMode mode, const RECT& rect,
+                                               int srcWidth, int srcHeight) {
+    m_lbDetector.Seed(mode, rect, srcWidth, srcHeight);
+    m_lbLastWidth = srcWidth;
+    m_lbLastHeight = srcHeight;
+    m_lbSeeded = true;
+
+    std::lock_guard<std::mutex> lock(m_mtxLBMode);
+    m_currentLBMode = m_lbDetector.GetCurrentMode();
+    m_currentLBRect = m_lbDetector.GetCurrentRect();
+    m_lbResultStable = true;
+    m_lbResultRejected = m_lbDetector.IsFullyRejected();
+    m_lbResultEpoch = m_lbEpoch;
+}
+
+bool LR2BGATransformLogic::GetConfirmedLetterboxResult(LetterboxMode& mode, RECT& rect) {
+    std::lock_guard<std::mutex> lock(m_mtxLBMode);
+    if (m_lbResultEpoch != m_lbEpoch) return false;
+    // 黒帯なしは除外ラッチがフレーム全体に達した場合のみ確定とする
+    // (解析前・暗転中の LB_MODE_ORIGINAL を保存しないため)
+    if (!m_lbResultStable) return false;
+    if (m_currentLBMode == LB_MODE_ORIGINAL && !m_lbResultRejected) return false;
+    mode = m_currentLBMode;
+    rect = m_currentLBRect;
+    return true;
+}
+
 LetterboxMode LR2BGATransformLogic::GetCurrentLetterboxMode() const {
     // m_mtxLBMode は mutable 宣言されているため、const メソッド内でもロック可能
     std::lock_guard<std::mutex> lock(m_mtxLBMode);
@@ -286,22 +584,30 @@ LetterboxMode LR2BGATransformLogic::GetCurrentLetterboxMode() const {
 //
 // 役割:
 //   設定された最大FPS (m_maxFPS) を超えないように制御します。
-//   入力タイムスタンプを壁時計へ同期し、グラフ進行を実時間へ合わせます。
-//   その上で、前回採用フレームとの差分に応じて超過分のみドロップします。
+//   入力タイムスタンプを壁時計 (QPC) へ同期し、グラフ進行を実時間へ合わせます。
+//   その上で、1/MaxFPS 間隔の目標ケイデンス (グリッド) に対して出力するフレームを選びます。
+//
+// 時刻と待機:
+//   LR2BGAFramePacer (QPC + 高分解能タイマー + 最後の0.5msのスピン) を使用します。
+//   GetTickCount64 / Sleep の約15.6ms分解能では 60fps (16.67ms) の判定が揺れるためです。
 //
 // 戻り値:
 //   S_OK    : 処理続行 (FPS制限内、または制限なし)
 //   S_FALSE : フレームスキップ (FPS制限によりドロップすべき)
 // ------------------------------------------------------------------------------
-HRESULT LR2BGATransformLogic::WaitFPSLimit(REFERENCE_TIME rtStart, REFERENCE_TIME rtEnd) {
-    if (!m_pSettings->m_limitFPSEnabled || m_pSettings->m_maxFPS <= 0) {
+HRESULT LR2BGATransformLogic::WaitFPSLimit(const LR2BGASettings::Snapshot& cfg,
+                                           REFERENCE_TIME rtStart, REFERENCE_TIME rtEnd) {
+    m_latenessValid = false;
+    if (!cfg.limitFPSEnabled || cfg.maxFPS <= 0) {
+        // 制限なしでも出力間隔は集計する
+        m_pacer.RecordOutput(m_pacer.Now(), 0);
         return S_OK;
     }
 
-    const REFERENCE_TIME minInterval = 10000000LL / m_pSettings->m_maxFPS;
+    const REFERENCE_TIME minInterval = 10000000LL / cfg.maxFPS;
     const bool hasValidTimestamp = (rtStart >= 0) && (rtEnd > rtStart);
     const bool isMonotonic = (m_lastOutputTime <= 0) || (rtStart >= m_lastOutputTime);
-    REFERENCE_TIME nowWallclock = (REFERENCE_TIME)GetTickCount64() * 10000;
+    REFERENCE_TIME nowWallclock = m_pacer.Now();
 
     // タイムライン同期:
     // 有効タイムスタンプ入力では、最初の入力時刻を基準に壁時計へ同期する。
@@ -314,60 +620,144 @@ HRESULT LR2BGATransformLogic::WaitFPSLimit(REFERENCE_TIME rtStart, REFERENCE_TIM
 
         const REFERENCE_TIME desiredWallclock =
             m_timelineBaseWallclockTime + (rtStart - m_timelineBaseInputTime);
+        m_lastLateness = nowWallclock - desiredWallclock;
+        m_latenessValid = true;
         if (desiredWallclock > nowWallclock) {
-            const REFERENCE_TIME remain = desiredWallclock - nowWallclock;
-            DWORD waitMs = (DWORD)(remain / 10000);
-            if (waitMs > 0) {
-                if (waitMs > kTransformMaxSleepMs) {
-                    waitMs = kTransformMaxSleepMs;
-                }
-                Sleep(waitMs);
-                nowWallclock = (REFERENCE_TIME)GetTickCount64() * 10000;
-            }
+            m_pacer.WaitUntil(desiredWallclock, (REFERENCE_TIME)kTransformMaxSleepMs * 10000);
+            nowWallclock = m_pacer.Now();
         }
     }
 
     // 基本は入力タイムスタンプ基準。無効/非単調な場合のみ壁時計へフォールバックする。
     if (hasValidTimestamp && isMonotonic) {
-        if (m_lastOutputTime > 0) {
-            const REFERENCE_TIME tsDelta = rtStart - m_lastOutputTime;
-            if (tsDelta < minInterval) {
-                m_droppedFrames++;
-                return S_FALSE; // Skip
-            }
+        bool accept;
+        if (m_srcFrameInterval > 0) {
+            // 入力のフレーム間隔が分かっている場合は間引きパターンを計画して選ぶ
+            accept = AcceptOnSourceCadence(rtStart, minInterval);
+        } else {
+            // 予定時刻に最も近いフレームを選ぶため、フレーム長の半分手前から受け付ける
+            REFERENCE_TIME tolerance = (rtEnd - rtStart) / 2;
+            if (tolerance > minInterval / 2) tolerance = minInterval / 2;
+            accept = AcceptOnCadence(rtStart, minInterval, tolerance, m_nextDueTime);
         }
-
-        if (m_lastOutputWallclockTime > 0) {
-            const REFERENCE_TIME wcDelta = nowWallclock - m_lastOutputWallclockTime;
-            if (wcDelta < minInterval) {
-                m_droppedFrames++;
-                return S_FALSE; // Skip
-            }
+        if (!accept) {
+            m_droppedFrames++;
+            return S_FALSE; // Skip
         }
-
         m_lastOutputTime = rtStart;
-        m_lastOutputWallclockTime = nowWallclock;
-        return S_OK;
-    }
-
-    // 無効タイムスタンプ時は、壁時計のみでFPS制限を適用
-    if (!m_loggedTimestampFallback && m_pSettings && m_pSettings->m_debugMode) {
-        OutputDebugStringA("[LR2BGAFilter] WaitFPSLimit fallback to wallclock (invalid/non-monotonic input timestamp)\n");
-        m_loggedTimestampFallback = true;
-    }
-
-    if (m_lastOutputWallclockTime > 0) {
-        const REFERENCE_TIME delta = nowWallclock - m_lastOutputWallclockTime;
-        if (delta < minInterval) {
+        m_nextDueWallclock = 0;
+    } else {
+        m_cadenceTarget = 0;  // タイムスタンプが戻ったら計画をやり直す
+        // 無効タイムスタンプ時は、壁時計のみでFPS制限を適用
+        if (!m_loggedTimestampFallback && cfg.debugMode) {
+            OutputDebugStringA("[LR2BGAFilter] WaitFPSLimit fallback to wallclock (invalid/non-monotonic input timestamp)\n");
+            m_loggedTimestampFallback = true;
+        }
+        if (!AcceptOnCadence(nowWallclock, minInterval, minInterval / 4, m_nextDueWallclock)) {
             m_droppedFrames++;
             return S_FALSE; // Skip
         }
+        m_nextDueTime = 0;
     }
 
-    m_lastOutputWallclockTime = nowWallclock;
+    m_pacer.RecordOutput(nowWallclock, minInterval);
     return S_OK;
 }
 
+// ------------------------------------------------------------------------------
+// Helper: AcceptOnCadence - 目標ケイデンスによる採否判定
+// 予定時刻 nextDue を interval ずつ進めるため、入力と上限が整数倍の関係でなくても
+// 平均の出力レートは上限に一致し、直前フレームとの差分で判定するより間隔が揃う。
+// 予定時刻の tolerance 手前から受け付ける。1間隔以上遅れた場合 (一時停止・シーク) は
+// グリッドを合わせ直す (遅れた分をまとめて出力しない)。
+// ------------------------------------------------------------------------------
+bool LR2BGATransformLogic::AcceptOnCadence(REFERENCE_TIME t, REFERENCE_TIME interval,
+                                           REFERENCE_TIME tolerance, REFERENCE_TIME& nextDue) {
+    if (nextDue != 0 && t < nextDue - tolerance) {
+        return false;
+    }
+    if (nextDue == 0 || t - nextDue >= interval) {
+        nextDue = t + interval;
+    } else {
+        nextDue += interval;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------------
+// Helper: AcceptOnSourceCadence - ケイデンス計画による採否判定
+//
+// 入力フレーム番号 n = (rtStart - base) / AvgTimePerFrame (四捨五入) と、
+// 目標間隔の出力枠 k (理想の出力時刻 k x targetInterval) を対応させる。
+// 各出力枠には理想の時刻に最も近い入力フレーム CadenceSlotFrame(k) を割り当てるため、
+// 59.94→30 は1枚おき、50→30 は5枚中3枚 (0, 2, 3, 5, 7, 8, ... 枚目。間隔 2-1-2) のように、
+// 変換比から決まる
+// 最も均等なパターンになる (Bresenham と同じ誤差累積)。
+// タイムスタンプの揺らぎは四捨五入で吸収し、直前フレームとの差分には依存しない。
+//
+// 上流が飛ばした (品質制御など) フレームに割り当てた出力枠は、次に届いたフレームで埋め、
+// 取りこぼした枠は数えて飛ばす (間引きが二重にかかって出力レートが下がらないように)。
+// 入力が目標より遅い場合は全フレームを出力する。
+// ------------------------------------------------------------------------------
+bool LR2BGATransformLogic::AcceptOnSourceCadence(REFERENCE_TIME rtStart, REFERENCE_TIME targetInterval) {
+    const REFERENCE_TIME src = m_srcFrameInterval;
+    if (src >= targetInterval) {
+        m_cadenceTarget = 0;
+        return true;
+    }
+    if (m_cadenceResetRequested.exchange(false)) {
+        m_cadenceOutputs = 0;
+        m_cadenceMissedSlots = 0;
+        m_cadenceErrSumSq = 0.0;
+        m_cadenceErrMax = 0.0;
+    }
+    // 目標の変更・巻き戻し・1秒以上の飛び (シーク、一時停止) では現在のフレームから計画し直す
+    if (m_cadenceTarget != targetInterval || rtStart < m_cadenceBase ||
+        (m_cadenceLastIndex >= 0 &&
+         rtStart - (m_cadenceBase + m_cadenceLastIndex * src) >= (REFERENCE_TIME)kTransformMaxSleepMs * 10000)) {
+        ResetCadencePlan(rtStart, targetInterval);
+    }
+
+    const LONGLONG n = (rtStart - m_cadenceBase + src / 2) / src;
+    if (n <= m_cadenceLastIndex || n < CadenceSlotFrame(m_cadenceNextSlot)) {
+        return false;
+    }
+
+    // このフレームが埋める出力枠 (入力フレームが n 以下に割り当てられた最後の枠) を求める
+    LONGLONG next = ((n + 1) * src - src / 2) / targetInterval;
+    if (next < m_cadenceNextSlot) next = m_cadenceNextSlot;
+    while (CadenceSlotFrame(next) <= n) next++;
+    const LONGLONG served = next - 1;
+
+    const double errMs = ((rtStart - m_cadenceBase) - served * targetInterval) / 10000.0;
+    m_cadenceErrSumSq += errMs * errMs;
+    if (fabs(errMs) > m_cadenceErrMax) m_cadenceErrMax = fabs(errMs);
+    m_cadenceOutputs++;
+    m_cadenceMissedSlots += served - m_cadenceNextSlot;
+
+    m_cadenceNextSlot = next;
+    m_cadenceLastIndex = n;
+    return true;
+}
+
+void LR2BGATransformLogic::ResetCadencePlan(REFERENCE_TIME base, REFERENCE_TIME targetInterval) {
+    m_cadenceTarget = targetInterval;
+    m_cadenceBase = base;
+    m_cadenceNextSlot = 0;
+    m_cadenceLastIndex = -1;
+}
+
+void LR2BGATransformLogic::GetCadenceInfo(CadenceInfo& out) const {
+    out = CadenceInfo();
+    out.active = (m_cadenceTarget > 0);
+    if (m_srcFrameInterval > 0) out.sourceFps = 10000000.0 / m_srcFrameInterval;
+    if (m_cadenceTarget > 0) out.targetFps = 10000000.0 / m_cadenceTarget;
+    out.outputs = m_cadenceOutputs;
+    out.missedSlots = m_cadenceMissedSlots;
+    out.rmsErrorMs = (m_cadenceOutputs > 0) ? sqrt(m_cadenceErrSumSq / m_cadenceOutputs) : 0.0;
+    out.maxErrorMs = m_cadenceErrMax;
+}
+
 // ------------------------------------------------------------------------------
 // Helper: FillOutputBuffer - 出力バッファへの描画処理
 //
@@ -385,17 +775,21 @@ HRESULT LR2BGATransformLogic::WaitFPSLimit(REFERENCE_TIME rtStart, REFERENCE_TIM
 //   4. 明るさ調整: LR2用の明度設定を適用。
 //
 // 引数:
+//   cfg                 : フレームの設定スナップショット（アルゴリズム、アスペクト比、明るさ）
 //   pSrcData / pDstData : 入出力バッファポインタ
 //   srcWidth...dstStride: 入出力の画像パラメータ
 //   pSrcRect            : 切り出し範囲（nullptrの場合は全体）
 //   rtStart / rtEnd     : タイムスタンプ参照（更新用）
 //   pOut                : 出力サンプル（データ長設定用）
+//   pExtraTarget        : 追加の出力先（外部ウィンドウ用。リサイズ時のみ使用）
 // ------------------------------------------------------------------------------
-HRESULT LR2BGATransformLogic::FillOutputBuffer(const BYTE* pSrcData, BYTE* pDstData,
+HRESULT LR2BGATransformLogic::FillOutputBuffer(const LR2BGASettings::Snapshot& cfg,
+                                               const BYTE* pSrcData, BYTE* pDstData,
                                                int srcWidth, int srcHeight, int srcStride, int srcBitCount,
                                                int dstWidth, int dstHeight, int dstStride, const RECT* pSrcRect,
                                                REFERENCE_TIME& rtStart, REFERENCE_TIME& rtEnd,
-                                               long& outActualDataLength) {
+                                               long& outActualDataLength,
+                                               const LR2BGAImageProc::ResizeTarget* pExtraTarget) {
     // -------------------------------------------------------------------------
     // ダミーモード処理
     // 入力がない場合（1x1黒画像）、一度だけ黒フレームを出力してスキップ
@@ -409,23 +803,33 @@ HRESULT LR2BGATransformLogic::FillOutputBuffer(const BYTE* pSrcData, BYTE* pDstD
             return S_OK;
         } else {
             // 2フレーム目以降はスキップ（プレゼンテーション時間だけ待機）
+            // 外部ウィンドウ無効時はフィルタが1フレーム目の後にストリームを終えるため、ここには来ない
             DWORD waitMs = 0;
             if (rtEnd > rtStart) waitMs = (DWORD)((rtEnd - rtStart) / 10000);
-            if (waitMs > 0 && waitMs < kTransformMaxSleepMs) Sleep(waitMs);
+            if (waitMs > 0 && waitMs < kTransformMaxSleepMs) {
+                m_pacer.WaitUntil(m_pacer.Now() + (REFERENCE_TIME)waitMs * 10000,
+                                  (REFERENCE_TIME)kTransformMaxSleepMs * 10000);
+            }
             return S_FALSE;
         }
     }
 
+    LARGE_INTEGER fillStart;
+    QueryPerformanceCounter(&fillStart);
+
     // -------------------------------------------------------------------------
     // パススルー判定
     // m_activePassthrough は StartStreaming でラッチ済み
     // -------------------------------------------------------------------------
     bool isPassthrough = m_activePassthrough;
+    int traceKernel = TRACE_KERNEL_COPY;   // トレースに記録するカーネルと出力の有効行数
+    int traceRows = 0;
 
     if (isPassthrough) {
         // パススルー時も出力バッファサイズを超えないように制限
         int copyHeight = (srcHeight < dstHeight) ? srcHeight : dstHeight;
         int copyWidth = (srcWidth < dstWidth) ? srcWidth : dstWidth;
+        traceRows = copyHeight;
         
         if (srcBitCount == 32) {
              for (int y = 0; y < copyHeight; y++) {
@@ -460,14 +864,35 @@ HRESULT LR2BGATransformLogic::FillOutputBuffer(const BYTE* pSrcData, BYTE* pDstD
         int actualW, actualH, offX, offY;
         LR2BGAImageProc::CalculateResizeDimensions(
             effectiveSrcW, effectiveSrcH, dstWidth, dstHeight,
-            (m_pSettings->m_keepAspectRatio != FALSE), 
+            cfg.keepAspectRatio,
             actualW, actualH, offX, offY);
 
         if (actualW < dstWidth || actualH < dstHeight) {
             ZeroMemory(pDstData, dstStride * dstHeight);
         }
-
-        if (m_pSettings->m_resizeAlgo == RESIZE_NEAREST) {
+        traceRows = actualH;
+        traceKernel = pExtraTarget ? TRACE_KERNEL_MULTI
+                    : (cfg.resizeAlgo == RESIZE_NEAREST) ? TRACE_KERNEL_NEAREST : TRACE_KERNEL_BILINEAR;
+
+        if (pExtraTarget) {
+            // 外部ウィンドウ用フレームも同じソース走査で生成する
+            LR2BGAImageProc::ResizeTarget targets[2];
+            targets[0].pDst = pDstData;
+            targets[0].dstWidth = dstWidth;
+            targets[0].dstHeight = dstHeight;
+            targets[0].dstStride = dstStride;
+            targets[0].actualWidth = actualW;
+            targets[0].actualHeight = actualH;
+            targets[0].offsetX = offX;
+            targets[0].offsetY = offY;
+            targets[0].bilinear = (cfg.resizeAlgo != RESIZE_NEAREST);
+            targets[0].pCache = &m_multiCache;
+            targets[1] = *pExtraTarget;
+
+            LR2BGAImageProc::ResizeMulti(
+                pSrcData, srcWidth, srcHeight, srcStride, srcBitCount,
+                pSrcRect, targets, 2);
+        } else if (cfg.resizeAlgo == RESIZE_NEAREST) {
             LR2BGAImageProc::ResizeNearestNeighbor(
                 pSrcData, srcWidth, srcHeight, srcStride, srcBitCount, pDstData,
                 dstWidth, dstHeight, dstStride, 24, actualW, actualH, offX, offY,
@@ -480,9 +905,16 @@ HRESULT LR2BGATransformLogic::FillOutputBuffer(const BYTE* pSrcData, BYTE* pDstD
         }
     }
 
+    LARGE_INTEGER resizeEnd;
+    QueryPerformanceCounter(&resizeEnd);
+    m_stageStats.Record(STAGE_RESIZE, fillStart.QuadPart, resizeEnd.QuadPart, 0, traceKernel, traceRows);
+
     // Brightness
-    if (m_pSettings->m_brightnessLR2 < 100) {
-        LR2BGAImageProc::ApplyBrightness(pDstData, dstWidth, dstHeight, dstStride, (int)m_pSettings->m_brightnessLR2);
+    if (cfg.brightnessLR2 < 100) {
+        LR2BGAImageProc::ApplyBrightness(pDstData, dstWidth, dstHeight, dstStride, cfg.brightnessLR2);
+        LARGE_INTEGER brightnessEnd;
+        QueryPerformanceCounter(&brightnessEnd);
+        m_stageStats.Record(STAGE_BRIGHTNESS, resizeEnd.QuadPart, brightnessEnd.QuadPart, 0, cfg.brightnessLR2);
     }
 
     outActualDataLength = dstStride * dstHeight;
@@ -491,4 +923,7 @@ HRESULT LR2BGATransformLogic::FillOutputBuffer(const BYTE* pSrcData, BYTE* pDstD
 
 void LR2BGATransformLogic::ResetStatistics() {
     m_droppedFrames = 0;
+    m_pacer.RequestReset();
+    m_cadenceResetRequested = true;
+    m_stageStats.RequestReset();
 }
@@ -21,9 +21,13 @@
 #include <vector>
 #include <mutex>
 #include <thread>
+#include <atomic>
 #include <condition_variable>
 
 #include "LR2BGALetterboxDetector.h"
+#include "LR2BGAFramePacer.h"
+#include "LR2BGAStageStats.h"
+#include "LR2BGAImageProc.h"
 #include "LR2BGASettings.h"
 #include "LR2BGATypes.h"
 
@@ -33,7 +37,11 @@ class LR2BGAWindow;
 //------------------------------------------------------------------------------
 // 定数定義 (Constants)
 //------------------------------------------------------------------------------
-constexpr DWORD kTransformLetterboxCheckIntervalMs = 200;  // 黒帯検出の実行間隔
+constexpr DWORD kTransformLetterboxCheckIntervalMs = 200;  // 黒帯検出の基本実行間隔
+constexpr DWORD kTransformLetterboxDenseIntervalMs = 50;   // ストリーム開始直後の実行間隔
+constexpr DWORD kTransformLetterboxDensePhaseMs = 1000;    // 密な解析を行う期間
+constexpr DWORD kTransformLetterboxMaxIntervalMs = 3200;   // 判定安定時のバックオフ上限
+constexpr int kTransformSceneCutThreshold = 40;            // シーンカット判定 (シグネチャの平均輝度差)
 constexpr DWORD kTransformMaxSleepMs = 1000;               // FPS制限時の最大スリープ時間
 
 //------------------------------------------------------------------------------
@@ -47,11 +55,15 @@ public:
     //--------------------------------------------------------------------------
     // 初期化・終了
     //--------------------------------------------------------------------------
-    // ストリーミング開始時に呼び出す (設定のラッチ)
-    void StartStreaming(int inputWidth, int inputHeight, int inputBitCount,
-                        int outputWidth, int outputHeight);
+    // ストリーミング開始時に呼び出す (cfg: 呼び出し側が開始時に取得した設定スナップショット。値をラッチする)
+    // srcFrameInterval: 入力の AvgTimePerFrame (0: 不明。FPS制限のケイデンス計画に使用)
+    void StartStreaming(const LR2BGASettings::Snapshot& cfg, int inputWidth, int inputHeight, int inputBitCount,
+                        int outputWidth, int outputHeight, REFERENCE_TIME srcFrameInterval);
     // ストリーミング終了時に呼び出す
     void StopStreaming();
+    // 時刻源の差し替え (FPS制限・黒帯検出のスケジューラ・ダミー出力の待機。NULL: QPC)
+    // オフライン再生用。ストリーミング開始前に呼ぶ
+    void SetClock(LR2BGAClock* pClock) { m_pacer.SetClock(pClock); }
 
     //--------------------------------------------------------------------------
     // レターボックス検出
@@ -60,17 +72,27 @@ public:
     void StartLetterboxThread();
     // 検出スレッドを停止
     void StopLetterboxThread();
+    // 検出スレッドを使わず、サムネイルの投函時に呼び出し元のスレッドで解析する
+    // (オフライン再生で結果をフレームに対して決定的にするため。検出スレッドの開始前に呼ぶ)
+    void SetSynchronousLetterbox(bool synchronous) { m_lbSynchronous = synchronous; }
     // レターボックス状態をリセット
     void ResetLetterboxState();
     // ダミー送信フラグをリセット
     void ResetDummySent() { m_dummySent = false; }
 
     // フレームを解析してソース矩形を調整
-    void ProcessLetterboxDetection(const BYTE* pSrcData, long actualDataLength,
+    // (以下のフレームごとの処理は、呼び出し側が Receive の先頭で取得した設定スナップショットを受け取る)
+    void ProcessLetterboxDetection(const LR2BGASettings::Snapshot& cfg,
+                                   const BYTE* pSrcData, long actualDataLength,
                                    int srcWidth, int srcHeight, int srcStride, int srcBitCount,
                                    RECT& srcRect, RECT*& pSrcRect);
     // 現在の検出モードを取得
     LetterboxMode GetCurrentLetterboxMode() const;
+    // キャッシュ済みの検出結果を適用 (StartStreaming 後、検出スレッド開始前に呼び出す)
+    void SeedLetterboxResult(LetterboxMode mode, const RECT& rect, int srcWidth, int srcHeight);
+    // 確定した検出結果を取得 (キャッシュ保存用、検出スレッド停止後に呼び出す)
+    // 未確定 (安定前、または黒帯なしの確定前) の場合は false を返す
+    bool GetConfirmedLetterboxResult(LetterboxMode& mode, RECT& rect);
     // 検出器への直接アクセス (デバッグ情報取得用)
     LR2BGALetterboxDetector& GetDetector() { return m_lbDetector; }
 
@@ -78,28 +100,94 @@ public:
     // FPS制限
     //--------------------------------------------------------------------------
     // フレームをスキップすべきか判定 (S_OK=続行, S_FALSE=スキップ)
-    HRESULT WaitFPSLimit(REFERENCE_TIME rtStart, REFERENCE_TIME rtEnd);
+    HRESULT WaitFPSLimit(const LR2BGASettings::Snapshot& cfg, REFERENCE_TIME rtStart, REFERENCE_TIME rtEnd);
+    // 直前の WaitFPSLimit で測った遅れ (壁時計 - タイムライン上の予定時刻、正なら遅延)
+    // FPS制限が無効、またはタイムスタンプが無効だったフレームでは false を返す
+    bool GetTimelineLateness(REFERENCE_TIME& late) const {
+        late = m_lastLateness;
+        return m_latenessValid;
+    }
 
     //--------------------------------------------------------------------------
     // フレーム変換
     //--------------------------------------------------------------------------
     // 入力バッファを変換して出力バッファへ書き込み
+    // pExtraTarget を指定した場合、リサイズ時に同じソース走査で追加の出力先も生成する (ResizeMulti)
     // 戻り値: S_OK=成功, S_FALSE=スキップ
-    HRESULT FillOutputBuffer(const BYTE* pSrcData, BYTE* pDstData,
+    HRESULT FillOutputBuffer(const LR2BGASettings::Snapshot& cfg,
+                             const BYTE* pSrcData, BYTE* pDstData,
                              int srcWidth, int srcHeight, int srcStride, int srcBitCount,
                              int dstWidth, int dstHeight, int dstStride, const RECT* pSrcRect,
                              REFERENCE_TIME& rtStart, REFERENCE_TIME& rtEnd,
-                             long& outActualDataLength);
+                             long& outActualDataLength,
+                             const LR2BGAImageProc::ResizeTarget* pExtraTarget = NULL);
+    // FillOutputBuffer がリサイズ出力を行うモードか (ダミー/パススルー以外)
+    // true の場合のみ pExtraTarget が使用される
+    bool IsResizeOutputActive() const { return !m_activeDummy && !m_activePassthrough; }
+    // FillOutputBuffer が入力をそのままコピーするモードか (ダミー以外のパススルー)
+    bool IsPassthroughActive() const { return !m_activeDummy && m_activePassthrough; }
+    // ダミー出力モードか (設定、または入力サイズ不正によるフェイルセーフ)
+    bool IsDummyActive() const { return m_activeDummy; }
 
     //--------------------------------------------------------------------------
     // 統計情報
     //--------------------------------------------------------------------------
     LONGLONG GetDroppedFrames() const { return m_droppedFrames; }
+    // 出力を許可したフレームの間隔 (ストリーミングスレッドから呼ぶ)
+    void GetFrameIntervalHistogram(FrameIntervalHistogram& out) const { m_pacer.GetHistogram(out); }
+    // FPS変換のケイデンス (ストリーミングスレッドから呼ぶ)
+    void GetCadenceInfo(CadenceInfo& out) const;
+    // 処理段階ごとの所要時間と実測出力フレームレート (記録はストリーミングスレッド、取得は任意のスレッド)
+    LR2BGAStageStats& GetStageStats() { return m_stageStats; }
+    const LR2BGAStageStats& GetStageStats() const { return m_stageStats; }
     void ResetStatistics();
 
 private:
     // レターボックス検出スレッド本体
     void LetterboxThreadProc();
+    // 輝度サムネイルを生成して検出スレッドへ受け渡す
+    void SubmitLetterboxThumbnail(const BYTE* pSrcData, long actualDataLength,
+                                  int srcWidth, int srcHeight, int srcStride, int srcBitCount);
+
+    // 検出スレッドへのコマンド (次回の解析前に適用される)
+    enum LetterboxCommand {
+        LB_CMD_NONE = 0,
+        LB_CMD_RESET,      // 検出器の完全リセット (設定変更・解像度変更)
+        LB_CMD_NEW_SCENE   // シーンカット (除外ラッチのみクリア)
+    };
+    // 検出器のパラメータ (設定スナップショットの黒閾値・安定化フレーム数)
+    struct LetterboxParams {
+        int threshold;
+        int stability;
+    };
+
+    // 適応スケジューラ: このフレームで解析を要求すべきか判定する
+    bool ScheduleLetterboxAnalysis(const BYTE* pSrcData, long actualDataLength,
+                                   int srcWidth, int srcHeight, int srcStride, int srcBitCount,
+                                   DWORD now);
+    // 密な解析フェーズから再開する
+    void RestartLetterboxSchedule(DWORD now);
+    // 検出スレッドへコマンドを送る (世代を進める)
+    void PostLetterboxCommand(LetterboxCommand command);
+    // 検出スレッドへパラメータの変更を送る (リセットと同時に適用される)
+    void PostLetterboxParams(const LetterboxParams& params);
+    // コマンドを適用してサムネイルを解析し、結果を公開する (検出スレッド、または同期モードの投函元)
+    // pParams: 未適用のパラメータ変更 (NULL: なし)
+    void AnalyzeLetterboxThumbnail(int index, LetterboxCommand command, unsigned int epoch,
+                                   const LetterboxParams* pParams);
+    // 前フレームからのシーンカットを検出する
+    bool DetectSceneCut(const BYTE* pSrcData, long actualDataLength,
+                        int srcWidth, int srcHeight, int srcStride, int srcBitCount);
+    // FPS制限: 目標ケイデンスのグリッドに対する採否判定
+    static bool AcceptOnCadence(REFERENCE_TIME t, REFERENCE_TIME interval,
+                                REFERENCE_TIME tolerance, REFERENCE_TIME& nextDue);
+    // FPS制限: 入力の AvgTimePerFrame に基づく間引きパターン (誤差累積) による採否判定
+    bool AcceptOnSourceCadence(REFERENCE_TIME rtStart, REFERENCE_TIME targetInterval);
+    // ケイデンス計画: 出力枠 slot に最も近い入力フレーム番号
+    LONGLONG CadenceSlotFrame(LONGLONG slot) const {
+        return (slot * m_cadenceTarget + m_srcFrameInterval / 2) / m_srcFrameInterval;
+    }
+    void ResetCadencePlan(REFERENCE_TIME base, REFERENCE_TIME targetInterval);
 
     //--------------------------------------------------------------------------
     // メンバ変数
@@ -110,32 +198,78 @@ private:
     // レターボックス検出
     LR2BGALetterboxDetector m_lbDetector;
     mutable std::mutex m_mtxLBMode;  // mutable: const メソッドからのロック取得を許可
-    std::mutex m_mtxLBBuffer;
     LetterboxMode m_currentLBMode;
+    RECT m_currentLBRect;            // 確定した切り出し範囲 (m_currentLBMode != ORIGINAL の場合のみ有効)
 
     // 非同期検出スレッド
     std::thread m_threadLB;
     std::condition_variable m_cvLB;
-    std::mutex m_mtxLBControl;
+    std::mutex m_mtxLBControl;  // 以下の制御フラグとサムネイルのインデックスを保護
     bool m_bLBExit;
     bool m_bLBRequest;
+    bool m_lbSynchronous;            // 検出スレッドを使わない (SetSynchronousLetterbox)
+
+    // 検出用輝度サムネイル (ダブルバッファ)
+    // 変換スレッドは解析中でない側へロックを持たずに書き込み、
+    // 書き込み完了後に m_mtxLBControl 下でインデックスのみを公開する。
+    LetterboxThumbnail m_lbThumbs[2];
+    int m_lbFrontIndex;      // 最新の公開済みサムネイル
+    int m_lbAnalyzingIndex;  // 検出スレッドが解析中のサムネイル (-1: なし)
+    LetterboxCommand m_lbCommand;     // 未適用のコマンド
+    unsigned int m_lbCommandEpoch;    // 最後に送ったコマンドの世代
+    LetterboxParams m_lbPendingParams; // 未適用のパラメータ (m_lbParamsPending が true の間有効)
+    bool m_lbParamsPending;
 
-    // 検出用フレームバッファ
-    std::vector<BYTE> m_lbBuffer;
-    LONG m_lbWidth;
-    LONG m_lbHeight;
-    LONG m_lbStride;
-    int m_lbBpp;
+    // 検出結果 (m_mtxLBMode 下、m_currentLBMode と同時に更新)
+    bool m_lbResultStable;            // 判定が安定している
+    bool m_lbResultRejected;          // 黒帯なしで確定済み
+    unsigned int m_lbResultEpoch;     // 結果を得た時点の世代
+
+    // 適応スケジューラ (変換スレッドのみが操作)
+    // ストリーム開始直後は密に解析し、判定が安定したら間隔を指数的に延ばす。
+    // 黒帯なしで確定した後はスナップショットを止め、解像度変更かシーンカットでのみ再開する。
     DWORD m_lastLBRequestTime;
+    DWORD m_lbPhaseStartTime;         // 密な解析フェーズの開始時刻
+    DWORD m_lbIntervalMs;             // 現在の解析間隔
+    bool m_lbScheduleStarted;
+    bool m_lbSeeded;                  // キャッシュ済みの結果から開始した (密な解析を省略)
+    bool m_lbShutdown;                // 解析停止中
+    unsigned int m_lbEpoch;           // 検出器のリセット/シーン切替の世代
+    int m_lbLastWidth;
+    int m_lbLastHeight;
+    BYTE m_lbSceneSignature[kSceneSignatureSize];
+    bool m_lbSceneSignatureValid;
+    std::atomic<bool> m_lbResetPending; // ResetLetterboxState (UIスレッド) からの要求
+    LetterboxParams m_lbParams;       // 検出器へ送ったパラメータ
+    unsigned m_lbParamsVersion;       // m_lbParams を比較した設定の世代
 
     // FPS制限
+    LR2BGAFramePacer m_pacer;
     REFERENCE_TIME m_lastOutputTime;
-    REFERENCE_TIME m_lastOutputWallclockTime;
+    REFERENCE_TIME m_nextDueTime;      // 次の出力予定 (入力タイムスタンプ基準、0: 未設定)
+    REFERENCE_TIME m_nextDueWallclock; // 次の出力予定 (壁時計基準、タイムスタンプ無効時)
+
+    // ケイデンス計画 (入力フレーム番号 n と出力枠 k の対応。ストリーミングスレッドのみが操作)
+    REFERENCE_TIME m_srcFrameInterval; // 入力の AvgTimePerFrame (0: 不明、グリッド判定を使用)
+    REFERENCE_TIME m_cadenceTarget;    // 計画中の出力間隔 (0: 計画なし)
+    REFERENCE_TIME m_cadenceBase;      // 入力フレーム番号0のタイムスタンプ
+    LONGLONG m_cadenceNextSlot;        // 次に埋める出力枠
+    LONGLONG m_cadenceLastIndex;       // 直前に出力した入力フレーム番号
+    LONGLONG m_cadenceOutputs;
+    LONGLONG m_cadenceMissedSlots;
+    double m_cadenceErrSumSq;          // 理想の出力時刻との差 (ms) の二乗和
+    double m_cadenceErrMax;
+    std::atomic<bool> m_cadenceResetRequested; // ResetStatistics (UIスレッド) からの要求
     REFERENCE_TIME m_timelineBaseInputTime;
     REFERENCE_TIME m_timelineBaseWallclockTime;
     LONGLONG m_droppedFrames;
     bool m_timelineBaseInitialized;
     bool m_loggedTimestampFallback;
+    REFERENCE_TIME m_lastLateness;    // 上流への品質制御用 (待機前の遅れ)
+    bool m_latenessValid;
+
+    // 処理段階ごとの所要時間 (FillOutputBuffer のリサイズ/明るさ調整はここで、それ以外はフィルタが記録)
+    LR2BGAStageStats m_stageStats;
 
     // ダミーモード状態
     bool m_dummySent;
@@ -150,4 +284,5 @@ private:
     // リサイズ用LUTバッファ
     std::vector<int> m_lutXIndices;
     std::vector<short> m_lutXWeights;
+    LR2BGAImageProc::ResizeCache m_multiCache;  // ResizeMulti 時の LR2 出力用
 };
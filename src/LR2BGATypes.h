@@ -29,4 +29,113 @@ enum ResizeAlgorithm {
     // Future: RESIZE_BICUBIC, RESIZE_LANCZOS などが必要であればここに追加
 };
 
+//------------------------------------------------------------------------------
+// LR2向け出力の受け渡し統計 (Output Delivery Statistics)
+// デバッグ表示用。ストリーミングスレッドで集計したものをスナップショットとして渡します。
+//------------------------------------------------------------------------------
+struct OutputDeliveryInfo {
+    int bufferCount;        // アロケータが実際に確保した出力バッファ数
+    bool pipelined;         // 専用スレッド (COutputQueue) 経由で受け渡し中か
+    long long samples;      // 集計対象の受け渡し回数
+    double avgDeliverMs;    // Deliver の平均所要時間 (同期時はLR2側の受け取り処理を含む)
+    double maxDeliverMs;
+    double avgBufferWaitMs; // 空き出力バッファの待ち時間 (全バッファが下流に保持されている間の停滞)
+    double maxBufferWaitMs;
+    double avgQueueDepth;   // 投函直後のキュー内サンプル数 (同期時は常に0)
+    int maxQueueDepth;
+    bool zeroCopy;          // 入力サンプルをそのまま渡すゼロコピー経路が有効か
+    long long zeroCopySamples; // ゼロコピーで渡したフレーム数
+};
+
+//------------------------------------------------------------------------------
+// 上流への品質制御の状態 (Upstream Quality Control Information)
+// デバッグ表示用。IQualityControl::Notify で上流へ送った要求と、その効果の集計です。
+//------------------------------------------------------------------------------
+struct UpstreamQualityInfo {
+    int proportion;         // 最後に送った Proportion (1000: 通常レート、未送信時も1000)
+    bool famine;            // 最後に送った種別が Famine (false: Flood)
+    double lateMs;          // 最後に送った遅れ (正なら遅延)
+    long long messagesSent; // 送信回数
+    HRESULT lastResult;     // 最後の送信結果 (上流が品質制御に対応していなければ失敗)
+    long long upstreamSkipped; // 提案レートを下げている間に上流が飛ばしたフレーム数 (タイムスタンプの間隔から推定)
+};
+
+//------------------------------------------------------------------------------
+// 入力アロケータの状態 (Input Allocator Information)
+// デバッグ表示用。上流が採用したアロケータと、受信サンプルのメモリ境界の集計です。
+//------------------------------------------------------------------------------
+struct InputAllocatorInfo {
+    bool connected;         // NotifyAllocator を受け取ったか
+    bool ownAllocator;      // フィルタ提供のアロケータ (64バイト境界) が採用されたか
+    long cBuffers;
+    long cbBuffer;
+    long cbAlign;
+    long cbPrefix;
+    long long alignedSamples; // 先頭が64バイト境界だったサンプル数
+    long long totalSamples;
+    bool strideAligned;       // 行ストライドが64バイトの倍数か (メディアタイプで決まる)
+};
+
+//------------------------------------------------------------------------------
+// 出力フレーム間隔のヒストグラム (Frame Interval Histogram)
+// FPS制限 (LR2BGAFramePacer) が出力を許可したフレームの間隔を 0.5ms 刻みで集計します。
+// 最後のバケットは上限超過分 (一時停止やシーク直後の長い間隔) です。
+//------------------------------------------------------------------------------
+constexpr int kFrameIntervalBucketCount = 101;        // 0.5ms x 100 + 超過
+constexpr double kFrameIntervalBucketMs = 0.5;
 
+struct FrameIntervalHistogram {
+    long long counts[kFrameIntervalBucketCount];
+    long long samples;      // 集計した間隔の数
+    double sumMs;           // 平均・標準偏差用
+    double sumSqMs;
+    double minMs;
+    double maxMs;
+    double targetMs;        // FPS制限の目標間隔 (0: 制限なし)
+    bool highResolution;    // 高分解能タイマーで待機しているか (false: 従来精度のタイマー)
+};
+
+//------------------------------------------------------------------------------
+// FPS変換のケイデンス (Cadence Information)
+// デバッグ表示用。入力の AvgTimePerFrame と FPS制限から決めた間引きパターンに対し、
+// 実際に出力したフレームが理想の出力時刻からどれだけずれたかを集計します。
+//------------------------------------------------------------------------------
+struct CadenceInfo {
+    bool active;            // ケイデンス計画で間引き中 (false: 間引き不要、または入力間隔が不明)
+    double sourceFps;       // 入力のフレームレート (AvgTimePerFrame)
+    double targetFps;       // FPS制限の目標
+    long long outputs;      // 集計した出力フレーム数
+    long long missedSlots;  // 該当する入力フレームが届かなかった出力枠 (上流のスキップ等)
+    double rmsErrorMs;      // 理想の出力時刻との差の二乗平均平方根
+    double maxErrorMs;      // 同、絶対値の最大
+};
+
+//------------------------------------------------------------------------------
+// 処理段階 (Processing Stages)
+// 段階ごとの所要時間 (LR2BGAStageStats) の集計単位です。
+// ILR2BGAFilterStats::GetStageLatency の引数にもなるため、値は変更せず末尾に追加すること。
+//------------------------------------------------------------------------------
+enum LR2BGAStage {
+    STAGE_FPS_WAIT = 0,     // FPS制限の判定と待機 (WaitFPSLimit)
+    STAGE_LETTERBOX,        // 黒帯検出の投函と結果の反映 (ProcessLetterboxDetection)
+    STAGE_EXT_WINDOW,       // 外部ウィンドウへのフレーム投函 (行コピー、または同時リサイズの準備)
+    STAGE_RESIZE,           // LR2向け出力の生成 (リサイズ/パススルーのコピー。同時リサイズ分を含む)
+    STAGE_BRIGHTNESS,       // LR2向け出力の明るさ調整
+    STAGE_DELIVER,          // 下流への受け渡し (Deliver)
+    STAGE_TOTAL,            // フレーム処理全体 (FPS制限の待機と受け渡しを除く)
+    STAGE_COUNT
+};
+
+//------------------------------------------------------------------------------
+// 処理段階の所要時間 (Stage Latency)
+// 対数バケットのヒストグラム (LR2BGALatencyHistogram) から求めた統計です。
+// パーセンタイルはバケットの上端の値のため、実測値より最大 1/8 大きく出ます。
+//------------------------------------------------------------------------------
+struct LR2BGAStageLatency {
+    LONGLONG samples;       // 集計したフレーム数
+    double meanMs;
+    double p50Ms;
+    double p95Ms;
+    double p99Ms;
+    double maxMs;
+};
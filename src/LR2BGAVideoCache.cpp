@@ -0,0 +1,165 @@
+﻿#include "LR2BGAVideoCache.h"
+#include <vector>
+#include <algorithm>
+#include <cwctype>
+
+//------------------------------------------------------------------------------
+// 定数定義 (Constants)
+//------------------------------------------------------------------------------
+static const wchar_t* kVideoCacheKey = L"Software\\LR2BGAFilter\\VideoCache";
+constexpr DWORD kVideoCacheVersion = 1;     // 保存形式のバージョン (変更時は旧エントリを無視)
+constexpr DWORD kVideoCacheMaxEntries = 512; // 保持するエントリ数の上限
+
+// レジストリに保存するバイナリ形式
+// 値名はハッシュのため、衝突に備えてサイズ・更新日時も保存して照合する
+#pragma pack(push, 4)
+struct VideoCacheRecord {
+    DWORD version;
+    ULONGLONG fileSize;
+    ULONGLONG lastWriteTime;
+    ULONGLONG lastUsedTime;   // 最後に使用した日時 (FILETIME、削除順の判定用)
+    LONG width;
+    LONG height;
+    LONGLONG avgTimePerFrame;
+    LONG lbThreshold;
+    LONG lbMode;
+    RECT cropRect;
+};
+#pragma pack(pop)
+
+bool VideoFileIdentity::QueryFileAttributes() {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (path.empty() || !GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+        return false;
+    }
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+        return false;
+    }
+    size = ((ULONGLONG)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    lastWriteTime = ((ULONGLONG)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+// ------------------------------------------------------------------------------
+// 値名の生成
+// パス (大文字小文字を区別しない) とサイズ・更新日時の FNV-1a 64bit ハッシュです。
+// ------------------------------------------------------------------------------
+void LR2BGAVideoCache::MakeValueName(const VideoFileIdentity& id, wchar_t* name, size_t nameSize) {
+    ULONGLONG hash = 14695981039346656037ULL;
+    auto mix = [&hash](ULONGLONG value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+    };
+    for (wchar_t ch : id.path) {
+        mix((ULONGLONG)towlower(ch), 2);
+    }
+    mix(id.size, 8);
+    mix(id.lastWriteTime, 8);
+    swprintf_s(name, nameSize, L"%016llX", hash);
+}
+
+bool LR2BGAVideoCache::Lookup(const VideoFileIdentity& id, VideoCacheEntry& entry) {
+    if (id.path.empty()) return false;
+
+    wchar_t name[32];
+    MakeValueName(id, name, _countof(name));
+
+    HKEY hKey;
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, kVideoCacheKey, 0, KEY_READ, &hKey) != ERROR_SUCCESS) {
+        return false;
+    }
+
+    VideoCacheRecord record;
+    DWORD type = 0;
+    DWORD size = sizeof(record);
+    LONG result = RegQueryValueExW(hKey, name, NULL, &type, (LPBYTE)&record, &size);
+    RegCloseKey(hKey);
+
+    if (result != ERROR_SUCCESS || type != REG_BINARY || size != sizeof(record)) return false;
+    if (record.version != kVideoCacheVersion) return false;
+    if (record.fileSize != id.size || record.lastWriteTime != id.lastWriteTime) return false;
+
+    entry.width = record.width;
+    entry.height = record.height;
+    entry.avgTimePerFrame = record.avgTimePerFrame;
+    entry.lbThreshold = record.lbThreshold;
+    entry.lbMode = record.lbMode;
+    entry.cropRect = record.cropRect;
+    return true;
+}
+
+void LR2BGAVideoCache::Store(const VideoFileIdentity& id, const VideoCacheEntry& entry) {
+    if (id.path.empty()) return;
+
+    wchar_t name[32];
+    MakeValueName(id, name, _countof(name));
+
+    VideoCacheRecord record = {};
+    record.version = kVideoCacheVersion;
+    record.fileSize = id.size;
+    record.lastWriteTime = id.lastWriteTime;
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    record.lastUsedTime = ((ULONGLONG)now.dwHighDateTime << 32) | now.dwLowDateTime;
+    record.width = entry.width;
+    record.height = entry.height;
+    record.avgTimePerFrame = entry.avgTimePerFrame;
+    record.lbThreshold = entry.lbThreshold;
+    record.lbMode = entry.lbMode;
+    record.cropRect = entry.cropRect;
+
+    HKEY hKey;
+    if (RegCreateKeyExW(HKEY_CURRENT_USER, kVideoCacheKey, 0, NULL, 0, KEY_READ | KEY_WRITE, NULL, &hKey, NULL) != ERROR_SUCCESS) {
+        return;
+    }
+    RegSetValueExW(hKey, name, 0, REG_BINARY, (const BYTE*)&record, sizeof(record));
+    Evict(hKey);
+    RegCloseKey(hKey);
+}
+
+// ------------------------------------------------------------------------------
+// 古いエントリの削除
+// 上限を超えている場合のみ全エントリを列挙し、最後に使用した日時が古い順に削除します。
+// ------------------------------------------------------------------------------
+void LR2BGAVideoCache::Evict(HKEY hKey) {
+    DWORD valueCount = 0;
+    if (RegQueryInfoKeyW(hKey, NULL, NULL, NULL, NULL, NULL, NULL, &valueCount, NULL, NULL, NULL, NULL) != ERROR_SUCCESS) {
+        return;
+    }
+    if (valueCount <= kVideoCacheMaxEntries) return;
+
+    struct Item {
+        std::wstring name;
+        ULONGLONG lastUsed;
+    };
+    std::vector<Item> items;
+    try {
+        items.reserve(valueCount);
+        for (DWORD i = 0;; i++) {
+            wchar_t name[64];
+            DWORD nameLen = _countof(name);
+            VideoCacheRecord record;
+            DWORD size = sizeof(record);
+            DWORD type = 0;
+            LONG result = RegEnumValueW(hKey, i, name, &nameLen, NULL, &type, (LPBYTE)&record, &size);
+            if (result == ERROR_NO_MORE_ITEMS) break;
+            if (result != ERROR_SUCCESS && result != ERROR_MORE_DATA) continue;
+            // 形式の異なるエントリは最優先で削除する
+            bool valid = (result == ERROR_SUCCESS && type == REG_BINARY && size == sizeof(record) &&
+                          record.version == kVideoCacheVersion);
+            items.push_back({ name, valid ? record.lastUsedTime : 0 });
+        }
+    } catch (...) {
+        return;
+    }
+
+    if (items.size() <= kVideoCacheMaxEntries) return;
+    size_t removeCount = items.size() - kVideoCacheMaxEntries;
+    std::partial_sort(items.begin(), items.begin() + removeCount, items.end(),
+                      [](const Item& a, const Item& b) { return a.lastUsed < b.lastUsed; });
+    for (size_t i = 0; i < removeCount; i++) {
+        RegDeleteValueW(hKey, items[i].name.c_str());
+    }
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <windows.h>
+#include <string>
+
+//------------------------------------------------------------------------------
+// 動画ファイルの識別情報 (Video File Identity)
+// 上流のソースフィルタ (IFileSourceFilter) から取得したパスと、ファイルのサイズ・更新日時です。
+// 同じパスでも内容が差し替えられた場合は別の動画として扱います。
+//------------------------------------------------------------------------------
+struct VideoFileIdentity {
+    std::wstring path;
+    ULONGLONG size = 0;
+    ULONGLONG lastWriteTime = 0; // FILETIME (100ns単位)
+
+    // パスからファイルのサイズ・更新日時を取得します
+    bool QueryFileAttributes();
+};
+
+//------------------------------------------------------------------------------
+// キャッシュエントリ (Video Cache Entry)
+// 前回再生時の最終的な解析結果です。
+//------------------------------------------------------------------------------
+struct VideoCacheEntry {
+    LONG width = 0;                  // 入力解像度 (一致しない場合は無効)
+    LONG height = 0;
+    LONGLONG avgTimePerFrame = 0;    // 入力フレーム間隔 (100ns単位、0は不明)
+    int lbThreshold = 0;             // 解析時の黒閾値 (設定変更時は無効)
+    int lbMode = 0;                  // LetterboxMode
+    RECT cropRect = {};              // 切り出し範囲 (lbMode != LB_MODE_ORIGINAL の場合)
+};
+
+//------------------------------------------------------------------------------
+// LR2BGAVideoCache
+//
+// 動画ごとの黒帯検出結果とフォーマットを永続化するキャッシュです。
+// 同じBGAを再生したときに、最初のフレームから正しい切り出し範囲を適用するために使用します。
+//
+// 保存先:
+//   HKCU\Software\LR2BGAFilter\VideoCache (設定と同じく、再生時のファイルIOを避けるためレジストリ)
+//   値名はファイル識別情報のハッシュ、データはバイナリのエントリです。
+//   エントリ数が上限を超えた場合は、最後に使用した日時が古いものから削除します。
+//
+// 呼び出し:
+//   Lookup は StartStreaming、Store は Stop (StopStreaming で確定したエントリを、ロックの解放後に)
+//   から呼び出します (フレーム処理中には触れない)。
+//------------------------------------------------------------------------------
+class LR2BGAVideoCache {
+public:
+    // キャッシュを検索します (見つからない、または形式が異なる場合は false)
+    bool Lookup(const VideoFileIdentity& id, VideoCacheEntry& entry);
+
+    // キャッシュへ保存します (上限を超えた場合は古いエントリを削除)
+    void Store(const VideoFileIdentity& id, const VideoCacheEntry& entry);
+
+private:
+    // 値名 (識別情報の64bitハッシュ) を生成します
+    static void MakeValueName(const VideoFileIdentity& id, wchar_t* name, size_t nameSize);
+
+    // 上限を超えたエントリを削除します
+    static void Evict(HKEY hKey);
+};
@@ -2,6 +2,7 @@
 #include <windows.h>
 #include <commctrl.h>
 #include <shellapi.h>
+#include <dwmapi.h>
 
 //------------------------------------------------------------------------------
 // LR2BGAWindow.cpp
@@ -24,9 +25,11 @@
 //   - 描画処理は GDI (Graphics Device Interface) を使用して行われます。
 //------------------------------------------------------------------------------
 #include "resource.h"
+#include "LR2BGATrace.h"
 #include <tlhelp32.h>
 #include <tchar.h>
 #include <stdio.h>
+#include <math.h>
 
 static const wchar_t* EXT_WND_CLASS = L"LR2BGAFilterExtWnd";
 static const wchar_t* OVERLAY_WND_CLASS = L"LR2BGAFilterOverlayWnd";
@@ -41,6 +44,11 @@ extern HINSTANCE g_hInst;  // LR2BGAFilter.cpp で定義
 constexpr DWORD kInputMonitorIntervalMs = 50;   // 入力監視のポーリング間隔 (ms)
 constexpr DWORD kFocusRestoreDelayMs = 100;     // フォーカス復帰待機時間 (ms)
 constexpr int kDebugWindowButtonMargin = 50;    // デバッグウィンドウのボタン領域高さ (px)
+constexpr UINT_PTR kExtVisibilityTimerId = 1;   // 外部ウィンドウの可視判定タイマーID
+constexpr UINT kExtVisibilityIntervalMs = 250;  // 他のウィンドウによる遮蔽の再判定間隔 (ms)
+constexpr UINT_PTR kDebugRefreshTimerId = 1;    // デバッグ表示の更新タイマーID
+constexpr UINT kDebugRefreshIntervalMs = 250;   // デバッグ表示の更新間隔 (ms)
+constexpr int kDebugSaveTraceButtonId = 102;    // 「Save Trace」ボタンID (101: Copy Info)
 
 // Defined in LR2BGAFilter.h/cpp, but we declare it here to avoid circular include issues
 EXTERN_C const GUID CLSID_LR2BGAFilterPropertyPage;
@@ -53,6 +61,11 @@ LR2BGAWindow::LR2BGAWindow(LR2BGASettings* pSettings)
     , m_hBtnSettings(NULL)
     , m_pRenderer(std::make_unique<LR2BGAExternalRenderer>(pSettings))
     , m_pFilterUnk(NULL)
+    , m_graphTopologyChanged(false)
+    , m_debugStats()
+    , m_debugStatsWriteIndex(0)
+    , m_debugStatsDisplayIndex(2)
+    , m_debugStatsReady(1)
 {
     // Mutexes don't need explicit initialization
     m_debugText[0] = L'\0';
@@ -238,6 +251,9 @@ void LR2BGAWindow::UpdateOverlayWindow()
     }
 }
 
+// 外部ウィンドウへのフレーム投函
+// ストリーミングスレッドから呼ばれ、Renderer のメールボックスへコピーするのみで即座に戻ります。
+// リサイズと提示は Renderer の描画スレッドで非同期に行われます。
 void LR2BGAWindow::UpdateExternalWindow(const BYTE* pSrcData, int srcWidth, int srcHeight, int srcStride, int srcBitCount, const RECT* pSrcRect)
 {
     if (m_pRenderer) {
@@ -245,6 +261,25 @@ void LR2BGAWindow::UpdateExternalWindow(const BYTE* pSrcData, int srcWidth, int
     }
 }
 
+bool LR2BGAWindow::BeginExternalPresizedFrame(int cropWidth, int cropHeight, LR2BGAImageProc::ResizeTarget& target)
+{
+    if (!m_pRenderer) return false;
+    return m_pRenderer->BeginPresizedFrame(m_hExtWnd, cropWidth, cropHeight, target);
+}
+
+void LR2BGAWindow::CommitExternalPresizedFrame(LONGLONG resizeQpc, int sharedPixels)
+{
+    if (m_pRenderer) {
+        m_pRenderer->CommitPresizedFrame(resizeQpc, sharedPixels);
+    }
+}
+
+bool LR2BGAWindow::IsExternalFrameDue()
+{
+    if (!m_pRenderer) return false;
+    return m_pRenderer->IsFrameDue(m_hExtWnd);
+}
+
 // 外部ウィンドウの位置・サイズ・最前面設定を更新
 void LR2BGAWindow::UpdateExternalWindowPos()
 {
@@ -419,9 +454,25 @@ LRESULT CALLBACK LR2BGAWindow::ExtWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, L
                         rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, 
                         SWP_NOACTIVATE | SWP_NOOWNERZORDER | SWP_NOZORDER);
                 }
+
+                // 表示/非表示・最小化/復元・移動・Zオーダー変更はすべてここを通るため、可視状態を更新する
+                pWindow->UpdateExtWindowVisibility(hwnd);
             }
             return 0;
 
+        case WM_TIMER:
+            // 他のウィンドウの移動による遮蔽の変化は通知されないため、定期的に判定し直す
+            if (wParam == kExtVisibilityTimerId) {
+                pWindow->UpdateExtWindowVisibility(hwnd);
+                return 0;
+            }
+            break;
+
+        case WM_DISPLAYCHANGE:
+            // モニター構成の変更で画面外になった/戻った場合
+            pWindow->UpdateExtWindowVisibility(hwnd);
+            break;
+
         case WM_CLOSE:
             DestroyWindow(hwnd);
             return 0;
@@ -477,6 +528,27 @@ void LR2BGAWindow::ShowDebugWindow()
 void LR2BGAWindow::FormatExtWindowInfo(wchar_t* buffer, size_t size)
 {
     if (m_pSettings->m_extWindowEnabled) {
+        wchar_t maxFPSStr[32];
+        if (m_pSettings->m_extWindowMaxFPS > 0) {
+            swprintf_s(maxFPSStr, sizeof(maxFPSStr)/sizeof(wchar_t), L"%d fps", m_pSettings->m_extWindowMaxFPS);
+        } else {
+            wcscpy_s(maxFPSStr, sizeof(maxFPSStr)/sizeof(wchar_t), L"Uncapped");
+        }
+
+        // 画質ガバナーの状態 (描画スレッドが更新するアトミック値の参照のみ)
+        int qualityLevel = LR2BGAExternalRenderer::QUALITY_FULL;
+        double frameCostMs = 0.0;
+        if (m_pRenderer) {
+            qualityLevel = m_pRenderer->GetQualityLevel();
+            frameCostMs = m_pRenderer->GetFrameCostMs();
+        }
+        const bool visible = m_pRenderer ? m_pRenderer->IsVisible() : false;
+        const long long duplicates = m_pRenderer ? m_pRenderer->GetDuplicateCount() : 0;
+        const wchar_t* qualityStr = L"Full";
+        if (!m_pSettings->m_extWindowAdaptiveQuality) qualityStr = L"Full (Adaptive Off)";
+        else if (qualityLevel == LR2BGAExternalRenderer::QUALITY_NEAREST) qualityStr = L"Nearest (Adaptive)";
+        else if (qualityLevel == LR2BGAExternalRenderer::QUALITY_HALF) qualityStr = L"Half Res (Adaptive)";
+
         swprintf_s(buffer, size,
             L"Enabled\r\n"
             L"  Position: %d, %d\r\n"
@@ -485,14 +557,20 @@ void LR2BGAWindow::FormatExtWindowInfo(wchar_t* buffer, size_t size)
             L"  Algorithm: %s\r\n"
             L"  Keep Aspect: %s\r\n"
             L"  Passthrough: %s\r\n"
-            L"  Layer: %s",
+            L"  Layer: %s\r\n"
+            L"  Max FPS: %s\r\n"
+            L"  Quality: %s (%.2f ms/frame)\r\n"
+            L"  Visible: %s\r\n"
+            L"  Duplicates Skipped: %lld",
             m_pSettings->m_extWindowX, m_pSettings->m_extWindowY,
             m_pSettings->m_extWindowWidth, m_pSettings->m_extWindowHeight,
             m_pSettings->m_extWindowPassthrough ? L"Yes (Source Sync)" : L"No (Fixed Size)",
             m_pSettings->m_extWindowAlgo == RESIZE_NEAREST ? L"Nearest" : L"Bilinear",
             m_pSettings->m_extWindowKeepAspect ? L"Yes" : L"No",
             m_pSettings->m_extWindowPassthrough ? L"Yes" : L"No",
-            m_pSettings->m_extWindowTopmost ? L"Topmost" : L"Bottommost");
+            m_pSettings->m_extWindowTopmost ? L"Topmost" : L"Bottommost",
+            maxFPSStr, qualityStr, frameCostMs,
+            visible ? L"Yes" : L"No (Paused)", duplicates);
     } else {
         wcscpy_s(buffer, size, L"Disabled");
     }
@@ -507,6 +585,136 @@ void LR2BGAWindow::FormatFPSLimit(wchar_t* buffer, size_t size)
     }
 }
 
+void LR2BGAWindow::FormatInputAllocatorInfo(wchar_t* buffer, size_t size, const InputAllocatorInfo& info)
+{
+    if (!info.connected) {
+        wcscpy_s(buffer, size, L"  Input Allocator: None\r\n");
+        return;
+    }
+    const double alignedPct = info.totalSamples > 0
+        ? 100.0 * (double)info.alignedSamples / (double)info.totalSamples : 0.0;
+    swprintf_s(buffer, size,
+        L"  Input Allocator: %s (%ld x %ld B, align %ld)\r\n"
+        L"  Input Aligned: %.1f%% of %lld samples, Stride %s\r\n",
+        info.ownAllocator ? L"Filter" : L"Upstream",
+        info.cBuffers, info.cbBuffer, info.cbAlign,
+        alignedPct, info.totalSamples,
+        info.strideAligned ? L"64B multiple" : L"Unaligned");
+}
+
+void LR2BGAWindow::FormatOutputDeliveryInfo(wchar_t* buffer, size_t size, const OutputDeliveryInfo& info)
+{
+    // バッファ数はアロケータの確定値 (未接続時は0)、受け渡し方式は現在のストリーミングの実際の状態
+    swprintf_s(buffer, size,
+        L"  Buffers: %d (%s)\r\n"
+        L"  Deliver: avg %.2f ms / max %.2f ms\r\n"
+        L"  Buffer Wait: avg %.2f ms / max %.2f ms\r\n"
+        L"  Queue Depth: avg %.2f / max %d\r\n"
+        L"  Zero-Copy: %s (%lld frames)\r\n",
+        info.bufferCount, info.pipelined ? L"Pipelined" : L"Synchronous",
+        info.avgDeliverMs, info.maxDeliverMs,
+        info.avgBufferWaitMs, info.maxBufferWaitMs,
+        info.avgQueueDepth, info.maxQueueDepth,
+        info.zeroCopy ? L"Active" : L"Inactive", info.zeroCopySamples);
+}
+
+void LR2BGAWindow::FormatUpstreamQualityInfo(wchar_t* buffer, size_t size, const UpstreamQualityInfo& info)
+{
+    // 上流が IQualityControl に対応していない場合は送信結果が失敗になる
+    const wchar_t* result = L"None";
+    if (info.messagesSent > 0) {
+        result = SUCCEEDED(info.lastResult) ? L"Accepted" : L"Not Supported";
+    }
+    swprintf_s(buffer, size,
+        L"  Upstream QC: %s %d/1000, Late %.1f ms, Sent %lld (%s)\r\n"
+        L"  Upstream Skipped: %lld frames\r\n",
+        info.famine ? L"Famine" : L"Flood", info.proportion, info.lateMs,
+        info.messagesSent, result, info.upstreamSkipped);
+}
+
+void LR2BGAWindow::FormatFrameIntervalInfo(wchar_t* buffer, size_t size, const FrameIntervalHistogram& hist)
+{
+    const wchar_t* timer = hist.highResolution ? L"High-Resolution Timer" : L"Standard Timer";
+    if (hist.samples <= 0) {
+        swprintf_s(buffer, size, L"  Output Interval: N/A (%s)\r\n", timer);
+        return;
+    }
+
+    // パーセンタイルはバケットの上端 (0.5ms刻み) で表示する。超過バケットは上限値で代用
+    double pct[3] = {};
+    const double ratios[3] = {0.50, 0.95, 0.99};
+    for (int p = 0; p < 3; p++) {
+        const long long threshold = (long long)(hist.samples * ratios[p]);
+        long long cumulative = 0;
+        int b = 0;
+        for (; b < kFrameIntervalBucketCount - 1; b++) {
+            cumulative += hist.counts[b];
+            if (cumulative > threshold) break;
+        }
+        pct[p] = (b + 1) * kFrameIntervalBucketMs;
+    }
+
+    const double avg = hist.sumMs / hist.samples;
+    double variance = hist.sumSqMs / hist.samples - avg * avg;
+    if (variance < 0.0) variance = 0.0;
+
+    wchar_t targetStr[32];
+    if (hist.targetMs > 0.0) {
+        swprintf_s(targetStr, L"%.2f ms", hist.targetMs);
+    } else {
+        wcscpy_s(targetStr, L"None");
+    }
+    swprintf_s(buffer, size,
+        L"  Output Interval: avg %.2f ms (target %s), sd %.2f ms (%s)\r\n"
+        L"  Interval p50/p95/p99: %.1f / %.1f / %.1f ms, min %.2f / max %.2f ms\r\n",
+        avg, targetStr, sqrt(variance), timer,
+        pct[0], pct[1], pct[2], hist.minMs, hist.maxMs);
+}
+
+void LR2BGAWindow::FormatCadenceInfo(wchar_t* buffer, size_t size, const CadenceInfo& info)
+{
+    if (!info.active) {
+        // 入力間隔が不明 (グリッド判定) か、入力が目標以下で間引いていない
+        swprintf_s(buffer, size, L"  Cadence: Inactive (source %.2f fps)\r\n", info.sourceFps);
+        return;
+    }
+    swprintf_s(buffer, size,
+        L"  Cadence: %.2f -> %.2f fps, keep %.1f%%, missed slots %lld\r\n"
+        L"  Cadence Error: RMS %.2f ms / max %.2f ms (%lld frames)\r\n",
+        info.sourceFps, info.targetFps,
+        (info.sourceFps > 0.0) ? info.targetFps * 100.0 / info.sourceFps : 0.0,
+        info.missedSlots, info.rmsErrorMs, info.maxErrorMs, info.outputs);
+}
+
+//------------------------------------------------------------------------------
+// FormatStageLatencyInfo
+// 処理段階ごとの所要時間。パーセンタイルは対数バケットの上端のため実測より最大 1/8 大きい。
+//------------------------------------------------------------------------------
+void LR2BGAWindow::FormatStageLatencyInfo(wchar_t* buffer, size_t size, const LR2BGAStageLatency* stages)
+{
+    static const wchar_t* const kStageNames[STAGE_COUNT] = {
+        L"FPS Wait", L"Letterbox", L"Ext Window", L"Resize", L"Brightness", L"Deliver", L"Total"
+    };
+
+    swprintf_s(buffer, size,
+        L"[Stage Latency] (ms)\r\n"
+        L"  %-10s %7s %7s %7s %7s %8s\r\n",
+        L"Stage", L"avg", L"p50", L"p95", L"p99", L"max");
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const LR2BGAStageLatency& s = stages[i];
+        wchar_t line[128];
+        if (s.samples == 0) {
+            swprintf_s(line, sizeof(line)/sizeof(wchar_t), L"  %-10s       -\r\n", kStageNames[i]);
+        } else {
+            swprintf_s(line, sizeof(line)/sizeof(wchar_t), L"  %-10s %7.3f %7.3f %7.3f %7.3f %8.3f\r\n",
+                kStageNames[i], s.meanMs, s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs);
+        }
+        wcscat_s(buffer, size, line);
+    }
+    wcscat_s(buffer, size, L"\r\n");
+}
+
 void LR2BGAWindow::FormatInputStatus(wchar_t* gamePadStatus, size_t gamePadSize, wchar_t* keyStatus, size_t keySize)
 {
     // Gamepad Check
@@ -554,29 +762,30 @@ void LR2BGAWindow::FormatLetterboxInfo(wchar_t* buffer, size_t size, const Lette
             case 0: lbModeStr = L"Scanning (Original)"; break; // LB_MODE_ORIGINAL
             case 1: lbModeStr = L"16:9 Detected"; break;      // LB_MODE_16_9
             case 2: lbModeStr = L"4:3 Detected"; break;       // LB_MODE_4_3
+            case 3: lbModeStr = L"Custom Rect Detected"; break; // LB_MODE_CUSTOM
             default: lbModeStr = L"Unknown"; break;
         }
     }
 
     if (m_pSettings->m_autoRemoveLetterbox) {
+        const RECT& fr = lbInfo.frameRect;
+        const RECT& lr = lbInfo.latchedRect;
+        const RECT& cr = lbInfo.currentRect;
         swprintf_s(buffer, size,
             L"[Auto Letterbox Removal]\r\n"
-            L"  LB Mode: %s\r\n"
+            L"  LB Mode: %s%s\r\n"
             L"  Stability: %d / %d\r\n"
-            L"  Center Black: %s (%.1f%%)\r\n"
-            L"  16:9 Check: %s (Top: %.1f%%, Btm: %.1f%%)%s\r\n"
-            L"  4:3 Check: %s (Top: %.1f%%, Btm: %.1f%%)%s\r\n\r\n",
-            lbModeStr,
+            L"  Content Black: %s (%.1f%%)\r\n"
+            L"  Frame Content: %s (L:%d T:%d R:%d B:%d)\r\n"
+            L"  Latched Content: (L:%d T:%d R:%d B:%d)\r\n"
+            L"  Crop Rect: (L:%d T:%d R:%d B:%d)\r\n\r\n",
+            lbModeStr, lbInfo.bRejected ? L" [Rejected]" : L"",
             lbInfo.stabilityCounter, m_pSettings->m_lbStability, // Fixed denominator
             lbInfo.isCenterBlack ? L"Yes" : L"No", lbInfo.centerBlackRatio * 100.0f,
-            (lbInfo.ratio169Top < 0) ? L"Skipped" : (lbInfo.is169TopBlack && lbInfo.is169BottomBlack ? L"Yes" : L"No"),
-            (lbInfo.ratio169Top < 0) ? 0.0f : lbInfo.ratio169Top * 100.0f,
-            (lbInfo.ratio169Bottom < 0) ? 0.0f : lbInfo.ratio169Bottom * 100.0f,
-            lbInfo.bRejected169 ? L" [Rejected]" : L"",
-            (lbInfo.ratio43Top < 0) ? L"Skipped" : (lbInfo.is43TopBlack && lbInfo.is43BottomBlack ? L"Yes" : L"No"),
-            (lbInfo.ratio43Top < 0) ? 0.0f : lbInfo.ratio43Top * 100.0f,
-            (lbInfo.ratio43Bottom < 0) ? 0.0f : lbInfo.ratio43Bottom * 100.0f,
-            lbInfo.bRejected43 ? L" [Rejected]" : L""
+            lbInfo.hasContent ? L"Yes" : L"No (All Black)",
+            fr.left, fr.top, fr.right, fr.bottom,
+            lr.left, lr.top, lr.right, lr.bottom,
+            cr.left, cr.top, cr.right, cr.bottom
         ); 
     } else {
         swprintf_s(buffer, size,
@@ -586,28 +795,71 @@ void LR2BGAWindow::FormatLetterboxInfo(wchar_t* buffer, size_t size, const Lette
 }
 
 //------------------------------------------------------------------------------
-// UpdateDebugInfo
+// PublishDebugStats
+// 
+// 役割:
+//   ストリーミングスレッドからデバッグ統計を公開します。
+//   トリプルバッファの書き込み面へコピーし、受け渡し待ちの面と交換するだけで、
+//   ロックの取得・文字列フォーマット・描画要求は行いません。
+//   デバッグウィンドウのスレッドは kDebugRefreshIntervalMs ごとに最新の1件だけを取り出すため、
+//   表示が追い付かない間に公開された古い統計は上書きされます。
+//------------------------------------------------------------------------------
+void LR2BGAWindow::PublishDebugStats(const FilterDebugStats& stats)
+{
+    m_debugStats[m_debugStatsWriteIndex] = stats;
+    int prev = m_debugStatsReady.exchange(m_debugStatsWriteIndex | kDebugStatsFreshBit, std::memory_order_acq_rel);
+    m_debugStatsWriteIndex = prev & kDebugStatsIndexMask;
+}
+
+//------------------------------------------------------------------------------
+// SetGraphTopology
+// 
+// 役割:
+//   接続先のフィルタ名とフィルタグラフの構成を保持します。
+//   COM を介したグラフの走査はフィルタ側でピンの接続・切断時にだけ行い、
+//   フレームごとには行いません。
+//------------------------------------------------------------------------------
+void LR2BGAWindow::SetGraphTopology(const std::wstring& inputFilter, const std::wstring& outputFilter,
+                                    const std::wstring& filterGraphInfo)
+{
+    try {
+        std::lock_guard<std::mutex> lock(m_mtxDebug);
+        m_inputFilterName = inputFilter;
+        m_outputFilterName = outputFilter;
+        m_filterGraphInfo = filterGraphInfo;
+        m_graphTopologyChanged = true;
+    } catch (const std::bad_alloc&) {
+        // 表示用の情報のため、確保に失敗した場合は更新を諦める
+    }
+}
+
+//------------------------------------------------------------------------------
+// RefreshDebugText
 // 
 // 役割:
 //   デバッグウィンドウに表示するテキスト情報を更新します。
-//   フィルタ本体から呼び出され、各パラメータ（フィルタグラフ情報、解像度、FPS等）を受け取ります。
-//   
-// 注意:
-//   大量の文字列フォーマット処理を含むため、頻繁（毎フレームなど）に呼び出すと負荷になる可能性があります。
-//   現状はLR2BGAFilter::UpdateDebugInfoで制御されています。
+//   WM_TIMER からデバッグウィンドウのスレッドで呼ばれ、未表示の統計かグラフ構成の変更が
+//   あるときだけテキストを作り直して再描画を要求します。
 //------------------------------------------------------------------------------
-void LR2BGAWindow::UpdateDebugInfo(
-    const std::wstring& inputFilter, const std::wstring& outputFilter,
-    const std::wstring& filterGraphInfo,
-    int inputWidth, int inputHeight, int inputBitCount,
-    int outputWidth, int outputHeight,
-    double frameRate, double outputFrameRate,
-    long long frameCount, long long droppedFrames,
-    double avgTime,
-    const LetterboxDebugInfo& lbInfo)
+void LR2BGAWindow::RefreshDebugText()
 {
     if (!m_hDebugWnd || !IsWindow(m_hDebugWnd)) return;
-    
+
+    bool topologyChanged = m_graphTopologyChanged.exchange(false);
+    if (m_debugStatsReady.load(std::memory_order_acquire) & kDebugStatsFreshBit) {
+        int ready = m_debugStatsReady.exchange(m_debugStatsDisplayIndex, std::memory_order_acq_rel);
+        m_debugStatsDisplayIndex = ready & kDebugStatsIndexMask;
+    } else if (!topologyChanged) {
+        return;
+    }
+
+    const FilterDebugStats& stats = m_debugStats[m_debugStatsDisplayIndex];
+    const LetterboxDebugInfo& lbInfo = stats.lbInfo;
+    const InputAllocatorInfo& allocInfo = stats.allocInfo;
+    const OutputDeliveryInfo& deliveryInfo = stats.deliveryInfo;
+    const UpstreamQualityInfo& qualityInfo = stats.qualityInfo;
+    const FrameIntervalHistogram& intervalHist = stats.intervalHist;
+    const CadenceInfo& cadenceInfo = stats.cadenceInfo;
 
     {
        std::lock_guard<std::mutex> lock(m_mtxDebug);
@@ -625,14 +877,38 @@ void LR2BGAWindow::UpdateDebugInfo(
     wchar_t lbDetailStr[1024];
     FormatLetterboxInfo(lbDetailStr, sizeof(lbDetailStr)/sizeof(wchar_t), lbInfo);
 
+    wchar_t allocStr[256];
+    FormatInputAllocatorInfo(allocStr, sizeof(allocStr)/sizeof(wchar_t), allocInfo);
+
+    wchar_t deliveryStr[384];
+    FormatOutputDeliveryInfo(deliveryStr, sizeof(deliveryStr)/sizeof(wchar_t), deliveryInfo);
+
+    wchar_t qualityStr[256];
+    FormatUpstreamQualityInfo(qualityStr, sizeof(qualityStr)/sizeof(wchar_t), qualityInfo);
+
+    wchar_t intervalStr[384];
+    FormatFrameIntervalInfo(intervalStr, sizeof(intervalStr)/sizeof(wchar_t), intervalHist);
+
+    wchar_t cadenceStr[256];
+    FormatCadenceInfo(cadenceStr, sizeof(cadenceStr)/sizeof(wchar_t), cadenceInfo);
+
+    wchar_t stageStr[1024];
+    FormatStageLatencyInfo(stageStr, sizeof(stageStr)/sizeof(wchar_t), stats.stageLatency);
+
     // デバッグテキストの構築
     swprintf_s(m_debugText, sizeof(m_debugText)/sizeof(wchar_t),
         L"[LR2 Output]\r\n"
         L"  Input Size: %dx%d (%d bpp)\r\n"
+        L"%s"
         L"  Output Size: %dx%d\r\n"
         L"  FPS Limit: %s\r\n"
+        L"%s"
+        L"%s"
         L"  Keep Aspect: %s\r\n"
-        L"  Raw Input Frame Rate: %.2f fps\r\n\r\n"
+        L"  Raw Input Frame Rate: %.2f fps\r\n"
+        L"  Output Frame Rate: %.2f fps (last 1s)\r\n"
+        L"%s"
+        L"%s\r\n"
         L"[External Window]\r\n"
         L"  %s\r\n\r\n"
         L"[Close Trigger]\r\n"
@@ -646,25 +922,33 @@ void LR2BGAWindow::UpdateDebugInfo(
         L"  Frame Count: %lld\r\n"
         L"  Dropped Frames: %lld\r\n"
         L"  Input Filter: %s\r\n"
-        L"  Output Filter: %s\r\n",
-        inputWidth, inputHeight, inputBitCount,
-        outputWidth, outputHeight,
+        L"  Output Filter: %s\r\n\r\n"
+        L"%s",
+        stats.inputWidth, stats.inputHeight, stats.inputBitCount,
+        allocStr,
+        stats.outputWidth, stats.outputHeight,
         fpsLimitStr,
+        intervalStr,
+        cadenceStr,
         m_pSettings->m_keepAspectRatio ? L"Yes" : L"No",
-        frameRate,
+        stats.frameRate,
+        stats.outputFrameRate,
+        deliveryStr,
+        qualityStr,
         // extInfo
         extInfo, 
         m_pSettings->m_closeOnRightClick ? L"Enabled" : L"Disabled",
         gamePadStatus,
         keyStatus,
         lbDetailStr,
-        filterGraphInfo.c_str(), // Filter Graph Section
+        m_filterGraphInfo.c_str(), // Filter Graph Section
         // Stats
-        avgTime,
-        frameCount,
-        droppedFrames,
-        inputFilter.c_str(),
-        outputFilter.c_str());
+        stats.avgTime,
+        stats.frameCount,
+        stats.droppedFrames,
+        m_inputFilterName.c_str(),
+        m_outputFilterName.c_str(),
+        stageStr);
     
     } // Unlock m_mtxDebug
     InvalidateRect(m_hDebugWnd, NULL, FALSE);
@@ -694,6 +978,19 @@ LRESULT CALLBACK LR2BGAWindow::DebugWndProc(HWND hwnd, UINT msg, WPARAM wParam,
             CreateWindowW(L"BUTTON", L"Open Settings",
                 WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
                 120, 10, 100, 30, hwnd, (HMENU)IDC_BUTTON_OPEN_SETTINGS, g_hInst, NULL); // IDC from resource.h
+
+            CreateWindowW(L"BUTTON", L"Save Trace",
+                WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                230, 10, 100, 30, hwnd, (HMENU)(INT_PTR)kDebugSaveTraceButtonId, g_hInst, NULL);
+
+            // 表示テキストは公開された統計から一定周期で作り直す (フレームごとには再描画しない)
+            SetTimer(hwnd, kDebugRefreshTimerId, kDebugRefreshIntervalMs, NULL);
+        }
+        return 0;
+
+    case WM_TIMER:
+        if (wParam == kDebugRefreshTimerId && pThis) {
+            pThis->RefreshDebugText();
         }
         return 0;
 
@@ -716,6 +1013,7 @@ LRESULT CALLBACK LR2BGAWindow::DebugWndProc(HWND hwnd, UINT msg, WPARAM wParam,
         return 0;
 
     case WM_DESTROY:
+        KillTimer(hwnd, kDebugRefreshTimerId);
         if (pThis && pThis->m_pSettings) {
              // 最大化・最小化されていない場合のみ保存
             // プロパティページが開いている場合など、GetWindowPlacement が SW_SHOWNORMAL 以外を返す可能性があるため
@@ -759,6 +1057,18 @@ LRESULT CALLBACK LR2BGAWindow::DebugWndProc(HWND hwnd, UINT msg, WPARAM wParam,
         } else if (LOWORD(wParam) == IDC_BUTTON_OPEN_SETTINGS && pThis) {
             // Open Settings Handler
             pThis->ShowPropertyPage();
+        } else if (LOWORD(wParam) == kDebugSaveTraceButtonId) {
+            // "Save Trace" ボタンハンドラ (記録は止めずに、その時点までのトレースを書き出す)
+            wchar_t path[MAX_PATH];
+            LR2BGATrace::MakeDefaultPath(path, MAX_PATH);
+            HRESULT hr = LR2BGATrace::Instance().SaveToFile(path);
+            wchar_t msg[MAX_PATH + 64];
+            if (SUCCEEDED(hr)) {
+                swprintf_s(msg, L"Trace saved:\r\n%s", path);
+            } else {
+                swprintf_s(msg, L"Failed to save trace (0x%08lX):\r\n%s", (unsigned long)hr, path);
+            }
+            MessageBoxW(hwnd, msg, L"LR2 BGA Filter", MB_OK | (SUCCEEDED(hr) ? MB_ICONINFORMATION : MB_ICONWARNING));
         }
         return 0;
 
@@ -1063,6 +1373,17 @@ void LR2BGAWindow::ExtWindowThread()
             ShowWindow(hwnd, SW_SHOWNOACTIVATE);
         }
 
+        // 描画スレッドの開始
+        // リサイズと再描画要求はストリーミングスレッドではなく描画スレッドで行います。
+        if (m_pRenderer) {
+            m_pRenderer->StartRenderThread(hwnd);
+        }
+
+        // 可視状態の初期判定と、遮蔽の定期判定の開始
+        // 見えていない間は外部ウィンドウ向けのコピー・リサイズ・描画をすべて止める
+        UpdateExtWindowVisibility(hwnd);
+        SetTimer(hwnd, kExtVisibilityTimerId, kExtVisibilityIntervalMs, NULL);
+
         // メッセージループ
         // このスレッド内でのウィンドウメッセージを処理します。
         MSG msg;
@@ -1073,11 +1394,107 @@ void LR2BGAWindow::ExtWindowThread()
     }
     
     // クリーンアップ
-    // スレッド終了時にハンドルを無効化します。
+    // 描画スレッドを停止してから、スレッド終了時にハンドルを無効化します。
+    if (m_pRenderer) {
+        m_pRenderer->StopRenderThread();
+    }
     m_hExtWnd = NULL;
     m_hOverlayWnd = NULL;
 }
 
+//------------------------------------------------------------------------------
+// 外部ウィンドウの可視判定 (Visibility)
+//------------------------------------------------------------------------------
+// 遮蔽判定で手前のウィンドウを集めるためのデータ
+struct OcclusionData {
+    HWND hTarget;                   // 外部ウィンドウ (ここに達したら列挙を終える)
+    HWND hOverlay;                  // 輝度調整用オーバーレイ (外部ウィンドウの一部として扱う)
+    std::vector<RECT> rects;        // 外部ウィンドウより手前にある不透明なウィンドウの矩形
+};
+
+// ウィンドウの見た目どおりの矩形 (DWMの影など不可視の枠を含めない)
+static bool GetVisibleWindowRect(HWND hwnd, RECT* pRect)
+{
+    if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, pRect, sizeof(RECT)))) return true;
+    return GetWindowRect(hwnd, pRect) != FALSE;
+}
+
+static BOOL CALLBACK EnumOccludersCallback(HWND hwnd, LPARAM lParam) {
+    OcclusionData* pData = (OcclusionData*)lParam;
+    // EnumWindows はトップレベルウィンドウを Z オーダーの手前から列挙する
+    if (hwnd == pData->hTarget) return FALSE;
+    if (hwnd == pData->hOverlay) return TRUE;
+    if (!IsWindowVisible(hwnd) || IsIconic(hwnd)) return TRUE;
+
+    // 半透明・クリック透過のウィンドウは下が見えている可能性があるため遮蔽物として扱わない
+    LONG_PTR exStyle = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
+    if (exStyle & (WS_EX_LAYERED | WS_EX_TRANSPARENT)) return TRUE;
+
+    // 別の仮想デスクトップ上などでクローク (非表示化) されているウィンドウ
+    BOOL cloaked = FALSE;
+    if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked) return TRUE;
+
+    RECT rc;
+    if (GetVisibleWindowRect(hwnd, &rc) && !IsRectEmpty(&rc)) {
+        pData->rects.push_back(rc);
+    }
+    return TRUE;
+}
+
+// 外部ウィンドウが手前のウィンドウで完全に覆われているか
+static bool IsWindowFullyOccluded(HWND hwnd, HWND hOverlay, const RECT& rcWnd)
+{
+    OcclusionData data;
+    data.hTarget = hwnd;
+    data.hOverlay = hOverlay;
+    EnumWindows(EnumOccludersCallback, (LPARAM)&data);
+    if (data.rects.empty()) return false;
+
+    HRGN hRgn = CreateRectRgnIndirect(&rcWnd);
+    if (!hRgn) return false;
+    bool occluded = false;
+    for (const RECT& rc : data.rects) {
+        HRGN hOther = CreateRectRgnIndirect(&rc);
+        if (!hOther) break;
+        const int type = CombineRgn(hRgn, hRgn, hOther, RGN_DIFF);
+        DeleteObject(hOther);
+        if (type == NULLREGION) {
+            occluded = true;
+            break;
+        }
+        if (type == ERROR) break;
+    }
+    DeleteObject(hRgn);
+    return occluded;
+}
+
+void LR2BGAWindow::UpdateExtWindowVisibility(HWND hwnd)
+{
+    if (!m_pRenderer) return;
+
+    bool visible = IsWindowVisible(hwnd) && !IsIconic(hwnd);
+
+    RECT rcWnd = {0};
+    if (visible) {
+        // どのモニターにも掛かっていない (画面外へ移動された、モニターが外された)
+        visible = GetVisibleWindowRect(hwnd, &rcWnd) &&
+                  MonitorFromRect(&rcWnd, MONITOR_DEFAULTTONULL) != NULL;
+    }
+
+    if (visible) {
+        // 完全に覆われている場合の停止は設定時のみ
+        // (OBS のウィンドウキャプチャは覆われたウィンドウも取り込めるため、既定では止めない)
+        m_pSettings->Lock();
+        const bool pauseWhenOccluded = m_pSettings->m_extWindowPauseWhenOccluded;
+        m_pSettings->Unlock();
+        if (pauseWhenOccluded && IsWindowFullyOccluded(hwnd, m_hOverlayWnd, rcWnd)) {
+            visible = false;
+        }
+    }
+
+    m_pRenderer->SetVisible(visible);
+}
+
 void LR2BGAWindow::InputMonitorThread()
 {
     // 入力監視ループ
@@ -13,6 +13,31 @@
 #include "LR2BGALetterboxDetector.h" // For LetterboxDebugInfo
 #include "LR2BGAExternalRenderer.h"
 
+//------------------------------------------------------------------------------
+// デバッグ統計 (Filter Debug Statistics)
+// ストリーミングスレッドが一定間隔で公開し、デバッグウィンドウのスレッドが表示用テキストを作ります。
+// フィルタグラフの構成 (接続先のフィルタ名など) は接続の変化時に SetGraphTopology で別途渡します。
+//------------------------------------------------------------------------------
+struct FilterDebugStats {
+    int inputWidth;
+    int inputHeight;
+    int inputBitCount;
+    int outputWidth;
+    int outputHeight;
+    double frameRate;           // 入力フレームレート (AvgTimePerFrame)
+    double outputFrameRate;     // 実測出力フレームレート (直近1秒)
+    long long frameCount;
+    long long droppedFrames;
+    double avgTime;             // 平均処理時間 (ms)
+    LetterboxDebugInfo lbInfo;
+    InputAllocatorInfo allocInfo;
+    OutputDeliveryInfo deliveryInfo;
+    UpstreamQualityInfo qualityInfo;
+    FrameIntervalHistogram intervalHist;
+    CadenceInfo cadenceInfo;
+    LR2BGAStageLatency stageLatency[STAGE_COUNT];
+};
+
 //------------------------------------------------------------------------------
 // クラス: LR2BGAWindow
 // 
@@ -53,8 +78,14 @@ public:
     // 外部ウィンドウ管理
     void ShowExternalWindow();      // 外部ウィンドウを作成・表示
     void CloseExternalWindow();     // 外部ウィンドウを破棄
-    // 外部ウィンドウへの映像更新（描画）
+    // 外部ウィンドウへの映像更新（最新フレームの投函。描画は Renderer の描画スレッドで非同期に実行）
     void UpdateExternalWindow(const BYTE* pSrcData, int srcWidth, int srcHeight, int srcStride, int srcBitCount, const RECT* pSrcRect = NULL);
+    // 外部ウィンドウ用フレームを LR2 向けリサイズと同時に生成する場合の投函先確保/投函完了
+    // (LR2BGAExternalRenderer::BeginPresizedFrame / CommitPresizedFrame を参照)
+    bool BeginExternalPresizedFrame(int cropWidth, int cropHeight, LR2BGAImageProc::ResizeTarget& target);
+    void CommitExternalPresizedFrame(LONGLONG resizeQpc, int sharedPixels);
+    // 外部ウィンドウ専用の上限FPSに対し、このフレームを投函すべきか (LR2向けのFPS制限とは独立)
+    bool IsExternalFrameDue();
     void UpdateExternalWindowPos(); // ウィンドウ位置・サイズ・Topmost設定の反映
     void UpdateOverlayWindow();     // オーバーレイ（明るさ調整用黒レイヤー）の更新
     
@@ -63,16 +94,13 @@ public:
     
     // デバッグウィンドウ管理
     void ShowDebugWindow();         // デバッグウィンドウを表示
-    // デバッグ情報の更新（テキスト生成と描画）
-    void UpdateDebugInfo(
-        const std::wstring& inputFilter, const std::wstring& outputFilter,
-        const std::wstring& filterGraphInfo,
-        int inputWidth, int inputHeight, int inputBitCount,
-        int outputWidth, int outputHeight,
-        double frameRate, double outputFrameRate,
-        long long frameCount, long long droppedFrames,
-        double avgTime,
-        const LetterboxDebugInfo& lbInfo);
+    bool IsDebugWindowOpen() const { return m_hDebugWnd != NULL; }
+    // デバッグ統計の公開 (ストリーミングスレッドから。ロックフリーで最新の1件だけを渡す)
+    // テキスト生成と描画はデバッグウィンドウのスレッドが一定周期で行う
+    void PublishDebugStats(const FilterDebugStats& stats);
+    // フィルタグラフの構成 (接続・切断・ストリーミング開始時に呼ぶ)
+    void SetGraphTopology(const std::wstring& inputFilter, const std::wstring& outputFilter,
+                          const std::wstring& filterGraphInfo);
     
     // シーン変更通知 (LR2MemoryMonitorからのコールバック用)
     void OnSceneChanged(int sceneId);
@@ -83,6 +111,9 @@ public:
 private:
     static LRESULT CALLBACK ExtWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
     void ExtWindowThread(); // Member function
+    // 外部ウィンドウが実際に見えているかを判定して Renderer へ通知 (ウィンドウスレッド専用)
+    // 最小化・非表示・画面外、および設定時は他のウィンドウに完全に覆われている場合に不可視とする
+    void UpdateExtWindowVisibility(HWND hwnd);
     static LRESULT CALLBACK DebugWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
     void DebugWindowThread(); // Member function
     
@@ -104,8 +135,16 @@ public:
 private:
     void FormatExtWindowInfo(wchar_t* buffer, size_t size);
     void FormatFPSLimit(wchar_t* buffer, size_t size);
+    void FormatInputAllocatorInfo(wchar_t* buffer, size_t size, const InputAllocatorInfo& info);
+    void FormatOutputDeliveryInfo(wchar_t* buffer, size_t size, const OutputDeliveryInfo& info);
+    void FormatUpstreamQualityInfo(wchar_t* buffer, size_t size, const UpstreamQualityInfo& info);
+    void FormatFrameIntervalInfo(wchar_t* buffer, size_t size, const FrameIntervalHistogram& hist);
+    void FormatCadenceInfo(wchar_t* buffer, size_t size, const CadenceInfo& info);
+    void FormatStageLatencyInfo(wchar_t* buffer, size_t size, const LR2BGAStageLatency* stages);
     void FormatInputStatus(wchar_t* gamePadStatus, size_t gamePadSize, wchar_t* keyStatus, size_t keySize);
     void FormatLetterboxInfo(wchar_t* buffer, size_t size, const LetterboxDebugInfo& lbInfo);
+    // 最新のデバッグ統計から表示用テキストを作り直す (デバッグウィンドウのスレッド専用)
+    void RefreshDebugText();
 
 public:
     LR2BGASettings* m_pSettings;
@@ -125,8 +164,8 @@ public:
     //--------------------------------------------------------------------------
     // 複数のミューテックスを必要とする場合、必ず以下の順序で取得すること:
     //   1. m_mtxInput (入力監視スレッド制御)
-    //   2. m_mtxDebug (デバッグテキストバッファ)
-    //   3. Renderer内部のmutex (描画バッファ保護)
+    //   2. m_mtxDebug (デバッグテキストバッファ・フィルタグラフ構成)
+    //   3. Renderer内部のmutex (メールボックス保護。描画バッファはトリプルバッファでロックフリー)
     //
     // 注意:
     //   - ロックを保持したまま GUI 操作 (SetWindowPos, SendMessage 等) を行わないこと。
@@ -138,8 +177,23 @@ public:
     HWND m_hDebugWnd;
     HWND m_hBtnSettings;        // 「Open Settings」ボタンハンドル
     std::thread m_threadDebug;
-    wchar_t m_debugText[2048];  // 表示用テキストバッファ
-    std::mutex m_mtxDebug; // テキストバッファアクセス保護用
+    wchar_t m_debugText[8192];  // 表示用テキストバッファ
+    std::mutex m_mtxDebug; // テキストバッファ・グラフ構成のアクセス保護用
+
+    // フィルタグラフの構成 (m_mtxDebug で保護)
+    std::wstring m_inputFilterName;
+    std::wstring m_outputFilterName;
+    std::wstring m_filterGraphInfo;
+    std::atomic<bool> m_graphTopologyChanged; // 停止中の接続変更も次の更新周期で表示へ反映する
+
+    // デバッグ統計の受け渡し (トリプルバッファ。ストリーミングスレッド -> デバッグウィンドウのスレッド)
+    static constexpr int kDebugStatsBufferCount = 3;
+    static constexpr int kDebugStatsIndexMask = 0x3;
+    static constexpr int kDebugStatsFreshBit = 0x4;     // 受け渡し待ちの面が未表示の新しい統計であることを示す
+    FilterDebugStats m_debugStats[kDebugStatsBufferCount];
+    int m_debugStatsWriteIndex;         // 書き込み中の面 (ストリーミングスレッド専用)
+    int m_debugStatsDisplayIndex;       // 表示中の面 (デバッグウィンドウのスレッド専用)
+    std::atomic<int> m_debugStatsReady; // 受け渡し待ちの面のインデックス | kDebugStatsFreshBit
 
     std::atomic<bool> m_bPropPageActive; // プロパティページ表示中フラグ
     std::thread m_threadProp;       // プロパティページスレッド
@@ -149,5 +203,7 @@ public:
 
 // Auto-link winmm.lib for joystick
 #pragma comment(lib, "winmm.lib")
+// Auto-link dwmapi.lib for occlusion check (DWMWA_CLOAKED / DWMWA_EXTENDED_FRAME_BOUNDS)
+#pragma comment(lib, "dwmapi.lib")
 
 
@@ -35,6 +35,9 @@
 // Controls - LR2 New Settings
 #define IDC_CHECK_DUMMY             1050
 #define IDC_CHECK_PASSTHROUGH       1051
+#define IDC_EDIT_OUTPUT_BUFFERS     1052
+#define IDC_SPIN_OUTPUT_BUFFERS     1053
+#define IDC_CHECK_OUTPUT_PIPELINED  1054
 
 // Controls - External Window
 #define IDC_CHECK_EXT_ENABLE        1060
@@ -51,6 +54,10 @@
 #define IDC_CHECK_EXT_PASSTHROUGH   1071
 #define IDC_RADIO_EXT_TOPMOST       1072
 #define IDC_RADIO_EXT_BOTTOMMOST    1073
+#define IDC_EDIT_EXT_MAXFPS         1074
+#define IDC_SPIN_EXT_MAXFPS         1075
+#define IDC_CHECK_EXT_ADAPTIVE      1076
+#define IDC_CHECK_EXT_PAUSE_OCCLUDED 1077
 
 // Controls - Brightness
 // Controls - Brightness
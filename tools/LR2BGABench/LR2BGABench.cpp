@@ -0,0 +1,494 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGABench.cpp
+// LR2 BGA Filter - 画像処理カーネルのヘッドレスベンチマーク
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   DirectShow のグラフを組まずに、画像処理コア (LR2BGAImageProc / LR2BGAThreadPool /
+//   LR2BGALetterboxDetector) の性能を測ります。Windows (MSVC) と Linux (GCC/Clang) で
+//   同じコードをビルドできます (Windows 以外は shim/ の最小限の windows.h を使う)。
+//
+// 測定:
+//   入力解像度 (480p-4K)、出力サイズ、ビット深度、アルゴリズム、カーネルの実装段階
+//   (LR2BGAImageProc::KernelTier) とスレッド数を総当たりし、1フレームあたりの所要時間の中央値から
+//   MPix/s (出力画素。黒帯検出は入力画素)、ns/画素、1スレッドに対する速度比を出力します。
+//   実装段階は、その組み合わせで実際に使われる関数が変わるものだけを測ります
+//   (例: 最近傍と RGB24 のバイリニアは SIMD 版がないため Cpp / CppOpt のみ)。
+//
+// 検証:
+//   測定の前に、各実装段階の出力が一致することを乱数ケースで確かめます (LR2BGAVerify)。
+//   不一致があれば測定せずに終了コード 1 を返します。--verify は検証だけを行います (ctest の対象)。
+//
+// 使用法:
+//   LR2BGABench [--quick] [--tier <cpp|cppopt|sse41|avx2>] [--threads 1,2,4]
+//               [--filter <文字列>] [--min-time <ms>] [--csv]
+//               [--verify | --no-verify] [--iterations <n>] [--seed <n>]
+//------------------------------------------------------------------------------
+
+#include "LR2BGAImageProc.h"
+#include "LR2BGALetterboxDetector.h"
+#include "LR2BGAThreadPool.h"
+#include "LR2BGAVerify.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef LR2BGAImageProc::KernelTier KernelTier;
+
+constexpr double kDefaultMinTimeMs = 100.0;   // 1ケースあたりの最短測定時間
+constexpr int kMinSamples = 5;                // 1ケースあたりの最少測定回数
+constexpr int kPreBenchVerifyIterations = 200; // 測定前の検証のケース数 (--verify の既定値より少なく)
+constexpr int kBrightness = 70;               // 明るさ調整のケースで使う値 (%)
+constexpr double kLetterboxBarRatio = 0.125;  // テストフレームの上下の黒帯 (高さに対する割合)
+
+struct Size {
+    int width;
+    int height;
+};
+
+const Size kSources[] = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+const Size kOutputs[] = {{256, 256}, {512, 512}, {1920, 1080}};   // LR2既定 / 外部ウィンドウ既定 / 全画面
+const int kBitDepths[] = {24, 32};
+
+struct Options {
+    bool quick = false;
+    bool csv = false;
+    double minTimeMs = kDefaultMinTimeMs;
+    int tier = -1;                  // -1: 対応するすべての段階
+    std::vector<int> threads;       // 空: 1 から倍々にワーカー数まで
+    std::string filter;
+};
+
+//------------------------------------------------------------------------------
+// テストフレーム (上下に黒帯があり、それ以外は乱数の画素)
+//------------------------------------------------------------------------------
+struct Frame {
+    std::vector<BYTE> data;
+    int width = 0;
+    int height = 0;
+    int bpp = 0;
+    int stride = 0;
+};
+
+Frame MakeTestFrame(int width, int height, int bpp, unsigned seed) {
+    Frame frame;
+    frame.width = width;
+    frame.height = height;
+    frame.bpp = bpp;
+    frame.stride = ((width * (bpp / 8) + 3) & ~3);
+    frame.data.assign((size_t)frame.stride * height, 0);
+
+    const int bar = (int)(height * kLetterboxBarRatio);
+    unsigned state = seed ? seed : 1;
+    for (int y = bar; y < height - bar; y++) {
+        BYTE *row = frame.data.data() + (size_t)y * frame.stride;
+        for (int x = 0; x < width * (bpp / 8); x++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            row[x] = (BYTE)(state >> 24);
+        }
+    }
+    return frame;
+}
+
+struct Output {
+    std::vector<BYTE> data;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    int actualWidth = 0;
+    int actualHeight = 0;
+    int offsetX = 0;
+    int offsetY = 0;
+};
+
+Output MakeOutput(const Frame &src, const Size &size) {
+    Output out;
+    out.width = size.width;
+    out.height = size.height;
+    out.stride = ((size.width * 3 + 3) & ~3);
+    out.data.assign((size_t)out.stride * size.height, 0);
+    LR2BGAImageProc::CalculateResizeDimensions(src.width, src.height, size.width, size.height, true,
+                                               out.actualWidth, out.actualHeight, out.offsetX, out.offsetY);
+    return out;
+}
+
+//------------------------------------------------------------------------------
+// 計測
+//------------------------------------------------------------------------------
+// 1回のウォームアップ後、最短測定時間と最少回数を満たすまで繰り返し、所要時間の中央値 (ms) を返す
+template <class Function>
+double MeasureMedianMs(Function func, double minTimeMs) {
+    typedef std::chrono::steady_clock Clock;
+    func();
+
+    std::vector<double> samples;
+    double totalMs = 0.0;
+    while (totalMs < minTimeMs || (int)samples.size() < kMinSamples) {
+        const Clock::time_point start = Clock::now();
+        func();
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        samples.push_back(ms);
+        totalMs += ms;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+struct Case {
+    const char *kernel;
+    Size source;
+    int bpp;
+    std::string output;
+    double pixels;          // 1フレームあたりの画素数 (MPix/s の基準)
+    bool tierIndependent;   // 実装段階によらず同じ関数 (段階を "-" と表示)
+};
+
+class Reporter {
+public:
+    explicit Reporter(bool csv) : m_csv(csv), m_baseMs(0.0) {}
+
+    void PrintHeader() const {
+        if (m_csv) {
+            printf("kernel,source,bpp,output,tier,threads,ms_per_frame,mpix_per_s,ns_per_pixel,scaling\n");
+        } else {
+            printf("%-10s %-10s %3s %-18s %-7s %3s %10s %9s %8s %7s\n", "kernel", "source", "bpp", "output",
+                   "tier", "thr", "ms/frame", "MPix/s", "ns/px", "scale");
+        }
+    }
+
+    // threads == 1 の結果を速度比の基準にする (スレッド数は昇順で渡す)
+    void Print(const Case &c, KernelTier tier, int threads, double ms) {
+        if (threads == 1) m_baseMs = ms;
+        const double mpixPerSec = (ms > 0.0) ? c.pixels / (ms * 1000.0) : 0.0;
+        const double nsPerPixel = (c.pixels > 0.0) ? ms * 1e6 / c.pixels : 0.0;
+        const double scaling = (m_baseMs > 0.0 && ms > 0.0) ? m_baseMs / ms : 0.0;
+        char source[32];
+        snprintf(source, sizeof(source), "%dx%d", c.source.width, c.source.height);
+        const char *tierName = c.tierIndependent ? "-" : LR2BGAImageProc::GetKernelTierName(tier);
+        if (m_csv) {
+            printf("%s,%s,%d,%s,%s,%d,%.4f,%.2f,%.3f,%.2f\n", c.kernel, source, c.bpp, c.output.c_str(),
+                   tierName, threads, ms, mpixPerSec, nsPerPixel, scaling);
+        } else {
+            printf("%-10s %-10s %3d %-18s %-7s %3d %10.3f %9.1f %8.3f %6.2fx\n", c.kernel, source, c.bpp,
+                   c.output.c_str(), tierName, threads, ms, mpixPerSec, nsPerPixel, scaling);
+        }
+        fflush(stdout);
+    }
+
+private:
+    bool m_csv;
+    double m_baseMs;
+};
+
+//------------------------------------------------------------------------------
+// ベンチマーク本体
+//------------------------------------------------------------------------------
+class Bench {
+public:
+    explicit Bench(const Options &options)
+        : m_options(options), m_reporter(options.csv),
+          m_maxTier(LR2BGAImageProc::GetMaxSupportedTier()),
+          m_workers(LR2BGAThreadPool::Instance().GetWorkerCount()) {}
+
+    void Run() {
+        printf("# LR2BGABench: max tier %s, %d worker threads, min time %.0f ms/case\n",
+               LR2BGAImageProc::GetKernelTierName(m_maxTier), m_workers, m_options.minTimeMs);
+        m_reporter.PrintHeader();
+
+        for (const Size &source : kSources) {
+            if (m_options.quick && source.width != 1920) continue;
+            for (int bpp : kBitDepths) {
+                const Frame frame = MakeTestFrame(source.width, source.height, bpp, 12345u + bpp);
+                RunResize(frame, "nearest");
+                RunResize(frame, "bilinear");
+                RunMulti(frame);
+                RunLetterbox(frame);
+            }
+        }
+        RunBrightness();
+
+        LR2BGAThreadPool::Instance().SetMaxParallelism(0);
+        LR2BGAImageProc::SetKernelTier(m_maxTier);
+    }
+
+private:
+    bool Selected(const char *kernel) const {
+        return m_options.filter.empty() || strstr(kernel, m_options.filter.c_str()) != NULL;
+    }
+
+    // 指定した段階のうち、CPU が対応し、--tier で選ばれたもの
+    std::vector<KernelTier> Tiers(std::initializer_list<KernelTier> effective) const {
+        std::vector<KernelTier> tiers;
+        for (KernelTier tier : effective) {
+            if (tier > m_maxTier) continue;
+            if (m_options.tier >= 0 && tier != m_options.tier) continue;
+            tiers.push_back(tier);
+        }
+        return tiers;
+    }
+
+    std::vector<int> ThreadCounts(bool parallel) const {
+        std::vector<int> counts;
+        if (!parallel) {
+            counts.push_back(1);
+        } else if (!m_options.threads.empty()) {
+            // ワーカー数を超える指定はワーカー数に丸める
+            for (int n : m_options.threads) {
+                const int clamped = (n < m_workers) ? n : m_workers;
+                if (counts.empty() || counts.back() != clamped) counts.push_back(clamped);
+            }
+        } else if (m_options.quick) {
+            counts.push_back(1);
+            if (m_workers > 1) counts.push_back(m_workers);
+        } else {
+            for (int n = 1; n < m_workers; n *= 2) counts.push_back(n);
+            counts.push_back(m_workers > 0 ? m_workers : 1);
+        }
+        return counts;
+    }
+
+    std::vector<Size> Outputs() const {
+        std::vector<Size> outputs;
+        for (const Size &size : kOutputs) {
+            if (m_options.quick && size.width != 256) continue;
+            outputs.push_back(size);
+        }
+        return outputs;
+    }
+
+    template <class Function>
+    void Measure(const Case &c, const std::vector<KernelTier> &tiers, Function func) {
+        for (KernelTier tier : tiers) {
+            LR2BGAImageProc::SetKernelTier(tier);
+            // Cpp 段階のリサイズと黒帯検出は単一スレッド
+            const bool parallel = (tier != LR2BGAImageProc::KERNEL_TIER_CPP) && strcmp(c.kernel, "letterbox") != 0 &&
+                                  strcmp(c.kernel, "brightness") != 0;
+            for (int threads : ThreadCounts(parallel)) {
+                LR2BGAThreadPool::Instance().SetMaxParallelism(threads);
+                const double ms = MeasureMedianMs(func, m_options.minTimeMs);
+                m_reporter.Print(c, tier, threads, ms);
+            }
+        }
+    }
+
+    void RunResize(const Frame &frame, const char *kernel) {
+        if (!Selected(kernel)) return;
+        const bool bilinear = (strcmp(kernel, "bilinear") == 0);
+        // SIMD 版はバイリニアかつ RGB32 入力のときだけ使われる
+        const std::vector<KernelTier> tiers =
+            (bilinear && frame.bpp == 32)
+                ? Tiers({LR2BGAImageProc::KERNEL_TIER_CPP, LR2BGAImageProc::KERNEL_TIER_CPPOPT,
+                         LR2BGAImageProc::KERNEL_TIER_SSE41, LR2BGAImageProc::KERNEL_TIER_AVX2})
+                : Tiers({LR2BGAImageProc::KERNEL_TIER_CPP, LR2BGAImageProc::KERNEL_TIER_CPPOPT});
+
+        for (const Size &size : Outputs()) {
+            Output out = MakeOutput(frame, size);
+            std::vector<int> lutIndices;
+            std::vector<short> lutWeights;
+            char name[32];
+            snprintf(name, sizeof(name), "%dx%d", size.width, size.height);
+            const Case c = {kernel, {frame.width, frame.height}, frame.bpp, name,
+                            (double)out.actualWidth * out.actualHeight, false};
+            Measure(c, tiers, [&] {
+                if (bilinear) {
+                    LR2BGAImageProc::ResizeBilinear(frame.data.data(), frame.width, frame.height, frame.stride,
+                                                    frame.bpp, out.data.data(), out.width, out.height, out.stride,
+                                                    24, out.actualWidth, out.actualHeight, out.offsetX,
+                                                    out.offsetY, NULL, lutIndices, lutWeights);
+                } else {
+                    LR2BGAImageProc::ResizeNearestNeighbor(frame.data.data(), frame.width, frame.height,
+                                                           frame.stride, frame.bpp, out.data.data(), out.width,
+                                                           out.height, out.stride, 24, out.actualWidth,
+                                                           out.actualHeight, out.offsetX, out.offsetY, NULL,
+                                                           lutIndices);
+                }
+            });
+        }
+    }
+
+    // LR2向け出力 (256x256) と外部ウィンドウ用 (512x512) を1回の走査で生成する (ResizeMulti)
+    void RunMulti(const Frame &frame) {
+        if (!Selected("multi")) return;
+        const std::vector<KernelTier> tiers =
+            (frame.bpp == 32) ? Tiers({LR2BGAImageProc::KERNEL_TIER_CPPOPT, LR2BGAImageProc::KERNEL_TIER_SSE41,
+                                       LR2BGAImageProc::KERNEL_TIER_AVX2})
+                              : Tiers({LR2BGAImageProc::KERNEL_TIER_CPPOPT});
+
+        Output outs[2] = {MakeOutput(frame, kOutputs[0]), MakeOutput(frame, kOutputs[1])};
+        LR2BGAImageProc::ResizeCache caches[2];
+        LR2BGAImageProc::ResizeTarget targets[2];
+        for (int i = 0; i < 2; i++) {
+            targets[i] = {outs[i].data.data(), outs[i].width, outs[i].height, outs[i].stride,
+                          outs[i].actualWidth, outs[i].actualHeight, outs[i].offsetX, outs[i].offsetY,
+                          true, &caches[i]};
+        }
+        const Case c = {"multi", {frame.width, frame.height}, frame.bpp, "256x256+512x512",
+                        (double)outs[0].actualWidth * outs[0].actualHeight +
+                            (double)outs[1].actualWidth * outs[1].actualHeight, false};
+        Measure(c, tiers, [&] {
+            LR2BGAImageProc::ResizeMulti(frame.data.data(), frame.width, frame.height, frame.stride, frame.bpp,
+                                         NULL, targets, 2);
+        });
+    }
+
+    // 黒帯検出 (輝度サムネイルの生成 + 解析。検出スレッドでの1フレーム分)
+    void RunLetterbox(const Frame &frame) {
+        if (!Selected("letterbox")) return;
+        // 輝度系のカーネルは Cpp と CppOpt で同じ
+        const std::vector<KernelTier> tiers = Tiers({LR2BGAImageProc::KERNEL_TIER_CPP,
+                                                     LR2BGAImageProc::KERNEL_TIER_SSE41,
+                                                     LR2BGAImageProc::KERNEL_TIER_AVX2});
+        LR2BGALetterboxDetector detector;
+        LetterboxThumbnail thumb;
+        const Case c = {"letterbox", {frame.width, frame.height}, frame.bpp, "-",
+                        (double)frame.width * frame.height, false};
+        Measure(c, tiers, [&] {
+            LR2BGALetterboxDetector::BuildThumbnail(frame.data.data(), frame.data.size(), frame.width,
+                                                    frame.height, frame.stride, frame.bpp, thumb);
+            detector.AnalyzeFrame(thumb);
+        });
+    }
+
+    void RunBrightness() {
+        if (!Selected("brightness")) return;
+        const std::vector<KernelTier> tiers = Tiers({m_maxTier});
+        for (const Size &size : Outputs()) {
+            const Frame frame = MakeTestFrame(size.width, size.height, 24, 777u);
+            std::vector<BYTE> work(frame.data);
+            char name[32];
+            snprintf(name, sizeof(name), "%dx%d", size.width, size.height);
+            const Case c = {"brightness", size, 24, name, (double)size.width * size.height, true};
+            Measure(c, tiers, [&] {
+                memcpy(work.data(), frame.data.data(), work.size());
+                LR2BGAImageProc::ApplyBrightness(work.data(), size.width, size.height, frame.stride, kBrightness);
+            });
+        }
+    }
+
+    Options m_options;
+    Reporter m_reporter;
+    KernelTier m_maxTier;
+    int m_workers;
+};
+
+//------------------------------------------------------------------------------
+// コマンドライン
+//------------------------------------------------------------------------------
+int ParseTier(const char *name) {
+    for (int tier = 0; tier < LR2BGAImageProc::KERNEL_TIER_COUNT; tier++) {
+        std::string tierName = LR2BGAImageProc::GetKernelTierName((KernelTier)tier);
+        tierName.erase(std::remove(tierName.begin(), tierName.end(), '.'), tierName.end());
+        std::string arg = name;
+        arg.erase(std::remove(arg.begin(), arg.end(), '.'), arg.end());
+        if (tierName.size() == arg.size() &&
+            std::equal(tierName.begin(), tierName.end(), arg.begin(),
+                       [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); })) {
+            return tier;
+        }
+    }
+    return -1;
+}
+
+bool ParseThreads(const char *list, std::vector<int> &threads) {
+    threads.clear();
+    std::string text = list;
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        const size_t comma = text.find(',', pos);
+        const std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        const int count = atoi(item.c_str());
+        if (count <= 0) return false;
+        threads.push_back(count);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+    return !threads.empty();
+}
+
+void PrintUsage() {
+    printf("Usage: LR2BGABench [--quick] [--tier <cpp|cppopt|sse41|avx2>] [--threads 1,2,4]\n"
+           "                   [--filter <nearest|bilinear|multi|letterbox|brightness>]\n"
+           "                   [--min-time <ms>] [--csv]\n"
+           "                   [--verify | --no-verify] [--iterations <n>] [--seed <n>]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    VerifyOptions verifyOptions;
+    bool verifyOnly = false;
+    bool skipVerify = false;
+    bool iterationsGiven = false;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool hasValue = (i + 1 < argc);
+        if (strcmp(arg, "--quick") == 0) {
+            options.quick = true;
+        } else if (strcmp(arg, "--csv") == 0) {
+            options.csv = true;
+        } else if (strcmp(arg, "--verify") == 0) {
+            verifyOnly = true;
+        } else if (strcmp(arg, "--no-verify") == 0) {
+            skipVerify = true;
+        } else if (strcmp(arg, "--iterations") == 0 && hasValue) {
+            verifyOptions.iterations = atoi(argv[++i]);
+            iterationsGiven = true;
+            if (verifyOptions.iterations <= 0) {
+                fprintf(stderr, "Invalid iteration count: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            verifyOptions.seed = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--tier") == 0 && hasValue) {
+            options.tier = ParseTier(argv[++i]);
+            if (options.tier < 0) {
+                fprintf(stderr, "Unknown tier: %s\n", argv[i]);
+                return 2;
+            }
+            if (options.tier > LR2BGAImageProc::GetMaxSupportedTier()) {
+                fprintf(stderr, "Tier %s is not supported by this CPU.\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            if (!ParseThreads(argv[++i], options.threads)) {
+                fprintf(stderr, "Invalid thread list: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--filter") == 0 && hasValue) {
+            options.filter = argv[++i];
+        } else if (strcmp(arg, "--min-time") == 0 && hasValue) {
+            options.minTimeMs = atof(argv[++i]);
+            if (options.minTimeMs < 0.0) options.minTimeMs = 0.0;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if (verifyOnly) {
+        return RunVerify(verifyOptions);
+    }
+    if (!skipVerify) {
+        if (!iterationsGiven) verifyOptions.iterations = kPreBenchVerifyIterations;
+        if (RunVerify(verifyOptions) != 0) {
+            fprintf(stderr, "Kernel tiers disagree; benchmark skipped (--no-verify to force).\n");
+            return 1;
+        }
+    }
+
+    Bench bench(options);
+    bench.Run();
+    return 0;
+}
@@ -0,0 +1,806 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAReplay.cpp
+// LR2 BGA Filter - 映像変換ロジックのオフライン再生
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   記録したフレーム列 (生の RGB フレームとタイムスタンプ) を、DirectShow のグラフなしで
+//   LR2BGATransformLogic に流し、フィルタの ProcessFrame と同じ順序
+//   (StartStreaming → WaitFPSLimit → ProcessLetterboxDetection → FillOutputBuffer) で処理します。
+//   フレームごとの判定 (出力/FPS制限でドロップ/スキップ、黒帯のモードと切り出し範囲) と
+//   各段階の所要時間を出力し、録画した BGA でパイプライン全体の挙動を測定・回帰確認できます。
+//
+// 時刻:
+//   FPS制限と黒帯検出のスケジューラは模擬時計 (LR2BGAClock) で動かし、待機は時刻を進めるだけです。
+//   フレームは既定で表示時刻どおりに届きます (参照クロックのあるグラフと同じ。--decode-ms で上流の処理時間、
+//   --no-realtime で待たずに次々と届く場合を模擬)。
+//   既定では処理時間を模擬時計に加えないため、同じ入力と設定からは常に同じ判定と出力ハッシュが
+//   得られます (--charge-cost で実測の処理時間を加える)。黒帯検出は検出スレッドを使わず、
+//   サムネイルを投函したフレームで解析します (SetSynchronousLetterbox)。
+//   所要時間の列と集計は実時間 (QPC) の測定値です。
+//
+// 入力:
+//   --raw <file> --size WxH: ffmpeg の rawvideo (bgr24 / bgra、上から下の行順) をそのまま読む。
+//     DirectShow の RGB (DIB) と同じ下から上の行順へ並べ替え、4バイト境界のストライドで渡す。
+//     タイムスタンプは --fps の等間隔、または --timestamps (1行1フレーム、秒。ffprobe の pts_time)。
+//   --synthetic: 上下に黒帯のある 640x480 / 59.94fps の合成映像 (途中で黒帯のないシーンへ切り替わる)。
+//     --check で既知の答え (黒帯の範囲、シーン切り替え後の解除、FPS制限の出力数) と照合する。
+//
+// 使用法:
+//   LR2BGAReplay (--raw <file> --size WxH [--bpp 24|32] [--fps <f>] [--timestamps <file>] | --synthetic)
+//                [--output WxH] [--algo nearest|bilinear] [--no-keep-aspect] [--max-fps <n>]
+//                [--brightness <0-100>] [--no-letterbox] [--lb-threshold <n>] [--lb-stability <n>]
+//                [--passthrough] [--dummy] [--frames <n>] [--decode-ms <ms>] [--no-realtime]
+//                [--charge-cost] [--csv] [--quiet] [--check]
+//------------------------------------------------------------------------------
+
+#include "LR2BGATransformLogic.h"
+#include "LR2BGAImageProc.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr REFERENCE_TIME kClockOrigin = 10LL * 10000000;      // 模擬時計の開始時刻 (0 は「未設定」と区別できないため)
+constexpr REFERENCE_TIME kSyntheticInterval = 166833;         // 59.94fps
+constexpr int kSyntheticWidth = 640;
+constexpr int kSyntheticHeight = 480;
+constexpr int kSyntheticBar = 60;                             // 上下の黒帯 (640x360 = 16:9 のコンテンツ)
+constexpr int kSyntheticFrames = 360;                         // 約6秒
+constexpr int kSyntheticCutFrame = 180;                       // この番号から黒帯のないシーン
+constexpr int kCheckSettleFrames = 60;                        // --check: 判定の確定を待つフレーム数 (約1秒)
+constexpr int kCheckBarTolerance = 4;                         // --check: 黒帯の境界の許容差 (px、検出は縮小サムネイル上)
+
+//------------------------------------------------------------------------------
+// SimulatedClock - 模擬時計 (待機は時刻を進めるだけ)
+//------------------------------------------------------------------------------
+class SimulatedClock : public LR2BGAClock {
+public:
+    SimulatedClock() : m_now(kClockOrigin), m_waited(0) {}
+
+    REFERENCE_TIME Now() override { return m_now; }
+    void WaitUntil(REFERENCE_TIME deadline) override {
+        if (deadline > m_now) {
+            m_waited += deadline - m_now;
+            m_now = deadline;
+        }
+    }
+
+    void Advance(REFERENCE_TIME delta) { m_now += delta; }
+    // 前回の呼び出し以降に WaitUntil で進めた時間
+    REFERENCE_TIME TakeWaited() {
+        const REFERENCE_TIME waited = m_waited;
+        m_waited = 0;
+        return waited;
+    }
+
+private:
+    REFERENCE_TIME m_now;
+    REFERENCE_TIME m_waited;
+};
+
+//------------------------------------------------------------------------------
+// フレーム列
+//------------------------------------------------------------------------------
+struct Frame {
+    REFERENCE_TIME rtStart;
+    REFERENCE_TIME rtEnd;
+};
+
+class FrameSource {
+public:
+    virtual ~FrameSource() {}
+    // 次のフレームを pData (stride * height バイト、DIB の行順) へ書き込む。終端なら false
+    virtual bool Next(BYTE *pData, Frame &frame) = 0;
+};
+
+// ffmpeg の rawvideo (上から下の行順、行間の余白なし)
+class RawFileSource : public FrameSource {
+public:
+    RawFileSource() : m_fp(NULL), m_width(0), m_height(0), m_bytes(0), m_stride(0), m_interval(0), m_index(0) {}
+    ~RawFileSource() override {
+        if (m_fp) fclose(m_fp);
+    }
+
+    bool Open(const char *path, int width, int height, int bpp, int stride, REFERENCE_TIME interval,
+              const std::vector<REFERENCE_TIME> &timestamps) {
+        m_fp = fopen(path, "rb");
+        if (!m_fp) return false;
+        m_width = width;
+        m_height = height;
+        m_bytes = bpp / 8;
+        m_stride = stride;
+        m_interval = interval;
+        m_timestamps = timestamps;
+        m_row.resize((size_t)width * m_bytes);
+        return true;
+    }
+
+    bool Next(BYTE *pData, Frame &frame) override {
+        if (!m_timestamps.empty() && m_index >= m_timestamps.size()) return false;
+        for (int y = 0; y < m_height; y++) {
+            if (fread(m_row.data(), 1, m_row.size(), m_fp) != m_row.size()) return false;
+            memcpy(pData + (size_t)(m_height - 1 - y) * m_stride, m_row.data(), m_row.size());
+        }
+        if (m_timestamps.empty()) {
+            frame.rtStart = (REFERENCE_TIME)m_index * m_interval;
+            frame.rtEnd = frame.rtStart + m_interval;
+        } else {
+            frame.rtStart = m_timestamps[m_index];
+            frame.rtEnd = -1;
+            if (frame.rtStart >= 0) {
+                // 終了時刻は次のフレームの開始 (最後のフレームは直前の間隔、分からなければ --fps の間隔)
+                REFERENCE_TIME next = (m_index + 1 < m_timestamps.size()) ? m_timestamps[m_index + 1] : -1;
+                if (next <= frame.rtStart) {
+                    next = frame.rtStart + (m_interval > 0 ? m_interval : kSyntheticInterval);
+                }
+                frame.rtEnd = next;
+            }
+        }
+        m_index++;
+        return true;
+    }
+
+private:
+    FILE *m_fp;
+    int m_width;
+    int m_height;
+    int m_bytes;
+    int m_stride;
+    REFERENCE_TIME m_interval;
+    std::vector<REFERENCE_TIME> m_timestamps;   // 空: m_interval の等間隔
+    std::vector<BYTE> m_row;
+    size_t m_index;
+};
+
+// 合成映像: 上下に黒帯のある動く模様 → kSyntheticCutFrame から黒帯のない別の模様
+class SyntheticSource : public FrameSource {
+public:
+    SyntheticSource(int frames, int stride) : m_frames(frames), m_stride(stride), m_index(0), m_noise(12345) {}
+
+    bool Next(BYTE *pData, Frame &frame) override {
+        if (m_index >= m_frames) return false;
+        const bool letterboxed = (m_index < kSyntheticCutFrame);
+        for (int y = 0; y < kSyntheticHeight; y++) {
+            BYTE *row = pData + (size_t)y * m_stride;
+            const bool bar = letterboxed && (y < kSyntheticBar || y >= kSyntheticHeight - kSyntheticBar);
+            for (int x = 0; x < kSyntheticWidth; x++) {
+                BYTE *px = row + x * 4;
+                if (bar) {
+                    // 黒帯にも圧縮ノイズ程度の揺らぎを入れる (閾値未満)
+                    const BYTE v = (BYTE)(Noise() & 0x07);
+                    px[0] = px[1] = px[2] = v;
+                } else if (letterboxed) {
+                    px[0] = (BYTE)(64 + ((x + m_index * 3) & 0x7F));
+                    px[1] = (BYTE)(64 + ((y * 2 + m_index) & 0x7F));
+                    px[2] = (BYTE)(96 + (Noise() & 0x3F));
+                } else {
+                    px[0] = (BYTE)(160 + ((x ^ y) & 0x3F));
+                    px[1] = (BYTE)(32 + ((x + y + m_index * 5) & 0x3F));
+                    px[2] = (BYTE)(64 + (Noise() & 0x7F));
+                }
+                px[3] = 0;
+            }
+        }
+        frame.rtStart = (REFERENCE_TIME)m_index * kSyntheticInterval;
+        frame.rtEnd = frame.rtStart + kSyntheticInterval;
+        m_index++;
+        return true;
+    }
+
+private:
+    unsigned Noise() {
+        m_noise ^= m_noise << 13;
+        m_noise ^= m_noise >> 17;
+        m_noise ^= m_noise << 5;
+        return m_noise >> 8;
+    }
+
+    int m_frames;
+    int m_stride;
+    int m_index;
+    unsigned m_noise;
+};
+
+//------------------------------------------------------------------------------
+// オプション
+//------------------------------------------------------------------------------
+struct Options {
+    std::string rawPath;
+    std::string timestampsPath;
+    bool synthetic = false;
+    int width = 0;
+    int height = 0;
+    int bpp = 24;
+    double fps = 0.0;
+
+    int outputWidth = DEFAULT_OUTPUT_WIDTH;
+    int outputHeight = DEFAULT_OUTPUT_HEIGHT;
+    bool setAlgo = false;
+    ResizeAlgorithm algo = RESIZE_BILINEAR;
+    bool noKeepAspect = false;
+    int maxFPS = -1;                    // -1: 既定 (FPS制限なし)、0: 制限なし
+    int brightness = -1;                // -1: 既定
+    bool noLetterbox = false;
+    int lbThreshold = -1;
+    int lbStability = -1;
+    bool passthrough = false;
+    bool dummy = false;
+
+    int maxFrames = 0;                  // 0: すべて
+    double decodeMs = 0.0;              // 1フレームごとに模擬時計を進める上流の処理時間
+    bool realtime = true;               // フレームが表示時刻より前に届かない (上流が参照クロックで送る)
+    bool chargeCost = false;
+    bool csv = false;
+    bool quiet = false;
+    bool check = false;
+};
+
+// フレームごとの判定
+enum Decision {
+    DECISION_OUTPUT = 0,
+    DECISION_DROP,          // FPS制限でドロップ
+    DECISION_SKIP           // ダミーモード等で出力なし
+};
+
+const char *DecisionName(Decision decision) {
+    switch (decision) {
+    case DECISION_OUTPUT: return "output";
+    case DECISION_DROP:   return "drop";
+    default:              return "skip";
+    }
+}
+
+const char *LetterboxModeName(LetterboxMode mode) {
+    switch (mode) {
+    case LB_MODE_16_9:   return "16:9";
+    case LB_MODE_4_3:    return "4:3";
+    case LB_MODE_CUSTOM: return "custom";
+    default:             return "original";
+    }
+}
+
+struct FrameRecord {
+    Decision decision;
+    LetterboxMode mode;
+    bool cropped;
+    RECT crop;
+};
+
+double QpcToUs(LONGLONG delta, LONGLONG freq) { return delta * 1000000.0 / freq; }
+
+//------------------------------------------------------------------------------
+// Replay - 再生の本体
+//------------------------------------------------------------------------------
+class Replay {
+public:
+    explicit Replay(const Options &options) : m_options(options), m_logic(&m_settings, NULL) {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        m_qpcFreq = freq.QuadPart;
+    }
+
+    int Run() {
+        int srcWidth = m_options.width;
+        int srcHeight = m_options.height;
+        int srcBpp = m_options.bpp;
+        REFERENCE_TIME srcInterval = (m_options.fps > 0.0) ? (REFERENCE_TIME)(10000000.0 / m_options.fps + 0.5) : 0;
+        if (m_options.synthetic) {
+            srcWidth = kSyntheticWidth;
+            srcHeight = kSyntheticHeight;
+            srcBpp = 32;
+            srcInterval = kSyntheticInterval;
+        }
+        const int srcStride = ((srcWidth * (srcBpp / 8) + 3) & ~3);
+
+        // 入力
+        std::unique_ptr<FrameSource> source;
+        if (m_options.synthetic) {
+            source.reset(new SyntheticSource(m_options.maxFrames > 0 ? m_options.maxFrames : kSyntheticFrames,
+                                             srcStride));
+        } else {
+            std::vector<REFERENCE_TIME> timestamps;
+            if (!m_options.timestampsPath.empty() && !LoadTimestamps(m_options.timestampsPath, timestamps)) {
+                fprintf(stderr, "Cannot read timestamps: %s\n", m_options.timestampsPath.c_str());
+                return 2;
+            }
+            if (timestamps.empty() && srcInterval <= 0) {
+                fprintf(stderr, "--fps or --timestamps is required for --raw.\n");
+                return 2;
+            }
+            RawFileSource *raw = new RawFileSource();
+            source.reset(raw);
+            if (!raw->Open(m_options.rawPath.c_str(), srcWidth, srcHeight, srcBpp, srcStride, srcInterval,
+                           timestamps)) {
+                fprintf(stderr, "Cannot open: %s\n", m_options.rawPath.c_str());
+                return 2;
+            }
+        }
+
+        // 設定 (フィルタの既定値に、指定されたものだけを上書きする。レジストリは読まない)
+        ApplySettings();
+        // スナップショットはフィルタが公開するのと同じ作り方 (外部ウィンドウは無効)
+        LR2BGASettings::Snapshot cfg = {};
+        m_settings.BuildSnapshot(cfg);
+
+        // フィルタの StartStreaming と同じ出力サイズの決め方 (パススルーは入力サイズ)
+        const int dstWidth = cfg.passthroughMode ? srcWidth : cfg.outputWidth;
+        const int dstHeight = cfg.passthroughMode ? srcHeight : cfg.outputHeight;
+        const int dstStride = ((dstWidth * 3 + 3) & ~3);
+
+        m_logic.SetClock(&m_clock);
+        m_logic.SetSynchronousLetterbox(true);
+        m_logic.StartStreaming(cfg, srcWidth, srcHeight, srcBpp, dstWidth, dstHeight, srcInterval);
+
+        std::vector<BYTE> src((size_t)srcStride * srcHeight);
+        std::vector<BYTE> dst((size_t)dstStride * dstHeight);
+
+        if (!m_options.quiet) {
+            printf("# LR2BGAReplay: %dx%d %dbpp -> %dx%d, %s%s, max fps %s, letterbox %s, kernel tier %s\n",
+                   srcWidth, srcHeight, srcBpp, dstWidth, dstHeight,
+                   cfg.resizeAlgo == RESIZE_NEAREST ? "nearest" : "bilinear",
+                   cfg.keepAspectRatio ? " (keep aspect)" : "",
+                   cfg.limitFPSEnabled ? std::to_string(cfg.maxFPS).c_str() : "off",
+                   cfg.autoRemoveLetterbox ? "auto" : "off",
+                   LR2BGAImageProc::GetKernelTierName(LR2BGAImageProc::GetKernelTier()));
+            PrintFrameHeader();
+        }
+
+        LARGE_INTEGER runStart, runEnd;
+        QueryPerformanceCounter(&runStart);
+        REFERENCE_TIME firstInput = -1, lastInput = -1;
+        int index = 0;
+        Frame frame;
+        while ((m_options.maxFrames <= 0 || index < m_options.maxFrames) && source->Next(src.data(), frame)) {
+            if (frame.rtStart >= 0) {
+                if (firstInput < 0) firstInput = frame.rtStart;
+                lastInput = frame.rtStart;
+            }
+            m_clock.Advance((REFERENCE_TIME)(m_options.decodeMs * 10000.0));
+            if (m_options.realtime && frame.rtStart >= 0) {
+                // 表示時刻より前には届かない (遅れている場合は届いた時点のまま)
+                m_clock.WaitUntil(kClockOrigin + (frame.rtStart - firstInput));
+                m_clock.TakeWaited();
+            }
+            const REFERENCE_TIME arrival = m_clock.Now();
+            ProcessFrame(index, frame, arrival, cfg, src.data(), srcWidth, srcHeight, srcStride, srcBpp,
+                         dst.data(), dstWidth, dstHeight, dstStride);
+            index++;
+        }
+        QueryPerformanceCounter(&runEnd);
+        m_logic.StopStreaming();
+
+        PrintSummary(index, firstInput, lastInput, runEnd.QuadPart - runStart.QuadPart);
+        if (m_options.check) {
+            return Check(index) ? 0 : 1;
+        }
+        return 0;
+    }
+
+private:
+    //--------------------------------------------------------------------------
+    // フレーム処理 (CLR2BGAFilter::ProcessFrame と同じ順序・同じ段階の記録)
+    //--------------------------------------------------------------------------
+    void ProcessFrame(int index, Frame frame, REFERENCE_TIME arrival, const LR2BGASettings::Snapshot &cfg,
+                      const BYTE *pSrc, int srcWidth, int srcHeight, int srcStride, int srcBpp,
+                      BYTE *pDst, int dstWidth, int dstHeight, int dstStride) {
+        LR2BGAStageStats &stageStats = m_logic.GetStageStats();
+        LARGE_INTEGER stageStart, stageEnd, startTime, endTime;
+
+        // FPS制限 (模擬時計の待機は時刻を進めるだけ)
+        QueryPerformanceCounter(&stageStart);
+        const HRESULT hrWait = m_logic.WaitFPSLimit(cfg, frame.rtStart, frame.rtEnd);
+        QueryPerformanceCounter(&stageEnd);
+        const bool dropByFPS = (hrWait == S_FALSE);
+        stageStats.Record(STAGE_FPS_WAIT, stageStart.QuadPart, stageEnd.QuadPart, frame.rtStart, dropByFPS ? 1 : 0);
+        const REFERENCE_TIME waited = m_clock.TakeWaited();
+        REFERENCE_TIME late = 0;
+        const bool lateValid = m_logic.GetTimelineLateness(late);
+        const double fpsUs = QpcToUs(stageEnd.QuadPart - stageStart.QuadPart, m_qpcFreq);
+
+        // 黒帯検出
+        QueryPerformanceCounter(&startTime);
+        RECT srcRect = {0, 0, srcWidth, srcHeight};
+        RECT *pSrcRect = NULL;
+        m_logic.ProcessLetterboxDetection(cfg, pSrc, (long)srcStride * srcHeight, srcWidth, srcHeight, srcStride,
+                                          srcBpp, srcRect, pSrcRect);
+        QueryPerformanceCounter(&stageEnd);
+        stageStats.Record(STAGE_LETTERBOX, startTime.QuadPart, stageEnd.QuadPart, 0, pSrcRect ? 1 : 0);
+        const double lbUs = QpcToUs(stageEnd.QuadPart - startTime.QuadPart, m_qpcFreq);
+
+        FrameRecord record;
+        record.mode = m_logic.GetCurrentLetterboxMode();
+        record.cropped = (pSrcRect != NULL);
+        record.crop = srcRect;
+
+        // 出力の生成
+        double fillUs = 0.0;
+        UINT64 hash = 0;
+        if (dropByFPS) {
+            record.decision = DECISION_DROP;
+            QueryPerformanceCounter(&endTime);
+            stageStats.Record(STAGE_TOTAL, startTime.QuadPart, endTime.QuadPart, frame.rtStart, TRACE_OUTCOME_FPS_DROP);
+        } else {
+            LARGE_INTEGER fillStart, fillEnd;
+            QueryPerformanceCounter(&fillStart);
+            REFERENCE_TIME rtStart = frame.rtStart, rtEnd = frame.rtEnd;
+            long outLength = 0;
+            const HRESULT hrFill = m_logic.FillOutputBuffer(cfg, pSrc, pDst, srcWidth, srcHeight, srcStride, srcBpp,
+                                                            dstWidth, dstHeight, dstStride, pSrcRect, rtStart,
+                                                            rtEnd, outLength);
+            QueryPerformanceCounter(&fillEnd);
+            fillUs = QpcToUs(fillEnd.QuadPart - fillStart.QuadPart, m_qpcFreq);
+            m_clock.TakeWaited();  // ダミーモードの待機は出力の判定に影響しない
+            if (hrFill == S_OK) {
+                record.decision = DECISION_OUTPUT;
+                hash = LR2BGAImageProc::HashRows(pDst, dstWidth * 3, dstHeight, dstStride);
+                stageStats.Record(STAGE_TOTAL, startTime.QuadPart, fillEnd.QuadPart, frame.rtStart,
+                                  TRACE_OUTCOME_OUTPUT);
+                stageStats.RecordOutput(fillEnd.QuadPart);
+            } else {
+                record.decision = DECISION_SKIP;
+                stageStats.Record(STAGE_TOTAL, startTime.QuadPart, fillStart.QuadPart, frame.rtStart,
+                                  TRACE_OUTCOME_SKIP);
+            }
+        }
+        QueryPerformanceCounter(&endTime);
+
+        if (m_options.chargeCost) {
+            m_clock.Advance((endTime.QuadPart - stageStart.QuadPart) * 10000000 / m_qpcFreq);
+        }
+
+        m_records.push_back(record);
+        if (record.decision == DECISION_OUTPUT) {
+            m_outputTimes.push_back(m_clock.Now());
+        }
+        if (!m_options.quiet) {
+            PrintFrame(index, frame, arrival, waited, lateValid, late, record, hash, fpsUs, lbUs, fillUs);
+        }
+        if (m_modeChanges.empty() || m_records.size() < 2 ||
+            m_records[m_records.size() - 2].mode != record.mode ||
+            m_records[m_records.size() - 2].cropped != record.cropped ||
+            !EqualRect(&m_records[m_records.size() - 2].crop, &record.crop)) {
+            m_modeChanges.push_back(index);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // 出力
+    //--------------------------------------------------------------------------
+    void PrintFrameHeader() const {
+        if (m_options.csv) {
+            printf("frame,input_ms,clock_ms,wait_ms,late_ms,decision,lb_mode,crop_left,crop_top,crop_right,"
+                   "crop_bottom,hash,fps_us,lb_us,fill_us\n");
+        } else {
+            printf("%6s %10s %10s %7s %7s %-6s %-8s %-21s %-16s %7s %7s %8s\n", "frame", "input_ms", "clock_ms",
+                   "wait", "late", "result", "lb_mode", "crop", "hash", "fps_us", "lb_us", "fill_us");
+        }
+    }
+
+    void PrintFrame(int index, const Frame &frame, REFERENCE_TIME arrival, REFERENCE_TIME waited, bool lateValid,
+                    REFERENCE_TIME late, const FrameRecord &record, UINT64 hash, double fpsUs, double lbUs,
+                    double fillUs) const {
+        const double inputMs = (frame.rtStart >= 0) ? frame.rtStart / 10000.0 : -1.0;
+        const double clockMs = (arrival - kClockOrigin) / 10000.0;
+        char crop[48] = "-";
+        if (record.cropped) {
+            snprintf(crop, sizeof(crop), "%ld,%ld,%ld,%ld", (long)record.crop.left, (long)record.crop.top,
+                     (long)record.crop.right, (long)record.crop.bottom);
+        }
+        char hashText[24] = "-";
+        if (record.decision == DECISION_OUTPUT) {
+            snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)hash);
+        }
+        char lateText[16] = "-";
+        if (lateValid) snprintf(lateText, sizeof(lateText), "%.2f", late / 10000.0);
+
+        if (m_options.csv) {
+            printf("%d,%.3f,%.3f,%.3f,%s,%s,%s,", index, inputMs, clockMs, waited / 10000.0, lateValid ? lateText : "",
+                   DecisionName(record.decision), LetterboxModeName(record.mode));
+            if (record.cropped) {
+                printf("%ld,%ld,%ld,%ld,", (long)record.crop.left, (long)record.crop.top, (long)record.crop.right,
+                       (long)record.crop.bottom);
+            } else {
+                printf(",,,,");
+            }
+            printf("%s,%.1f,%.1f,%.1f\n", record.decision == DECISION_OUTPUT ? hashText : "", fpsUs, lbUs, fillUs);
+        } else {
+            printf("%6d %10.3f %10.3f %7.2f %7s %-6s %-8s %-21s %-16s %7.1f %7.1f %8.1f\n", index, inputMs, clockMs,
+                   waited / 10000.0, lateText, DecisionName(record.decision), LetterboxModeName(record.mode), crop,
+                   hashText, fpsUs, lbUs, fillUs);
+        }
+    }
+
+    void PrintSummary(int frames, REFERENCE_TIME firstInput, REFERENCE_TIME lastInput, LONGLONG runQpc) const {
+        int outputs = 0, drops = 0, skips = 0;
+        for (const FrameRecord &r : m_records) {
+            if (r.decision == DECISION_OUTPUT) outputs++;
+            else if (r.decision == DECISION_DROP) drops++;
+            else skips++;
+        }
+        printf("# frames %d: output %d, drop %d, skip %d\n", frames, outputs, drops, skips);
+
+        if (m_outputTimes.size() >= 2 && m_outputTimes.back() > m_outputTimes.front()) {
+            const double spanSec = (m_outputTimes.back() - m_outputTimes.front()) / 10000000.0;
+            printf("# output rate (simulated clock): %.3f fps", (m_outputTimes.size() - 1) / spanSec);
+            if (lastInput > firstInput) {
+                printf(" (input %.3f fps)", (frames - 1) / ((lastInput - firstInput) / 10000000.0));
+            }
+            printf("\n");
+        }
+
+        FrameIntervalHistogram hist;
+        m_logic.GetFrameIntervalHistogram(hist);
+        if (hist.samples > 0) {
+            const double mean = hist.sumMs / hist.samples;
+            double variance = hist.sumSqMs / hist.samples - mean * mean;
+            if (variance < 0.0) variance = 0.0;
+            printf("# output interval: mean %.3f ms, sd %.3f ms, min %.3f ms, max %.3f ms", mean,
+                   sqrt(variance), hist.minMs, hist.maxMs);
+            if (hist.targetMs > 0.0) printf(" (target %.3f ms)", hist.targetMs);
+            printf("\n");
+        }
+
+        CadenceInfo cadence;
+        m_logic.GetCadenceInfo(cadence);
+        if (cadence.active) {
+            printf("# cadence: %.3f -> %.3f fps, rms error %.3f ms, max error %.3f ms, missed slots %lld\n",
+                   cadence.sourceFps, cadence.targetFps, cadence.rmsErrorMs, cadence.maxErrorMs, (long long)cadence.missedSlots);
+        }
+
+        printf("# letterbox changes:\n");
+        for (int index : m_modeChanges) {
+            const FrameRecord &r = m_records[index];
+            if (r.cropped) {
+                printf("#   frame %6d: %-8s crop (%ld,%ld)-(%ld,%ld)\n", index, LetterboxModeName(r.mode),
+                       (long)r.crop.left, (long)r.crop.top, (long)r.crop.right, (long)r.crop.bottom);
+            } else {
+                printf("#   frame %6d: %-8s no crop\n", index, LetterboxModeName(r.mode));
+            }
+        }
+
+        static const struct {
+            LR2BGAStage stage;
+            const char *name;
+        } kStages[] = {
+            {STAGE_FPS_WAIT, "fps_wait"},
+            {STAGE_LETTERBOX, "letterbox"},
+            {STAGE_RESIZE, "resize"},
+            {STAGE_BRIGHTNESS, "brightness"},
+            {STAGE_TOTAL, "total"},
+        };
+        printf("# stage latency (real time, ms): %-10s %8s %8s %8s %8s %8s %8s\n", "stage", "samples", "mean", "p50",
+               "p95", "p99", "max");
+        for (const auto &s : kStages) {
+            LR2BGAStageLatency latency;
+            m_logic.GetStageStats().GetStageLatency(s.stage, latency);
+            if (latency.samples == 0) continue;
+            printf("#                                %-10s %8lld %8.3f %8.3f %8.3f %8.3f %8.3f\n", s.name,
+                   (long long)latency.samples, latency.meanMs, latency.p50Ms, latency.p95Ms, latency.p99Ms, latency.maxMs);
+        }
+        const double runSec = (double)runQpc / m_qpcFreq;
+        printf("# replay: %.3f s real time, %.1f frames/s\n", runSec, runSec > 0.0 ? frames / runSec : 0.0);
+    }
+
+    //--------------------------------------------------------------------------
+    // --check: 合成映像の既知の答えと照合する
+    //--------------------------------------------------------------------------
+    bool Check(int frames) const {
+        bool ok = true;
+        auto fail = [&ok](const char *message, int frame) {
+            fprintf(stderr, "check failed: %s (frame %d)\n", message, frame);
+            ok = false;
+        };
+        if (!m_options.synthetic) {
+            fprintf(stderr, "check failed: --check requires --synthetic\n");
+            return false;
+        }
+        for (int i = 0; i < frames && m_settings.m_autoRemoveLetterbox; i++) {
+            const FrameRecord &r = m_records[i];
+            if (i >= kCheckSettleFrames && i < kSyntheticCutFrame) {
+                // 黒帯が確定し、16:9 のコンテンツを欠かさず黒帯の近くで切り出し続けている
+                const bool contentKept = r.cropped && r.crop.left == 0 && r.crop.right == kSyntheticWidth &&
+                                         r.crop.top <= kSyntheticBar &&
+                                         r.crop.bottom >= kSyntheticHeight - kSyntheticBar;
+                const bool barsRemoved = r.crop.top >= kSyntheticBar - kCheckBarTolerance &&
+                                         r.crop.bottom <= kSyntheticHeight - kSyntheticBar + kCheckBarTolerance;
+                if (r.mode != LB_MODE_16_9 || !contentKept || !barsRemoved) {
+                    fail("letterbox crop is not the 16:9 content area", i);
+                    break;
+                }
+            } else if (i >= kSyntheticCutFrame + kCheckSettleFrames) {
+                // 黒帯のないシーンへの切り替えで切り出しが解除されている
+                if (r.cropped && !(r.crop.top == 0 && r.crop.bottom == kSyntheticHeight &&
+                                   r.crop.left == 0 && r.crop.right == kSyntheticWidth)) {
+                    fail("crop was not released after the scene cut", i);
+                    break;
+                }
+            }
+        }
+        if (m_settings.m_limitFPSEnabled && m_settings.m_maxFPS > 0 && !m_settings.m_dummyMode) {
+            int outputs = 0;
+            for (const FrameRecord &r : m_records) {
+                if (r.decision == DECISION_OUTPUT) outputs++;
+            }
+            // 入力の時間長に対する期待出力数 (±1)
+            const double durationSec = frames * kSyntheticInterval / 10000000.0;
+            const double expectedOutputs = min(durationSec * m_settings.m_maxFPS, (double)frames);
+            if (outputs < expectedOutputs - 1.0 || outputs > expectedOutputs + 1.0) {
+                fprintf(stderr, "check failed: %d outputs, expected %.1f\n", outputs, expectedOutputs);
+                ok = false;
+            }
+        }
+        printf("# check: %s\n", ok ? "OK" : "FAILED");
+        return ok;
+    }
+
+    //--------------------------------------------------------------------------
+    // 設定
+    //--------------------------------------------------------------------------
+    void ApplySettings() {
+        if (m_options.synthetic && m_options.maxFPS < 0) {
+            // 合成映像は 59.94fps → 30fps の間引きを既定で確かめる
+            m_settings.m_limitFPSEnabled = true;
+            m_settings.m_maxFPS = 30;
+        }
+        m_settings.m_outputWidth = m_options.outputWidth;
+        m_settings.m_outputHeight = m_options.outputHeight;
+        if (m_options.setAlgo) m_settings.m_resizeAlgo = m_options.algo;
+        if (m_options.noKeepAspect) m_settings.m_keepAspectRatio = false;
+        if (m_options.maxFPS > 0) {
+            m_settings.m_limitFPSEnabled = true;
+            m_settings.m_maxFPS = m_options.maxFPS;
+        } else if (m_options.maxFPS == 0) {
+            m_settings.m_limitFPSEnabled = false;
+        }
+        if (m_options.brightness >= 0) m_settings.m_brightnessLR2 = m_options.brightness;
+        if (m_options.noLetterbox) m_settings.m_autoRemoveLetterbox = false;
+        if (m_options.lbThreshold >= 0) m_settings.m_lbThreshold = m_options.lbThreshold;
+        if (m_options.lbStability > 0) m_settings.m_lbStability = m_options.lbStability;
+        m_settings.m_passthroughMode = m_options.passthrough;
+        m_settings.m_dummyMode = m_options.dummy;
+        m_settings.m_debugMode = false;
+        m_settings.m_extWindowEnabled = false;
+    }
+
+    // 1行1フレームの時刻 (秒)。数値でない行 (ffprobe の N/A) は無効なタイムスタンプとして渡す
+    static bool LoadTimestamps(const std::string &path, std::vector<REFERENCE_TIME> &out) {
+        FILE *fp = fopen(path.c_str(), "r");
+        if (!fp) return false;
+        char line[128];
+        while (fgets(line, sizeof(line), fp)) {
+            char *end = NULL;
+            const double sec = strtod(line, &end);
+            if (end == line) {
+                bool blank = true;
+                for (const char *p = line; *p; p++) {
+                    if (*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') blank = false;
+                }
+                if (!blank) out.push_back(-1);
+                continue;
+            }
+            out.push_back((REFERENCE_TIME)(sec * 10000000.0 + 0.5));
+        }
+        fclose(fp);
+        return !out.empty();
+    }
+
+    Options m_options;
+    LR2BGASettings m_settings;
+    LR2BGATransformLogic m_logic;
+    SimulatedClock m_clock;
+    LONGLONG m_qpcFreq;
+
+    std::vector<FrameRecord> m_records;
+    std::vector<REFERENCE_TIME> m_outputTimes;   // 出力したフレームの模擬時計の時刻
+    std::vector<int> m_modeChanges;              // 黒帯の判定・切り出し範囲が変わったフレーム
+};
+
+bool ParseSize(const char *text, int &width, int &height) {
+    return sscanf(text, "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+}
+
+void PrintUsage() {
+    printf("Usage: LR2BGAReplay (--raw <file> --size WxH [--bpp 24|32] [--fps <f>] [--timestamps <file>]\n"
+           "                    | --synthetic)\n"
+           "                    [--output WxH] [--algo nearest|bilinear] [--no-keep-aspect] [--max-fps <n>]\n"
+           "                    [--brightness <0-100>] [--no-letterbox] [--lb-threshold <n>] [--lb-stability <n>]\n"
+           "                    [--passthrough] [--dummy] [--frames <n>] [--decode-ms <ms>] [--no-realtime]\n"
+           "                    [--charge-cost] [--csv] [--quiet] [--check]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool hasValue = (i + 1 < argc);
+        if (strcmp(arg, "--raw") == 0 && hasValue) {
+            options.rawPath = argv[++i];
+        } else if (strcmp(arg, "--size") == 0 && hasValue) {
+            if (!ParseSize(argv[++i], options.width, options.height)) {
+                fprintf(stderr, "Invalid size: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--bpp") == 0 && hasValue) {
+            options.bpp = atoi(argv[++i]);
+            if (options.bpp != 24 && options.bpp != 32) {
+                fprintf(stderr, "Unsupported bit depth: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--fps") == 0 && hasValue) {
+            options.fps = atof(argv[++i]);
+        } else if (strcmp(arg, "--timestamps") == 0 && hasValue) {
+            options.timestampsPath = argv[++i];
+        } else if (strcmp(arg, "--synthetic") == 0) {
+            options.synthetic = true;
+        } else if (strcmp(arg, "--output") == 0 && hasValue) {
+            if (!ParseSize(argv[++i], options.outputWidth, options.outputHeight)) {
+                fprintf(stderr, "Invalid size: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--algo") == 0 && hasValue) {
+            const char *algo = argv[++i];
+            options.setAlgo = true;
+            if (strcmp(algo, "nearest") == 0) {
+                options.algo = RESIZE_NEAREST;
+            } else if (strcmp(algo, "bilinear") == 0) {
+                options.algo = RESIZE_BILINEAR;
+            } else {
+                fprintf(stderr, "Unknown algorithm: %s\n", algo);
+                return 2;
+            }
+        } else if (strcmp(arg, "--no-keep-aspect") == 0) {
+            options.noKeepAspect = true;
+        } else if (strcmp(arg, "--max-fps") == 0 && hasValue) {
+            options.maxFPS = atoi(argv[++i]);
+            if (options.maxFPS < 0) options.maxFPS = 0;
+        } else if (strcmp(arg, "--brightness") == 0 && hasValue) {
+            options.brightness = atoi(argv[++i]);
+            if (options.brightness < 0) options.brightness = 0;
+            if (options.brightness > 100) options.brightness = 100;
+        } else if (strcmp(arg, "--no-letterbox") == 0) {
+            options.noLetterbox = true;
+        } else if (strcmp(arg, "--lb-threshold") == 0 && hasValue) {
+            options.lbThreshold = atoi(argv[++i]);
+        } else if (strcmp(arg, "--lb-stability") == 0 && hasValue) {
+            options.lbStability = atoi(argv[++i]);
+        } else if (strcmp(arg, "--passthrough") == 0) {
+            options.passthrough = true;
+        } else if (strcmp(arg, "--dummy") == 0) {
+            options.dummy = true;
+        } else if (strcmp(arg, "--frames") == 0 && hasValue) {
+            options.maxFrames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--decode-ms") == 0 && hasValue) {
+            options.decodeMs = atof(argv[++i]);
+            if (options.decodeMs < 0.0) options.decodeMs = 0.0;
+        } else if (strcmp(arg, "--no-realtime") == 0) {
+            options.realtime = false;
+        } else if (strcmp(arg, "--charge-cost") == 0) {
+            options.chargeCost = true;
+        } else if (strcmp(arg, "--csv") == 0) {
+            options.csv = true;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+        } else if (strcmp(arg, "--check") == 0) {
+            options.check = true;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (!options.synthetic && (options.rawPath.empty() || options.width <= 0)) {
+        PrintUsage();
+        return 2;
+    }
+
+    Replay replay(options);
+    return replay.Run();
+}
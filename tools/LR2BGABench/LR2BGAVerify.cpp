@@ -0,0 +1,411 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAVerify.cpp
+// LR2 BGA Filter - 画像処理カーネルの実装段階間の一致検証 実装
+//------------------------------------------------------------------------------
+
+#include "LR2BGAVerify.h"
+
+#include "LR2BGAImageProc.h"
+#include "LR2BGAThreadPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+typedef LR2BGAImageProc::KernelTier KernelTier;
+
+// 浮動小数点の基準実装 (Cpp) と固定小数点版の差の上限
+// どちらも切り捨てで、差は重みの量子化 (11bit) による1未満のずれが整数部に出る分だけ
+constexpr int kBilinearReferenceTolerance = 1;
+constexpr BYTE kSentinel = 0xA5;       // 出力バッファの初期値 (書かれない画素の検出用)
+constexpr int kMaxSourceSize = 160;
+constexpr int kMaxOutputSize = 200;
+constexpr int kMaxLumaWidth = 300;
+
+//------------------------------------------------------------------------------
+// GuardedBuffer - 前後をアクセス不可のページで挟んだバッファ
+// guardAfter=true なら末尾の直後、false なら先頭の直前がアクセス不可のページになる。
+//------------------------------------------------------------------------------
+class GuardedBuffer {
+public:
+    GuardedBuffer() : m_base(NULL), m_total(0), m_data(NULL), m_size(0) {}
+    ~GuardedBuffer() { Release(); }
+
+    GuardedBuffer(const GuardedBuffer &) = delete;
+    GuardedBuffer &operator=(const GuardedBuffer &) = delete;
+
+    bool Allocate(size_t size, bool guardAfter) {
+        Release();
+        const size_t page = PageSize();
+        const size_t body = (size + page - 1) / page * page;
+        m_total = body + page * 2;
+#if defined(_WIN32)
+        m_base = (BYTE *)VirtualAlloc(NULL, m_total, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!m_base) return false;
+        DWORD oldProtect;
+        VirtualProtect(m_base, page, PAGE_NOACCESS, &oldProtect);
+        VirtualProtect(m_base + page + body, page, PAGE_NOACCESS, &oldProtect);
+#else
+        void *p = mmap(NULL, m_total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return false;
+        m_base = (BYTE *)p;
+        mprotect(m_base, page, PROT_NONE);
+        mprotect(m_base + page + body, page, PROT_NONE);
+#endif
+        m_data = guardAfter ? m_base + page + body - size : m_base + page;
+        m_size = size;
+        return true;
+    }
+
+    BYTE *Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    static size_t PageSize() {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    }
+
+    void Release() {
+        if (!m_base) return;
+#if defined(_WIN32)
+        VirtualFree(m_base, 0, MEM_RELEASE);
+#else
+        munmap(m_base, m_total);
+#endif
+        m_base = NULL;
+        m_data = NULL;
+    }
+
+    BYTE *m_base;
+    size_t m_total;
+    BYTE *m_data;
+    size_t m_size;
+};
+
+//------------------------------------------------------------------------------
+// 乱数 (xorshift32。シードが同じなら環境によらず同じケースを生成する)
+//------------------------------------------------------------------------------
+class Random {
+public:
+    explicit Random(unsigned seed) : m_state(seed ? seed : 1) {}
+
+    unsigned Next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    // [lo, hi] の整数
+    int Range(int lo, int hi) { return lo + (int)(Next() % (unsigned)(hi - lo + 1)); }
+    bool Chance(int percent) { return Range(0, 99) < percent; }
+
+    void Fill(BYTE *p, size_t size) {
+        for (size_t i = 0; i < size; i++) p[i] = (BYTE)(Next() >> 24);
+    }
+
+private:
+    unsigned m_state;
+};
+
+//------------------------------------------------------------------------------
+// リサイズのケース
+//------------------------------------------------------------------------------
+struct ResizeCase {
+    int srcWidth, srcHeight, srcBpp, srcStride;
+    bool useCrop;
+    RECT crop;
+    int dstWidth, dstHeight, dstStride;
+    int actualWidth, actualHeight, offsetX, offsetY;
+    bool guardAfter;
+    int threads;
+};
+
+void PrintCase(const ResizeCase &c) {
+    fprintf(stderr, "  src %dx%d %dbpp stride %d, crop %s(%ld,%ld)-(%ld,%ld), dst %dx%d stride %d, "
+                    "actual %dx%d offset (%d,%d), guard %s, threads %d\n",
+            c.srcWidth, c.srcHeight, c.srcBpp, c.srcStride, c.useCrop ? "" : "none ", (long)c.crop.left,
+            (long)c.crop.top, (long)c.crop.right, (long)c.crop.bottom, c.dstWidth, c.dstHeight, c.dstStride, c.actualWidth, c.actualHeight,
+            c.offsetX, c.offsetY, c.guardAfter ? "after" : "before", c.threads);
+}
+
+ResizeCase MakeResizeCase(Random &rng) {
+    ResizeCase c = {};
+    // 1-3画素の極端なサイズも一定の割合で混ぜる
+    c.srcWidth = rng.Chance(10) ? rng.Range(1, 3) : rng.Range(1, kMaxSourceSize);
+    c.srcHeight = rng.Chance(10) ? rng.Range(1, 3) : rng.Range(1, kMaxSourceSize);
+    c.srcBpp = rng.Chance(50) ? 32 : 24;
+    // フィルタのストライドは4バイト境界。行末の余白を増やしたケースも試す
+    c.srcStride = ((c.srcWidth * (c.srcBpp / 8) + 3) & ~3) + (rng.Chance(30) ? 4 * rng.Range(1, 4) : 0);
+
+    SetRect(&c.crop, 0, 0, c.srcWidth, c.srcHeight);
+    c.useCrop = rng.Chance(60);
+    if (c.useCrop) {
+        c.crop.left = rng.Range(0, c.srcWidth - 1);
+        c.crop.right = rng.Range(c.crop.left + 1, c.srcWidth);
+        c.crop.top = rng.Range(0, c.srcHeight - 1);
+        c.crop.bottom = rng.Range(c.crop.top + 1, c.srcHeight);
+        // 幅1・高さ1の切り出しを、範囲外の読み込みが起きやすい右端・下端に置く
+        if (rng.Chance(15)) {
+            c.crop.left = c.srcWidth - 1;
+            c.crop.right = c.srcWidth;
+        }
+        if (rng.Chance(15)) {
+            c.crop.top = c.srcHeight - 1;
+            c.crop.bottom = c.srcHeight;
+        }
+    }
+
+    c.dstWidth = rng.Range(1, kMaxOutputSize);
+    c.dstHeight = rng.Range(1, kMaxOutputSize);
+    c.dstStride = ((c.dstWidth * 3 + 3) & ~3);
+    if (rng.Chance(60)) {
+        LR2BGAImageProc::CalculateResizeDimensions(c.crop.right - c.crop.left, c.crop.bottom - c.crop.top,
+                                                   c.dstWidth, c.dstHeight, rng.Chance(70), c.actualWidth,
+                                                   c.actualHeight, c.offsetX, c.offsetY);
+    } else {
+        // 出力範囲からはみ出す配置 (各カーネルの端の処理を確かめる)
+        c.actualWidth = rng.Range(1, c.dstWidth + 8);
+        c.actualHeight = rng.Range(1, c.dstHeight + 8);
+        c.offsetX = rng.Range(-8, c.dstWidth - c.actualWidth + 8);
+        c.offsetY = rng.Range(-8, c.dstHeight - c.actualHeight + 8);
+    }
+    c.guardAfter = rng.Chance(70);
+    const int threadChoices[] = {0, 1, 2, 3};
+    c.threads = threadChoices[rng.Range(0, 3)];
+    return c;
+}
+
+class Verifier {
+public:
+    explicit Verifier(const VerifyOptions &options)
+        : m_options(options), m_maxTier(LR2BGAImageProc::GetMaxSupportedTier()), m_failures(0),
+          m_checks(0), m_maxReferenceDiff(0) {}
+
+    int Run() {
+        Random rng(m_options.seed);
+        for (int i = 0; i < m_options.iterations && m_failures == 0; i++) {
+            const ResizeCase c = MakeResizeCase(rng);
+            VerifyResize(c, rng, false);
+            VerifyResize(c, rng, true);
+            VerifyLuma(rng);
+        }
+        LR2BGAThreadPool::Instance().SetMaxParallelism(0);
+        LR2BGAImageProc::SetKernelTier(m_maxTier);
+
+        // CPU が対応しない段階 (AVX2 非対応機の AVX2 など) は比較から外している
+        const bool skipped = m_maxTier < LR2BGAImageProc::KERNEL_TIER_AVX2;
+        printf("# verify: %d cases (seed %u), %lld comparisons, tiers up to %s%s, "
+               "max |Cpp - CppOpt| bilinear = %d (limit %d): %s\n",
+               m_options.iterations, m_options.seed, m_checks, LR2BGAImageProc::GetKernelTierName(m_maxTier),
+               skipped ? " (higher tiers skipped: not supported by this CPU)" : "",
+               m_maxReferenceDiff, kBilinearReferenceTolerance, m_failures ? "FAILED" : "OK");
+        return m_failures ? 1 : 0;
+    }
+
+private:
+    void Fail(const ResizeCase *c, const char *what, const char *tier, const char *against, size_t offset,
+              int got, int expected) {
+        if (m_failures++ == 0 || m_options.verbose) {
+            fprintf(stderr, "verify: %s mismatch (%s vs %s) at byte %zu: %d != %d\n", what, tier, against,
+                    offset, got, expected);
+            if (c) PrintCase(*c);
+        }
+    }
+
+    void ResetOutput(GuardedBuffer &buffer, const ResizeCase &c) {
+        buffer.Allocate((size_t)c.dstStride * c.dstHeight, c.guardAfter);
+        memset(buffer.Data(), kSentinel, buffer.Size());
+    }
+
+    // 書き込まれるべき画素 (出力範囲と配置の重なり) か
+    static bool InActiveArea(const ResizeCase &c, size_t offset) {
+        const int y = (int)(offset / c.dstStride);
+        const int xByte = (int)(offset % c.dstStride);
+        if (xByte >= c.dstWidth * 3) return false;
+        const int x = xByte / 3;
+        return x >= c.offsetX && x < c.offsetX + c.actualWidth && y >= c.offsetY && y < c.offsetY + c.actualHeight;
+    }
+
+    // 書き込まれない画素 (配置の外・行末の余白) が初期値のままか
+    void CheckUntouched(const ResizeCase &c, const GuardedBuffer &out, const char *what, const char *tier) {
+        for (size_t i = 0; i < out.Size(); i++) {
+            m_checks++;
+            if (!InActiveArea(c, i) && out.Data()[i] != kSentinel) {
+                Fail(&c, what, tier, "untouched", i, out.Data()[i], kSentinel);
+                return;
+            }
+        }
+    }
+
+    void CheckExact(const ResizeCase &c, const GuardedBuffer &out, const GuardedBuffer &expected, const char *what,
+                    const char *tier, const char *against) {
+        for (size_t i = 0; i < out.Size(); i++) {
+            m_checks++;
+            if (out.Data()[i] != expected.Data()[i]) {
+                Fail(&c, what, tier, against, i, out.Data()[i], expected.Data()[i]);
+                return;
+            }
+        }
+    }
+
+    void CheckWithin(const ResizeCase &c, const GuardedBuffer &out, const GuardedBuffer &expected, int tolerance,
+                     const char *what, const char *tier, const char *against) {
+        for (size_t i = 0; i < out.Size(); i++) {
+            m_checks++;
+            const int diff = abs((int)out.Data()[i] - (int)expected.Data()[i]);
+            if (diff > m_maxReferenceDiff) m_maxReferenceDiff = diff;
+            if (diff > tolerance) {
+                Fail(&c, what, tier, against, i, out.Data()[i], expected.Data()[i]);
+                return;
+            }
+        }
+    }
+
+    void RunSingle(const ResizeCase &c, const BYTE *pSrc, bool bilinear, KernelTier tier, GuardedBuffer &out) {
+        LR2BGAImageProc::SetKernelTier(tier);
+        ResetOutput(out, c);
+        std::vector<int> lutIndices;
+        std::vector<short> lutWeights;
+        const RECT *pCrop = c.useCrop ? &c.crop : NULL;
+        if (bilinear) {
+            LR2BGAImageProc::ResizeBilinear(pSrc, c.srcWidth, c.srcHeight, c.srcStride, c.srcBpp, out.Data(),
+                                            c.dstWidth, c.dstHeight, c.dstStride, 24, c.actualWidth,
+                                            c.actualHeight, c.offsetX, c.offsetY, pCrop, lutIndices, lutWeights);
+        } else {
+            LR2BGAImageProc::ResizeNearestNeighbor(pSrc, c.srcWidth, c.srcHeight, c.srcStride, c.srcBpp,
+                                                   out.Data(), c.dstWidth, c.dstHeight, c.dstStride, 24,
+                                                   c.actualWidth, c.actualHeight, c.offsetX, c.offsetY, pCrop,
+                                                   lutIndices);
+        }
+    }
+
+    void RunMulti(const ResizeCase &c, const BYTE *pSrc, bool bilinear, KernelTier tier, GuardedBuffer &out) {
+        LR2BGAImageProc::SetKernelTier(tier);
+        ResetOutput(out, c);
+        LR2BGAImageProc::ResizeCache cache;
+        LR2BGAImageProc::ResizeTarget target = {out.Data(), c.dstWidth, c.dstHeight, c.dstStride,
+                                                c.actualWidth, c.actualHeight, c.offsetX, c.offsetY,
+                                                bilinear, &cache};
+        LR2BGAImageProc::ResizeMulti(pSrc, c.srcWidth, c.srcHeight, c.srcStride, c.srcBpp,
+                                     c.useCrop ? &c.crop : NULL, &target, 1);
+    }
+
+    void VerifyResize(const ResizeCase &c, Random &rng, bool bilinear) {
+        const char *what = bilinear ? "bilinear" : "nearest";
+        GuardedBuffer src;
+        src.Allocate((size_t)c.srcStride * c.srcHeight, c.guardAfter);
+        rng.Fill(src.Data(), src.Size());
+        LR2BGAThreadPool::Instance().SetMaxParallelism(c.threads);
+
+        // 基準: CppOpt (固定小数点 + LUT)
+        // 既定の命令セットでビルドされた C++ 版で、フィルタ本体が使うものと同じ条件になる
+        GuardedBuffer expected;
+        RunSingle(c, src.Data(), bilinear, LR2BGAImageProc::KERNEL_TIER_CPPOPT, expected);
+        CheckUntouched(c, expected, what, "CppOpt");
+
+        GuardedBuffer out;
+        // 浮動小数点の基準実装: 最近傍は一致、バイリニアは許容差以内
+        RunSingle(c, src.Data(), bilinear, LR2BGAImageProc::KERNEL_TIER_CPP, out);
+        if (bilinear) {
+            CheckWithin(c, out, expected, kBilinearReferenceTolerance, what, "Cpp", "CppOpt");
+        } else {
+            CheckExact(c, out, expected, what, "Cpp", "CppOpt");
+        }
+
+        // SIMD 版とマルチターゲット版はビット単位で一致
+        for (int t = LR2BGAImageProc::KERNEL_TIER_CPPOPT; t <= m_maxTier; t++) {
+            const KernelTier tier = (KernelTier)t;
+            const char *tierName = LR2BGAImageProc::GetKernelTierName(tier);
+            if (tier > LR2BGAImageProc::KERNEL_TIER_CPPOPT) {
+                RunSingle(c, src.Data(), bilinear, tier, out);
+                CheckExact(c, out, expected, what, tierName, "CppOpt");
+            }
+            RunMulti(c, src.Data(), bilinear, tier, out);
+            char name[32];
+            snprintf(name, sizeof(name), "Multi/%s", tierName);
+            CheckExact(c, out, expected, what, name, "CppOpt");
+        }
+    }
+
+    // 輝度系のカーネル (黒帯検出): Cpp と SIMD 版がビット単位で一致
+    void VerifyLuma(Random &rng) {
+        const int width = rng.Range(1, kMaxLumaWidth);
+        const int bpp = rng.Chance(50) ? 32 : 24;
+        const bool guardAfter = rng.Chance(70);
+        GuardedBuffer row, expected, out;
+        row.Allocate((size_t)width * (bpp / 8), guardAfter);
+        rng.Fill(row.Data(), row.Size());
+        // 黒に近い値を多めにして閾値付近を通す
+        for (size_t i = 0; i < row.Size(); i++) {
+            if (rng.Chance(40)) row.Data()[i] &= 0x1F;
+        }
+        const int threshold = rng.Range(0, 256);
+
+        GuardedBuffer colMaxInit, colMax;
+        colMaxInit.Allocate(width, guardAfter);
+        rng.Fill(colMaxInit.Data(), colMaxInit.Size());
+
+        LR2BGAImageProc::SetKernelTier(LR2BGAImageProc::KERNEL_TIER_CPP);
+        expected.Allocate(width, guardAfter);
+        LR2BGAImageProc::ConvertRowToLuma(row.Data(), width, bpp, expected.Data());
+        const int expectedCount = LR2BGAImageProc::CountBelowThreshold(row.Data(), (int)row.Size(), threshold);
+        GuardedBuffer expectedColMax;
+        expectedColMax.Allocate(width, guardAfter);
+        memcpy(expectedColMax.Data(), colMaxInit.Data(), width);
+        const BYTE expectedRowMax = LR2BGAImageProc::AccumulateLumaProfile(expected.Data(), width, expectedColMax.Data());
+
+        for (int t = LR2BGAImageProc::KERNEL_TIER_SSE41; t <= m_maxTier; t++) {
+            const KernelTier tier = (KernelTier)t;
+            const char *tierName = LR2BGAImageProc::GetKernelTierName(tier);
+            LR2BGAImageProc::SetKernelTier(tier);
+
+            out.Allocate(width, guardAfter);
+            LR2BGAImageProc::ConvertRowToLuma(row.Data(), width, bpp, out.Data());
+            m_checks += width;
+            if (memcmp(out.Data(), expected.Data(), width) != 0) {
+                Fail(NULL, bpp == 32 ? "luma32" : "luma24", tierName, "Cpp", 0, 0, 0);
+            }
+
+            const int count = LR2BGAImageProc::CountBelowThreshold(row.Data(), (int)row.Size(), threshold);
+            m_checks++;
+            if (count != expectedCount) Fail(NULL, "count-below", tierName, "Cpp", 0, count, expectedCount);
+
+            colMax.Allocate(width, guardAfter);
+            memcpy(colMax.Data(), colMaxInit.Data(), width);
+            const BYTE rowMax = LR2BGAImageProc::AccumulateLumaProfile(expected.Data(), width, colMax.Data());
+            m_checks += width + 1;
+            if (rowMax != expectedRowMax) Fail(NULL, "luma-profile row", tierName, "Cpp", 0, rowMax, expectedRowMax);
+            if (memcmp(colMax.Data(), expectedColMax.Data(), width) != 0) {
+                Fail(NULL, "luma-profile column", tierName, "Cpp", 0, 0, 0);
+            }
+        }
+    }
+
+    VerifyOptions m_options;
+    KernelTier m_maxTier;
+    int m_failures;
+    long long m_checks;
+    int m_maxReferenceDiff;
+};
+
+} // namespace
+
+int RunVerify(const VerifyOptions &options) {
+    Verifier verifier(options);
+    return verifier.Run();
+}
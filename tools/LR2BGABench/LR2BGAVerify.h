@@ -0,0 +1,21 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAVerify.h
+// LR2 BGA Filter - 画像処理カーネルの実装段階間の一致検証
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   同じ固定小数点演算を実装し直している各段階 (CppOpt / SSE4.1 / AVX2、ResizeMulti) が
+//   ビット単位で一致すること、浮動小数点の基準実装 (Cpp) との差が許容範囲内であることを、
+//   乱数で生成した入出力サイズ・ストライド・切り出し範囲・ビット深度で確かめます。
+//   入出力バッファはアクセス不可のページに接して確保し、範囲外の読み書きはその場で異常終了させます。
+//------------------------------------------------------------------------------
+#pragma once
+
+struct VerifyOptions {
+    int iterations = 2000;          // リサイズのケース数 (輝度系カーネルも同じ回数)
+    unsigned seed = 1;
+    bool verbose = false;
+};
+
+// すべて一致すれば 0、不一致があれば 1 を返す (範囲外アクセスはガードページで異常終了する)
+int RunVerify(const VerifyOptions &options);
@@ -0,0 +1,30 @@
+﻿//------------------------------------------------------------------------------
+// intrin.h (LR2BGABench shim)
+// MSVC の intrin.h の代わりに、GCC/Clang の SIMD 組み込み関数と CPUID を提供する
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <immintrin.h>
+#include <cpuid.h>
+
+// cpuid.h の __cpuid はマクロで引数が異なり、__cpuidex は GCC/Clang のバージョンによって
+// 定義の有無が違うため、MSVC と同じ引数の関数を別名で定義してマクロで置き換える
+#undef __cpuid
+#undef __cpuidex
+
+inline void LR2BGAShimCpuidEx(int info[4], int function, int subfunction) {
+    __cpuid_count(function, subfunction, info[0], info[1], info[2], info[3]);
+}
+
+inline void LR2BGAShimCpuid(int info[4], int function) {
+    LR2BGAShimCpuidEx(info, function, 0);
+}
+
+#define __cpuidex LR2BGAShimCpuidEx
+#define __cpuid LR2BGAShimCpuid
+
+inline unsigned char _BitScanReverse(unsigned long *index, unsigned long mask) {
+    if (mask == 0) return 0;
+    *index = 31 - __builtin_clz((unsigned int)mask);
+    return 1;
+}
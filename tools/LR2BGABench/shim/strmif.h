@@ -0,0 +1,9 @@
+﻿//------------------------------------------------------------------------------
+// strmif.h (LR2BGABench shim)
+// LR2BGATypes.h が参照する DirectShow の型だけを定義する
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <windows.h>
+
+typedef LONGLONG REFERENCE_TIME;
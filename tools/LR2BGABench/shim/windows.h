@@ -0,0 +1,189 @@
+﻿//------------------------------------------------------------------------------
+// windows.h (LR2BGABench shim)
+// Windows 以外 (Linux の GCC/Clang) で画像処理コアをビルドするための最小限の代替ヘッダ
+//------------------------------------------------------------------------------
+//
+// LR2BGAImageProc / LR2BGAThreadPool / LR2BGALetterboxDetector と、オフライン再生 (LR2BGAReplay) が
+// 加えてビルドする LR2BGATransformLogic / LR2BGAFramePacer / LR2BGAStageStats / LR2BGASettings が
+// 使う型と関数だけを定義します。Windows では本物の windows.h が使われ、このディレクトリは
+// インクルードパスに入りません (CMakeLists.txt)。
+// レジストリは常に「キーなし」を返すため、LR2BGASettings は既定値のままになります。
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <wchar.h>
+#include <time.h>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef unsigned char BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef int BOOL;
+typedef unsigned int UINT;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef uint64_t UINT64;
+typedef int32_t HRESULT;
+typedef void *HANDLE;
+typedef void *HINSTANCE;
+typedef void *HWND;
+typedef wchar_t WCHAR;
+typedef const wchar_t *LPCWSTR;
+typedef wchar_t *LPWSTR;
+typedef BYTE *LPBYTE;
+typedef DWORD *LPDWORD;
+typedef void *HKEY;
+
+typedef union _LARGE_INTEGER {
+    struct {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef struct tagRECT {
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECT;
+
+#define TRUE 1
+#define FALSE 0
+#define WINAPI
+#define INFINITE 0xFFFFFFFF
+#define CW_USEDEFAULT ((int)0x80000000)
+#define VK_RETURN 0x0D
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_UNEXPECTED ((HRESULT)0x8000FFFFL)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define ZeroMemory(p, n) memset((p), 0, (n))
+#define CopyMemory(d, s, n) memcpy((d), (s), (n))
+#define FillMemory(p, n, v) memset((p), (v), (n))
+
+// windows.h の max/min マクロの代わり (マクロにすると標準ライブラリのヘッダと衝突するため関数で定義)
+template <class A, class B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return (a > b) ? a : b; }
+template <class A, class B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return (a < b) ? a : b; }
+
+// QPC は 100ns 単位の単調時計で代用する
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER *pFrequency) {
+    pFrequency->QuadPart = 10000000;
+    return TRUE;
+}
+
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER *pCount) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    pCount->QuadPart = (LONGLONG)ts.tv_sec * 10000000 + ts.tv_nsec / 100;
+    return TRUE;
+}
+
+inline DWORD GetCurrentThreadId() {
+#if defined(__linux__)
+    return (DWORD)syscall(SYS_gettid);
+#else
+    static thread_local char marker;
+    return (DWORD)(uintptr_t)&marker;
+#endif
+}
+
+inline void OutputDebugStringA(const char *) {}
+inline void OutputDebugStringW(const wchar_t *) {}
+
+inline BOOL SetRect(RECT *r, int left, int top, int right, int bottom) {
+    r->left = left;
+    r->top = top;
+    r->right = right;
+    r->bottom = bottom;
+    return TRUE;
+}
+
+inline BOOL SetRectEmpty(RECT *r) { return SetRect(r, 0, 0, 0, 0); }
+
+inline BOOL IsRectEmpty(const RECT *r) { return r->right <= r->left || r->bottom <= r->top; }
+
+inline BOOL EqualRect(const RECT *a, const RECT *b) {
+    return a->left == b->left && a->top == b->top && a->right == b->right && a->bottom == b->bottom;
+}
+
+inline BOOL UnionRect(RECT *dst, const RECT *a, const RECT *b) {
+    if (IsRectEmpty(a)) {
+        *dst = IsRectEmpty(b) ? RECT{0, 0, 0, 0} : *b;
+    } else if (IsRectEmpty(b)) {
+        *dst = *a;
+    } else {
+        *dst = RECT{min(a->left, b->left), min(a->top, b->top),
+                    max(a->right, b->right), max(a->bottom, b->bottom)};
+    }
+    return !IsRectEmpty(dst);
+}
+
+inline BOOL IntersectRect(RECT *dst, const RECT *a, const RECT *b) {
+    *dst = RECT{max(a->left, b->left), max(a->top, b->top),
+                min(a->right, b->right), min(a->bottom, b->bottom)};
+    if (IsRectEmpty(dst)) {
+        SetRectEmpty(dst);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//------------------------------------------------------------------------------
+// 待機 (LR2BGAFramePacer)
+// waitable timer は作成できない扱いにし、LR2BGAFramePacer の Sleep による代替経路を使う
+//------------------------------------------------------------------------------
+#define TIMER_ALL_ACCESS 0x1F0003
+
+inline HANDLE CreateWaitableTimerExW(void *, LPCWSTR, DWORD, DWORD) { return NULL; }
+inline BOOL SetWaitableTimer(HANDLE, const LARGE_INTEGER *, LONG, void *, void *, BOOL) { return FALSE; }
+inline DWORD WaitForSingleObject(HANDLE, DWORD) { return 0; }
+inline BOOL CloseHandle(HANDLE) { return TRUE; }
+
+inline void Sleep(DWORD ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000;
+    nanosleep(&ts, NULL);
+}
+
+inline void YieldProcessor() {}
+
+//------------------------------------------------------------------------------
+// レジストリ (LR2BGASettings)
+// 読み込みは常にキーなし、書き込みは常に失敗する (設定は呼び出し側がメンバへ直接与える)
+//------------------------------------------------------------------------------
+#define ERROR_SUCCESS 0L
+#define ERROR_FILE_NOT_FOUND 2L
+#define HKEY_CURRENT_USER ((HKEY)(uintptr_t)0x80000001)
+#define KEY_READ 0x20019
+#define KEY_WRITE 0x20006
+#define REG_DWORD 4
+#define REG_OPTION_NON_VOLATILE 0
+
+inline LONG RegOpenKeyExW(HKEY, LPCWSTR, DWORD, DWORD, HKEY *) { return ERROR_FILE_NOT_FOUND; }
+inline LONG RegCreateKeyExW(HKEY, LPCWSTR, DWORD, LPWSTR, DWORD, DWORD, void *, HKEY *, LPDWORD) {
+    return ERROR_FILE_NOT_FOUND;
+}
+inline LONG RegQueryValueExW(HKEY, LPCWSTR, LPDWORD, LPDWORD, LPBYTE, LPDWORD) { return ERROR_FILE_NOT_FOUND; }
+inline LONG RegSetValueExW(HKEY, LPCWSTR, DWORD, DWORD, const BYTE *, DWORD) { return ERROR_FILE_NOT_FOUND; }
+inline LONG RegCloseKey(HKEY) { return ERROR_SUCCESS; }
@@ -0,0 +1,130 @@
+﻿//------------------------------------------------------------------------------
+// LR2BGAStatsReader.cpp
+// LR2 BGA Filter - 共有メモリの統計を表示する参照用リーダー
+//------------------------------------------------------------------------------
+//
+// 概要:
+//   フィルタが公開する共有メモリ (LR2BGASharedStats.h) を読み取り専用で開き、
+//   一定周期で統計を1行ずつ表示します。外部ツール (配信用オーバーレイ等) を作る際の参考実装です。
+//   フィルタのストリーミングスレッドとはロックを共有せず、
+//   シーケンスロックで整合した値だけを表示します (LR2BGAReadSharedStats)。
+//
+// 使用法:
+//   LR2BGAStatsReader.exe [--interval ミリ秒] [--once]
+//------------------------------------------------------------------------------
+
+#include <windows.h>
+#include <stdio.h>
+#include <wchar.h>
+
+#include "../../src/LR2BGASharedStats.h"
+
+namespace {
+
+constexpr DWORD kDefaultIntervalMs = 500;
+constexpr DWORD kMinIntervalMs = 16;
+constexpr double kStaleSeconds = 2.0;   // この間更新がなければ「更新なし」と表示する
+
+const char *LetterboxModeName(LONG mode) {
+    switch (mode) {
+    case 0: return "Original";
+    case 1: return "16:9";
+    case 2: return "4:3";
+    case 3: return "Custom";
+    default: return "?";
+    }
+}
+
+void PrintStats(const LR2BGASharedStatsData &s, LONGLONG nowQpc) {
+    const double ageSec = (s.qpcFrequency > 0) ? (double)(nowQpc - s.updateQpc) / s.qpcFrequency : 0.0;
+    const char *state = !s.streaming ? "stopped" : (ageSec > kStaleSeconds ? "stalled" : "streaming");
+
+    printf("[%-9s] in %ldx%ld %.2ffps -> out %ldx%ld %.2ffps | frames in %lld out %lld drop %lld | "
+           "proc avg %.2f p95 %.2f p99 %.2f max %.2f ms, deliver p95 %.2f ms | LB %s",
+           state, s.inputWidth, s.inputHeight, s.inputFrameRate, s.outputWidth, s.outputHeight,
+           s.outputFrameRate, s.inputFrames, s.outputFrames, s.droppedFrames, s.avgProcessMs,
+           s.processP95Ms, s.processP99Ms, s.processMaxMs, s.deliverP95Ms,
+           LetterboxModeName(s.letterboxMode));
+    if (s.cropActive) {
+        printf(" (%ld,%ld)-(%ld,%ld)", s.cropRect.left, s.cropRect.top, s.cropRect.right, s.cropRect.bottom);
+    }
+    printf(" | updated %.1fs ago\n", ageSec);
+}
+
+void PrintUsage() {
+    printf("Usage: LR2BGAStatsReader [--interval <ms>] [--once]\n");
+}
+
+} // namespace
+
+int wmain(int argc, wchar_t **argv) {
+    DWORD intervalMs = kDefaultIntervalMs;
+    bool once = false;
+    for (int i = 1; i < argc; i++) {
+        if (wcscmp(argv[i], L"--once") == 0) {
+            once = true;
+        } else if (wcscmp(argv[i], L"--interval") == 0 && i + 1 < argc) {
+            const long value = wcstol(argv[++i], NULL, 10);
+            intervalMs = (value < (long)kMinIntervalMs) ? kMinIntervalMs : (DWORD)value;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    // フィルタが起動する前からでも待てるよう、開けるまで再試行する
+    HANDLE hMapping = NULL;
+    const LR2BGASharedStatsBlock *pBlock = NULL;
+    bool waitingPrinted = false;
+    for (;;) {
+        if (!pBlock) {
+            hMapping = OpenFileMappingW(FILE_MAP_READ, FALSE, LR2BGA_SHARED_STATS_NAME);
+            if (hMapping) {
+                pBlock = static_cast<const LR2BGASharedStatsBlock *>(
+                    MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, sizeof(LR2BGASharedStatsBlock)));
+                if (!pBlock) {
+                    CloseHandle(hMapping);
+                    hMapping = NULL;
+                }
+            }
+        }
+
+        if (!pBlock) {
+            if (once) {
+                fprintf(stderr, "LR2 BGA Filter statistics are not available (%ls).\n", LR2BGA_SHARED_STATS_NAME);
+                return 1;
+            }
+            if (!waitingPrinted) {
+                printf("Waiting for LR2 BGA Filter...\n");
+                waitingPrinted = true;
+            }
+        } else if (pBlock->magic != kLR2BGASharedStatsMagic) {
+            // フィルタがヘッダを書く前 (作成直後)
+            if (once) {
+                fprintf(stderr, "LR2 BGA Filter statistics are not initialized yet.\n");
+                return 1;
+            }
+        } else if (pBlock->version != kLR2BGASharedStatsVersion) {
+            fprintf(stderr, "Unsupported statistics version %lu (expected %lu).\n",
+                    pBlock->version, kLR2BGASharedStatsVersion);
+            return 1;
+        } else {
+            LR2BGASharedStatsData stats;
+            if (LR2BGAReadSharedStats(pBlock, stats)) {
+                LARGE_INTEGER now;
+                QueryPerformanceCounter(&now);
+                PrintStats(stats, now.QuadPart);
+                if (once) break;
+            } else if (once) {
+                // 書き込みが続いて一貫した値を読めなかった
+                fprintf(stderr, "Could not read consistent LR2 BGA Filter statistics.\n");
+                return 1;
+            }
+        }
+        Sleep(intervalMs);
+    }
+
+    UnmapViewOfFile(pBlock);
+    CloseHandle(hMapping);
+    return 0;
+}